@@ -59,6 +59,12 @@ kotlin {
             implementation("org.jetbrains.kotlinx:kotlinx-coroutines-android:1.8.0")
             implementation("androidx.exifinterface:exifinterface:1.3.7")
         }
+        androidInstrumentedTest.dependencies {
+            // On-device tests that exercise the native library (libavif builds only)
+            implementation(libs.kotlin.testJunit)
+            implementation(libs.androidx.testExt.junit)
+            implementation(libs.androidx.test.runner)
+        }
     }
 }
 
@@ -71,6 +77,7 @@ android {
     }
     defaultConfig {
         minSdk = libs.versions.android.minSdk.get().toInt()
+        testInstrumentationRunner = "androidx.test.runner.AndroidJUnitRunner"
 
         // NDK configuration for native AVIF support
         // The native library is built conditionally:
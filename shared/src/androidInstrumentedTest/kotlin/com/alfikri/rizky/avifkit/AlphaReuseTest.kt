@@ -0,0 +1,116 @@
+package com.alfikri.rizky.avifkit
+
+import android.graphics.Bitmap
+import android.graphics.Color
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import kotlinx.coroutines.runBlocking
+import org.junit.Before
+import org.junit.Test
+import org.junit.runner.RunWith
+import java.io.ByteArrayOutputStream
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertTrue
+
+/**
+ * Encoders that reuse planes between images must still follow each image's alpha
+ */
+@RunWith(AndroidJUnit4::class)
+class AlphaReuseTest {
+
+    @Before
+    fun setUp() {
+        TestImages.assumeLibavif()
+    }
+
+    @Test
+    fun sessionKeepsAlphaAfterAnOpaqueEncode() = runBlocking {
+        AvifSession(EncodingOptions(quality = 90, speed = 9)).use { session ->
+            val opaque = session.encode(TestImages.pattern(64, 48))
+            val translucent = session.encode(TestImages.pattern(64, 48, translucent = true))
+            val opaqueAgain = session.encode(TestImages.pattern(64, 48))
+
+            assertFalse(TestImages.converter.getImageInfo(ImageInput.FromBytes(opaque)).hasAlpha)
+            assertTrue(TestImages.converter.getImageInfo(ImageInput.FromBytes(translucent)).hasAlpha)
+            assertFalse(TestImages.converter.getImageInfo(ImageInput.FromBytes(opaqueAgain)).hasAlpha)
+
+            val decoded = TestImages.converter.decodeAvif(ImageInput.FromBytes(translucent))
+            assertTrue(Color.alpha(decoded.getPixel(0, 0)) < 128)
+        }
+    }
+
+    @Test
+    fun animationMixesOpaqueAndTranslucentFrames() {
+        val frames = listOf(
+            TestImages.pattern(64, 48, translucent = true),
+            TestImages.pattern(64, 48),
+            TestImages.pattern(64, 48, translucent = true)
+        )
+        assertFramesEncode(EncodingOptions(quality = 90, speed = 9), frames)
+    }
+
+    @Test
+    fun scaledAnimationMixesOpaqueAndTranslucentFrames() {
+        val frames = listOf(
+            TestImages.pattern(128, 96, translucent = true),
+            TestImages.pattern(128, 96),
+            TestImages.pattern(128, 96, translucent = true)
+        )
+        assertFramesEncode(EncodingOptions(quality = 90, speed = 9, maxDimension = 64), frames)
+    }
+
+    @Test
+    fun opaqueBitmapSequenceHasNoAlpha() {
+        // ARGB_8888 bitmaps always carry an alpha channel; the pixels decide
+        val data = AvifAnimationEncoder(EncodingOptions(quality = 90, speed = 9)).use { encoder ->
+            repeat(3) { encoder.addFrame(TestImages.pattern(64, 48), duration = 100) }
+            encoder.finish()
+        }
+
+        AvifAnimationDecoder(data).use { decoder ->
+            assertEquals(3, decoder.frameCount)
+            assertFalse(decoder.hasAlpha)
+            assertEquals(255, Color.alpha(decoder.decodeFrame(1).bitmap.getPixel(0, 0)))
+        }
+    }
+
+    @Test
+    fun gridAddsAlphaAtTheFirstTranslucentStrip() = runBlocking {
+        // Strips are one cell row tall, so the top cell row is converted before any alpha appears
+        val opaque = TestImages.pattern(128, 128)
+        val translucentBottom = TestImages.pattern(128, 128).copy(Bitmap.Config.ARGB_8888, true).apply {
+            val bottom = TestImages.pattern(128, 64, translucent = true)
+            val pixels = IntArray(128 * 64)
+            bottom.getPixels(pixels, 0, 128, 0, 0, 128, 64)
+            setPixels(pixels, 0, 128, 0, 64, 128, 64)
+        }
+
+        val opaqueGrid = TestImages.encodeGrid(ImageInput.FromBytes(png(opaque)), cellSize = 64)
+        assertFalse(TestImages.converter.getImageInfo(ImageInput.FromBytes(opaqueGrid)).hasAlpha)
+
+        val grid = TestImages.encodeGrid(ImageInput.FromBytes(png(translucentBottom)), cellSize = 64)
+        assertTrue(TestImages.converter.getImageInfo(ImageInput.FromBytes(grid)).hasAlpha)
+        val decoded = TestImages.converter.decodeAvif(ImageInput.FromBytes(grid))
+        assertEquals(255, Color.alpha(decoded.getPixel(0, 0)))
+        assertEquals(255, Color.alpha(decoded.getPixel(127, 63)))
+        assertTrue(Color.alpha(decoded.getPixel(0, 64)) < 128)
+    }
+
+    private fun png(bitmap: Bitmap): ByteArray =
+        ByteArrayOutputStream().also { bitmap.compress(Bitmap.CompressFormat.PNG, 100, it) }.toByteArray()
+
+    private fun assertFramesEncode(options: EncodingOptions, frames: List<Bitmap>) {
+        val data = AvifAnimationEncoder(options).use { encoder ->
+            frames.forEach { encoder.addFrame(it, duration = 100) }
+            encoder.finish()
+        }
+
+        AvifAnimationDecoder(data).use { decoder ->
+            assertEquals(frames.size, decoder.frameCount)
+            assertTrue(decoder.hasAlpha)
+            assertTrue(Color.alpha(decoder.decodeFrame(0).bitmap.getPixel(0, 0)) < 128)
+            assertEquals(255, Color.alpha(decoder.decodeFrame(1).bitmap.getPixel(0, 0)))
+            assertTrue(Color.alpha(decoder.decodeFrame(2).bitmap.getPixel(0, 0)) < 128)
+        }
+    }
+}
@@ -0,0 +1,102 @@
+package com.alfikri.rizky.avifkit
+
+import android.graphics.Bitmap
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import kotlinx.coroutines.runBlocking
+import org.junit.Before
+import org.junit.Test
+import org.junit.runner.RunWith
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+import kotlin.test.assertTrue
+
+@RunWith(AndroidJUnit4::class)
+class AvifStreamDecoderTest {
+
+    @Before
+    fun setUp() {
+        TestImages.assumeLibavif()
+    }
+
+    @Test
+    fun gridImageDecodesIncrementallyAndMatchesOneShotDecode() = runBlocking {
+        val data = TestImages.encodeGrid(TestImages.pattern(512, 384), cellSize = 128)
+        val rows = streamInChunks(data, chunkSize = 701)
+
+        // A grid becomes available cell row by cell row before the data is complete
+        assertTrue(rows.any { it in 1 until 384 }, "no partial rows reported: $rows")
+    }
+
+    @Test
+    fun stillImageMatchesOneShotDecode() = runBlocking {
+        val data = TestImages.encode(TestImages.pattern(200, 150, translucent = true))
+        streamInChunks(data, chunkSize = 257)
+        Unit
+    }
+
+    @Test
+    fun singleByteChunks() = runBlocking {
+        val data = TestImages.encodeGrid(TestImages.pattern(256, 192), cellSize = 64)
+        streamInChunks(data, chunkSize = 1)
+        Unit
+    }
+
+    @Test
+    fun truncatedStreamFailsOnFinish() = runBlocking {
+        val data = TestImages.encode(TestImages.pattern(64, 64))
+        AvifStreamDecoder(data.size.toLong()).use { decoder ->
+            decoder.append(data, 0, data.size / 2)
+            assertFailsWith<AvifError.DecodingFailed> { decoder.finish() }
+        }
+    }
+
+    /**
+     * Stream data in chunks, painting after every chunk, and compare the final
+     * bitmap with a one-shot decode; returns the decoded row count after each chunk
+     */
+    private suspend fun streamInChunks(data: ByteArray, chunkSize: Int): List<Int> {
+        val expected = TestImages.converter.decodeAvif(ImageInput.FromBytes(data))
+        val rows = mutableListOf<Int>()
+        AvifStreamDecoder(data.size.toLong()).use { decoder ->
+            var offset = 0
+            while (offset < data.size) {
+                val length = minOf(chunkSize, data.size - offset)
+                val decoded = decoder.append(data, offset, length)
+                offset += length
+
+                assertTrue(decoded >= (rows.lastOrNull() ?: 0), "decodedRows went back: $rows then $decoded")
+                assertTrue(decoded <= decoder.totalRows)
+                if (decoded > 0) {
+                    assertEquals(expected.width, decoder.width)
+                    assertEquals(expected.height, decoder.height)
+                    decoder.bitmap()
+                }
+                rows += decoded
+            }
+            decoder.finish()
+            assertTrue(decoder.isComplete)
+            assertEquals(decoder.totalRows, decoder.decodedRows)
+
+            val actual = decoder.bitmap()!!
+            assertBitmapsEqual(expected, actual)
+        }
+        return rows
+    }
+
+    private fun assertBitmapsEqual(expected: Bitmap, actual: Bitmap) {
+        assertEquals(expected.width, actual.width)
+        assertEquals(expected.height, actual.height)
+        val expectedPixels = IntArray(expected.width * expected.height)
+        val actualPixels = IntArray(actual.width * actual.height)
+        expected.getPixels(expectedPixels, 0, expected.width, 0, 0, expected.width, expected.height)
+        actual.getPixels(actualPixels, 0, actual.width, 0, 0, actual.width, actual.height)
+        for (i in expectedPixels.indices) {
+            if (expectedPixels[i] != actualPixels[i]) {
+                throw AssertionError(
+                    "pixel (${i % expected.width}, ${i / expected.width}) differs: " +
+                        "expected %08x, was %08x".format(expectedPixels[i], actualPixels[i])
+                )
+            }
+        }
+    }
+}
@@ -0,0 +1,46 @@
+package com.alfikri.rizky.avifkit
+
+import android.graphics.Bitmap
+import android.graphics.Color
+import android.os.Build
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import kotlinx.coroutines.runBlocking
+import org.junit.Assume.assumeTrue
+import org.junit.Before
+import org.junit.Test
+import org.junit.runner.RunWith
+import kotlin.test.assertEquals
+import kotlin.test.assertFalse
+import kotlin.test.assertTrue
+
+@RunWith(AndroidJUnit4::class)
+class HighBitDepthTest {
+
+    @Before
+    fun setUp() {
+        TestImages.assumeLibavif()
+        assumeTrue(Build.VERSION.SDK_INT >= Build.VERSION_CODES.O)
+    }
+
+    @Test
+    fun opaqueSourceHasNoAlphaItem() = runBlocking {
+        val bitmap = halfFloatBitmap(Color.argb(255, 200, 120, 40))
+        val info = TestImages.converter.getImageInfo(ImageInput.FromBytes(encode(bitmap)))
+        assertEquals(10, info.bitDepth)
+        assertFalse(info.hasAlpha)
+    }
+
+    @Test
+    fun translucentSourceKeepsAlpha() = runBlocking {
+        val bitmap = halfFloatBitmap(Color.argb(128, 200, 120, 40))
+        val info = TestImages.converter.getImageInfo(ImageInput.FromBytes(encode(bitmap)))
+        assertEquals(10, info.bitDepth)
+        assertTrue(info.hasAlpha)
+    }
+
+    private suspend fun encode(bitmap: Bitmap): ByteArray =
+        TestImages.converter.encodeAvifHighBitDepth(bitmap, 10, EncodingOptions(quality = 90, speed = 9))
+
+    private fun halfFloatBitmap(color: Int): Bitmap =
+        Bitmap.createBitmap(48, 32, Bitmap.Config.RGBA_F16).apply { eraseColor(color) }
+}
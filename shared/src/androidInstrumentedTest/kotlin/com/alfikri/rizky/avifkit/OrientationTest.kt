@@ -0,0 +1,204 @@
+package com.alfikri.rizky.avifkit
+
+import android.graphics.Bitmap
+import android.graphics.Color
+import android.os.Build
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import kotlinx.coroutines.runBlocking
+import org.junit.Assume.assumeTrue
+import org.junit.Before
+import org.junit.Test
+import org.junit.runner.RunWith
+import kotlin.math.abs
+import kotlin.test.assertEquals
+import kotlin.test.assertTrue
+
+/**
+ * Every decode path shows irot/imir the same way, for all eight Exif orientations
+ *
+ * Sources are JPEGs of a four-colour bitmap tagged with an Exif orientation; the
+ * encoder keeps the pixels in sensor order and writes the orientation as irot/imir.
+ */
+@RunWith(AndroidJUnit4::class)
+class OrientationTest {
+
+    @Before
+    fun setUp() {
+        TestImages.assumeLibavif()
+    }
+
+    @Test
+    fun decodeShowsEveryOrientation() = runBlocking {
+        forEachOrientation { orientation, avif ->
+            assertQuadrants(orientation, TestImages.converter.decodeAvif(ImageInput.FromBytes(avif)))
+        }
+    }
+
+    @Test
+    fun imageInfoReportsDisplayedSize() = runBlocking {
+        forEachOrientation { orientation, avif ->
+            val info = TestImages.converter.getImageInfo(ImageInput.FromBytes(avif))
+            val decoded = TestImages.converter.decodeAvif(ImageInput.FromBytes(avif))
+            assertEquals(decoded.width, info.width, "orientation $orientation")
+            assertEquals(decoded.height, info.height, "orientation $orientation")
+        }
+    }
+
+    @Test
+    fun animationDecoderShowsEveryOrientation() = runBlocking {
+        forEachOrientation { orientation, avif ->
+            AvifAnimationDecoder(avif).use { decoder ->
+                val frame = decoder.decodeFrame(0).bitmap
+                assertEquals(frame.width, decoder.width, "orientation $orientation")
+                assertEquals(frame.height, decoder.height, "orientation $orientation")
+                assertQuadrants(orientation, frame)
+            }
+        }
+    }
+
+    @Test
+    fun streamDecoderShowsEveryOrientation() = runBlocking {
+        for (orientation in 1..8) {
+            val jpeg = TestImages.orientedJpeg(TestImages.quadrants(WIDTH, HEIGHT), orientation)
+            val avif = TestImages.encodeGrid(ImageInput.FromBytes(jpeg), cellSize = 64)
+            val expected = TestImages.converter.decodeAvif(ImageInput.FromBytes(avif))
+
+            AvifStreamDecoder(avif.size.toLong()).use { decoder ->
+                var offset = 0
+                while (offset < avif.size) {
+                    val length = minOf(97, avif.size - offset)
+                    if (decoder.append(avif, offset, length) > 0) {
+                        assertEquals(expected.width, decoder.width, "orientation $orientation")
+                        assertEquals(expected.height, decoder.height, "orientation $orientation")
+                        decoder.bitmap()
+                    }
+                    offset += length
+                }
+                decoder.finish()
+                assertTrue(expected.sameAs(decoder.bitmap()), "orientation $orientation differs from decodeAvif")
+            }
+        }
+    }
+
+    @Test
+    fun highBitDepthDecodeShowsEveryOrientation() = runBlocking {
+        assumeTrue(Build.VERSION.SDK_INT >= Build.VERSION_CODES.O)
+        forEachOrientation { orientation, avif ->
+            val bitmap = TestImages.converter.decodeAvifHighBitDepth(
+                ImageInput.FromBytes(avif),
+                HighBitDepthFormat.RGBA_F16
+            )
+            assertQuadrants(orientation, bitmap)
+        }
+    }
+
+    @Test
+    fun regionDecodeUsesDisplayedCoordinates() = runBlocking {
+        for (orientation in 1..8) {
+            val jpeg = TestImages.orientedJpeg(TestImages.pattern(WIDTH, HEIGHT), orientation)
+            val avif = TestImages.encodeGrid(ImageInput.FromBytes(jpeg), cellSize = 64)
+            val full = TestImages.converter.decodeAvif(ImageInput.FromBytes(avif))
+
+            // Odd offsets, so the stored rectangle needs chroma alignment on every side it maps to
+            val region = TestImages.converter.decodeRegion(ImageInput.FromBytes(avif), 37, 21, 50, 41)
+            assertEquals(50, region.width, "orientation $orientation")
+            assertEquals(41, region.height, "orientation $orientation")
+            for (y in 0 until region.height) {
+                for (x in 0 until region.width) {
+                    val expected = full.getPixel(37 + x, 21 + y)
+                    val actual = region.getPixel(x, y)
+                    assertTrue(
+                        close(expected, actual),
+                        "orientation $orientation, region ($x, $y): expected %08x, was %08x".format(expected, actual)
+                    )
+                }
+            }
+        }
+    }
+
+    @Test
+    fun rotatedDecodeMatchesTheStoredPixelsExactly() = runBlocking {
+        // 4:2:0 and larger than a conversion strip both ways, so strip edges fall inside the image
+        val source = TestImages.pattern(LARGE_WIDTH, LARGE_HEIGHT)
+        for (orientation in listOf(3, 6, 8)) {
+            val avif = TestImages.encode(ImageInput.FromBytes(TestImages.orientedJpeg(source, orientation)))
+            val displayed = TestImages.converter.decodeAvif(ImageInput.FromBytes(avif))
+            val stored = TestImages.converter.decodeAvif(ImageInput.FromBytes(withoutRotation(avif)))
+            assertEquals(LARGE_WIDTH, stored.width)
+            assertEquals(LARGE_HEIGHT, stored.height)
+
+            val storedPixels = IntArray(stored.width * stored.height)
+            stored.getPixels(storedPixels, 0, stored.width, 0, 0, stored.width, stored.height)
+            val displayedPixels = IntArray(displayed.width * displayed.height)
+            displayed.getPixels(displayedPixels, 0, displayed.width, 0, 0, displayed.width, displayed.height)
+            for (y in 0 until stored.height) {
+                for (x in 0 until stored.width) {
+                    val (u, v) = TestImages.displayedPoint(
+                        orientation,
+                        (x + 0.5f) / stored.width,
+                        (y + 0.5f) / stored.height
+                    )
+                    val dx = (u * displayed.width).toInt()
+                    val dy = (v * displayed.height).toInt()
+                    val expected = storedPixels[y * stored.width + x]
+                    val actual = displayedPixels[dy * displayed.width + dx]
+                    assertEquals(
+                        expected,
+                        actual,
+                        "orientation $orientation, stored ($x, $y): expected %08x, was %08x".format(expected, actual)
+                    )
+                }
+            }
+        }
+    }
+
+    /**
+     * The same file with its irot angle set to 0, which decodes in stored orientation
+     */
+    private fun withoutRotation(avif: ByteArray): ByteArray {
+        val type = "irot".toByteArray(Charsets.US_ASCII)
+        val at = (0..avif.size - type.size).first { i -> type.indices.all { avif[i + it] == type[it] } }
+        return avif.copyOf().also { it[at + type.size] = 0 }
+    }
+
+    private suspend fun forEachOrientation(check: suspend (Int, ByteArray) -> Unit) {
+        for (orientation in 1..8) {
+            val jpeg = TestImages.orientedJpeg(TestImages.quadrants(WIDTH, HEIGHT), orientation)
+            check(orientation, TestImages.encode(ImageInput.FromBytes(jpeg)))
+        }
+    }
+
+    /**
+     * The bitmap has the displayed size and each stored quadrant shows where the orientation puts it
+     */
+    private fun assertQuadrants(orientation: Int, bitmap: Bitmap) {
+        val swapped = orientation >= 5
+        assertEquals(if (swapped) HEIGHT else WIDTH, bitmap.width, "orientation $orientation")
+        assertEquals(if (swapped) WIDTH else HEIGHT, bitmap.height, "orientation $orientation")
+        for (row in 0..1) {
+            for (column in 0..1) {
+                val (u, v) = TestImages.displayedPoint(orientation, (column + 0.5f) / 2, (row + 0.5f) / 2)
+                val actual = bitmap.getPixel((u * bitmap.width).toInt(), (v * bitmap.height).toInt())
+                val expected = TestImages.quadrantColor(column, row)
+                assertTrue(
+                    close(expected, actual),
+                    "orientation $orientation, quadrant ($column, $row): expected %08x, was %08x"
+                        .format(expected, actual)
+                )
+            }
+        }
+    }
+
+    private fun close(expected: Int, actual: Int): Boolean =
+        abs(Color.red(expected) - Color.red(actual)) <= TOLERANCE &&
+            abs(Color.green(expected) - Color.green(actual)) <= TOLERANCE &&
+            abs(Color.blue(expected) - Color.blue(actual)) <= TOLERANCE
+
+    private companion object {
+        const val WIDTH = 192
+        const val HEIGHT = 128
+        const val TOLERANCE = 40
+        const val LARGE_WIDTH = 200
+        const val LARGE_HEIGHT = 150
+    }
+}
@@ -0,0 +1,65 @@
+package com.alfikri.rizky.avifkit
+
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import kotlinx.coroutines.runBlocking
+import org.junit.Before
+import org.junit.Test
+import org.junit.runner.RunWith
+import kotlin.test.assertEquals
+import kotlin.test.assertNotNull
+import kotlin.test.assertTrue
+
+@RunWith(AndroidJUnit4::class)
+class TargetQualityTest {
+
+    private val source = TestImages.pattern(320, 240)
+    private val options = EncodingOptions(speed = 9)
+
+    @Before
+    fun setUp() {
+        TestImages.assumeLibavif()
+    }
+
+    @Test
+    fun searchStaysWithinItsBounds() {
+        for (target in TARGETS) {
+            val result = search(target)
+            assertTrue(result.quality in 0..100, "target $target: quality ${result.quality}")
+            assertTrue(result.attempts in 1..MAX_ATTEMPTS, "target $target: ${result.attempts} attempts")
+            assertTrue(result.score > 0f && result.score <= 1f, "target $target: score ${result.score}")
+            if (result.targetMet) {
+                assertTrue(result.score >= target, "target $target met with score ${result.score}")
+            }
+        }
+    }
+
+    @Test
+    fun higherTargetsNeverPickLowerQuality() {
+        val results = TARGETS.map { search(it) }
+        for (i in 1 until results.size) {
+            val lower = results[i - 1]
+            val higher = results[i]
+            if (!lower.targetMet || !higher.targetMet) continue
+            assertTrue(
+                higher.quality >= lower.quality,
+                "target ${TARGETS[i]} picked quality ${higher.quality} below ${lower.quality} for ${TARGETS[i - 1]}"
+            )
+        }
+    }
+
+    @Test
+    fun targetQualityEncodeDecodes() = runBlocking {
+        val encoded = TestImages.encode(source, options.copy(targetQuality = 0.95f))
+        val decoded = TestImages.converter.decodeAvif(ImageInput.FromBytes(encoded))
+        assertEquals(source.width, decoded.width)
+        assertEquals(source.height, decoded.height)
+    }
+
+    private fun search(target: Float): TargetQualityEncodeResult =
+        assertNotNull(TestImages.converter.encodeToTargetQuality(source, options, target), "no native search")
+
+    private companion object {
+        val TARGETS = listOf(0.80f, 0.90f, 0.95f, 0.98f)
+        const val MAX_ATTEMPTS = 8
+    }
+}
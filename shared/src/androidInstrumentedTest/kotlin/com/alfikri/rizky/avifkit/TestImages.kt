@@ -0,0 +1,124 @@
+package com.alfikri.rizky.avifkit
+
+import android.graphics.Bitmap
+import android.graphics.Color
+import androidx.exifinterface.media.ExifInterface
+import androidx.test.platform.app.InstrumentationRegistry
+import org.junit.Assume.assumeTrue
+import java.io.File
+
+/**
+ * Fixtures for the on-device tests, generated with the library itself
+ *
+ * Every AVIF used by the tests is encoded at run time from a synthetic bitmap,
+ * so no binary fixtures are checked in and the tests follow encoder changes.
+ */
+internal object TestImages {
+
+    val converter = AvifConverter()
+
+    /**
+     * Skip the calling test in placeholder builds (no libavif linked)
+     */
+    fun assumeLibavif() {
+        val available = AvifConverter.isNativeLibraryLoaded() && runCatching { AvifStreamDecoder().close() }.isSuccess
+        assumeTrue("libavif is not linked into this build", available)
+    }
+
+    /**
+     * Smooth colour ramps with a few hard edges; alpha ramps left to right when translucent
+     */
+    fun pattern(width: Int, height: Int, translucent: Boolean = false): Bitmap {
+        val pixels = IntArray(width * height)
+        for (y in 0 until height) {
+            for (x in 0 until width) {
+                val red = x * 255 / maxOf(1, width - 1)
+                val green = y * 255 / maxOf(1, height - 1)
+                val blue = if ((x / 32 + y / 32) % 2 == 0) 40 else 210
+                val alpha = if (translucent) 64 + x * 191 / maxOf(1, width - 1) else 255
+                pixels[y * width + x] = Color.argb(alpha, red, green, blue)
+            }
+        }
+        return Bitmap.createBitmap(pixels, width, height, Bitmap.Config.ARGB_8888)
+    }
+
+    /**
+     * A bitmap whose four quadrants have distinct colours, so any rotation or flip is visible
+     */
+    fun quadrants(width: Int, height: Int): Bitmap {
+        val bitmap = Bitmap.createBitmap(width, height, Bitmap.Config.ARGB_8888)
+        for (y in 0 until height) {
+            for (x in 0 until width) {
+                bitmap.setPixel(x, y, quadrantColor(x * 2 / width, y * 2 / height))
+            }
+        }
+        return bitmap
+    }
+
+    fun quadrantColor(column: Int, row: Int): Int = when (row * 2 + column) {
+        0 -> Color.RED
+        1 -> Color.GREEN
+        2 -> Color.BLUE
+        else -> Color.WHITE
+    }
+
+    /**
+     * A JPEG of [bitmap] tagged with an Exif orientation (pixels stay in sensor order)
+     */
+    fun orientedJpeg(bitmap: Bitmap, orientation: Int): ByteArray {
+        val file = tempFile("oriented", ".jpg")
+        try {
+            file.outputStream().use { bitmap.compress(Bitmap.CompressFormat.JPEG, 100, it) }
+            ExifInterface(file.path).apply {
+                setAttribute(ExifInterface.TAG_ORIENTATION, orientation.toString())
+                saveAttributes()
+            }
+            return file.readBytes()
+        } finally {
+            file.delete()
+        }
+    }
+
+    /**
+     * Where the normalized stored point (u, v) is displayed under an Exif orientation
+     */
+    fun displayedPoint(orientation: Int, u: Float, v: Float): Pair<Float, Float> = when (orientation) {
+        ExifInterface.ORIENTATION_FLIP_HORIZONTAL -> 1 - u to v
+        ExifInterface.ORIENTATION_ROTATE_180 -> 1 - u to 1 - v
+        ExifInterface.ORIENTATION_FLIP_VERTICAL -> u to 1 - v
+        ExifInterface.ORIENTATION_TRANSPOSE -> v to u
+        ExifInterface.ORIENTATION_ROTATE_90 -> 1 - v to u
+        ExifInterface.ORIENTATION_TRANSVERSE -> 1 - v to 1 - u
+        ExifInterface.ORIENTATION_ROTATE_270 -> v to 1 - u
+        else -> u to v
+    }
+
+    suspend fun encode(bitmap: Bitmap, options: EncodingOptions = EncodingOptions(quality = 90, speed = 9)): ByteArray =
+        encode(ImageInput.FromBitmap(bitmap), options)
+
+    suspend fun encode(input: ImageInput, options: EncodingOptions = EncodingOptions(quality = 90, speed = 9)): ByteArray =
+        converter.encodeAvif(input, Priority.BALANCED, options)
+
+    /**
+     * Encode as an AVIF grid of [cellSize] cells (what large photos use)
+     */
+    suspend fun encodeGrid(bitmap: Bitmap, cellSize: Int): ByteArray = encodeGrid(ImageInput.FromBitmap(bitmap), cellSize)
+
+    suspend fun encodeGrid(input: ImageInput, cellSize: Int): ByteArray {
+        val file = tempFile("grid", ".avif")
+        try {
+            converter.convertLargeImageToFile(
+                input,
+                file.path,
+                EncodingOptions(quality = 90, speed = 9),
+                cellSize
+            )
+            return file.readBytes()
+        } finally {
+            file.delete()
+        }
+    }
+
+    fun tempFile(prefix: String, suffix: String): File =
+        File.createTempFile(prefix, suffix, InstrumentationRegistry.getInstrumentation().targetContext.cacheDir)
+}
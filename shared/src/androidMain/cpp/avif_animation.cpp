@@ -0,0 +1,302 @@
+#include "avif_common.h"
+#include "avif_io.h"
+#include "avif_orientation.h"
+#include "avif_threads.h"
+
+#include <cmath>
+#include <mutex>
+#include <unistd.h>
+
+using namespace avifkit;
+
+#if HAVE_LIBAVIF
+namespace {
+
+/**
+ * Frame iterator state behind an AvifAnimationDecoder handle
+ *
+ * The decoder is parsed once and frames are decoded on demand, so memory stays
+ * at one decoded frame (plus the codec's reference frames) regardless of the
+ * frame count. Sequential access uses avifDecoderNextImage; jumps go through
+ * avifDecoderNthImage, which restarts from the nearest keyframe. libavif fixes
+ * a codec's thread count when the codec is created, which happens on the first
+ * decode and again after every seek, so the handle leases its share of the
+ * thread budget once when it opens and keeps it until it is closed.
+ */
+struct Animation {
+    threads::Lease lease;
+    std::mutex lock;
+    AvifDecoderPtr decoder;
+    std::vector<uint8_t> data;  // owned copy for byte array sources
+    int fd = -1;                // dup'ed descriptor for file sources
+
+    ~Animation() {
+        decoder.reset();  // the IO may still reference data or fd
+        if (fd >= 0) close(fd);
+    }
+};
+
+Animation* fromHandle(jlong handle) {
+    return reinterpret_cast<Animation*>(static_cast<intptr_t>(handle));
+}
+
+/**
+ * Create the decoder, attach the IO set up by attachIO and parse the container
+ */
+template <typename AttachIO>
+jlong openAnimation(Animation* animation, AttachIO attachIO) {
+    std::unique_ptr<Animation> owner(animation);
+    if (decoderCodecName()[0] == '\0') {
+        LOGE("No decoder codec available! AOM decoder not found.");
+        return 0;
+    }
+
+    owner->decoder.reset(avifDecoderCreate());
+    if (!owner->decoder) {
+        LOGE("Failed to create AVIF decoder");
+        return 0;
+    }
+    configureDecoder(owner->decoder.get(), AVIF_CODEC_CHOICE_AUTO);
+    owner->decoder->maxThreads = owner->lease.count();
+    if (!attachIO(owner->decoder.get())) {
+        return 0;
+    }
+
+    avifResult result = avifDecoderParse(owner->decoder.get());
+    if (result != AVIF_RESULT_OK) {
+        LOGE("Failed in avifDecoderParse: %s", avifResultToString(result));
+        return 0;
+    }
+
+    LOGI("Opened AVIF animation: %ux%u, frames=%d, repetitionCount=%d",
+         owner->decoder->image->width, owner->decoder->image->height,
+         owner->decoder->imageCount, owner->decoder->repetitionCount);
+    return static_cast<jlong>(reinterpret_cast<intptr_t>(owner.release()));
+}
+
+/**
+ * Decode frame `index`, continuing sequentially when possible
+ */
+avifResult decodeFrame(avifDecoder* decoder, int index) {
+    if (index < 0 || index >= decoder->imageCount) {
+        LOGE("Frame index %d out of range (frames=%d)", index, decoder->imageCount);
+        return AVIF_RESULT_NO_IMAGES_REMAINING;
+    }
+    if (index == decoder->imageIndex) {
+        return AVIF_RESULT_OK;  // already current
+    }
+
+    avifResult result = index == decoder->imageIndex + 1
+        ? avifDecoderNextImage(decoder)
+        : avifDecoderNthImage(decoder, static_cast<uint32_t>(index));
+    if (result != AVIF_RESULT_OK) {
+        LOGE("Failed to decode frame %d: %s", index, avifResultToString(result));
+    }
+    return result;
+}
+
+} // namespace
+#endif
+
+extern "C" {
+
+/**
+ * Open an image sequence (or still image) held in a byte array
+ * The bytes are copied once into native memory. Returns 0 on failure.
+ */
+JNIEXPORT jlong JNICALL
+Java_com_alfikri_rizky_avifkit_AvifAnimationDecoder_nativeOpen(
+    JNIEnv* env,
+    jobject /* this */,
+    jbyteArray avifData) {
+
+#if HAVE_LIBAVIF
+    auto* animation = new Animation();
+    jsize length = env->GetArrayLength(avifData);
+    animation->data.resize(length);
+    env->GetByteArrayRegion(avifData, 0, length, reinterpret_cast<jbyte*>(animation->data.data()));
+
+    return openAnimation(animation, [animation](avifDecoder* decoder) {
+        avifResult result = avifDecoderSetIOMemory(decoder, animation->data.data(), animation->data.size());
+        if (result != AVIF_RESULT_OK) {
+            LOGE("Failed to set decoder IO: %s", avifResultToString(result));
+            return false;
+        }
+        return true;
+    });
+#else
+    LOGW("PLACEHOLDER: libavif not available, animation decoding not supported");
+    return 0;
+#endif
+}
+
+/**
+ * Open an image sequence from a file descriptor (duplicated; the caller may close theirs)
+ * Frames are read from the file as they are decoded. Returns 0 on failure.
+ */
+JNIEXPORT jlong JNICALL
+Java_com_alfikri_rizky_avifkit_AvifAnimationDecoder_nativeOpenFd(
+    JNIEnv* /* env */,
+    jobject /* this */,
+    jint fd) {
+
+#if HAVE_LIBAVIF
+    auto* animation = new Animation();
+    animation->fd = dup(fd);
+    if (animation->fd < 0) {
+        LOGE("Failed to duplicate file descriptor %d", fd);
+        delete animation;
+        return 0;
+    }
+
+    return openAnimation(animation, [animation](avifDecoder* decoder) {
+        avifIO* reader = io::createFdReader(animation->fd);
+        if (!reader) {
+            return false;
+        }
+        avifDecoderSetIO(decoder, reader);
+        return true;
+    });
+#else
+    LOGW("PLACEHOLDER: libavif not available, animation decoding not supported");
+    return 0;
+#endif
+}
+
+/**
+ * Container-level properties
+ * outInfo (6 ints): width, height, frameCount, hasAlpha, repetitionCount, depth.
+ * width and height are the displayed (oriented) size; repetitionCount is -1 for
+ * infinite and -2 if unknown.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_alfikri_rizky_avifkit_AvifAnimationDecoder_nativeGetInfo(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong handle,
+    jintArray outInfo) {
+
+#if HAVE_LIBAVIF
+    Animation* animation = fromHandle(handle);
+    if (!animation || env->GetArrayLength(outInfo) < 6) {
+        return JNI_FALSE;
+    }
+    std::lock_guard<std::mutex> guard(animation->lock);
+
+    const avifDecoder* decoder = animation->decoder.get();
+    uint32_t width;
+    uint32_t height;
+    orientation::displaySize(orientation::displayOrientation(decoder->image), decoder->image->width,
+                             decoder->image->height, &width, &height);
+    jint info[6] = {
+        static_cast<jint>(width),
+        static_cast<jint>(height),
+        decoder->imageCount,
+        decoder->alphaPresent ? 1 : 0,
+        decoder->repetitionCount,
+        static_cast<jint>(decoder->image->depth)
+    };
+    env->SetIntArrayRegion(outInfo, 0, 6, info);
+    return JNI_TRUE;
+#else
+    return JNI_FALSE;
+#endif
+}
+
+/**
+ * Presentation duration of a frame in milliseconds (from the track timing, no decode)
+ * Returns -1 for an invalid index.
+ */
+JNIEXPORT jlong JNICALL
+Java_com_alfikri_rizky_avifkit_AvifAnimationDecoder_nativeFrameDurationMs(
+    JNIEnv* /* env */,
+    jobject /* this */,
+    jlong handle,
+    jint index) {
+
+#if HAVE_LIBAVIF
+    Animation* animation = fromHandle(handle);
+    if (!animation) {
+        return -1;
+    }
+    std::lock_guard<std::mutex> guard(animation->lock);
+
+    avifImageTiming timing;
+    if (avifDecoderNthImageTiming(animation->decoder.get(), static_cast<uint32_t>(index), &timing) != AVIF_RESULT_OK) {
+        return -1;
+    }
+    return static_cast<jlong>(std::llround(timing.duration * 1000.0));
+#else
+    return -1;
+#endif
+}
+
+/**
+ * Whether a frame can be decoded without any earlier frame
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_alfikri_rizky_avifkit_AvifAnimationDecoder_nativeIsKeyframe(
+    JNIEnv* /* env */,
+    jobject /* this */,
+    jlong handle,
+    jint index) {
+
+#if HAVE_LIBAVIF
+    Animation* animation = fromHandle(handle);
+    if (!animation || index < 0) {
+        return JNI_FALSE;
+    }
+    std::lock_guard<std::mutex> guard(animation->lock);
+    return avifDecoderIsKeyframe(animation->decoder.get(), static_cast<uint32_t>(index)) ? JNI_TRUE : JNI_FALSE;
+#else
+    return JNI_FALSE;
+#endif
+}
+
+/**
+ * Decode a frame straight into a mutable ARGB_8888 Bitmap, in display orientation
+ * Reusing the same bitmap for every frame keeps the output at a single buffer.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_alfikri_rizky_avifkit_AvifAnimationDecoder_nativeDecodeFrame(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong handle,
+    jint index,
+    jobject bitmap) {
+
+#if HAVE_LIBAVIF
+    Animation* animation = fromHandle(handle);
+    if (!animation) {
+        LOGE("Invalid animation handle");
+        return JNI_FALSE;
+    }
+    std::lock_guard<std::mutex> guard(animation->lock);
+
+    avifDecoder* decoder = animation->decoder.get();
+    if (decodeFrame(decoder, index) != AVIF_RESULT_OK) {
+        return JNI_FALSE;
+    }
+    return decodedImageIntoBitmap(env, decoder->image, bitmap, orientation::displayOrientation(decoder->image))
+        ? JNI_TRUE : JNI_FALSE;
+#else
+    LOGW("PLACEHOLDER: libavif not available, animation decoding not supported");
+    return JNI_FALSE;
+#endif
+}
+
+/**
+ * Release the decoder and its source
+ */
+JNIEXPORT void JNICALL
+Java_com_alfikri_rizky_avifkit_AvifAnimationDecoder_nativeClose(
+    JNIEnv* /* env */,
+    jobject /* this */,
+    jlong handle) {
+
+#if HAVE_LIBAVIF
+    delete fromHandle(handle);
+#endif
+}
+
+} // extern "C"
@@ -0,0 +1,361 @@
+#include "avif_common.h"
+#include "avif_io.h"
+#include "avif_threads.h"
+
+#include <memory>
+#include <mutex>
+
+using namespace avifkit;
+
+#if HAVE_LIBAVIF
+namespace {
+
+/**
+ * Sequence encoder state behind an AvifAnimationEncoder handle
+ *
+ * Frames are converted to YUV and handed to avifEncoderAddImage one at a time.
+ * The codec compresses each frame immediately, so only the current frame's
+ * planes (reused between frames of the same size) and the compressed samples
+ * so far are resident. libavif fixes the codec's thread count when the first
+ * frame creates it and rejects a maxThreads change afterwards, so the handle
+ * leases its share of the thread budget once, when it is created, and returns
+ * it when the sequence is finished. Every frame must also have the same planes,
+ * so whether the sequence carries alpha is decided once, from the first frame's
+ * pixels: an opaque first frame (e.g. any video frame in an RGBA Bitmap) gives
+ * the whole sequence YUV planes only.
+ */
+struct Sequence {
+    std::mutex lock;
+    std::unique_ptr<threads::Lease> lease;
+    AvifEncoderPtr encoder;
+    AvifImagePtr frame;
+    avifPixelFormat pixelFormat = AVIF_PIXEL_FORMAT_YUV420;
+    int maxDimension = 0;
+    int frameCount = 0;
+    bool alpha = false;  // valid once frameCount > 0
+    bool finished = false;
+};
+
+Sequence* fromHandle(jlong handle) {
+    return reinterpret_cast<Sequence*>(static_cast<intptr_t>(handle));
+}
+
+/**
+ * Convert one frame into sequence->frame, reusing its planes when the layout matches
+ */
+bool convertFrame(Sequence* sequence, const RgbSource& source, int width, int height) {
+    uint32_t dstWidth;
+    uint32_t dstHeight;
+    resample::scaledSize(width, height, sequence->maxDimension, sequence->maxDimension, 0, &dstWidth, &dstHeight);
+
+    const bool sourceAlpha = avifRGBFormatHasAlpha(source.format);
+    if (sequence->frameCount == 0) {
+        sequence->alpha = sourceAlpha && !isOpaqueSource(source, width, height);
+    } else if (sourceAlpha && !sequence->alpha && !isOpaqueSource(source, width, height)) {
+        LOGW("Frame %d has alpha but the sequence started opaque; dropping it", sequence->frameCount);
+    }
+
+    // Planes always follow sequence->alpha, so only the size decides reuse
+    avifImage* frame = sequence->frame.get();
+    bool scaled = dstWidth != static_cast<uint32_t>(width) || dstHeight != static_cast<uint32_t>(height);
+    if (frame && !scaled && frame->width == dstWidth && frame->height == dstHeight) {
+        return convertRgbIntoImage(frame, source) == AVIF_RESULT_OK;
+    }
+
+    AlphaPlane alpha = sequence->alpha ? AlphaPlane::ALWAYS : AlphaPlane::NEVER;
+    sequence->frame = createScaledImageFromRgb(source, width, height, dstWidth, dstHeight, sequence->pixelFormat,
+                                               resample::Filter::AUTO, false, alpha);
+    return sequence->frame != nullptr;
+}
+
+/**
+ * Encode the converted frame into the sequence
+ */
+bool addConvertedFrame(Sequence* sequence, jlong duration, bool forceKeyframe) {
+    avifEncoder* encoder = sequence->encoder.get();
+    avifAddImageFlags flags = forceKeyframe ? AVIF_ADD_IMAGE_FLAG_FORCE_KEYFRAME : AVIF_ADD_IMAGE_FLAG_NONE;
+    avifResult result = avifEncoderAddImage(encoder, sequence->frame.get(),
+                                            static_cast<uint64_t>(duration > 0 ? duration : 1), flags);
+    if (result != AVIF_RESULT_OK) {
+        LOGE("Failed to add frame %d: %s", sequence->frameCount, avifResultToString(result));
+        return false;
+    }
+    sequence->frameCount++;
+    LOGD("Added frame %d: %ux%u, duration=%lld", sequence->frameCount - 1,
+         sequence->frame->width, sequence->frame->height, static_cast<long long>(duration));
+    return true;
+}
+
+/**
+ * Resolve a handle, logging when it is invalid
+ */
+Sequence* openSequence(jlong handle) {
+    Sequence* sequence = fromHandle(handle);
+    if (!sequence) {
+        LOGE("Invalid sequence encoder handle");
+    }
+    return sequence;
+}
+
+/**
+ * Finish the bitstream; the encoder cannot take frames afterwards
+ */
+bool finishSequence(Sequence* sequence, ScopedRWData* output) {
+    if (sequence->finished || sequence->frameCount == 0) {
+        LOGE("Cannot finish sequence: %s", sequence->finished ? "already finished" : "no frames added");
+        return false;
+    }
+    sequence->finished = true;
+    sequence->frame.reset();
+
+    avifResult result = avifEncoderFinish(sequence->encoder.get(), &output->data);
+    sequence->lease.reset();
+    if (result != AVIF_RESULT_OK) {
+        LOGE("Failed to finish sequence: %s", avifResultToString(result));
+        return false;
+    }
+    LOGI("Encoded AVIF sequence: %d frames, output size=%zu bytes", sequence->frameCount, output->data.size);
+    return true;
+}
+
+} // namespace
+#endif
+
+extern "C" {
+
+/**
+ * Create a sequence encoder
+ * timescale: ticks per second for frame durations; keyframeInterval: 0 = codec default;
+ * repetitionCount: -1 = loop forever. Returns 0 on failure.
+ */
+JNIEXPORT jlong JNICALL
+Java_com_alfikri_rizky_avifkit_AvifAnimationEncoder_nativeCreate(
+    JNIEnv* /* env */,
+    jobject /* this */,
+    jint quality,
+    jint speed,
+    jint subsample,
+    jint maxDimension,
+    jlong timescale,
+    jint keyframeInterval,
+    jint repetitionCount) {
+
+#if HAVE_LIBAVIF
+    if (encoderCodecName()[0] == '\0') {
+        LOGE("No encoder codec available! AOM codec not found.");
+        return 0;
+    }
+
+    auto* sequence = new Sequence();
+    sequence->encoder.reset(avifEncoderCreate());
+    if (!sequence->encoder) {
+        LOGE("Failed to create AVIF encoder");
+        delete sequence;
+        return 0;
+    }
+
+    EncodeSettings defaults;
+    avifEncoder* encoder = sequence->encoder.get();
+    encoder->quality = quality;
+    encoder->qualityAlpha = quality;
+    encoder->speed = speed;
+    encoder->codecChoice = defaults.codecChoice;
+    encoder->timescale = static_cast<uint64_t>(timescale > 0 ? timescale : 1000);
+    encoder->keyframeInterval = keyframeInterval;
+    encoder->repetitionCount = repetitionCount;
+    sequence->lease.reset(new threads::Lease());
+    encoder->maxThreads = sequence->lease->count();
+
+    sequence->pixelFormat = pixelFormatFromSubsample(subsample);
+    sequence->maxDimension = maxDimension;
+
+    LOGI("Created AVIF sequence encoder: quality=%d, speed=%d, timescale=%llu, keyframeInterval=%d",
+         quality, speed, static_cast<unsigned long long>(encoder->timescale), keyframeInterval);
+    return static_cast<jlong>(reinterpret_cast<intptr_t>(sequence));
+#else
+    LOGW("PLACEHOLDER: libavif not available, sequence encoding not supported");
+    return 0;
+#endif
+}
+
+/**
+ * Append a frame from a locked ARGB_8888 Bitmap (pixels are only locked during conversion)
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_alfikri_rizky_avifkit_AvifAnimationEncoder_nativeAddBitmap(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong handle,
+    jobject bitmap,
+    jlong duration,
+    jboolean forceKeyframe) {
+
+#if HAVE_LIBAVIF
+    Sequence* sequence = openSequence(handle);
+    if (!sequence) {
+        return JNI_FALSE;
+    }
+    std::lock_guard<std::mutex> guard(sequence->lock);
+    if (sequence->finished) {
+        LOGE("Sequence already finished");
+        return JNI_FALSE;
+    }
+
+    {
+        ScopedBitmapPixels bitmapPixels(env, bitmap);
+        if (!bitmapPixels.pixels()) {
+            return JNI_FALSE;
+        }
+        RgbSource source;
+        source.pixels = bitmapPixels.pixels();
+        source.rowBytes = bitmapPixels.info().stride;
+        source.format = AVIF_RGB_FORMAT_RGBA;
+        source.alphaPremultiplied = bitmapPixels.premultiplied();
+        if (!convertFrame(sequence, source, bitmapPixels.info().width, bitmapPixels.info().height)) {
+            return JNI_FALSE;
+        }
+    }
+
+    return addConvertedFrame(sequence, duration, forceKeyframe == JNI_TRUE) ? JNI_TRUE : JNI_FALSE;
+#else
+    return JNI_FALSE;
+#endif
+}
+
+/**
+ * Append a frame from a direct ByteBuffer
+ * channelOrder: 0=RGBA, 1=BGRA, 2=ARGB, 3=ABGR, 4=RGB, 5=BGR (8 bits per channel)
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_alfikri_rizky_avifkit_AvifAnimationEncoder_nativeAddBuffer(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong handle,
+    jobject buffer,
+    jint width,
+    jint height,
+    jint rowBytes,
+    jint channelOrder,
+    jboolean alphaPremultiplied,
+    jlong duration,
+    jboolean forceKeyframe) {
+
+#if HAVE_LIBAVIF
+    Sequence* sequence = openSequence(handle);
+    if (!sequence) {
+        return JNI_FALSE;
+    }
+    std::lock_guard<std::mutex> guard(sequence->lock);
+    if (sequence->finished) {
+        LOGE("Sequence already finished");
+        return JNI_FALSE;
+    }
+
+    avifRGBFormat format;
+    if (!rgbFormatFromChannelOrder(channelOrder, &format)) {
+        LOGE("Unsupported channel order: %d", channelOrder);
+        return JNI_FALSE;
+    }
+
+    void* address = env->GetDirectBufferAddress(buffer);
+    jlong capacity = env->GetDirectBufferCapacity(buffer);
+    jlong pixelBytes = static_cast<jlong>(width) * avifRGBFormatChannelCount(format);
+    if (!address || width <= 0 || height <= 0 || rowBytes < pixelBytes ||
+        capacity < static_cast<jlong>(rowBytes) * (height - 1) + pixelBytes) {
+        LOGE("Invalid frame buffer: capacity=%lld, %dx%d, rowBytes=%d",
+             static_cast<long long>(capacity), width, height, rowBytes);
+        return JNI_FALSE;
+    }
+
+    RgbSource source;
+    source.pixels = static_cast<const uint8_t*>(address);
+    source.rowBytes = rowBytes;
+    source.format = format;
+    source.alphaPremultiplied = alphaPremultiplied == JNI_TRUE;
+    if (!convertFrame(sequence, source, width, height)) {
+        return JNI_FALSE;
+    }
+
+    return addConvertedFrame(sequence, duration, forceKeyframe == JNI_TRUE) ? JNI_TRUE : JNI_FALSE;
+#else
+    return JNI_FALSE;
+#endif
+}
+
+/**
+ * Finish the sequence and return the bitstream as a Java byte array
+ */
+JNIEXPORT jbyteArray JNICALL
+Java_com_alfikri_rizky_avifkit_AvifAnimationEncoder_nativeFinish(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong handle) {
+
+#if HAVE_LIBAVIF
+    Sequence* sequence = openSequence(handle);
+    if (!sequence) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> guard(sequence->lock);
+
+    ScopedRWData output;
+    if (!finishSequence(sequence, &output)) {
+        return nullptr;
+    }
+    return toJavaByteArray(env, output.data);
+#else
+    return nullptr;
+#endif
+}
+
+/**
+ * Finish the sequence and write it straight to a file (temporary file + rename)
+ * Returns the number of bytes written, or -1 on failure.
+ */
+JNIEXPORT jlong JNICALL
+Java_com_alfikri_rizky_avifkit_AvifAnimationEncoder_nativeFinishToPath(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong handle,
+    jstring path,
+    jboolean sync) {
+
+#if HAVE_LIBAVIF
+    Sequence* sequence = openSequence(handle);
+    if (!sequence) {
+        return -1;
+    }
+    std::lock_guard<std::mutex> guard(sequence->lock);
+
+    ScopedRWData output;
+    if (!finishSequence(sequence, &output)) {
+        return -1;
+    }
+
+    const char* pathChars = env->GetStringUTFChars(path, nullptr);
+    if (!pathChars) {
+        return -1;
+    }
+    bool ok = io::writeFile(pathChars, output.data.data, output.data.size, sync == JNI_TRUE, true);
+    env->ReleaseStringUTFChars(path, pathChars);
+    return ok ? static_cast<jlong>(output.data.size) : -1;
+#else
+    return -1;
+#endif
+}
+
+/**
+ * Release the encoder (discarding frames if the sequence was never finished)
+ */
+JNIEXPORT void JNICALL
+Java_com_alfikri_rizky_avifkit_AvifAnimationEncoder_nativeClose(
+    JNIEnv* /* env */,
+    jobject /* this */,
+    jlong handle) {
+
+#if HAVE_LIBAVIF
+    delete fromHandle(handle);
+#endif
+}
+
+} // extern "C"
@@ -0,0 +1,343 @@
+#include "avif_common.h"
+#include "avif_io.h"
+#include "avif_orientation.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using namespace avifkit;
+
+#if HAVE_LIBAVIF
+namespace {
+
+/**
+ * Native back half of the batch conversion pipeline
+ *
+ * Callers (one per decode worker) convert a bitmap to YUV and submit it; the
+ * YUV image waits in a bounded queue until an encoder thread picks it up,
+ * encodes it and writes it to its output path. Results are queued for the
+ * collector, so a failed item never stops the batch. The bounded queue is
+ * the back-pressure that keeps decoding from running ahead of encoding.
+ */
+class Batch {
+public:
+    Batch(const EncodeSettings& settings, avifPixelFormat pixelFormat, int maxDimension,
+          int workers, int capacity)
+        : settings_(settings), pixelFormat_(pixelFormat), maxDimension_(maxDimension),
+          capacity_(static_cast<size_t>(capacity)) {
+        for (int i = 0; i < workers; i++) {
+            threads_.emplace_back(&Batch::work, this);
+        }
+    }
+
+    ~Batch() {
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            aborted_ = true;
+            inputClosed_ = true;
+            queue_.clear();
+        }
+        notEmpty_.notify_all();
+        notFull_.notify_all();
+        for (std::thread& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    avifPixelFormat pixelFormat() const { return pixelFormat_; }
+    bool lossless() const { return settings_.lossless; }
+    int maxDimension() const { return maxDimension_; }
+
+    /**
+     * Queue a converted image, blocking while the queue is full
+     */
+    bool submit(int index, AvifImagePtr image, std::string outputPath) {
+        std::unique_lock<std::mutex> guard(lock_);
+        notFull_.wait(guard, [this] { return queue_.size() < capacity_ || aborted_; });
+        if (aborted_ || inputClosed_) {
+            return false;
+        }
+        queue_.push_back(Item{index, std::move(image), std::move(outputPath)});
+        pending_++;
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    /**
+     * No more submissions; workers exit once the queue is drained
+     */
+    void closeInput() {
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            inputClosed_ = true;
+        }
+        notEmpty_.notify_all();
+        resultReady_.notify_all();
+    }
+
+    /**
+     * Wait up to timeoutMs for a finished item
+     * Returns 1 with a result, 0 on timeout, -1 once input is closed and everything is reported.
+     */
+    int poll(int timeoutMs, int* index, int64_t* bytes) {
+        std::unique_lock<std::mutex> guard(lock_);
+        auto finished = [this] { return !results_.empty() || (inputClosed_ && pending_ == 0); };
+        if (!resultReady_.wait_for(guard, std::chrono::milliseconds(timeoutMs), finished)) {
+            return 0;
+        }
+        if (results_.empty()) {
+            return -1;
+        }
+        *index = results_.front().index;
+        *bytes = results_.front().bytes;
+        results_.pop_front();
+        return 1;
+    }
+
+private:
+    struct Item {
+        int index;
+        AvifImagePtr image;
+        std::string outputPath;
+    };
+    struct Result {
+        int index;
+        int64_t bytes;  // -1 on failure
+    };
+
+    void work() {
+        while (true) {
+            Item item;
+            {
+                std::unique_lock<std::mutex> guard(lock_);
+                notEmpty_.wait(guard, [this] { return !queue_.empty() || inputClosed_; });
+                if (queue_.empty()) {
+                    return;
+                }
+                item = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            notFull_.notify_one();
+
+            int64_t bytes = encodeAndWrite(item);
+            {
+                std::lock_guard<std::mutex> guard(lock_);
+                results_.push_back(Result{item.index, bytes});
+                pending_--;
+            }
+            resultReady_.notify_all();
+        }
+    }
+
+    int64_t encodeAndWrite(Item& item) {
+        ScopedRWData output;
+        avifResult result = encodeImage(item.image.get(), settings_, &output.data);
+        item.image.reset();  // planes are no longer needed while writing
+        if (result != AVIF_RESULT_OK) {
+            LOGE("Batch item %d: failed to encode: %s", item.index, avifResultToString(result));
+            return -1;
+        }
+        if (!io::writeFile(item.outputPath.c_str(), output.data.data, output.data.size, false, true)) {
+            LOGE("Batch item %d: failed to write %s", item.index, item.outputPath.c_str());
+            return -1;
+        }
+        LOGD("Batch item %d: %zu bytes -> %s", item.index, output.data.size, item.outputPath.c_str());
+        return static_cast<int64_t>(output.data.size);
+    }
+
+    const EncodeSettings settings_;
+    const avifPixelFormat pixelFormat_;
+    const int maxDimension_;
+    const size_t capacity_;
+
+    std::mutex lock_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+    std::condition_variable resultReady_;
+    std::deque<Item> queue_;
+    std::deque<Result> results_;
+    int pending_ = 0;
+    bool inputClosed_ = false;
+    bool aborted_ = false;
+    std::vector<std::thread> threads_;
+};
+
+Batch* fromHandle(jlong handle) {
+    return reinterpret_cast<Batch*>(static_cast<intptr_t>(handle));
+}
+
+} // namespace
+#endif
+
+extern "C" {
+
+/**
+ * Start the encode/write stage of a batch conversion
+ * workers encoder threads run concurrently, each encode leasing its share of the
+ * thread budget; queueCapacity bounds the converted images waiting for an encoder.
+ * Returns 0 on failure.
+ */
+JNIEXPORT jlong JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeBatchCreate(
+    JNIEnv* /* env */,
+    jobject /* this */,
+    jint quality,
+    jint alphaQuality,
+    jint speed,
+    jint subsample,
+    jboolean lossless,
+    jint maxDimension,
+    jint workers,
+    jint queueCapacity) {
+
+#if HAVE_LIBAVIF
+    if (encoderCodecName()[0] == '\0') {
+        LOGE("No encoder codec available! AOM codec not found.");
+        return 0;
+    }
+
+    workers = std::max(1, workers);
+    EncodeSettings settings;
+    settings.quality = quality;
+    settings.qualityAlpha = alphaQuality;
+    settings.speed = speed;
+    settings.lossless = lossless == JNI_TRUE;
+
+    LOGI("Batch pipeline: %d encoder workers, queue=%d", workers, queueCapacity);
+    auto* batch = new Batch(settings, pixelFormatFromSubsample(subsample), maxDimension,
+                            workers, std::max(1, queueCapacity));
+    return static_cast<jlong>(reinterpret_cast<intptr_t>(batch));
+#else
+    LOGW("PLACEHOLDER: libavif not available, batch conversion not supported");
+    return 0;
+#endif
+}
+
+/**
+ * Convert a bitmap to YUV on the calling thread and queue it for encoding
+ * Blocks while the queue is full. The bitmap is only needed until this returns.
+ * orientation (Exif 1-8) is stored as irot/imir, exif (or null) as Exif metadata and
+ * icc (or null) as the colour profile.
+ * Returns false if the conversion failed or the batch was closed.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeBatchSubmit(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong handle,
+    jint index,
+    jobject bitmap,
+    jint orientation,
+    jbyteArray exif,
+    jbyteArray icc,
+    jstring outputPath) {
+
+#if HAVE_LIBAVIF
+    Batch* batch = fromHandle(handle);
+    if (!batch) {
+        LOGE("Invalid batch handle");
+        return JNI_FALSE;
+    }
+
+    AvifImagePtr image;
+    {
+        ScopedBitmapPixels bitmapPixels(env, bitmap);
+        if (!bitmapPixels.pixels()) {
+            return JNI_FALSE;
+        }
+        const AndroidBitmapInfo& info = bitmapPixels.info();
+        RgbSource source;
+        source.pixels = bitmapPixels.pixels();
+        source.rowBytes = info.stride;
+        source.format = AVIF_RGB_FORMAT_RGBA;
+        source.alphaPremultiplied = bitmapPixels.premultiplied();
+
+        uint32_t dstWidth;
+        uint32_t dstHeight;
+        resample::scaledSize(info.width, info.height, batch->maxDimension(), batch->maxDimension(), 0,
+                             &dstWidth, &dstHeight);
+        image = createScaledImageFromRgb(source, info.width, info.height, dstWidth, dstHeight,
+                                         batch->pixelFormat(), resample::Filter::AUTO, batch->lossless());
+    }
+    if (!image || !orientation::setSourceMetadata(env, image.get(), orientation, exif, icc)) {
+        return JNI_FALSE;
+    }
+
+    const char* pathChars = env->GetStringUTFChars(outputPath, nullptr);
+    if (!pathChars) {
+        return JNI_FALSE;
+    }
+    std::string path(pathChars);
+    env->ReleaseStringUTFChars(outputPath, pathChars);
+
+    return batch->submit(index, std::move(image), std::move(path)) ? JNI_TRUE : JNI_FALSE;
+#else
+    return JNI_FALSE;
+#endif
+}
+
+/**
+ * Signal that no more items will be submitted
+ */
+JNIEXPORT void JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeBatchCloseInput(
+    JNIEnv* /* env */,
+    jobject /* this */,
+    jlong handle) {
+
+#if HAVE_LIBAVIF
+    if (Batch* batch = fromHandle(handle)) {
+        batch->closeInput();
+    }
+#endif
+}
+
+/**
+ * Wait up to timeoutMs for a finished item
+ * outResult (2 longs) receives index and bytes written (-1 if the item failed).
+ * Returns 1 with a result, 0 on timeout, -1 when the batch is closed and fully reported.
+ */
+JNIEXPORT jint JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeBatchPoll(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong handle,
+    jint timeoutMs,
+    jlongArray outResult) {
+
+#if HAVE_LIBAVIF
+    Batch* batch = fromHandle(handle);
+    if (!batch || env->GetArrayLength(outResult) < 2) {
+        return -1;
+    }
+    int index = 0;
+    int64_t bytes = -1;
+    int status = batch->poll(timeoutMs, &index, &bytes);
+    if (status == 1) {
+        jlong values[2] = {index, bytes};
+        env->SetLongArrayRegion(outResult, 0, 2, values);
+    }
+    return status;
+#else
+    return -1;
+#endif
+}
+
+/**
+ * Stop the pipeline: queued items are dropped and encoder threads joined
+ */
+JNIEXPORT void JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeBatchDestroy(
+    JNIEnv* /* env */,
+    jobject /* this */,
+    jlong handle) {
+
+#if HAVE_LIBAVIF
+    delete fromHandle(handle);
+#endif
+}
+
+} // extern "C"
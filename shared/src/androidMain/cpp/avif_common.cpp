@@ -0,0 +1,612 @@
+#include "avif_common.h"
+#include "avif_image_kernels.h"
+#include "avif_orientation.h"
+#include "avif_pixel_kernels.h"
+#include "avif_threads.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace avifkit {
+
+void clearPendingException(JNIEnv* env) {
+    if (env->ExceptionCheck()) {
+        env->ExceptionDescribe();
+        env->ExceptionClear();
+    }
+}
+
+jobject newDecodedImage(JNIEnv* env, const int32_t* pixels, int width, int height) {
+    jclass decodedImageClass = env->FindClass("com/alfikri/rizky/avifkit/DecodedImage");
+    if (!decodedImageClass) {
+        LOGE("Failed to find DecodedImage class");
+        clearPendingException(env);
+        return nullptr;
+    }
+
+    jmethodID constructor = env->GetMethodID(decodedImageClass, "<init>", "([III)V");
+    if (!constructor) {
+        LOGE("Failed to find DecodedImage constructor");
+        clearPendingException(env);
+        return nullptr;
+    }
+
+    // Create int array for pixels
+    jsize pixelCount = static_cast<jsize>(width) * height;
+    jintArray pixelArray = env->NewIntArray(pixelCount);
+    if (!pixelArray) {
+        LOGE("Failed to allocate pixel array");
+        return nullptr;
+    }
+
+    env->SetIntArrayRegion(pixelArray, 0, pixelCount, reinterpret_cast<const jint*>(pixels));
+
+    // Create and return DecodedImage object
+    jobject result = env->NewObject(decodedImageClass, constructor, pixelArray, width, height);
+    if (!result) {
+        LOGE("Failed to create DecodedImage object");
+        clearPendingException(env);
+        return nullptr;
+    }
+    return result;
+}
+
+#if HAVE_LIBAVIF
+
+const char* encoderCodecName() {
+    static const char* name = [] {
+        const char* codecName = avifCodecName(AVIF_CODEC_CHOICE_AUTO, AVIF_CODEC_FLAG_CAN_ENCODE);
+        return codecName ? codecName : "";
+    }();
+    return name;
+}
+
+const char* decoderCodecName() {
+    static const char* name = [] {
+        const char* codecName = avifCodecName(AVIF_CODEC_CHOICE_AUTO, AVIF_CODEC_FLAG_CAN_DECODE);
+        return codecName ? codecName : "";
+    }();
+    return name;
+}
+
+avifPixelFormat pixelFormatFromSubsample(jint subsample) {
+    switch (subsample) {
+        case 0: return AVIF_PIXEL_FORMAT_YUV444;
+        case 1: return AVIF_PIXEL_FORMAT_YUV422;
+        case 2:
+        default: return AVIF_PIXEL_FORMAT_YUV420;
+    }
+}
+
+bool isOpaqueSource(const RgbSource& source, int width, int height) {
+    if (!avifRGBFormatHasAlpha(source.format)) {
+        return true;
+    }
+    const int alphaOffset = (source.format == AVIF_RGB_FORMAT_ARGB || source.format == AVIF_RGB_FORMAT_ABGR) ? 0 : 3;
+    return kernels::isOpaque(source.pixels, source.rowBytes, width, height, alphaOffset);
+}
+
+namespace {
+
+/**
+ * Create an image and allocate its planes, with alpha as the policy and source decide
+ * *rgb receives the source to convert from (premultiplication is moot when opaque).
+ */
+AvifImagePtr createImageForSource(const RgbSource& source, int width, int height, uint32_t dstWidth,
+                                  uint32_t dstHeight, avifPixelFormat pixelFormat, bool lossless, AlphaPlane alpha,
+                                  RgbSource* rgb) {
+    AvifImagePtr image(avifImageCreate(dstWidth, dstHeight, 8, lossless ? AVIF_PIXEL_FORMAT_YUV444 : pixelFormat));
+    if (!image) {
+        LOGE("Failed to create AVIF image");
+        return nullptr;
+    }
+    if (lossless) {
+        image->matrixCoefficients = AVIF_MATRIX_COEFFICIENTS_IDENTITY;
+        image->yuvRange = AVIF_RANGE_FULL;
+    }
+
+    *rgb = source;
+    avifPlanesFlags planes = AVIF_PLANES_YUV;
+    if (alpha == AlphaPlane::ALWAYS) {
+        planes |= AVIF_PLANES_A;
+    } else if (alpha == AlphaPlane::IF_TRANSLUCENT && !isOpaqueSource(source, width, height)) {
+        planes |= AVIF_PLANES_A;
+    } else if (alpha == AlphaPlane::IF_TRANSLUCENT && avifRGBFormatHasAlpha(source.format)) {
+        LOGD("Source is opaque, skipping the alpha plane");
+        rgb->alphaPremultiplied = false;
+    }
+    avifResult allocResult = avifImageAllocatePlanes(image.get(), planes);
+    if (allocResult != AVIF_RESULT_OK) {
+        LOGE("Failed to allocate image planes: %s", avifResultToString(allocResult));
+        return nullptr;
+    }
+    return image;
+}
+
+} // namespace
+
+AvifImagePtr createImageFromRgb(const RgbSource& source, int width, int height, avifPixelFormat pixelFormat,
+                                bool lossless, AlphaPlane alpha) {
+    RgbSource rgb;
+    AvifImagePtr image = createImageForSource(source, width, height, width, height, pixelFormat, lossless, alpha,
+                                              &rgb);
+    if (!image || convertRgbIntoImage(image.get(), rgb) != AVIF_RESULT_OK) {
+        return nullptr;
+    }
+    return image;
+}
+
+AvifImagePtr createScaledImageFromRgb(const RgbSource& source, int width, int height,
+                                      uint32_t dstWidth, uint32_t dstHeight, avifPixelFormat pixelFormat,
+                                      resample::Filter filter, bool lossless, AlphaPlane alpha) {
+    if (dstWidth == static_cast<uint32_t>(width) && dstHeight == static_cast<uint32_t>(height)) {
+        return createImageFromRgb(source, width, height, pixelFormat, lossless, alpha);
+    }
+
+    RgbSource rgb;
+    AvifImagePtr image = createImageForSource(source, width, height, dstWidth, dstHeight, pixelFormat, lossless, alpha,
+                                              &rgb);
+    if (!image) {
+        return nullptr;
+    }
+
+    const uint32_t channels = avifRGBFormatChannelCount(rgb.format);
+    filter = resample::resolveFilter(filter, width, height, dstWidth, dstHeight);
+    LOGD("Fused resize %dx%d -> %ux%u (filter=%d)", width, height, dstWidth, dstHeight, static_cast<int>(filter));
+
+    kernels::YuvParams params;
+    if (rgb.format == AVIF_RGB_FORMAT_RGBA &&
+        kernels::useForImage(image.get(), true, rgb.alphaPremultiplied, &params)) {
+        // Collect resampled rows into one chroma block, then convert that strip
+        const uint32_t stripRows = 1u << params.chromaShiftY;
+        const uint32_t stripRowBytes = dstWidth * 4;
+        std::vector<uint8_t> strip(static_cast<size_t>(stripRowBytes) * stripRows);
+        const kernels::Yuv8Planes planes = kernels::planesOf(image.get());
+
+        resample::scale8Rows(rgb.pixels, rgb.rowBytes, width, height, dstWidth, dstHeight, channels, filter,
+                             [&](uint32_t y, const uint8_t* row) {
+            uint32_t slot = y % stripRows;
+            std::memcpy(strip.data() + static_cast<size_t>(slot) * stripRowBytes, row, stripRowBytes);
+            if (slot + 1 < stripRows && y + 1 < dstHeight) {
+                return;
+            }
+
+            uint32_t stripY = y - slot;
+            uint32_t rows = slot + 1;
+            if (rgb.alphaPremultiplied) {
+                // Resampling premultiplied pixels avoids dark fringes; unpremultiply afterwards
+                kernels::unpremultiplyAlpha(strip.data(), static_cast<size_t>(dstWidth) * rows);
+            }
+            kernels::Yuv8Planes at = planes;
+            at.y += static_cast<size_t>(stripY) * planes.yRowBytes;
+            at.u += static_cast<size_t>(stripY >> params.chromaShiftY) * planes.uRowBytes;
+            at.v += static_cast<size_t>(stripY >> params.chromaShiftY) * planes.vRowBytes;
+            if (at.a) at.a += static_cast<size_t>(stripY) * planes.aRowBytes;
+            kernels::rgbaToYuv8(strip.data(), stripRowBytes, dstWidth, rows, params, at);
+        });
+        return image;
+    }
+
+    // Other layouts: resample into a small buffer, then let libavif convert it
+    RgbSource scaled = rgb;
+    scaled.rowBytes = dstWidth * channels;
+    std::vector<uint8_t> pixels(static_cast<size_t>(scaled.rowBytes) * dstHeight);
+    resample::scale8(rgb.pixels, rgb.rowBytes, width, height, pixels.data(), scaled.rowBytes,
+                     dstWidth, dstHeight, channels, filter);
+    scaled.pixels = pixels.data();
+    if (convertRgbIntoImage(image.get(), scaled) != AVIF_RESULT_OK) {
+        return nullptr;
+    }
+    return image;
+}
+
+avifResult convertRgbIntoImage(avifImage* image, const RgbSource& source) {
+    kernels::YuvParams params;
+    if (source.format == AVIF_RGB_FORMAT_RGBA && (image->alphaPlane || !source.alphaPremultiplied) &&
+        kernels::useForImage(image, true, source.alphaPremultiplied, &params)) {
+        kernels::Yuv8Planes planes = kernels::planesOf(image);
+        if (!source.alphaPremultiplied) {
+            kernels::rgbaToYuv8(source.pixels, source.rowBytes, image->width, image->height, params, planes);
+            return AVIF_RESULT_OK;
+        }
+
+        // Unpremultiply a packed copy; the caller's pixels stay untouched
+        uint32_t packedRowBytes = image->width * 4;
+        std::vector<uint8_t> straight(static_cast<size_t>(packedRowBytes) * image->height);
+        for (uint32_t y = 0; y < image->height; y++) {
+            std::memcpy(straight.data() + static_cast<size_t>(y) * packedRowBytes,
+                        source.pixels + static_cast<size_t>(y) * source.rowBytes, packedRowBytes);
+        }
+        kernels::unpremultiplyAlpha(straight.data(), static_cast<size_t>(image->width) * image->height);
+        kernels::rgbaToYuv8(straight.data(), packedRowBytes, image->width, image->height, params, planes);
+        return AVIF_RESULT_OK;
+    }
+
+    // Setup RGB image for conversion, pointing straight at the caller's memory
+    avifRGBImage rgb;
+    avifRGBImageSetDefaults(&rgb, image);
+    rgb.pixels = const_cast<uint8_t*>(source.pixels);
+    rgb.rowBytes = source.rowBytes;
+    rgb.format = source.format;
+    rgb.depth = 8;
+    rgb.alphaPremultiplied = source.alphaPremultiplied ? AVIF_TRUE : AVIF_FALSE;
+
+    // Convert RGB to YUV
+    avifResult convertResult = avifImageRGBToYUV(image, &rgb);
+    if (convertResult != AVIF_RESULT_OK) {
+        LOGE("Failed to convert RGB to YUV: %s", avifResultToString(convertResult));
+    }
+    return convertResult;
+}
+
+namespace {
+
+/**
+ * Create an encoder with the shared parameters and the given codec thread count
+ */
+AvifEncoderPtr createEncoder(const EncodeSettings& settings, int threadCount) {
+    AvifEncoderPtr encoder(avifEncoderCreate());
+    if (!encoder) {
+        LOGE("Failed to create AVIF encoder");
+        return nullptr;
+    }
+
+    // Set encoding parameters
+    if (settings.lossless) {
+        encoder->quality = AVIF_QUALITY_LOSSLESS;
+        encoder->qualityAlpha = AVIF_QUALITY_LOSSLESS;
+    } else {
+        encoder->quality = settings.quality;
+        encoder->qualityAlpha = settings.qualityAlpha >= 0 ? settings.qualityAlpha : settings.quality;
+    }
+    encoder->speed = settings.speed;
+    encoder->codecChoice = settings.codecChoice;
+    encoder->maxThreads = threadCount;
+    return encoder;
+}
+
+avifResult checkEncodedOutput(avifResult result, const avifRWData* output) {
+    if (result == AVIF_RESULT_OK && (output->size == 0 || output->data == nullptr)) {
+        // Empty output means the codec is not linked properly
+        LOGE("Encoder produced empty output! AOM codec may not be linked properly.");
+        return AVIF_RESULT_UNKNOWN_ERROR;
+    }
+    return result;
+}
+
+} // namespace
+
+avifResult encodeImage(const avifImage* image, const EncodeSettings& settings, avifRWData* output) {
+    threads::Lease lease(settings.maxThreads);
+    AvifEncoderPtr encoder = createEncoder(settings, lease.count());
+    if (!encoder) {
+        return AVIF_RESULT_OUT_OF_MEMORY;
+    }
+    return checkEncodedOutput(avifEncoderWrite(encoder.get(), image, output), output);
+}
+
+avifResult encodeGrid(const avifImage* const* cells, uint32_t gridCols, uint32_t gridRows,
+                      const EncodeSettings& settings, avifRWData* output) {
+    threads::Lease lease(settings.maxThreads);
+    AvifEncoderPtr encoder = createEncoder(settings, lease.count());
+    if (!encoder) {
+        return AVIF_RESULT_OUT_OF_MEMORY;
+    }
+
+    avifResult result = avifEncoderAddImageGrid(encoder.get(), gridCols, gridRows, cells, AVIF_ADD_IMAGE_FLAG_SINGLE);
+    if (result != AVIF_RESULT_OK) {
+        LOGE("Failed to add %ux%u image grid: %s", gridCols, gridRows, avifResultToString(result));
+        return result;
+    }
+    return checkEncodedOutput(avifEncoderFinish(encoder.get(), output), output);
+}
+
+jbyteArray toJavaByteArray(JNIEnv* env, const avifRWData& data) {
+    jbyteArray result = env->NewByteArray(data.size);
+    if (!result) {
+        LOGE("Failed to allocate Java byte array for encoded data");
+        return nullptr;
+    }
+    env->SetByteArrayRegion(result, 0, data.size, reinterpret_cast<const jbyte*>(data.data));
+    return result;
+}
+
+void configureDecoder(avifDecoder* decoder, avifCodecChoice codecChoice) {
+    decoder->codecChoice = codecChoice;
+    decoder->ignoreXMP = AVIF_TRUE;
+    decoder->ignoreExif = AVIF_FALSE;  // IMPORTANT: Preserve EXIF for orientation data
+}
+
+avifResult decodeFirstImage(avifDecoder* decoder, const uint8_t* data, size_t size) {
+    if (size >= 16) {
+        LOGD("AVIF data first 16 bytes: %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x",
+             data[0], data[1], data[2], data[3], data[4], data[5], data[6], data[7],
+             data[8], data[9], data[10], data[11], data[12], data[13], data[14], data[15]);
+    }
+
+    avifResult result = avifDecoderSetIOMemory(decoder, data, size);
+    if (result != AVIF_RESULT_OK) {
+        LOGE("Failed to parse AVIF: %s", avifResultToString(result));
+        return result;
+    }
+    return decodeFirstImage(decoder);
+}
+
+avifResult decodeFirstImage(avifDecoder* decoder) {
+    // Codecs are created during parse with the thread count set here
+    threads::Lease lease;
+    decoder->maxThreads = lease.count();
+
+    // Parse the AVIF structure first (also resets any previous state on a reused decoder)
+    avifResult result = avifDecoderParse(decoder);
+    if (result != AVIF_RESULT_OK) {
+        LOGE("Failed in avifDecoderParse: %s", avifResultToString(result));
+        LOGE("Decoder state - imageCount: %d, imageIndex: %d", decoder->imageCount, decoder->imageIndex);
+        return result;
+    }
+
+    LOGD("Parse successful - imageCount: %d, imageIndex: %d", decoder->imageCount, decoder->imageIndex);
+
+    // Decode first image
+    result = avifDecoderNextImage(decoder);
+    if (result != AVIF_RESULT_OK) {
+        LOGE("Failed to decode AVIF: %s", avifResultToString(result));
+        LOGE("After decode - imageCount: %d, imageIndex: %d", decoder->imageCount, decoder->imageIndex);
+        return result;
+    }
+
+    LOGD("Decode successful - image dimensions: %dx%d, depth: %d",
+         decoder->image->width, decoder->image->height, decoder->image->depth);
+    return AVIF_RESULT_OK;
+}
+
+bool rgbFormatFromChannelOrder(jint channelOrder, avifRGBFormat* format) {
+    switch (channelOrder) {
+        case 0: *format = AVIF_RGB_FORMAT_RGBA; return true;
+        case 1: *format = AVIF_RGB_FORMAT_BGRA; return true;
+        case 2: *format = AVIF_RGB_FORMAT_ARGB; return true;
+        case 3: *format = AVIF_RGB_FORMAT_ABGR; return true;
+        case 4: *format = AVIF_RGB_FORMAT_RGB; return true;
+        case 5: *format = AVIF_RGB_FORMAT_BGR; return true;
+        default: return false;
+    }
+}
+
+avifResult convertImageIntoRgb(const avifImage* image, const RgbTarget& target) {
+    kernels::YuvParams params;
+    if (target.format == AVIF_RGB_FORMAT_RGBA &&
+        kernels::useForImage(image, false, target.alphaPremultiplied, &params)) {
+        kernels::yuv8ToRgba(kernels::planesOf(image), image->width, image->height, params, target.pixels,
+                            target.rowBytes);
+        if (target.alphaPremultiplied && image->alphaPlane) {
+            for (uint32_t y = 0; y < image->height; y++) {
+                kernels::premultiplyAlpha(target.pixels + static_cast<size_t>(y) * target.rowBytes, image->width);
+            }
+        }
+        return AVIF_RESULT_OK;
+    }
+
+    avifRGBImage rgb;
+    avifRGBImageSetDefaults(&rgb, image);
+    rgb.format = target.format;
+    rgb.depth = 8;
+    rgb.pixels = target.pixels;
+    rgb.rowBytes = target.rowBytes;
+    rgb.alphaPremultiplied = target.alphaPremultiplied ? AVIF_TRUE : AVIF_FALSE;
+
+    avifResult convertResult = avifImageYUVToRGB(image, &rgb);
+    if (convertResult != AVIF_RESULT_OK) {
+        LOGE("Failed to convert YUV to RGB: %s", avifResultToString(convertResult));
+    }
+    return convertResult;
+}
+
+uint32_t chromaContextRows(const avifImage* image) {
+    return image->yuvFormat == AVIF_PIXEL_FORMAT_YUV420 ? 2 : 0;
+}
+
+avifResult setContextView(avifImage* view, const avifImage* image, uint32_t top, uint32_t rows, uint32_t limit,
+                          uint32_t* skipRows) {
+    const uint32_t context = chromaContextRows(image);
+    const uint32_t first = top >= context ? top - context : 0;
+    const uint32_t end = std::max(top + rows, std::min(top + rows + context, limit));
+    avifCropRect rect = {0, first, image->width, end - first};
+    *skipRows = top - first;
+    return avifImageSetViewRect(view, image, &rect);
+}
+
+namespace {
+
+/**
+ * Bitmap.reconfigure(width, height, ARGB_8888) so a recycled bitmap can take a new frame size
+ */
+bool reconfigureBitmap(JNIEnv* env, jobject bitmap, uint32_t width, uint32_t height) {
+    jclass bitmapClass = env->GetObjectClass(bitmap);
+    jclass configClass = env->FindClass("android/graphics/Bitmap$Config");
+    if (!bitmapClass || !configClass) {
+        clearPendingException(env);
+        return false;
+    }
+    jfieldID argbField = env->GetStaticFieldID(configClass, "ARGB_8888", "Landroid/graphics/Bitmap$Config;");
+    jmethodID reconfigure = env->GetMethodID(bitmapClass, "reconfigure", "(IILandroid/graphics/Bitmap$Config;)V");
+    if (!argbField || !reconfigure) {
+        clearPendingException(env);
+        return false;
+    }
+    jobject argbConfig = env->GetStaticObjectField(configClass, argbField);
+    env->CallVoidMethod(bitmap, reconfigure, static_cast<jint>(width), static_cast<jint>(height), argbConfig);
+    if (env->ExceptionCheck()) {
+        // Allocation too small or bitmap not mutable
+        LOGE("Failed to reconfigure target bitmap to %ux%u", width, height);
+        clearPendingException(env);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool decodedImageIntoBitmap(JNIEnv* env, const avifImage* image, jobject bitmap, int exifOrientation) {
+    uint32_t width;
+    uint32_t height;
+    orientation::displaySize(exifOrientation, image->width, image->height, &width, &height);
+
+    AndroidBitmapInfo info;
+    if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS) {
+        LOGE("Failed to get bitmap info");
+        return false;
+    }
+    if (info.width != width || info.height != height ||
+        info.format != ANDROID_BITMAP_FORMAT_RGBA_8888) {
+        if (!reconfigureBitmap(env, bitmap, width, height) ||
+            AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS) {
+            return false;
+        }
+    }
+
+    void* pixels = nullptr;
+    if (AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS || !pixels) {
+        LOGE("Failed to lock bitmap pixels");
+        return false;
+    }
+
+    RgbTarget target;
+    target.pixels = static_cast<uint8_t*>(pixels);
+    target.rowBytes = info.stride;
+    target.format = AVIF_RGB_FORMAT_RGBA;
+    target.alphaPremultiplied =
+        (info.flags & ANDROID_BITMAP_FLAGS_ALPHA_MASK) == ANDROID_BITMAP_FLAGS_ALPHA_PREMUL;
+
+    avifResult convertResult = orientation::convertImageIntoRgb(image, exifOrientation, target);
+    AndroidBitmap_unlockPixels(env, bitmap);
+    return convertResult == AVIF_RESULT_OK;
+}
+
+bool decodedImageIntoBuffer(JNIEnv* env, const avifImage* image, bool alphaPresent, jobject buffer,
+                            jint rowBytes, jint channelOrder, jintArray outInfo, int exifOrientation) {
+    uint32_t width;
+    uint32_t height;
+    orientation::displaySize(exifOrientation, image->width, image->height, &width, &height);
+
+    if (outInfo && env->GetArrayLength(outInfo) >= 3) {
+        jint info[3] = {
+            static_cast<jint>(width),
+            static_cast<jint>(height),
+            alphaPresent ? 1 : 0
+        };
+        env->SetIntArrayRegion(outInfo, 0, 3, info);
+    }
+
+    avifRGBFormat format;
+    if (!rgbFormatFromChannelOrder(channelOrder, &format)) {
+        LOGE("Unsupported channel order: %d", channelOrder);
+        return false;
+    }
+
+    void* address = env->GetDirectBufferAddress(buffer);
+    jlong capacity = env->GetDirectBufferCapacity(buffer);
+    if (!address || capacity < 0) {
+        LOGE("Buffer is not a direct ByteBuffer");
+        return false;
+    }
+
+    jlong pixelBytes = static_cast<jlong>(width) * avifRGBFormatChannelCount(format);
+    if (rowBytes < pixelBytes ||
+        capacity < static_cast<jlong>(rowBytes) * (height - 1) + pixelBytes) {
+        LOGW("Target buffer too small for %ux%u: capacity=%lld, rowBytes=%d",
+             width, height, static_cast<long long>(capacity), rowBytes);
+        return false;
+    }
+
+    RgbTarget target;
+    target.pixels = static_cast<uint8_t*>(address);
+    target.rowBytes = rowBytes;
+    target.format = format;
+    return orientation::convertImageIntoRgb(image, exifOrientation, target) == AVIF_RESULT_OK;
+}
+
+avifResult convertImageToArgb(const avifImage* image, std::vector<int32_t>& argb, int exifOrientation) {
+    uint32_t width;
+    uint32_t height;
+    orientation::displaySize(exifOrientation, image->width, image->height, &width, &height);
+    size_t pixelCount = static_cast<size_t>(width) * height;
+    argb.resize(pixelCount);
+
+    // Convert straight into the int buffer as RGBA bytes, then swizzle in place
+    RgbTarget target;
+    target.pixels = reinterpret_cast<uint8_t*>(argb.data());
+    target.rowBytes = width * 4;
+    target.format = AVIF_RGB_FORMAT_RGBA;
+    avifResult convertResult = orientation::convertImageIntoRgb(image, exifOrientation, target);
+    if (convertResult != AVIF_RESULT_OK) {
+        return convertResult;
+    }
+
+    // RGBA bytes -> BGRA bytes == ARGB ints on little-endian (Android Bitmap format)
+    kernels::swapRedBlue(target.pixels, target.pixels, pixelCount);
+    return AVIF_RESULT_OK;
+}
+
+AvifImagePtr scaleImage(const avifImage* image, uint32_t width, uint32_t height, resample::Filter filter) {
+    AvifImagePtr scaled(avifImageCreate(width, height, image->depth, image->yuvFormat));
+    if (!scaled) {
+        LOGE("Failed to create scaled image");
+        return nullptr;
+    }
+    scaled->yuvRange = image->yuvRange;
+    scaled->yuvChromaSamplePosition = image->yuvChromaSamplePosition;
+    scaled->colorPrimaries = image->colorPrimaries;
+    scaled->transferCharacteristics = image->transferCharacteristics;
+    scaled->matrixCoefficients = image->matrixCoefficients;
+    scaled->alphaPremultiplied = image->alphaPremultiplied;
+
+    avifPlanesFlags planes = AVIF_PLANES_YUV;
+    if (image->alphaPlane) {
+        planes |= AVIF_PLANES_A;
+    }
+    avifResult allocResult = avifImageAllocatePlanes(scaled.get(), planes);
+    if (allocResult != AVIF_RESULT_OK) {
+        LOGE("Failed to allocate scaled planes: %s", avifResultToString(allocResult));
+        return nullptr;
+    }
+
+    // Pick the filter once from the luma reduction so all planes agree
+    filter = resample::resolveFilter(filter, image->width, image->height, width, height);
+    const bool highBitDepth = image->depth > 8;
+    const uint32_t maxValue = (1u << image->depth) - 1;
+    auto scalePlane = [&](const uint8_t* src, uint32_t srcRowBytes, uint32_t srcW, uint32_t srcH,
+                          uint8_t* dst, uint32_t dstRowBytes, uint32_t dstW, uint32_t dstH) {
+        if (highBitDepth) {
+            resample::scale16(reinterpret_cast<const uint16_t*>(src), srcRowBytes, srcW, srcH,
+                              reinterpret_cast<uint16_t*>(dst), dstRowBytes, dstW, dstH, 1, maxValue, filter);
+        } else {
+            resample::scale8(src, srcRowBytes, srcW, srcH, dst, dstRowBytes, dstW, dstH, 1, filter);
+        }
+    };
+
+    scalePlane(image->yuvPlanes[AVIF_CHAN_Y], image->yuvRowBytes[AVIF_CHAN_Y], image->width, image->height,
+               scaled->yuvPlanes[AVIF_CHAN_Y], scaled->yuvRowBytes[AVIF_CHAN_Y], width, height);
+
+    avifPixelFormatInfo formatInfo;
+    avifGetPixelFormatInfo(image->yuvFormat, &formatInfo);
+    if (!formatInfo.monochrome) {
+        const uint32_t shiftX = formatInfo.chromaShiftX;
+        const uint32_t shiftY = formatInfo.chromaShiftY;
+        for (int channel : {AVIF_CHAN_U, AVIF_CHAN_V}) {
+            scalePlane(image->yuvPlanes[channel], image->yuvRowBytes[channel],
+                       (image->width + shiftX) >> shiftX, (image->height + shiftY) >> shiftY,
+                       scaled->yuvPlanes[channel], scaled->yuvRowBytes[channel],
+                       (width + shiftX) >> shiftX, (height + shiftY) >> shiftY);
+        }
+    }
+
+    if (image->alphaPlane) {
+        scalePlane(image->alphaPlane, image->alphaRowBytes, image->width, image->height,
+                   scaled->alphaPlane, scaled->alphaRowBytes, width, height);
+    }
+    return scaled;
+}
+
+#endif // HAVE_LIBAVIF
+
+} // namespace avifkit
@@ -0,0 +1,326 @@
+#ifndef AVIFKIT_AVIF_COMMON_H
+#define AVIFKIT_AVIF_COMMON_H
+
+#include <jni.h>
+#include <android/bitmap.h>
+#include <android/log.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "avif_resample.h"
+
+// Conditional libavif inclusion
+#if HAVE_LIBAVIF
+#include "avif/avif.h"
+#endif
+
+#define LOG_TAG "AvifJNI"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#ifdef NDEBUG
+#define LOGD(...) ((void)0)
+#else
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#endif
+
+/**
+ * Helpers shared by the JNI entry points (AvifConverter, AvifSession, ...)
+ */
+namespace avifkit {
+
+/**
+ * Log and clear any pending Java exception (e.g. after a failed FindClass)
+ */
+void clearPendingException(JNIEnv* env);
+
+/**
+ * Create a DecodedImage(pixels, width, height) from packed ARGB ints
+ */
+jobject newDecodedImage(JNIEnv* env, const int32_t* pixels, int width, int height);
+
+#if HAVE_LIBAVIF
+
+// RAII owners for libavif objects so multi-step paths can bail out early
+struct AvifImageDeleter {
+    void operator()(avifImage* image) const { avifImageDestroy(image); }
+};
+struct AvifEncoderDeleter {
+    void operator()(avifEncoder* encoder) const { avifEncoderDestroy(encoder); }
+};
+struct AvifDecoderDeleter {
+    void operator()(avifDecoder* decoder) const { avifDecoderDestroy(decoder); }
+};
+using AvifImagePtr = std::unique_ptr<avifImage, AvifImageDeleter>;
+using AvifEncoderPtr = std::unique_ptr<avifEncoder, AvifEncoderDeleter>;
+using AvifDecoderPtr = std::unique_ptr<avifDecoder, AvifDecoderDeleter>;
+
+/**
+ * Owns an avifRWData and frees it on scope exit
+ */
+struct ScopedRWData {
+    avifRWData data = AVIF_DATA_EMPTY;
+    ScopedRWData() = default;
+    ScopedRWData(const ScopedRWData&) = delete;
+    ScopedRWData& operator=(const ScopedRWData&) = delete;
+    ~ScopedRWData() { avifRWDataFree(&data); }
+};
+
+/**
+ * Pins a Java byte array for the lifetime of the scope (released with JNI_ABORT)
+ */
+class ScopedByteArrayElements {
+public:
+    ScopedByteArrayElements(JNIEnv* env, jbyteArray array)
+        : env_(env), array_(array),
+          elements_(array ? env->GetByteArrayElements(array, nullptr) : nullptr),
+          length_(array ? env->GetArrayLength(array) : 0) {}
+    ~ScopedByteArrayElements() {
+        if (elements_) env_->ReleaseByteArrayElements(array_, elements_, JNI_ABORT);
+    }
+    ScopedByteArrayElements(const ScopedByteArrayElements&) = delete;
+    ScopedByteArrayElements& operator=(const ScopedByteArrayElements&) = delete;
+
+    const uint8_t* data() const { return reinterpret_cast<const uint8_t*>(elements_); }
+    jsize length() const { return length_; }
+
+private:
+    JNIEnv* env_;
+    jbyteArray array_;
+    jbyte* elements_;
+    jsize length_;
+};
+
+/**
+ * Locks an RGBA_8888 Bitmap's pixels for the lifetime of the scope
+ * With highBitDepth, RGBA_F16 and RGBA_1010102 are accepted instead.
+ * pixels() is nullptr if the bitmap has another format or could not be locked.
+ */
+class ScopedBitmapPixels {
+public:
+    ScopedBitmapPixels(JNIEnv* env, jobject bitmap, bool highBitDepth = false) : env_(env), bitmap_(bitmap) {
+        if (AndroidBitmap_getInfo(env, bitmap, &info_) != ANDROID_BITMAP_RESULT_SUCCESS) {
+            LOGE("Failed to get bitmap info");
+            return;
+        }
+        if (highBitDepth && info_.format != ANDROID_BITMAP_FORMAT_RGBA_F16 &&
+            info_.format != ANDROID_BITMAP_FORMAT_RGBA_1010102) {
+            LOGE("Unsupported bitmap format: %d (expected RGBA_F16 or RGBA_1010102)", info_.format);
+            return;
+        }
+        if (!highBitDepth && info_.format != ANDROID_BITMAP_FORMAT_RGBA_8888) {
+            LOGE("Unsupported bitmap format: %d (expected RGBA_8888)", info_.format);
+            return;
+        }
+        if (AndroidBitmap_lockPixels(env, bitmap, &pixels_) != ANDROID_BITMAP_RESULT_SUCCESS) {
+            LOGE("Failed to lock bitmap pixels");
+            pixels_ = nullptr;
+        }
+    }
+    ~ScopedBitmapPixels() {
+        if (pixels_) AndroidBitmap_unlockPixels(env_, bitmap_);
+    }
+    ScopedBitmapPixels(const ScopedBitmapPixels&) = delete;
+    ScopedBitmapPixels& operator=(const ScopedBitmapPixels&) = delete;
+
+    const uint8_t* pixels() const { return static_cast<const uint8_t*>(pixels_); }
+    uint8_t* mutablePixels() { return static_cast<uint8_t*>(pixels_); }
+    const AndroidBitmapInfo& info() const { return info_; }
+    bool premultiplied() const {
+        return (info_.flags & ANDROID_BITMAP_FLAGS_ALPHA_MASK) == ANDROID_BITMAP_FLAGS_ALPHA_PREMUL;
+    }
+
+private:
+    JNIEnv* env_;
+    jobject bitmap_;
+    AndroidBitmapInfo info_ = {};
+    void* pixels_ = nullptr;
+};
+
+/**
+ * Encoder parameters applied to each avifEncoder
+ */
+struct EncodeSettings {
+    int quality = 75;
+    int qualityAlpha = -1;  // -1 = same as quality
+    int speed = 6;
+    bool lossless = false;  // overrides both qualities; the image must use identity coefficients and 4:4:4
+    int maxThreads = 0;  // upper bound on codec threads; 0 = the job's share of the thread budget
+    avifCodecChoice codecChoice = AVIF_CODEC_CHOICE_AUTO;
+};
+
+/**
+ * Codec names resolved once per process (empty string if none is available)
+ */
+const char* encoderCodecName();
+const char* decoderCodecName();
+
+/**
+ * Map the Kotlin subsample value (0=444, 1=422, 2=420) to a libavif pixel format
+ */
+avifPixelFormat pixelFormatFromSubsample(jint subsample);
+
+/**
+ * Describes caller-owned 8-bit RGB(A) memory (Java array, locked Bitmap or direct buffer)
+ * that can be fed to avifImageRGBToYUV without an intermediate copy
+ */
+struct RgbSource {
+    const uint8_t* pixels = nullptr;
+    uint32_t rowBytes = 0;
+    avifRGBFormat format = AVIF_RGB_FORMAT_RGBA;
+    bool alphaPremultiplied = false;
+};
+
+/**
+ * Which images get an alpha plane
+ */
+enum class AlphaPlane {
+    IF_TRANSLUCENT,  // when the source format carries alpha and some pixel is not fully opaque
+    ALWAYS,          // even for opaque or alpha-less sources (filled with opaque alpha)
+    NEVER            // source alpha is dropped
+};
+
+/**
+ * Create an 8-bit YUV(A) image from RGB(A) pixels
+ * By default the alpha plane is only allocated when the source format carries alpha
+ * and at least one pixel is not fully opaque; image sequences, whose frames must all
+ * agree, pass ALWAYS or NEVER. lossless stores RGB with identity matrix coefficients
+ * in 4:4:4 (pixelFormat is ignored), as lossless encoding requires.
+ * Returns nullptr (and logs) on failure
+ */
+AvifImagePtr createImageFromRgb(const RgbSource& source, int width, int height, avifPixelFormat pixelFormat,
+                                bool lossless = false, AlphaPlane alpha = AlphaPlane::IF_TRANSLUCENT);
+
+/**
+ * Create an 8-bit YUV(A) image of dstWidth x dstHeight from larger RGB(A) pixels
+ * The downscale is fused with RGB->YUV: resampled rows go straight into the planes,
+ * so the source is read once and no full-size intermediate is allocated. Alpha and
+ * lossless are handled as in createImageFromRgb.
+ * Returns nullptr (and logs) on failure
+ */
+AvifImagePtr createScaledImageFromRgb(const RgbSource& source, int width, int height,
+                                      uint32_t dstWidth, uint32_t dstHeight, avifPixelFormat pixelFormat,
+                                      resample::Filter filter = resample::Filter::AUTO, bool lossless = false,
+                                      AlphaPlane alpha = AlphaPlane::IF_TRANSLUCENT);
+
+/**
+ * True if the source has no alpha channel or every pixel is fully opaque
+ * (vectorized scan that stops at the first translucent row)
+ */
+bool isOpaqueSource(const RgbSource& source, int width, int height);
+
+/**
+ * Convert RGB(A) pixels into an existing image with allocated planes
+ */
+avifResult convertRgbIntoImage(avifImage* image, const RgbSource& source);
+
+/**
+ * Encode an already converted image
+ * A fresh avifEncoder is required per bitstream; libavif encoders are single-use.
+ */
+avifResult encodeImage(const avifImage* image, const EncodeSettings& settings, avifRWData* output);
+
+/**
+ * Encode a gridCols x gridRows grid of cell images (row-major) as one AVIF image
+ * Cells share one size, except the right column and bottom row, which may be
+ * narrower or shorter. Cells are compressed one after another, each using the
+ * job's codec threads.
+ */
+avifResult encodeGrid(const avifImage* const* cells, uint32_t gridCols, uint32_t gridRows,
+                      const EncodeSettings& settings, avifRWData* output);
+
+/**
+ * Copy encoded bytes into a new Java byte array
+ */
+jbyteArray toJavaByteArray(JNIEnv* env, const avifRWData& data);
+
+/**
+ * Apply the default decoder options (metadata handling)
+ * Codec threads are leased from the thread budget when the decode runs.
+ */
+void configureDecoder(avifDecoder* decoder, avifCodecChoice codecChoice);
+
+/**
+ * Point the decoder at in-memory AVIF data, parse it and decode the first image
+ * On success decoder->image holds the decoded frame.
+ */
+avifResult decodeFirstImage(avifDecoder* decoder, const uint8_t* data, size_t size);
+
+/**
+ * Parse and decode the first image from the IO already set on the decoder
+ * (e.g. a file descriptor reader from avif_io.h)
+ * decoder->maxThreads is set from a thread budget lease held for the decode.
+ */
+avifResult decodeFirstImage(avifDecoder* decoder);
+
+/**
+ * Map the Kotlin ChannelOrder value (0=RGBA, 1=BGRA, 2=ARGB, 3=ABGR, 4=RGB, 5=BGR)
+ * to a libavif RGB format
+ */
+bool rgbFormatFromChannelOrder(jint channelOrder, avifRGBFormat* format);
+
+/**
+ * Describes caller-owned 8-bit memory that decoded pixels are written into
+ */
+struct RgbTarget {
+    uint8_t* pixels = nullptr;
+    uint32_t rowBytes = 0;
+    avifRGBFormat format = AVIF_RGB_FORMAT_RGBA;
+    bool alphaPremultiplied = false;
+};
+
+/**
+ * Convert a decoded image straight into caller memory (single write of the final layout)
+ */
+avifResult convertImageIntoRgb(const avifImage* image, const RgbTarget& target);
+
+/**
+ * Rows of context a strip needs on each side to convert to RGB like the whole image
+ * Bilinear 4:2:0 upsampling blends in the neighbouring chroma row, up to two luma
+ * rows away; other formats need none.
+ */
+uint32_t chromaContextRows(const avifImage* image);
+
+/**
+ * Point view at rows [top, top + rows) of image plus chromaContextRows on each side
+ * The context is clipped to rows [0, limit), e.g. the rows decoded so far. top must
+ * be even for 4:2:0. *skipRows receives the context rows above top, where row top
+ * starts in the view; only the rows after them match the whole-image conversion.
+ */
+avifResult setContextView(avifImage* view, const avifImage* image, uint32_t top, uint32_t rows, uint32_t limit,
+                          uint32_t* skipRows);
+
+/**
+ * Write a decoded image into a mutable ARGB_8888 Bitmap
+ * The bitmap is reconfigured to the displayed size when needed (its allocation must be
+ * large enough). exifOrientation (see avif_orientation.h) is applied during conversion.
+ */
+bool decodedImageIntoBitmap(JNIEnv* env, const avifImage* image, jobject bitmap, int exifOrientation = 1);
+
+/**
+ * Write a decoded image into a direct ByteBuffer
+ * outInfo (optional, 3 ints) receives the displayed width, height and hasAlpha, also
+ * when the buffer is too small so the caller can grow it.
+ */
+bool decodedImageIntoBuffer(JNIEnv* env, const avifImage* image, bool alphaPresent, jobject buffer,
+                            jint rowBytes, jint channelOrder, jintArray outInfo, int exifOrientation = 1);
+
+/**
+ * Convert a decoded image to packed ARGB ints (Android Bitmap layout)
+ * argb is resized as needed so callers can reuse it between calls. With an
+ * exifOrientation other than 1 the pixels are laid out in the displayed size.
+ */
+avifResult convertImageToArgb(const avifImage* image, std::vector<int32_t>& argb, int exifOrientation = 1);
+
+/**
+ * Downscale every plane of a decoded image (YUV and alpha) to width x height
+ * Done before YUV->RGB, so no full-resolution RGB buffer is ever allocated.
+ */
+AvifImagePtr scaleImage(const avifImage* image, uint32_t width, uint32_t height, resample::Filter filter);
+
+#endif // HAVE_LIBAVIF
+
+} // namespace avifkit
+
+#endif // AVIFKIT_AVIF_COMMON_H
@@ -0,0 +1,368 @@
+#include "avif_common.h"
+#include "avif_io.h"
+#include "avif_threads.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+using namespace avifkit;
+
+#if HAVE_LIBAVIF
+namespace {
+
+// A grid item stores rows and columns minus one in a byte
+constexpr uint32_t kMaxGridCells = 256;
+constexpr uint32_t kMinCellSize = 64;
+
+/**
+ * Grid encode state behind a handle
+ *
+ * The image is split into cellWidth x cellHeight cells that are filled from
+ * RGBA row strips as they arrive, top to bottom. Only the YUV cells and the
+ * caller's current strip are resident; the full-frame RGBA image never exists.
+ * Cells get alpha planes only when the first translucent strip arrives.
+ */
+struct Grid {
+    std::mutex lock;
+    EncodeSettings settings;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t cellWidth = 0;
+    uint32_t cellHeight = 0;
+    uint32_t cols = 0;
+    uint32_t rows = 0;
+    std::vector<AvifImagePtr> cells;  // row-major
+    uint32_t rowsFilled = 0;
+    bool alpha = false;  // cells have alpha planes
+    bool finished = false;
+};
+
+Grid* fromHandle(jlong handle) {
+    return reinterpret_cast<Grid*>(static_cast<intptr_t>(handle));
+}
+
+/**
+ * Smallest even cell size >= requested that keeps the grid within kMaxGridCells
+ */
+uint32_t cellSizeFor(uint32_t extent, uint32_t requested) {
+    uint32_t size = std::max(kMinCellSize, requested & ~1u);
+    uint32_t minimum = (extent + kMaxGridCells - 1) / kMaxGridCells;
+    if (size < minimum) {
+        size = (minimum + 1) & ~1u;
+    }
+    return std::min(size, std::max(extent, 1u));
+}
+
+/**
+ * Convert image rows [top, top + count) of one cell column from the strip
+ */
+bool convertColumn(Grid* grid, uint32_t col, const RgbSource& strip, uint32_t top, uint32_t count) {
+    const uint32_t x = col * grid->cellWidth;
+    for (uint32_t y = top; y < top + count;) {
+        const uint32_t cellRow = y / grid->cellHeight;
+        const uint32_t cellTop = cellRow * grid->cellHeight;
+        const uint32_t rowsInCell = std::min(top + count, cellTop + grid->cellHeight) - y;
+        avifImage* cell = grid->cells[cellRow * grid->cols + col].get();
+
+        // A view over the cell rows this strip covers; it writes into the cell's planes
+        AvifImagePtr view(avifImageCreateEmpty());
+        avifCropRect rect = {0, y - cellTop, cell->width, rowsInCell};
+        if (!view || avifImageSetViewRect(view.get(), cell, &rect) != AVIF_RESULT_OK) {
+            LOGE("Failed to create view of cell (%u, %u)", col, cellRow);
+            return false;
+        }
+
+        RgbSource source = strip;
+        source.pixels = strip.pixels + static_cast<size_t>(y - top) * strip.rowBytes + static_cast<size_t>(x) * 4;
+        if (convertRgbIntoImage(view.get(), source) != AVIF_RESULT_OK) {
+            return false;
+        }
+        y += rowsInCell;
+    }
+    return true;
+}
+
+/**
+ * Give every cell an alpha plane, opaque for the rows filled so far
+ */
+bool addAlphaPlanes(Grid* grid) {
+    for (const AvifImagePtr& cell : grid->cells) {
+        if (avifImageAllocatePlanes(cell.get(), AVIF_PLANES_A) != AVIF_RESULT_OK) {
+            LOGE("Failed to allocate grid alpha planes");
+            return false;
+        }
+        for (uint32_t y = 0; y < cell->height; y++) {
+            std::memset(cell->alphaPlane + static_cast<size_t>(y) * cell->alphaRowBytes, 255, cell->width);
+        }
+    }
+    grid->alpha = true;
+    LOGD("Grid turned translucent at row %u; added alpha planes", grid->rowsFilled);
+    return true;
+}
+
+/**
+ * Convert a strip into every cell column, spreading the columns over the job's threads
+ */
+bool convertStrip(Grid* grid, const RgbSource& strip, uint32_t top, uint32_t count) {
+    threads::Lease lease;
+    const uint32_t workers = std::min<uint32_t>(static_cast<uint32_t>(lease.count()), grid->cols);
+    std::atomic<uint32_t> nextColumn(0);
+    std::atomic<bool> ok(true);
+    auto work = [&]() {
+        for (uint32_t col = nextColumn++; col < grid->cols && ok; col = nextColumn++) {
+            if (!convertColumn(grid, col, strip, top, count)) {
+                ok = false;
+            }
+        }
+    };
+
+    std::vector<std::thread> helpers;
+    for (uint32_t i = 1; i < workers; i++) {
+        helpers.emplace_back(work);
+    }
+    work();
+    for (std::thread& helper : helpers) {
+        helper.join();
+    }
+    return ok;
+}
+
+/**
+ * Encode the completed grid; cells are released afterwards
+ */
+bool finishGrid(Grid* grid, ScopedRWData* output) {
+    if (grid->finished || grid->rowsFilled != grid->height) {
+        LOGE("Cannot finish grid: %s", grid->finished ? "already finished" : "rows missing");
+        return false;
+    }
+    grid->finished = true;
+
+    std::vector<const avifImage*> cells;
+    cells.reserve(grid->cells.size());
+    for (const AvifImagePtr& cell : grid->cells) {
+        cells.push_back(cell.get());
+    }
+    avifResult result = encodeGrid(cells.data(), grid->cols, grid->rows, grid->settings, &output->data);
+    grid->cells.clear();
+    if (result != AVIF_RESULT_OK) {
+        LOGE("Failed to encode grid: %s", avifResultToString(result));
+        return false;
+    }
+    LOGI("Encoded AVIF grid: %ux%u as %ux%u cells of %ux%u, output size=%zu bytes",
+         grid->width, grid->height, grid->cols, grid->rows, grid->cellWidth, grid->cellHeight, output->data.size);
+    return true;
+}
+
+} // namespace
+#endif
+
+extern "C" {
+
+/**
+ * Start a grid encode of a width x height image
+ * cellSize is rounded to an even size of at least 64 and grown if the grid would
+ * exceed 256 cells per side. All YUV planes are allocated up front, so an image
+ * too large for memory fails here rather than after decoding; alpha planes are
+ * added by the first translucent strip. Returns 0 on failure.
+ */
+JNIEXPORT jlong JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeGridCreate(
+    JNIEnv* /* env */,
+    jobject /* this */,
+    jint width,
+    jint height,
+    jint cellSize,
+    jint quality,
+    jint alphaQuality,
+    jint speed,
+    jint subsample,
+    jboolean lossless) {
+
+#if HAVE_LIBAVIF
+    if (encoderCodecName()[0] == '\0') {
+        LOGE("No encoder codec available! AOM codec not found.");
+        return 0;
+    }
+    if (width <= 0 || height <= 0) {
+        LOGE("Invalid grid image size: %dx%d", width, height);
+        return 0;
+    }
+
+    std::unique_ptr<Grid> grid(new Grid());
+    grid->settings.quality = quality;
+    grid->settings.qualityAlpha = alphaQuality;
+    grid->settings.speed = speed;
+    grid->settings.lossless = lossless == JNI_TRUE;
+    grid->width = static_cast<uint32_t>(width);
+    grid->height = static_cast<uint32_t>(height);
+    grid->cellWidth = cellSizeFor(grid->width, static_cast<uint32_t>(cellSize));
+    grid->cellHeight = cellSizeFor(grid->height, static_cast<uint32_t>(cellSize));
+    grid->cols = (grid->width + grid->cellWidth - 1) / grid->cellWidth;
+    grid->rows = (grid->height + grid->cellHeight - 1) / grid->cellHeight;
+
+    const avifPixelFormat pixelFormat = lossless == JNI_TRUE ? AVIF_PIXEL_FORMAT_YUV444 : pixelFormatFromSubsample(subsample);
+    grid->cells.reserve(static_cast<size_t>(grid->cols) * grid->rows);
+    for (uint32_t row = 0; row < grid->rows; row++) {
+        for (uint32_t col = 0; col < grid->cols; col++) {
+            const uint32_t cellWidth = std::min(grid->cellWidth, grid->width - col * grid->cellWidth);
+            const uint32_t cellHeight = std::min(grid->cellHeight, grid->height - row * grid->cellHeight);
+            AvifImagePtr cell(avifImageCreate(cellWidth, cellHeight, 8, pixelFormat));
+            if (cell && lossless == JNI_TRUE) {
+                cell->matrixCoefficients = AVIF_MATRIX_COEFFICIENTS_IDENTITY;
+                cell->yuvRange = AVIF_RANGE_FULL;
+            }
+            if (!cell || avifImageAllocatePlanes(cell.get(), AVIF_PLANES_YUV) != AVIF_RESULT_OK) {
+                LOGE("Failed to allocate grid cell (%u, %u)", col, row);
+                return 0;
+            }
+            grid->cells.push_back(std::move(cell));
+        }
+    }
+
+    LOGI("Created AVIF grid encoder: %dx%d as %ux%u cells of %ux%u", width, height,
+         grid->cols, grid->rows, grid->cellWidth, grid->cellHeight);
+    return static_cast<jlong>(reinterpret_cast<intptr_t>(grid.release()));
+#else
+    LOGW("PLACEHOLDER: libavif not available, grid encoding not supported");
+    return 0;
+#endif
+}
+
+/**
+ * Fill image rows [top, top + rowCount) from rows starting at sourceTop of an ARGB_8888 Bitmap
+ * Strips must arrive in order and, except for the last one, span an even number of rows.
+ * The bitmap must be at least as wide as the image and is only needed until this returns.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeGridAddRows(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong handle,
+    jobject bitmap,
+    jint sourceTop,
+    jint top,
+    jint rowCount) {
+
+#if HAVE_LIBAVIF
+    Grid* grid = fromHandle(handle);
+    if (!grid) {
+        LOGE("Invalid grid handle");
+        return JNI_FALSE;
+    }
+    std::lock_guard<std::mutex> guard(grid->lock);
+
+    const uint32_t end = static_cast<uint32_t>(top) + static_cast<uint32_t>(rowCount);
+    if (grid->finished || top < 0 || rowCount <= 0 || static_cast<uint32_t>(top) != grid->rowsFilled ||
+        end > grid->height || (end != grid->height && (rowCount & 1))) {
+        LOGE("Invalid grid strip: top=%d, rows=%d (filled=%u, height=%u)", top, rowCount, grid->rowsFilled, grid->height);
+        return JNI_FALSE;
+    }
+
+    ScopedBitmapPixels bitmapPixels(env, bitmap);
+    if (!bitmapPixels.pixels()) {
+        return JNI_FALSE;
+    }
+    const AndroidBitmapInfo& info = bitmapPixels.info();
+    if (info.width < grid->width || sourceTop < 0 || static_cast<uint32_t>(sourceTop + rowCount) > info.height) {
+        LOGE("Strip bitmap %ux%u does not cover rows %d..%d", info.width, info.height, sourceTop, sourceTop + rowCount);
+        return JNI_FALSE;
+    }
+
+    RgbSource strip;
+    strip.pixels = bitmapPixels.pixels() + static_cast<size_t>(sourceTop) * info.stride;
+    strip.rowBytes = info.stride;
+    strip.format = AVIF_RGB_FORMAT_RGBA;
+    strip.alphaPremultiplied = bitmapPixels.premultiplied();
+    if (!grid->alpha && !isOpaqueSource(strip, static_cast<int>(grid->width), rowCount) && !addAlphaPlanes(grid)) {
+        return JNI_FALSE;
+    }
+    if (!convertStrip(grid, strip, static_cast<uint32_t>(top), static_cast<uint32_t>(rowCount))) {
+        return JNI_FALSE;
+    }
+    grid->rowsFilled = end;
+    return JNI_TRUE;
+#else
+    return JNI_FALSE;
+#endif
+}
+
+/**
+ * Encode the filled grid and return the bitstream as a Java byte array
+ */
+JNIEXPORT jbyteArray JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeGridFinish(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong handle) {
+
+#if HAVE_LIBAVIF
+    Grid* grid = fromHandle(handle);
+    if (!grid) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> guard(grid->lock);
+
+    ScopedRWData output;
+    if (!finishGrid(grid, &output)) {
+        return nullptr;
+    }
+    return toJavaByteArray(env, output.data);
+#else
+    return nullptr;
+#endif
+}
+
+/**
+ * Encode the filled grid and write it straight to a file (temporary file + rename)
+ * Returns the number of bytes written, or -1 on failure.
+ */
+JNIEXPORT jlong JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeGridFinishToPath(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong handle,
+    jstring path,
+    jboolean sync) {
+
+#if HAVE_LIBAVIF
+    Grid* grid = fromHandle(handle);
+    if (!grid) {
+        return -1;
+    }
+    std::lock_guard<std::mutex> guard(grid->lock);
+
+    ScopedRWData output;
+    if (!finishGrid(grid, &output)) {
+        return -1;
+    }
+
+    const char* pathChars = env->GetStringUTFChars(path, nullptr);
+    if (!pathChars) {
+        return -1;
+    }
+    bool ok = io::writeFile(pathChars, output.data.data, output.data.size, sync == JNI_TRUE, true);
+    env->ReleaseStringUTFChars(path, pathChars);
+    return ok ? static_cast<jlong>(output.data.size) : -1;
+#else
+    return -1;
+#endif
+}
+
+/**
+ * Release the grid (discarding the cells if it was never finished)
+ */
+JNIEXPORT void JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeGridClose(
+    JNIEnv* /* env */,
+    jobject /* this */,
+    jlong handle) {
+
+#if HAVE_LIBAVIF
+    delete fromHandle(handle);
+#endif
+}
+
+} // extern "C"
@@ -0,0 +1,453 @@
+#include "avif_common.h"
+#include "avif_orientation.h"
+
+#include <algorithm>
+
+using namespace avifkit;
+
+#if HAVE_LIBAVIF
+namespace {
+
+// RGBA_1010102 is repacked through a 16-bit strip of this many rows (even, so
+// 4:2:0 views start on a chroma row), plus chroma context when decoding
+constexpr uint32_t kPackedStripRows = 64;
+
+/**
+ * Android RGBA_1010102 pixel: R in the low 10 bits, then G, B and a 2-bit alpha
+ */
+void unpackRow1010102(const uint8_t* src, uint32_t width, uint16_t* dst) {
+    const uint32_t* packed = reinterpret_cast<const uint32_t*>(src);
+    for (uint32_t x = 0; x < width; x++) {
+        uint32_t pixel = packed[x];
+        dst[0] = static_cast<uint16_t>(pixel & 0x3FF);
+        dst[1] = static_cast<uint16_t>((pixel >> 10) & 0x3FF);
+        dst[2] = static_cast<uint16_t>((pixel >> 20) & 0x3FF);
+        dst[3] = static_cast<uint16_t>((pixel >> 30) * 341);  // 2 -> 10 bits
+        dst += 4;
+    }
+}
+
+void packRow1010102(const uint16_t* src, uint32_t width, uint8_t* dst) {
+    uint32_t* packed = reinterpret_cast<uint32_t*>(dst);
+    for (uint32_t x = 0; x < width; x++) {
+        uint32_t alpha = (static_cast<uint32_t>(src[3]) * 3 + 511) / 1023;  // 10 -> 2 bits
+        packed[x] = src[0] | (static_cast<uint32_t>(src[1]) << 10) | (static_cast<uint32_t>(src[2]) << 20) | (alpha << 30);
+        src += 4;
+    }
+}
+
+/**
+ * Describes caller-owned RGBA pixels wider than 8 bits per channel
+ */
+enum class HighDepthLayout {
+    UINT16,       // 4 x uint16 per pixel, full 16-bit range
+    HALF_FLOAT,   // 4 x half float per pixel (RGBA_F16), 0..1
+    PACKED_1010102
+};
+
+struct HighDepthPixels {
+    uint8_t* pixels = nullptr;
+    uint32_t rowBytes = 0;
+    HighDepthLayout layout = HighDepthLayout::UINT16;
+    bool alphaPremultiplied = false;
+};
+
+bool layoutFromBitmapFormat(int32_t format, HighDepthLayout* layout) {
+    switch (format) {
+        case ANDROID_BITMAP_FORMAT_RGBA_F16: *layout = HighDepthLayout::HALF_FLOAT; return true;
+        case ANDROID_BITMAP_FORMAT_RGBA_1010102: *layout = HighDepthLayout::PACKED_1010102; return true;
+        default: return false;
+    }
+}
+
+/**
+ * True if every pixel's alpha is at its maximum (1.0 or above for half floats)
+ */
+bool isOpaqueHighDepth(const HighDepthPixels& pixels, int width, int height) {
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = pixels.pixels + static_cast<size_t>(y) * pixels.rowBytes;
+        for (int x = 0; x < width; x++) {
+            switch (pixels.layout) {
+                case HighDepthLayout::UINT16:
+                    if (reinterpret_cast<const uint16_t*>(row)[x * 4 + 3] != 0xFFFF) return false;
+                    break;
+                case HighDepthLayout::HALF_FLOAT: {
+                    // Positive halfs order like integers; 0x3C00 is 1.0, 0x7C00 and up are inf/NaN
+                    uint16_t alpha = reinterpret_cast<const uint16_t*>(row)[x * 4 + 3];
+                    if (alpha < 0x3C00 || alpha >= 0x7C00) return false;
+                    break;
+                }
+                case HighDepthLayout::PACKED_1010102:
+                    if ((reinterpret_cast<const uint32_t*>(row)[x] >> 30) != 3) return false;
+                    break;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Convert RGB(A) <-> YUV(A) in strips, going through a 16-bit buffer for packed pixels
+ * RGB -> YUV needs no context; YUV -> RGB converts each strip with its chroma context
+ * and packs only its own rows, so strip edges match a conversion of the whole image.
+ */
+avifResult convertPacked(avifImage* image, const HighDepthPixels& pixels, bool toYuv) {
+    const uint32_t context = toYuv ? 0 : chromaContextRows(image);
+    std::vector<uint16_t> strip(static_cast<size_t>(image->width) * 4 * (kPackedStripRows + 2 * context));
+    for (uint32_t top = 0; top < image->height; top += kPackedStripRows) {
+        const uint32_t rows = std::min(kPackedStripRows, image->height - top);
+        AvifImagePtr view(avifImageCreateEmpty());
+        uint32_t skipRows = 0;
+        avifResult viewResult = AVIF_RESULT_OUT_OF_MEMORY;
+        if (view) {
+            avifCropRect rect = {0, top, image->width, rows};
+            viewResult = toYuv ? avifImageSetViewRect(view.get(), image, &rect)
+                               : setContextView(view.get(), image, top, rows, image->height, &skipRows);
+        }
+        if (viewResult != AVIF_RESULT_OK) {
+            LOGE("Failed to create view of rows %u..%u", top, top + rows);
+            return AVIF_RESULT_OUT_OF_MEMORY;
+        }
+
+        avifRGBImage rgb;
+        avifRGBImageSetDefaults(&rgb, view.get());
+        rgb.format = AVIF_RGB_FORMAT_RGBA;
+        rgb.depth = 10;
+        rgb.pixels = reinterpret_cast<uint8_t*>(strip.data());
+        rgb.rowBytes = image->width * 4 * sizeof(uint16_t);
+        rgb.alphaPremultiplied = pixels.alphaPremultiplied ? AVIF_TRUE : AVIF_FALSE;
+
+        uint8_t* first = pixels.pixels + static_cast<size_t>(top) * pixels.rowBytes;
+        avifResult result;
+        if (toYuv) {
+            for (uint32_t y = 0; y < rows; y++) {
+                unpackRow1010102(first + static_cast<size_t>(y) * pixels.rowBytes, image->width,
+                                 strip.data() + static_cast<size_t>(y) * image->width * 4);
+            }
+            result = avifImageRGBToYUV(view.get(), &rgb);
+        } else {
+            result = avifImageYUVToRGB(view.get(), &rgb);
+            for (uint32_t y = 0; result == AVIF_RESULT_OK && y < rows; y++) {
+                packRow1010102(strip.data() + static_cast<size_t>(skipRows + y) * image->width * 4, image->width,
+                               first + static_cast<size_t>(y) * pixels.rowBytes);
+            }
+        }
+        if (result != AVIF_RESULT_OK) {
+            LOGE("Failed to convert rows %u..%u: %s", top, top + rows, avifResultToString(result));
+            return result;
+        }
+    }
+    return AVIF_RESULT_OK;
+}
+
+avifResult convertHighDepth(avifImage* image, const HighDepthPixels& pixels, bool toYuv) {
+    if (pixels.layout == HighDepthLayout::PACKED_1010102) {
+        return convertPacked(image, pixels, toYuv);
+    }
+
+    // 16-bit layouts are read and written in place
+    avifRGBImage rgb;
+    avifRGBImageSetDefaults(&rgb, image);
+    rgb.format = AVIF_RGB_FORMAT_RGBA;
+    rgb.depth = 16;
+    rgb.isFloat = pixels.layout == HighDepthLayout::HALF_FLOAT ? AVIF_TRUE : AVIF_FALSE;
+    rgb.pixels = pixels.pixels;
+    rgb.rowBytes = pixels.rowBytes;
+    rgb.alphaPremultiplied = pixels.alphaPremultiplied ? AVIF_TRUE : AVIF_FALSE;
+
+    avifResult result = toYuv ? avifImageRGBToYUV(image, &rgb) : avifImageYUVToRGB(image, &rgb);
+    if (result != AVIF_RESULT_OK) {
+        LOGE("Failed to convert %s: %s", toYuv ? "RGB to YUV" : "YUV to RGB", avifResultToString(result));
+    }
+    return result;
+}
+
+/**
+ * Create a depth-bit YUV(A) image tagged with the given CICP colour primaries and transfer
+ * The alpha plane is only allocated if some pixel is not fully opaque.
+ */
+AvifImagePtr createHighDepthImage(const HighDepthPixels& pixels, int width, int height, int depth,
+                                  avifPixelFormat pixelFormat, jint colorPrimaries, jint transfer) {
+    if (depth != 10 && depth != 12) {
+        LOGE("Unsupported bit depth: %d (expected 10 or 12)", depth);
+        return nullptr;
+    }
+    AvifImagePtr image(avifImageCreate(width, height, depth, pixelFormat));
+    if (!image) {
+        LOGE("Failed to create AVIF image");
+        return nullptr;
+    }
+    image->colorPrimaries = static_cast<avifColorPrimaries>(colorPrimaries);
+    image->transferCharacteristics = static_cast<avifTransferCharacteristics>(transfer);
+    if (colorPrimaries == AVIF_COLOR_PRIMARIES_BT2020) {
+        image->matrixCoefficients = AVIF_MATRIX_COEFFICIENTS_BT2020_NCL;
+    }
+
+    // Opaque sources get no alpha plane (and so no alpha item in the file)
+    bool opaque = isOpaqueHighDepth(pixels, width, height);
+    avifResult allocResult = avifImageAllocatePlanes(image.get(), opaque ? AVIF_PLANES_YUV : AVIF_PLANES_ALL);
+    if (allocResult != AVIF_RESULT_OK) {
+        LOGE("Failed to allocate image planes: %s", avifResultToString(allocResult));
+        return nullptr;
+    }
+    if (opaque) {
+        LOGD("Source is opaque, skipping the alpha plane");
+    }
+    if (convertHighDepth(image.get(), pixels, true) != AVIF_RESULT_OK) {
+        return nullptr;
+    }
+    return image;
+}
+
+/**
+ * Convert a decoded image into high depth pixels of the displayed size
+ */
+avifResult convertHighDepthOriented(avifImage* image, int exifOrientation, const HighDepthPixels& pixels) {
+    if (exifOrientation == 1) {
+        return convertHighDepth(image, pixels, false);
+    }
+    const uint32_t pixelBytes = pixels.layout == HighDepthLayout::PACKED_1010102 ? 4 : 8;
+    HighDepthPixels strip = pixels;
+    return orientation::convertOriented(image, exifOrientation, pixelBytes, pixels.pixels, pixels.rowBytes,
+                                        [&strip](avifImage* view, uint8_t* stripPixels, uint32_t stripRowBytes) {
+        strip.pixels = stripPixels;
+        strip.rowBytes = stripRowBytes;
+        return convertHighDepth(view, strip, false);
+    });
+}
+
+/**
+ * Bitmap.reconfigure(width, height, getConfig()) for a bitmap sized for the stored orientation
+ */
+bool reconfigureKeepingConfig(JNIEnv* env, jobject bitmap, uint32_t width, uint32_t height) {
+    jclass bitmapClass = env->GetObjectClass(bitmap);
+    jmethodID getConfig = env->GetMethodID(bitmapClass, "getConfig", "()Landroid/graphics/Bitmap$Config;");
+    jmethodID reconfigure = env->GetMethodID(bitmapClass, "reconfigure", "(IILandroid/graphics/Bitmap$Config;)V");
+    if (!getConfig || !reconfigure) {
+        clearPendingException(env);
+        return false;
+    }
+    jobject config = env->CallObjectMethod(bitmap, getConfig);
+    if (config) {
+        env->CallVoidMethod(bitmap, reconfigure, static_cast<jint>(width), static_cast<jint>(height), config);
+    }
+    if (!config || env->ExceptionCheck()) {
+        LOGE("Failed to reconfigure target bitmap to %ux%u", width, height);
+        clearPendingException(env);
+        return false;
+    }
+    return true;
+}
+
+jbyteArray encodeHighDepth(JNIEnv* env, const avifImage* image, jint quality, jint speed) {
+    EncodeSettings settings;
+    settings.quality = quality;
+    settings.speed = speed;
+
+    ScopedRWData output;
+    avifResult result = encodeImage(image, settings, &output.data);
+    if (result != AVIF_RESULT_OK) {
+        LOGE("Failed to encode %u-bit image: %s", image->depth, avifResultToString(result));
+        return nullptr;
+    }
+    LOGI("Encoded %u-bit AVIF: %ux%u, output size=%zu bytes", image->depth, image->width, image->height,
+         output.data.size);
+    return toJavaByteArray(env, output.data);
+}
+
+} // namespace
+#endif
+
+extern "C" {
+
+/**
+ * Encode 16-bit-per-channel RGBA from a direct ByteBuffer as a 10- or 12-bit AVIF
+ * halfFloat selects half-float samples (0..1) instead of uint16 (0..65535).
+ * colorPrimaries and transfer are CICP codes written to the nclx colr box; BT.2020
+ * primaries also select BT.2020 matrix coefficients.
+ */
+JNIEXPORT jbyteArray JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeEncodeHighDepthBuffer(
+    JNIEnv* env,
+    jobject /* this */,
+    jobject buffer,
+    jint width,
+    jint height,
+    jint rowBytes,
+    jboolean halfFloat,
+    jboolean alphaPremultiplied,
+    jint depth,
+    jint colorPrimaries,
+    jint transfer,
+    jint quality,
+    jint speed,
+    jint subsample) {
+
+    LOGI("nativeEncodeHighDepthBuffer: %dx%d, rowBytes=%d, halfFloat=%d, depth=%d, cicp=%d/%d",
+         width, height, rowBytes, halfFloat, depth, colorPrimaries, transfer);
+
+#if HAVE_LIBAVIF
+    if (encoderCodecName()[0] == '\0') {
+        LOGE("No encoder codec available! AOM codec not found.");
+        return nullptr;
+    }
+
+    void* address = env->GetDirectBufferAddress(buffer);
+    jlong capacity = env->GetDirectBufferCapacity(buffer);
+    if (!address || capacity < 0) {
+        LOGE("Buffer is not a direct ByteBuffer");
+        return nullptr;
+    }
+    jlong pixelBytes = static_cast<jlong>(width) * 8;
+    if (width <= 0 || height <= 0 || rowBytes < pixelBytes ||
+        capacity < static_cast<jlong>(rowBytes) * (height - 1) + pixelBytes) {
+        LOGE("Buffer too small or invalid geometry: capacity=%lld, %dx%d, rowBytes=%d",
+             static_cast<long long>(capacity), width, height, rowBytes);
+        return nullptr;
+    }
+
+    HighDepthPixels pixels;
+    pixels.pixels = static_cast<uint8_t*>(address);
+    pixels.rowBytes = rowBytes;
+    pixels.layout = halfFloat == JNI_TRUE ? HighDepthLayout::HALF_FLOAT : HighDepthLayout::UINT16;
+    pixels.alphaPremultiplied = alphaPremultiplied == JNI_TRUE;
+
+    AvifImagePtr image = createHighDepthImage(pixels, width, height, depth, pixelFormatFromSubsample(subsample),
+                                              colorPrimaries, transfer);
+    if (!image) {
+        return nullptr;
+    }
+    return encodeHighDepth(env, image.get(), quality, speed);
+#else
+    LOGW("PLACEHOLDER: libavif not available, high bit depth encoding not supported");
+    return nullptr;
+#endif
+}
+
+/**
+ * Encode an RGBA_F16 or RGBA_1010102 Bitmap as a 10- or 12-bit AVIF
+ * The pixels are read in place (RGBA_1010102 through a small strip buffer).
+ */
+JNIEXPORT jbyteArray JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeEncodeHighDepthBitmap(
+    JNIEnv* env,
+    jobject /* this */,
+    jobject bitmap,
+    jint depth,
+    jint colorPrimaries,
+    jint transfer,
+    jint quality,
+    jint speed,
+    jint subsample) {
+
+#if HAVE_LIBAVIF
+    if (encoderCodecName()[0] == '\0') {
+        LOGE("No encoder codec available! AOM codec not found.");
+        return nullptr;
+    }
+
+    ScopedBitmapPixels bitmapPixels(env, bitmap, true);
+    if (!bitmapPixels.pixels()) {
+        return nullptr;
+    }
+    const AndroidBitmapInfo& info = bitmapPixels.info();
+
+    HighDepthPixels pixels;
+    if (!layoutFromBitmapFormat(info.format, &pixels.layout)) {
+        LOGE("Unsupported high bit depth bitmap format: %d", info.format);
+        return nullptr;
+    }
+    pixels.pixels = bitmapPixels.mutablePixels();
+    pixels.rowBytes = info.stride;
+    pixels.alphaPremultiplied = bitmapPixels.premultiplied();
+
+    AvifImagePtr image = createHighDepthImage(pixels, info.width, info.height, depth,
+                                              pixelFormatFromSubsample(subsample), colorPrimaries, transfer);
+    if (!image) {
+        return nullptr;
+    }
+    return encodeHighDepth(env, image.get(), quality, speed);
+#else
+    LOGW("PLACEHOLDER: libavif not available, high bit depth encoding not supported");
+    return nullptr;
+#endif
+}
+
+/**
+ * Decode into a caller-supplied RGBA_F16 or RGBA_1010102 Bitmap of the displayed size
+ * Samples keep the image's transfer function; the caller tags the bitmap with the
+ * matching ColorSpace. RGBA_1010102 costs 4 bytes per pixel, like ARGB_8888.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeDecodeHighDepthIntoBitmap(
+    JNIEnv* env,
+    jobject /* this */,
+    jbyteArray avifData,
+    jobject bitmap) {
+
+#if HAVE_LIBAVIF
+    if (decoderCodecName()[0] == '\0') {
+        LOGE("No decoder codec available! AOM decoder not found.");
+        return JNI_FALSE;
+    }
+    ScopedByteArrayElements data(env, avifData);
+    if (!data.data()) {
+        LOGE("Failed to get AVIF data");
+        return JNI_FALSE;
+    }
+
+    AvifDecoderPtr decoder(avifDecoderCreate());
+    if (!decoder) {
+        LOGE("Failed to create AVIF decoder");
+        return JNI_FALSE;
+    }
+    configureDecoder(decoder.get(), AVIF_CODEC_CHOICE_AUTO);
+    if (decodeFirstImage(decoder.get(), data.data(), data.length()) != AVIF_RESULT_OK) {
+        return JNI_FALSE;
+    }
+    avifImage* image = decoder->image;
+    const int exifOrientation = orientation::displayOrientation(image);
+    uint32_t width;
+    uint32_t height;
+    orientation::displaySize(exifOrientation, image->width, image->height, &width, &height);
+
+    // The probe only sees irot/imir; an Exif-only rotation arrives with width and height swapped
+    AndroidBitmapInfo bitmapInfo;
+    if (AndroidBitmap_getInfo(env, bitmap, &bitmapInfo) == ANDROID_BITMAP_RESULT_SUCCESS &&
+        bitmapInfo.width == height && bitmapInfo.height == width && width != height &&
+        !reconfigureKeepingConfig(env, bitmap, width, height)) {
+        return JNI_FALSE;
+    }
+
+    ScopedBitmapPixels bitmapPixels(env, bitmap, true);
+    if (!bitmapPixels.pixels()) {
+        return JNI_FALSE;
+    }
+    const AndroidBitmapInfo& info = bitmapPixels.info();
+    if (info.width != width || info.height != height) {
+        LOGE("Bitmap %ux%u does not match image %ux%u", info.width, info.height, width, height);
+        return JNI_FALSE;
+    }
+
+    HighDepthPixels pixels;
+    if (!layoutFromBitmapFormat(info.format, &pixels.layout)) {
+        LOGE("Unsupported high bit depth bitmap format: %d", info.format);
+        return JNI_FALSE;
+    }
+    pixels.pixels = bitmapPixels.mutablePixels();
+    pixels.rowBytes = info.stride;
+    pixels.alphaPremultiplied = bitmapPixels.premultiplied();
+    if (convertHighDepthOriented(image, exifOrientation, pixels) != AVIF_RESULT_OK) {
+        return JNI_FALSE;
+    }
+    LOGD("Decoded %u-bit AVIF into %s bitmap: %ux%u (orientation %d)", image->depth,
+         pixels.layout == HighDepthLayout::HALF_FLOAT ? "RGBA_F16" : "RGBA_1010102", width, height,
+         exifOrientation);
+    return JNI_TRUE;
+#else
+    LOGW("PLACEHOLDER: libavif not available, high bit depth decoding not supported");
+    return JNI_FALSE;
+#endif
+}
+
+} // extern "C"
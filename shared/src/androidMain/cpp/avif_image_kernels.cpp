@@ -0,0 +1,167 @@
+#include "avif_image_kernels.h"
+
+#if HAVE_LIBAVIF
+
+#include <android/log.h>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#define IMAGE_KERNELS_LOG_TAG "AvifJNI"
+#define IKLOGW(...) __android_log_print(ANDROID_LOG_WARN, IMAGE_KERNELS_LOG_TAG, __VA_ARGS__)
+
+namespace avifkit {
+namespace kernels {
+
+namespace {
+
+struct ImageDeleter {
+    void operator()(avifImage* image) const { avifImageDestroy(image); }
+};
+using ImagePtr = std::unique_ptr<avifImage, ImageDeleter>;
+
+bool planeEquals(const uint8_t* a, uint32_t aRowBytes, const uint8_t* b, uint32_t bRowBytes,
+                 uint32_t width, uint32_t height) {
+    for (uint32_t y = 0; y < height; y++) {
+        if (std::memcmp(a + static_cast<size_t>(y) * aRowBytes, b + static_cast<size_t>(y) * bRowBytes, width) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Run libavif and the kernels on the same odd-sized synthetic tile and compare
+ */
+bool outputMatchesLibavif(const avifImage* like, const YuvParams& params, bool toYuv, bool premultiplied) {
+    const uint32_t width = 37;
+    const uint32_t height = 11;
+    std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+    uint32_t state = 0x9E3779B9u;
+    for (uint8_t& value : rgba) {
+        state = state * 1664525u + 1013904223u;
+        value = static_cast<uint8_t>(state >> 24);
+    }
+
+    auto makeImage = [&]() {
+        ImagePtr image(avifImageCreate(width, height, 8, like->yuvFormat));
+        if (image) {
+            image->matrixCoefficients = like->matrixCoefficients;
+            image->yuvRange = like->yuvRange;
+            if (avifImageAllocatePlanes(image.get(), AVIF_PLANES_ALL) != AVIF_RESULT_OK) {
+                image.reset();
+            }
+        }
+        return image;
+    };
+
+    ImagePtr reference = makeImage();
+    if (!reference) return false;
+    avifRGBImage rgb;
+    avifRGBImageSetDefaults(&rgb, reference.get());
+    rgb.format = AVIF_RGB_FORMAT_RGBA;
+    rgb.depth = 8;
+    rgb.pixels = rgba.data();
+    rgb.rowBytes = width * 4;
+    rgb.alphaPremultiplied = (toYuv && premultiplied) ? AVIF_TRUE : AVIF_FALSE;
+    if (avifImageRGBToYUV(reference.get(), &rgb) != AVIF_RESULT_OK) return false;
+
+    if (toYuv) {
+        ImagePtr candidate = makeImage();
+        if (!candidate) return false;
+        std::vector<uint8_t> straight(rgba);
+        if (premultiplied) {
+            unpremultiplyAlpha(straight.data(), static_cast<size_t>(width) * height);
+        }
+        rgbaToYuv8(straight.data(), width * 4, width, height, params, planesOf(candidate.get()));
+
+        uint32_t uvWidth = (width + params.chromaShiftX) >> params.chromaShiftX;
+        uint32_t uvHeight = (height + params.chromaShiftY) >> params.chromaShiftY;
+        Yuv8Planes r = planesOf(reference.get());
+        Yuv8Planes c = planesOf(candidate.get());
+        return planeEquals(r.y, r.yRowBytes, c.y, c.yRowBytes, width, height) &&
+               planeEquals(r.u, r.uRowBytes, c.u, c.uRowBytes, uvWidth, uvHeight) &&
+               planeEquals(r.v, r.vRowBytes, c.v, c.vRowBytes, uvWidth, uvHeight) &&
+               planeEquals(r.a, r.aRowBytes, c.a, c.aRowBytes, width, height);
+    }
+
+    std::vector<uint8_t> expected(rgba.size());
+    std::vector<uint8_t> actual(rgba.size());
+    rgb.pixels = expected.data();
+    rgb.alphaPremultiplied = premultiplied ? AVIF_TRUE : AVIF_FALSE;
+    if (avifImageYUVToRGB(reference.get(), &rgb) != AVIF_RESULT_OK) return false;
+    yuv8ToRgba(planesOf(reference.get()), width, height, params, actual.data(), width * 4);
+    if (premultiplied) {
+        premultiplyAlpha(actual.data(), static_cast<size_t>(width) * height);
+    }
+    return expected == actual;
+}
+
+} // namespace
+
+bool paramsForImage(const avifImage* image, YuvParams* params) {
+    if (image->depth != 8 || image->alphaPremultiplied) {
+        return false;
+    }
+    switch (image->yuvFormat) {
+        case AVIF_PIXEL_FORMAT_YUV444: params->chromaShiftX = 0; params->chromaShiftY = 0; break;
+        case AVIF_PIXEL_FORMAT_YUV422: params->chromaShiftX = 1; params->chromaShiftY = 0; break;
+        case AVIF_PIXEL_FORMAT_YUV420: params->chromaShiftX = 1; params->chromaShiftY = 1; break;
+        default: return false;
+    }
+    switch (image->matrixCoefficients) {
+        case AVIF_MATRIX_COEFFICIENTS_BT470BG:
+        case AVIF_MATRIX_COEFFICIENTS_BT601: params->kr = 0.299f; params->kb = 0.114f; break;
+        case AVIF_MATRIX_COEFFICIENTS_BT709: params->kr = 0.2126f; params->kb = 0.0722f; break;
+        case AVIF_MATRIX_COEFFICIENTS_BT2020_NCL: params->kr = 0.2627f; params->kb = 0.0593f; break;
+        default: return false;
+    }
+    params->fullRange = image->yuvRange == AVIF_RANGE_FULL;
+    return true;
+}
+
+Yuv8Planes planesOf(const avifImage* image) {
+    Yuv8Planes planes;
+    planes.y = image->yuvPlanes[AVIF_CHAN_Y];
+    planes.u = image->yuvPlanes[AVIF_CHAN_U];
+    planes.v = image->yuvPlanes[AVIF_CHAN_V];
+    planes.a = image->alphaPlane;
+    planes.yRowBytes = image->yuvRowBytes[AVIF_CHAN_Y];
+    planes.uRowBytes = image->yuvRowBytes[AVIF_CHAN_U];
+    planes.vRowBytes = image->yuvRowBytes[AVIF_CHAN_V];
+    planes.aRowBytes = image->alphaRowBytes;
+    return planes;
+}
+
+bool useForImage(const avifImage* image, bool toYuv, bool premultiplied, YuvParams* params) {
+    if (!paramsForImage(image, params)) {
+        return false;
+    }
+
+    static std::mutex lock;
+    static std::map<uint32_t, bool> verified;
+    uint32_t key = static_cast<uint32_t>(image->yuvFormat) |
+                   (static_cast<uint32_t>(image->matrixCoefficients) << 4) |
+                   (static_cast<uint32_t>(image->yuvRange) << 12) |
+                   (toYuv ? 1u << 13 : 0u) |
+                   (premultiplied ? 1u << 14 : 0u);
+
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = verified.find(key);
+    if (it == verified.end()) {
+        bool matches = outputMatchesLibavif(image, *params, toYuv, premultiplied);
+        if (!matches) {
+            IKLOGW("Pixel kernels differ from libavif (format=%d, matrix=%d, range=%d, %s), using libavif",
+                   image->yuvFormat, image->matrixCoefficients, image->yuvRange, toYuv ? "RGB->YUV" : "YUV->RGB");
+        }
+        it = verified.emplace(key, matches).first;
+    }
+    return it->second;
+}
+
+} // namespace kernels
+} // namespace avifkit
+
+#endif // HAVE_LIBAVIF
@@ -0,0 +1,41 @@
+#ifndef AVIFKIT_AVIF_IMAGE_KERNELS_H
+#define AVIFKIT_AVIF_IMAGE_KERNELS_H
+
+#include "avif_pixel_kernels.h"
+
+#if HAVE_LIBAVIF
+#include "avif/avif.h"
+
+/**
+ * Pixel kernels applied to libavif images
+ *
+ * Decides, per image layout, whether the kernels may stand in for libavif's own
+ * RGB <-> YUV conversion. Depends on libavif but not on JNI.
+ */
+namespace avifkit {
+namespace kernels {
+
+/**
+ * Kernel parameters for an image, or false when only libavif handles it
+ * (high bit depth, 4:0:0, identity or derived matrices, premultiplied planes)
+ */
+bool paramsForImage(const avifImage* image, YuvParams* params);
+
+/**
+ * The image's 8-bit planes (a is null when the image has no alpha plane)
+ */
+Yuv8Planes planesOf(const avifImage* image);
+
+/**
+ * True when the kernels can stand in for libavif's conversion of this image
+ * params receives the kernel parameters. premultiplied describes the RGB side.
+ * The comparison against libavif runs once per format/matrix/range/direction.
+ */
+bool useForImage(const avifImage* image, bool toYuv, bool premultiplied, YuvParams* params);
+
+} // namespace kernels
+} // namespace avifkit
+
+#endif // HAVE_LIBAVIF
+
+#endif // AVIFKIT_AVIF_IMAGE_KERNELS_H
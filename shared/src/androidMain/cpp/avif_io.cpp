@@ -0,0 +1,291 @@
+#include "avif_io.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace avifkit {
+namespace io {
+
+#if HAVE_LIBAVIF
+
+namespace {
+
+/**
+ * avifIO must be the first member so libavif's avifIO* can be cast back
+ */
+struct FdReader {
+    avifIO io;
+    int fd = -1;
+    uint64_t size = 0;
+    const uint8_t* mapping = nullptr;  // whole file when mmap succeeded
+    std::vector<uint8_t> scratch;      // pread fallback, valid until the next read
+};
+
+void destroyFdReader(avifIO* io) {
+    auto* reader = reinterpret_cast<FdReader*>(io);
+    if (reader->mapping) {
+        munmap(const_cast<uint8_t*>(reader->mapping), reader->size);
+    }
+    delete reader;
+}
+
+avifResult readFd(avifIO* io, uint32_t readFlags, uint64_t offset, size_t size, avifROData* out) {
+    auto* reader = reinterpret_cast<FdReader*>(io);
+    if (readFlags != 0 || offset > reader->size) {
+        return AVIF_RESULT_IO_ERROR;
+    }
+    size = static_cast<size_t>(std::min<uint64_t>(size, reader->size - offset));
+
+    if (reader->mapping) {
+        out->data = reader->mapping + offset;
+        out->size = size;
+        return AVIF_RESULT_OK;
+    }
+
+    reader->scratch.resize(size);
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = pread(reader->fd, reader->scratch.data() + done, size - done,
+                          static_cast<off_t>(offset + done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            LOGE("pread failed at offset %llu: %s", static_cast<unsigned long long>(offset + done),
+                 n < 0 ? strerror(errno) : "unexpected end of file");
+            return AVIF_RESULT_IO_ERROR;
+        }
+        done += static_cast<size_t>(n);
+    }
+    out->data = reader->scratch.data();
+    out->size = size;
+    return AVIF_RESULT_OK;
+}
+
+} // namespace
+
+avifIO* createFdReader(int fd) {
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        LOGE("Invalid file descriptor %d: %s", fd, strerror(errno));
+        return nullptr;
+    }
+    if (!S_ISREG(st.st_mode) || st.st_size <= 0) {
+        LOGE("File descriptor %d is not a non-empty regular file", fd);
+        return nullptr;
+    }
+
+    auto* reader = new FdReader();
+    std::memset(&reader->io, 0, sizeof(reader->io));
+    reader->fd = fd;
+    reader->size = static_cast<uint64_t>(st.st_size);
+
+    void* mapping = mmap(nullptr, reader->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping != MAP_FAILED) {
+        reader->mapping = static_cast<const uint8_t*>(mapping);
+    } else {
+        LOGD("mmap of fd %d failed (%s), using pread", fd, strerror(errno));
+    }
+
+    reader->io.destroy = destroyFdReader;
+    reader->io.read = readFd;
+    reader->io.sizeHint = reader->size;
+    // Mapped bytes stay valid for the IO's lifetime, so libavif can skip its own copies
+    reader->io.persistent = reader->mapping ? AVIF_TRUE : AVIF_FALSE;
+    return &reader->io;
+}
+
+namespace {
+
+/**
+ * avifIO must be the first member so libavif's avifIO* can be cast back
+ */
+struct StreamReader {
+    avifIO io;
+    std::vector<uint8_t> data;
+    bool ended = false;
+};
+
+void destroyStreamReader(avifIO* io) {
+    delete reinterpret_cast<StreamReader*>(io);
+}
+
+avifResult readStream(avifIO* io, uint32_t readFlags, uint64_t offset, size_t size, avifROData* out) {
+    auto* reader = reinterpret_cast<StreamReader*>(io);
+    const uint64_t available = reader->data.size();
+    if (readFlags != 0) {
+        return AVIF_RESULT_IO_ERROR;
+    }
+    if (offset + size > available && !reader->ended) {
+        return AVIF_RESULT_WAITING_ON_IO;
+    }
+    if (offset > available) {
+        return AVIF_RESULT_IO_ERROR;
+    }
+    out->data = reader->data.data() + offset;
+    out->size = static_cast<size_t>(std::min<uint64_t>(size, available - offset));
+    return AVIF_RESULT_OK;
+}
+
+} // namespace
+
+avifIO* createStreamReader(uint64_t sizeHint) {
+    auto* reader = new StreamReader();
+    std::memset(&reader->io, 0, sizeof(reader->io));
+    if (sizeHint > 0) {
+        reader->data.reserve(static_cast<size_t>(sizeHint));
+    }
+    reader->io.destroy = destroyStreamReader;
+    reader->io.read = readStream;
+    reader->io.sizeHint = sizeHint;
+    // Appending may move the buffer, so libavif must copy what it keeps
+    reader->io.persistent = AVIF_FALSE;
+    return &reader->io;
+}
+
+uint8_t* extendStream(avifIO* io, size_t size) {
+    auto* reader = reinterpret_cast<StreamReader*>(io);
+    const size_t end = reader->data.size();
+    reader->data.resize(end + size);
+    return reader->data.data() + end;
+}
+
+void endStream(avifIO* io) {
+    reinterpret_cast<StreamReader*>(io)->ended = true;
+}
+
+uint64_t streamSize(const avifIO* io) {
+    return reinterpret_cast<const StreamReader*>(io)->data.size();
+}
+
+namespace {
+
+struct PrefixReader {
+    avifIO io;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    size_t prefix = 0;
+};
+
+void destroyPrefixReader(avifIO* io) {
+    delete reinterpret_cast<PrefixReader*>(io);
+}
+
+avifResult readPrefix(avifIO* io, uint32_t readFlags, uint64_t offset, size_t size, avifROData* out) {
+    auto* reader = reinterpret_cast<PrefixReader*>(io);
+    if (readFlags != 0) {
+        return AVIF_RESULT_IO_ERROR;
+    }
+    if (offset + size > reader->prefix && reader->prefix < reader->size) {
+        return AVIF_RESULT_WAITING_ON_IO;
+    }
+    if (offset > reader->size) {
+        return AVIF_RESULT_IO_ERROR;
+    }
+    out->data = reader->data + offset;
+    out->size = static_cast<size_t>(std::min<uint64_t>(size, reader->size - offset));
+    return AVIF_RESULT_OK;
+}
+
+} // namespace
+
+avifIO* createPrefixReader(const uint8_t* data, size_t size) {
+    auto* reader = new PrefixReader();
+    std::memset(&reader->io, 0, sizeof(reader->io));
+    reader->data = data;
+    reader->size = size;
+    reader->io.destroy = destroyPrefixReader;
+    reader->io.read = readPrefix;
+    reader->io.sizeHint = size;
+    reader->io.persistent = AVIF_TRUE;
+    return &reader->io;
+}
+
+void setPrefixLength(avifIO* io, size_t length) {
+    auto* reader = reinterpret_cast<PrefixReader*>(io);
+    reader->prefix = std::min(length, reader->size);
+}
+
+bool writeFully(int fd, const uint8_t* data, size_t size, bool sync) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = write(fd, data + done, size - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            LOGE("write to fd %d failed after %zu of %zu bytes: %s", fd, done, size,
+                 n < 0 ? strerror(errno) : "no progress");
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    if (sync && fsync(fd) != 0) {
+        LOGE("fsync of fd %d failed: %s", fd, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+namespace {
+
+void syncParentDirectory(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : path.substr(0, slash == 0 ? 1 : slash);
+    int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return;
+    if (fsync(fd) != 0) {
+        LOGW("fsync of directory %s failed: %s", directory.c_str(), strerror(errno));
+    }
+    close(fd);
+}
+
+} // namespace
+
+bool writeFile(const char* path, const uint8_t* data, size_t size, bool sync, bool atomic) {
+    std::string target(path);
+    std::string written = target;
+
+    int fd;
+    if (atomic) {
+        // Unique name next to the target (same filesystem for rename); mkostemp
+        // creates it with O_EXCL, so an existing file or symlink is never reused
+        written += ".XXXXXX";
+        fd = mkostemp(&written[0], O_CLOEXEC);
+        if (fd >= 0 && fchmod(fd, 0644) != 0) {
+            LOGW("Failed to set permissions on %s: %s", written.c_str(), strerror(errno));
+        }
+    } else {
+        fd = open(written.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    }
+    if (fd < 0) {
+        LOGE("Failed to open %s for writing: %s", written.c_str(), strerror(errno));
+        return false;
+    }
+    bool ok = writeFully(fd, data, size, sync);
+    if (close(fd) != 0 && ok) {
+        LOGE("Failed to close %s: %s", written.c_str(), strerror(errno));
+        ok = false;
+    }
+
+    if (atomic) {
+        if (ok && rename(written.c_str(), target.c_str()) != 0) {
+            LOGE("Failed to rename %s to %s: %s", written.c_str(), target.c_str(), strerror(errno));
+            ok = false;
+        }
+        if (!ok) {
+            unlink(written.c_str());
+        } else if (sync) {
+            syncParentDirectory(target);
+        }
+    }
+    return ok;
+}
+
+#endif // HAVE_LIBAVIF
+
+} // namespace io
+} // namespace avifkit
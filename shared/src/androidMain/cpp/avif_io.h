@@ -0,0 +1,94 @@
+#ifndef AVIFKIT_AVIF_IO_H
+#define AVIFKIT_AVIF_IO_H
+
+#include "avif_common.h"
+
+/**
+ * File descriptor IO for libavif
+ *
+ * Lets the decoder pull only the byte ranges it asks for (box headers, the
+ * primary item's extents) and the encoder write its output buffer straight to
+ * disk, instead of routing whole files through the Java heap.
+ */
+namespace avifkit {
+namespace io {
+
+#if HAVE_LIBAVIF
+
+/**
+ * Create an avifIO reading from a seekable file descriptor
+ *
+ * Regular files are mmap'ed read-only, so reads are zero-copy and pages are
+ * only faulted in for the ranges libavif touches. Anything mmap refuses falls
+ * back to pread into a scratch buffer. The fd is not owned and may be closed
+ * once the decoder is done with the IO. Returns nullptr (and logs) on failure.
+ * Ownership of the returned IO passes to the decoder via avifDecoderSetIO.
+ */
+avifIO* createFdReader(int fd);
+
+/**
+ * Create an avifIO over data that arrives in chunks (e.g. a download)
+ *
+ * Reads past the bytes received so far return AVIF_RESULT_WAITING_ON_IO until
+ * endStream is called, so a decoder with allowIncremental can be resumed after
+ * each extendStream. sizeHint is the expected total size, or 0 if unknown.
+ * Ownership of the returned IO passes to the decoder via avifDecoderSetIO.
+ */
+avifIO* createStreamReader(uint64_t sizeHint);
+
+/**
+ * Grow a stream reader by size bytes and return where the received bytes go
+ *
+ * The caller fills all size bytes before the next decoder call, so received data
+ * is copied once, straight into the reader's buffer. Must not be called during a
+ * decoder call.
+ */
+uint8_t* extendStream(avifIO* io, size_t size);
+
+/**
+ * Mark a stream reader complete; later reads past the end fail instead of waiting
+ */
+void endStream(avifIO* io);
+
+/**
+ * Bytes received so far by a stream reader
+ */
+uint64_t streamSize(const avifIO* io);
+
+/**
+ * Create an avifIO over complete in-memory data that exposes only a growing prefix
+ *
+ * Reads past the prefix return AVIF_RESULT_WAITING_ON_IO (until the prefix is
+ * the whole buffer), so an incremental decode can be advanced step by step and
+ * stopped once the rows it needs are decoded. data must outlive the IO.
+ * Ownership of the returned IO passes to the decoder via avifDecoderSetIO.
+ */
+avifIO* createPrefixReader(const uint8_t* data, size_t size);
+
+/**
+ * Extend the prefix visible through a prefix reader
+ */
+void setPrefixLength(avifIO* io, size_t length);
+
+/**
+ * Write all of data to fd at its current position (retrying short writes)
+ * sync fsyncs the file before returning. Returns false (and logs) on failure.
+ */
+bool writeFully(int fd, const uint8_t* data, size_t size, bool sync);
+
+/**
+ * Write data to path, replacing any existing file
+ *
+ * With atomic the bytes go to a uniquely named temporary file (path + random
+ * suffix, created exclusively) that is renamed over path once complete, so readers
+ * never see a partial file; it is removed if anything fails. With
+ * sync the file (and, after a rename, its directory) is fsync'ed.
+ */
+bool writeFile(const char* path, const uint8_t* data, size_t size, bool sync, bool atomic);
+
+#endif // HAVE_LIBAVIF
+
+} // namespace io
+} // namespace avifkit
+
+#endif // AVIFKIT_AVIF_IO_H
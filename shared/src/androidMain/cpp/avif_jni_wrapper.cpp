@@ -1,23 +1,450 @@
-#include <jni.h>
-#include <android/log.h>
-#include <vector>
-#include <memory>
+#include "avif_common.h"
+#include "avif_io.h"
+#include "avif_orientation.h"
+#include "avif_pixel_kernels.h"
+#include "avif_probe.h"
+#include "avif_threads.h"
+
+#include <android/bitmap.h>
+#include <algorithm>
 #include <cstring>
+#include <functional>
+#include <string>
+
+using namespace avifkit;
 
-// Conditional libavif inclusion
 #if HAVE_LIBAVIF
-#include "avif/avif.h"
-#endif
+namespace {
+
+/**
+ * Parameters and output of one candidate encode during a size-targeted search
+ */
+struct EncodeCandidate {
+    int quality = 0;
+    int speed = 0;
+    int subsample = 2;
+    std::vector<uint8_t> data;
+};
+
+/**
+ * State shared by the size-targeted search strategies.
+ * YUV conversion happens at most once per chroma format; every attempt
+ * reuses the converted image and only re-runs the AV1 encode.
+ * `settings` carries what the search does not vary (alpha quality, lossless);
+ * attempts override its quality and speed. The orientation and the exif/icc
+ * arrays (or null) are attached to every converted image.
+ */
+class TargetSizeSearch {
+public:
+    TargetSizeSearch(JNIEnv* env, const RgbSource& source, int width, int height,
+                     uint32_t dstWidth, uint32_t dstHeight, int exifOrientation, jbyteArray exif, jbyteArray icc,
+                     size_t targetSize, const EncodeSettings& settings)
+        : env_(env), source_(source), width_(width), height_(height),
+          dstWidth_(dstWidth), dstHeight_(dstHeight), exifOrientation_(exifOrientation), exif_(exif), icc_(icc),
+          targetSize_(targetSize), settings_(settings) {}
+
+    /**
+     * Encode with the given parameters. Returns false on hard failure.
+     */
+    bool attempt(int quality, int speed, int subsample, EncodeCandidate* out) {
+        const avifImage* image = imageFor(subsample);
+        if (!image) return false;
+
+        EncodeSettings settings = settings_;
+        settings.quality = quality;
+        settings.speed = speed;
+
+        ScopedRWData output;
+        avifResult result = encodeImage(image, settings, &output.data);
+        attempts_++;
+        if (result != AVIF_RESULT_OK) {
+            LOGE("Failed to encode AVIF: %s", avifResultToString(result));
+            return false;
+        }
+
+        LOGI("Size search attempt %d: quality=%d, speed=%d, subsample=%d, size=%zu, target=%zu",
+             attempts_, quality, speed, subsample, output.data.size, targetSize_);
+
+        out->quality = quality;
+        out->speed = speed;
+        out->subsample = subsample;
+        out->data.assign(output.data.data, output.data.data + output.data.size);
+        return true;
+    }
+
+    bool meetsTarget(const EncodeCandidate& candidate) const {
+        return candidate.data.size() <= targetSize_;
+    }
+
+    size_t targetSize() const { return targetSize_; }
+    int attempts() const { return attempts_; }
+    bool lossless() const { return settings_.lossless; }
+
+private:
+    const avifImage* imageFor(int subsample) {
+        int index = subsample < 0 || subsample > 2 ? 2 : subsample;
+        if (!images_[index]) {
+            images_[index] = createScaledImageFromRgb(source_, width_, height_, dstWidth_, dstHeight_,
+                                                      pixelFormatFromSubsample(index), resample::Filter::AUTO,
+                                                      settings_.lossless);
+            if (images_[index] &&
+                !orientation::setSourceMetadata(env_, images_[index].get(), exifOrientation_, exif_, icc_)) {
+                images_[index].reset();
+            }
+        }
+        return images_[index].get();
+    }
+
+    JNIEnv* env_;
+    RgbSource source_;
+    int width_;
+    int height_;
+    uint32_t dstWidth_;
+    uint32_t dstHeight_;
+    int exifOrientation_;
+    jbyteArray exif_;
+    jbyteArray icc_;
+    size_t targetSize_;
+    EncodeSettings settings_;
+    int attempts_ = 0;
+    AvifImagePtr images_[3];
+};
+
+/**
+ * LOSSLESS: quality and subsampling have no effect, so a single encode decides
+ * whether the target is met; the caller shrinks dimensions otherwise.
+ */
+bool searchLossless(TargetSizeSearch& search, int quality, int speed, EncodeCandidate* best, bool* targetMet) {
+    if (!search.attempt(quality, speed, 0, best)) return false;
+    *targetMet = search.meetsTarget(*best);
+    return true;
+}
+
+/**
+ * SMART: binary search for the highest quality that fits the target.
+ * Mirrors the Kotlin search (quality 40-100, 8 attempts) and, if nothing fits,
+ * continues into quality 0-39 at 4:2:0 before giving up.
+ */
+bool searchSmart(TargetSizeSearch& search, int speed, int subsample,
+                 EncodeCandidate* best, bool* targetMet) {
+    EncodeCandidate candidate;
+    EncodeCandidate smallest;
+    bool haveSmallest = false;
+    *targetMet = false;
+
+    auto binarySearch = [&](int minQuality, int maxQuality, int searchSubsample, int maxAttempts) -> bool {
+        int attempts = 0;
+        while (minQuality <= maxQuality && attempts < maxAttempts) {
+            int testQuality = (minQuality + maxQuality) / 2;
+            if (!search.attempt(testQuality, speed, searchSubsample, &candidate)) return false;
+            attempts++;
+
+            if (!haveSmallest || candidate.data.size() < smallest.data.size()) {
+                smallest = candidate;
+                haveSmallest = true;
+            }
+
+            if (search.meetsTarget(candidate)) {
+                // Meets target - keep it and try higher quality
+                *best = std::move(candidate);
+                *targetMet = true;
+                minQuality = testQuality + 1;
+            } else {
+                // Too large - try lower quality
+                maxQuality = testQuality - 1;
+            }
+        }
+        return true;
+    };
+
+    if (!binarySearch(40, 100, subsample, 8)) return false;
+
+    if (!*targetMet) {
+        LOGW("Quality 40-100 cannot meet %zu bytes, searching lower quality at 4:2:0", search.targetSize());
+        if (!binarySearch(0, 39, 2, 6)) return false;
+    }
+
+    if (!*targetMet) {
+        *best = std::move(smallest);
+    }
+    return true;
+}
 
-#define LOG_TAG "AvifJNI"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
-#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+/**
+ * STRICT: keep compressing after the target is met and return the smallest result.
+ * Uses the same parameter ladder as adjustCompressionParameters() on the Kotlin side,
+ * except for dimension changes which stay with the caller.
+ */
+bool searchStrict(TargetSizeSearch& search, int quality, int speed, int subsample,
+                  EncodeCandidate* best, bool* targetMet) {
+    EncodeCandidate candidate;
+    EncodeCandidate smallest;
+    bool haveSmallest = false;
+    *targetMet = false;
+
+    const int maxAttempts = 10;
+    for (int attempt = 0; attempt < maxAttempts; attempt++) {
+        if (!search.attempt(quality, speed, subsample, &candidate)) return false;
+
+        bool meets = search.meetsTarget(candidate);
+        if (meets && (!*targetMet || candidate.data.size() < best->data.size())) {
+            *best = candidate;
+            *targetMet = true;
+        }
+        if (!haveSmallest || candidate.data.size() < smallest.data.size()) {
+            smallest = candidate;
+            haveSmallest = true;
+        }
+
+        // Adjust parameters for the next attempt
+        float reductionRatio = static_cast<float>(search.targetSize()) / candidate.data.size();
+        int nextQuality;
+        int nextSpeed = speed;
+        int nextSubsample = subsample;
+        if (reductionRatio < 0.5f) {
+            nextQuality = std::max(40, static_cast<int>(quality * 0.7f));
+            nextSubsample = 2;
+            nextSpeed = std::min(10, speed + 2);
+        } else if (reductionRatio < 0.75f) {
+            nextQuality = std::max(50, quality - 15);
+            nextSpeed = std::min(10, speed + 1);
+        } else {
+            nextQuality = std::max(60, quality - 8);
+        }
+
+        // Identical parameters produce an identical bitstream, no point re-encoding
+        if (nextQuality == quality && nextSpeed == speed && nextSubsample == subsample) {
+            break;
+        }
+        quality = nextQuality;
+        speed = nextSpeed;
+        subsample = nextSubsample;
+    }
+
+    if (!*targetMet) {
+        *best = std::move(smallest);
+    }
+    return true;
+}
+
+/**
+ * Convert a locked ARGB_8888 Bitmap to YUV, downscaling so neither side exceeds maxDimension
+ * Only the (resize +) RGB->YUV conversion needs the bitmap memory; it is unlocked on return.
+ * The pixels stay in sensor order; orientation, exif and icc are attached as metadata.
+ */
+AvifImagePtr imageFromBitmap(JNIEnv* env, jobject bitmap, jint subsample, jint maxDimension, bool lossless,
+                             jint orientation, jbyteArray exif, jbyteArray icc) {
+    AvifImagePtr image;
+    {
+        ScopedBitmapPixels bitmapPixels(env, bitmap);
+        if (!bitmapPixels.pixels()) {
+            return nullptr;
+        }
+        const AndroidBitmapInfo& info = bitmapPixels.info();
+        LOGD("Bitmap source: %ux%u, stride=%u", info.width, info.height, info.stride);
+
+        RgbSource source;
+        source.pixels = bitmapPixels.pixels();
+        source.rowBytes = info.stride;
+        source.format = AVIF_RGB_FORMAT_RGBA;
+        source.alphaPremultiplied = bitmapPixels.premultiplied();
+
+        uint32_t dstWidth;
+        uint32_t dstHeight;
+        resample::scaledSize(info.width, info.height, maxDimension, maxDimension, 0, &dstWidth, &dstHeight);
+
+        image = createScaledImageFromRgb(source, info.width, info.height, dstWidth, dstHeight,
+                                         pixelFormatFromSubsample(subsample), resample::Filter::AUTO, lossless);
+    }
+    if (!image || !orientation::setSourceMetadata(env, image.get(), orientation, exif, icc)) {
+        return nullptr;
+    }
+    return image;
+}
+
+/**
+ * Encoder settings from EncodingOptions values (alphaQuality < 0 = same as quality)
+ */
+EncodeSettings encodeSettings(jint quality, jint alphaQuality, jint speed, jboolean lossless) {
+    EncodeSettings settings;
+    settings.quality = quality;
+    settings.qualityAlpha = alphaQuality;
+    settings.speed = speed;
+    settings.lossless = lossless == JNI_TRUE;
+    return settings;
+}
+
+/**
+ * Encode a converted image; the bitstream stays in native memory for the caller to write out
+ */
+bool encodeToNative(const avifImage* image, const EncodeSettings& settings, ScopedRWData* output) {
+    avifResult encodeResult = encodeImage(image, settings, &output->data);
+    if (encodeResult != AVIF_RESULT_OK) {
+        LOGE("Failed to encode AVIF: %s", avifResultToString(encodeResult));
+        return false;
+    }
+    LOGI("Successfully encoded AVIF: %ux%u%s, output size=%zu bytes",
+         image->width, image->height, image->alphaPlane ? " with alpha" : "", output->data.size);
+    return true;
+}
+
+/**
+ * Encode a converted image and copy the bitstream into a Java byte array
+ */
+jbyteArray encodeToJavaArray(JNIEnv* env, const avifImage* image, const EncodeSettings& settings) {
+    ScopedRWData output;
+    if (!encodeToNative(image, settings, &output)) {
+        return nullptr;
+    }
+
+    // Create Java byte array for result
+    return toJavaByteArray(env, output.data);
+}
+
+/**
+ * Create a decoder with the default options
+ * Returns nullptr (and logs) if no decoder codec is available
+ */
+AvifDecoderPtr createDefaultDecoder() {
+    if (decoderCodecName()[0] == '\0') {
+        LOGE("No decoder codec available! AOM decoder not found.");
+        return nullptr;
+    }
+
+    AvifDecoderPtr decoder(avifDecoderCreate());
+    if (!decoder) {
+        LOGE("Failed to create AVIF decoder");
+        return nullptr;
+    }
+    configureDecoder(decoder.get(), AVIF_CODEC_CHOICE_AUTO);
+    return decoder;
+}
+
+/**
+ * Create a decoder with the default options and decode the first image of in-memory data
+ * Returns nullptr (and logs) on failure
+ */
+AvifDecoderPtr decodeFromMemory(const uint8_t* data, size_t size) {
+    AvifDecoderPtr decoder = createDefaultDecoder();
+    if (!decoder || decodeFirstImage(decoder.get(), data, size) != AVIF_RESULT_OK) {
+        return nullptr;
+    }
+    return decoder;
+}
+
+/**
+ * Like decodeFromMemory, but libavif reads only the ranges it needs from the file
+ */
+AvifDecoderPtr decodeFromFd(int fd) {
+    AvifDecoderPtr decoder = createDefaultDecoder();
+    if (!decoder) {
+        return nullptr;
+    }
+    avifIO* reader = io::createFdReader(fd);
+    if (!reader) {
+        return nullptr;
+    }
+    avifDecoderSetIO(decoder.get(), reader);  // decoder owns the IO from here
+
+    if (decodeFirstImage(decoder.get()) != AVIF_RESULT_OK) {
+        return nullptr;
+    }
+    return decoder;
+}
+
+/**
+ * Decode in-memory data only as far down as the stored row bottomFor(image) returns
+ *
+ * The data is revealed to an incremental decoder in steps; grid cells are
+ * decoded top to bottom as their bytes become visible, so cell rows below
+ * the bottom are never decoded. Non-grid images are decoded whole. bottomFor
+ * is called once the header is parsed, so it can depend on the image's size
+ * and orientation. On success at least the rows above min(bottom, height) of
+ * decoder->image are valid.
+ */
+AvifDecoderPtr decodeTopRowsFromMemory(const uint8_t* data, size_t size,
+                                       const std::function<uint32_t(const avifImage*)>& bottomFor) {
+    AvifDecoderPtr decoder = createDefaultDecoder();
+    if (!decoder) {
+        return nullptr;
+    }
+    avifIO* reader = io::createPrefixReader(data, size);
+    avifDecoderSetIO(decoder.get(), reader);  // decoder owns the IO from here
+    decoder->allowIncremental = AVIF_TRUE;
+    threads::Lease lease;
+    decoder->maxThreads = lease.count();
+
+    constexpr size_t kMinRevealStep = 64 * 1024;
+    const size_t step = std::max(kMinRevealStep, size / 32);
+    size_t revealed = 0;
+    bool parsed = false;
+    uint32_t bottom = 0;
+    while (true) {
+        revealed = std::min(size, revealed + step);
+        io::setPrefixLength(reader, revealed);
+
+        avifResult result = parsed ? AVIF_RESULT_OK : avifDecoderParse(decoder.get());
+        if (result == AVIF_RESULT_OK) {
+            if (!parsed) {
+                bottom = bottomFor(decoder->image);
+            }
+            parsed = true;
+            result = avifDecoderNextImage(decoder.get());
+        }
+        if (result == AVIF_RESULT_OK) {
+            return decoder;
+        }
+        if (result != AVIF_RESULT_WAITING_ON_IO || revealed == size) {
+            LOGE("Failed to decode AVIF rows: %s", avifResultToString(result));
+            return nullptr;
+        }
+        if (parsed && avifDecoderDecodedRowCount(decoder.get()) >= std::min(bottom, decoder->image->height)) {
+            LOGD("Stopped decoding at row %u of %u after %zu of %zu bytes",
+                 avifDecoderDecodedRowCount(decoder.get()), decoder->image->height, revealed, size);
+            return decoder;
+        }
+    }
+}
+
+/**
+ * Downscale (if requested) and convert a decoded image to packed ARGB
+ * The target box applies to the displayed image: with an orientation that swaps
+ * axes it is swapped before scaling, and width/height receive the displayed size.
+ */
+bool scaledArgbFromImage(const avifImage* image, jint targetWidth, jint targetHeight, jint sampleSize,
+                         jint filter, int exifOrientation, std::vector<int32_t>& pixels,
+                         uint32_t* width, uint32_t* height) {
+    const bool swap = orientation::swapsAxes(exifOrientation);
+    resample::scaledSize(image->width, image->height, swap ? targetHeight : targetWidth,
+                         swap ? targetWidth : targetHeight, sampleSize, width, height);
+
+    AvifImagePtr scaled;
+    if (*width != image->width || *height != image->height) {
+        scaled = scaleImage(image, *width, *height, resample::filterFromNative(filter));
+        if (!scaled) {
+            return false;
+        }
+        LOGD("Decoded AVIF %ux%u scaled to %ux%u", image->width, image->height, *width, *height);
+        image = scaled.get();
+    }
+    orientation::displaySize(exifOrientation, image->width, image->height, width, height);
+    return convertImageToArgb(image, pixels, exifOrientation) == AVIF_RESULT_OK;
+}
+
+} // namespace
+#endif
 
 extern "C" {
 
 /**
  * Native encoding function with libavif support
+ * maxDimension > 0 downscales (fused with RGB->YUV) so neither side exceeds it.
+ * alphaQuality < 0 reuses quality; lossless stores RGB with identity coefficients in
+ * 4:4:4. Fully opaque input is encoded without an alpha plane.
+ * orientation (Exif 1-8) is written as irot/imir instead of rotating the pixels;
+ * exif (TIFF header on, or null) is stored as the image's Exif metadata and icc
+ * (or null) as its colour profile.
+ * Returns null if pixels holds fewer than width * height * 4 bytes.
  */
 JNIEXPORT jbyteArray JNICALL
 Java_com_alfikri_rizky_avifkit_AvifConverter_nativeEncode(
@@ -27,11 +454,17 @@ Java_com_alfikri_rizky_avifkit_AvifConverter_nativeEncode(
     jint width,
     jint height,
     jint quality,
+    jint alphaQuality,
     jint speed,
-    jint subsample) {
+    jint subsample,
+    jboolean lossless,
+    jint maxDimension,
+    jint orientation,
+    jbyteArray exif,
+    jbyteArray icc) {
 
-    LOGI("nativeEncode: %dx%d, quality=%d, speed=%d, subsample=%d",
-         width, height, quality, speed, subsample);
+    LOGI("nativeEncode: %dx%d, quality=%d, alphaQuality=%d, speed=%d, subsample=%d, lossless=%d, maxDimension=%d",
+         width, height, quality, alphaQuality, speed, subsample, lossless, maxDimension);
 
     // Get pixel data from Java
     jbyte* pixelData = env->GetByteArrayElements(pixels, nullptr);
@@ -41,6 +474,11 @@ Java_com_alfikri_rizky_avifkit_AvifConverter_nativeEncode(
         LOGE("Failed to get pixel data");
         return nullptr;
     }
+    if (width <= 0 || height <= 0 || pixelLength < static_cast<int64_t>(width) * height * 4) {
+        LOGE("Pixel buffer too small: %d bytes for %dx%d", pixelLength, width, height);
+        env->ReleaseByteArrayElements(pixels, pixelData, JNI_ABORT);
+        return nullptr;
+    }
 
 #if HAVE_LIBAVIF
     // ==========================================
@@ -50,114 +488,33 @@ Java_com_alfikri_rizky_avifkit_AvifConverter_nativeEncode(
     LOGI("Using libavif for encoding");
 
     // Check codec availability first
-    const char* codecName = avifCodecName(AVIF_CODEC_CHOICE_AUTO, AVIF_CODEC_FLAG_CAN_ENCODE);
-    if (codecName && codecName[0] != '\0') {
-        LOGI("Available encoder codec: %s", codecName);
+    const char* codecName = encoderCodecName();
+    if (codecName[0] != '\0') {
+        LOGD("Available encoder codec: %s", codecName);
     } else {
         env->ReleaseByteArrayElements(pixels, pixelData, JNI_ABORT);
         LOGE("No encoder codec available! AOM codec not found.");
         return nullptr;
     }
 
-    // Create AVIF encoder
-    avifEncoder* encoder = avifEncoderCreate();
-    if (!encoder) {
-        env->ReleaseByteArrayElements(pixels, pixelData, JNI_ABORT);
-        LOGE("Failed to create AVIF encoder");
-        return nullptr;
-    }
-
-    // Set encoding parameters
-    encoder->quality = quality;
-    encoder->qualityAlpha = quality;  // Same quality for alpha
-    encoder->speed = speed;
-    encoder->maxThreads = 4;  // Use up to 4 threads
-    encoder->codecChoice = AVIF_CODEC_CHOICE_AUTO;
-
-    // Determine pixel format from subsample
-    avifPixelFormat pixelFormat;
-    switch (subsample) {
-        case 0: pixelFormat = AVIF_PIXEL_FORMAT_YUV444; break;
-        case 1: pixelFormat = AVIF_PIXEL_FORMAT_YUV422; break;
-        case 2:
-        default: pixelFormat = AVIF_PIXEL_FORMAT_YUV420; break;
-    }
-
-    // Create AVIF image
-    avifImage* image = avifImageCreate(width, height, 8, pixelFormat);
-    if (!image) {
-        avifEncoderDestroy(encoder);
-        env->ReleaseByteArrayElements(pixels, pixelData, JNI_ABORT);
-        LOGE("Failed to create AVIF image");
-        return nullptr;
-    }
-
-    // Allocate image planes
-    avifResult allocResult = avifImageAllocatePlanes(image, AVIF_PLANES_YUV | AVIF_PLANES_A);
-    if (allocResult != AVIF_RESULT_OK) {
-        avifImageDestroy(image);
-        avifEncoderDestroy(encoder);
-        env->ReleaseByteArrayElements(pixels, pixelData, JNI_ABORT);
-        LOGE("Failed to allocate image planes: %s", avifResultToString(allocResult));
-        return nullptr;
-    }
-
-    // Setup RGB image for conversion
-    avifRGBImage rgb;
-    avifRGBImageSetDefaults(&rgb, image);
-    rgb.pixels = reinterpret_cast<uint8_t*>(pixelData);
-    rgb.rowBytes = width * 4;  // RGBA = 4 bytes per pixel
-    rgb.format = AVIF_RGB_FORMAT_RGBA;
-    rgb.depth = 8;
-
-    // Convert RGBA to YUV
-    avifResult convertResult = avifImageRGBToYUV(image, &rgb);
-    if (convertResult != AVIF_RESULT_OK) {
-        avifImageDestroy(image);
-        avifEncoderDestroy(encoder);
-        env->ReleaseByteArrayElements(pixels, pixelData, JNI_ABORT);
-        LOGE("Failed to convert RGB to YUV: %s", avifResultToString(convertResult));
-        return nullptr;
-    }
-
-    // Encode the image
-    avifRWData output = AVIF_DATA_EMPTY;
-    avifResult encodeResult = avifEncoderWrite(encoder, image, &output);
-
-    // Clean up encoder and image
-    avifImageDestroy(image);
-    avifEncoderDestroy(encoder);
+    // Convert RGBA to YUV, downscaling on the way if requested
+    uint32_t dstWidth;
+    uint32_t dstHeight;
+    resample::scaledSize(width, height, maxDimension, maxDimension, 0, &dstWidth, &dstHeight);
+
+    RgbSource source;
+    source.pixels = reinterpret_cast<const uint8_t*>(pixelData);
+    source.rowBytes = width * 4;  // RGBA = 4 bytes per pixel
+    AvifImagePtr image = createScaledImageFromRgb(source, width, height, dstWidth, dstHeight,
+                                                  pixelFormatFromSubsample(subsample), resample::Filter::AUTO,
+                                                  lossless == JNI_TRUE);
     env->ReleaseByteArrayElements(pixels, pixelData, JNI_ABORT);
-
-    if (encodeResult != AVIF_RESULT_OK) {
-        avifRWDataFree(&output);
-        LOGE("Failed to encode AVIF: %s", avifResultToString(encodeResult));
-        return nullptr;
-    }
-
-    // Check if output is empty (codec not available)
-    if (output.size == 0 || output.data == nullptr) {
-        avifRWDataFree(&output);
-        LOGE("Encoder produced empty output! AOM codec may not be linked properly.");
-        LOGE("output.size=%zu, output.data=%p", output.size, output.data);
+    if (!image || !orientation::setSourceMetadata(env, image.get(), orientation, exif, icc)) {
         return nullptr;
     }
 
-    LOGI("Successfully encoded AVIF: %dx%d, output size=%zu bytes",
-         width, height, output.size);
-
-    // Create Java byte array for result
-    jbyteArray result = env->NewByteArray(output.size);
-    if (!result) {
-        avifRWDataFree(&output);
-        LOGE("Failed to allocate Java byte array for encoded data");
-        return nullptr;
-    }
-
-    env->SetByteArrayRegion(result, 0, output.size,
-                           reinterpret_cast<const jbyte*>(output.data));
-
-    avifRWDataFree(&output);
+    // Encode the image
+    jbyteArray result = encodeToJavaArray(env, image.get(), encodeSettings(quality, alphaQuality, speed, lossless));
 
     return result;
 
@@ -192,199 +549,409 @@ Java_com_alfikri_rizky_avifkit_AvifConverter_nativeEncode(
 }
 
 /**
- * Native decoding function with libavif support
+ * Encode straight from a locked Bitmap's pixel memory (no Java-side pixel copy)
+ * Supports ARGB_8888 bitmaps; premultiplied alpha is undone during RGB->YUV conversion.
+ * maxDimension > 0 downscales (fused with RGB->YUV) so neither side exceeds it.
+ * orientation, exif and icc are stored as metadata, as in nativeEncode.
  */
-JNIEXPORT jobject JNICALL
-Java_com_alfikri_rizky_avifkit_AvifConverter_nativeDecode(
+JNIEXPORT jbyteArray JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeEncodeBitmap(
     JNIEnv* env,
     jobject /* this */,
-    jbyteArray avifData) {
+    jobject bitmap,
+    jint quality,
+    jint alphaQuality,
+    jint speed,
+    jint subsample,
+    jboolean lossless,
+    jint maxDimension,
+    jint orientation,
+    jbyteArray exif,
+    jbyteArray icc) {
 
-    LOGI("nativeDecode called");
+    LOGI("nativeEncodeBitmap: quality=%d, alphaQuality=%d, speed=%d, subsample=%d, lossless=%d, maxDimension=%d",
+         quality, alphaQuality, speed, subsample, lossless, maxDimension);
 
-    // Get AVIF data from Java
-    jbyte* data = env->GetByteArrayElements(avifData, nullptr);
-    jsize dataLength = env->GetArrayLength(avifData);
+#if HAVE_LIBAVIF
+    // ==========================================
+    // PRODUCTION: Using libavif
+    // ==========================================
 
-    if (!data) {
-        LOGE("Failed to get AVIF data");
+    AvifImagePtr image = imageFromBitmap(env, bitmap, subsample, maxDimension, lossless == JNI_TRUE,
+                                         orientation, exif, icc);
+    if (!image) {
         return nullptr;
     }
 
+    return encodeToJavaArray(env, image.get(), encodeSettings(quality, alphaQuality, speed, lossless));
+#else
+    LOGW("PLACEHOLDER: libavif not available, direct bitmap encoding not supported");
+    return nullptr;
+#endif
+}
+
+/**
+ * Encode a Bitmap and write the bitstream straight to a file descriptor
+ * The output never becomes a Java array. The fd is written at its current position and
+ * is not closed; sync fsyncs it. Returns the number of bytes written, or -1 on failure.
+ */
+JNIEXPORT jlong JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeEncodeBitmapToFd(
+    JNIEnv* env,
+    jobject /* this */,
+    jobject bitmap,
+    jint quality,
+    jint alphaQuality,
+    jint speed,
+    jint subsample,
+    jboolean lossless,
+    jint maxDimension,
+    jint orientation,
+    jbyteArray exif,
+    jbyteArray icc,
+    jint fd,
+    jboolean sync) {
+
+#if HAVE_LIBAVIF
+    ScopedRWData output;
+    {
+        AvifImagePtr image = imageFromBitmap(env, bitmap, subsample, maxDimension, lossless == JNI_TRUE,
+                                         orientation, exif, icc);
+        if (!image || !encodeToNative(image.get(), encodeSettings(quality, alphaQuality, speed, lossless), &output)) {
+            return -1;
+        }
+        // YUV planes are released before the write
+    }
+
+    if (!io::writeFully(fd, output.data.data, output.data.size, sync == JNI_TRUE)) {
+        return -1;
+    }
+    return static_cast<jlong>(output.data.size);
+#else
+    LOGW("PLACEHOLDER: libavif not available, encoding to a file descriptor not supported");
+    return -1;
+#endif
+}
+
+/**
+ * Encode a Bitmap and write the bitstream straight to a file, replacing it
+ * atomic writes a temporary file next to path and renames it into place; sync fsyncs
+ * the file (and directory). Returns the number of bytes written, or -1 on failure.
+ */
+JNIEXPORT jlong JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeEncodeBitmapToPath(
+    JNIEnv* env,
+    jobject /* this */,
+    jobject bitmap,
+    jint quality,
+    jint alphaQuality,
+    jint speed,
+    jint subsample,
+    jboolean lossless,
+    jint maxDimension,
+    jint orientation,
+    jbyteArray exif,
+    jbyteArray icc,
+    jstring path,
+    jboolean sync,
+    jboolean atomic) {
+
+#if HAVE_LIBAVIF
+    ScopedRWData output;
+    {
+        AvifImagePtr image = imageFromBitmap(env, bitmap, subsample, maxDimension, lossless == JNI_TRUE,
+                                         orientation, exif, icc);
+        if (!image || !encodeToNative(image.get(), encodeSettings(quality, alphaQuality, speed, lossless), &output)) {
+            return -1;
+        }
+    }
+
+    const char* pathChars = env->GetStringUTFChars(path, nullptr);
+    if (!pathChars) {
+        return -1;
+    }
+    bool ok = io::writeFile(pathChars, output.data.data, output.data.size,
+                            sync == JNI_TRUE, atomic == JNI_TRUE);
+    env->ReleaseStringUTFChars(path, pathChars);
+    return ok ? static_cast<jlong>(output.data.size) : -1;
+#else
+    LOGW("PLACEHOLDER: libavif not available, encoding to a file not supported");
+    return -1;
+#endif
+}
+
+/**
+ * Encode straight from a direct ByteBuffer with explicit row stride and channel order
+ * channelOrder: 0=RGBA, 1=BGRA, 2=ARGB, 3=ABGR, 4=RGB, 5=BGR (8 bits per channel)
+ */
+JNIEXPORT jbyteArray JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeEncodeBuffer(
+    JNIEnv* env,
+    jobject /* this */,
+    jobject buffer,
+    jint width,
+    jint height,
+    jint rowBytes,
+    jint channelOrder,
+    jboolean alphaPremultiplied,
+    jint quality,
+    jint alphaQuality,
+    jint speed,
+    jint subsample,
+    jboolean lossless) {
+
+    LOGI("nativeEncodeBuffer: %dx%d, rowBytes=%d, channelOrder=%d, quality=%d, alphaQuality=%d, speed=%d, "
+         "subsample=%d, lossless=%d", width, height, rowBytes, channelOrder, quality, alphaQuality, speed,
+         subsample, lossless);
+
 #if HAVE_LIBAVIF
     // ==========================================
     // PRODUCTION: Using libavif
     // ==========================================
 
-    LOGI("Using libavif for decoding");
-
-    // Check decoder codec availability
-    const char* decoderCodecName = avifCodecName(AVIF_CODEC_CHOICE_AUTO, AVIF_CODEC_FLAG_CAN_DECODE);
-    if (decoderCodecName && decoderCodecName[0] != '\0') {
-        LOGI("Available decoder codec: %s", decoderCodecName);
-    } else {
-        env->ReleaseByteArrayElements(avifData, data, JNI_ABORT);
-        LOGE("No decoder codec available! AOM decoder not found.");
+    avifRGBFormat format;
+    if (!rgbFormatFromChannelOrder(channelOrder, &format)) {
+        LOGE("Unsupported channel order: %d", channelOrder);
         return nullptr;
     }
 
-    // Log first few bytes of AVIF data for debugging
-    LOGI("AVIF data first 16 bytes: %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x",
-         (unsigned char)data[0], (unsigned char)data[1], (unsigned char)data[2], (unsigned char)data[3],
-         (unsigned char)data[4], (unsigned char)data[5], (unsigned char)data[6], (unsigned char)data[7],
-         (unsigned char)data[8], (unsigned char)data[9], (unsigned char)data[10], (unsigned char)data[11],
-         (unsigned char)data[12], (unsigned char)data[13], (unsigned char)data[14], (unsigned char)data[15]);
-
-    // Create decoder
-    avifDecoder* decoder = avifDecoderCreate();
-    if (!decoder) {
-        env->ReleaseByteArrayElements(avifData, data, JNI_ABORT);
-        LOGE("Failed to create AVIF decoder");
+    void* address = env->GetDirectBufferAddress(buffer);
+    jlong capacity = env->GetDirectBufferCapacity(buffer);
+    if (!address || capacity < 0) {
+        LOGE("Buffer is not a direct ByteBuffer");
         return nullptr;
     }
 
-    // Set decoder options
-    decoder->maxThreads = 4;
-    decoder->ignoreXMP = AVIF_TRUE;
-    decoder->ignoreExif = AVIF_FALSE;  // IMPORTANT: Preserve EXIF for orientation data
-
-    // Parse AVIF data
-    avifResult parseResult = avifDecoderSetIOMemory(
-        decoder,
-        reinterpret_cast<const uint8_t*>(data),
-        dataLength
-    );
-
-    if (parseResult != AVIF_RESULT_OK) {
-        avifDecoderDestroy(decoder);
-        env->ReleaseByteArrayElements(avifData, data, JNI_ABORT);
-        LOGE("Failed to parse AVIF: %s", avifResultToString(parseResult));
+    // The last row only needs width * channels bytes, earlier rows need the full stride
+    jlong pixelBytes = static_cast<jlong>(width) * avifRGBFormatChannelCount(format);
+    if (width <= 0 || height <= 0 || rowBytes < pixelBytes ||
+        capacity < static_cast<jlong>(rowBytes) * (height - 1) + pixelBytes) {
+        LOGE("Buffer too small or invalid geometry: capacity=%lld, %dx%d, rowBytes=%d",
+             static_cast<long long>(capacity), width, height, rowBytes);
         return nullptr;
     }
 
-    LOGI("Parse successful, calling avifDecoderParse...");
+    RgbSource source;
+    source.pixels = static_cast<const uint8_t*>(address);
+    source.rowBytes = rowBytes;
+    source.format = format;
+    source.alphaPremultiplied = alphaPremultiplied == JNI_TRUE;
 
-    // Parse the AVIF structure first
-    parseResult = avifDecoderParse(decoder);
-    if (parseResult != AVIF_RESULT_OK) {
-        avifDecoderDestroy(decoder);
-        env->ReleaseByteArrayElements(avifData, data, JNI_ABORT);
-        LOGE("Failed in avifDecoderParse: %s", avifResultToString(parseResult));
-        LOGE("Decoder state - imageCount: %d, imageIndex: %d", decoder->imageCount, decoder->imageIndex);
+    AvifImagePtr image = createImageFromRgb(source, width, height, pixelFormatFromSubsample(subsample),
+                                            lossless == JNI_TRUE);
+    if (!image) {
         return nullptr;
     }
 
-    LOGI("Parse successful - imageCount: %d, imageIndex: %d", decoder->imageCount, decoder->imageIndex);
+    return encodeToJavaArray(env, image.get(), encodeSettings(quality, alphaQuality, speed, lossless));
+#else
+    LOGW("PLACEHOLDER: libavif not available, direct buffer encoding not supported");
+    return nullptr;
+#endif
+}
 
-    // Decode first image
-    avifResult decodeResult = avifDecoderNextImage(decoder);
-    if (decodeResult != AVIF_RESULT_OK) {
-        avifDecoderDestroy(decoder);
-        env->ReleaseByteArrayElements(avifData, data, JNI_ABORT);
-        LOGE("Failed to decode AVIF: %s", avifResultToString(decodeResult));
-        LOGE("After decode - imageCount: %d, imageIndex: %d", decoder->imageCount, decoder->imageIndex);
+/**
+ * Size-targeted encoding in a single native call
+ *
+ * Converts the bitmap to YUV once (per chroma format actually tried) and searches
+ * quality/speed/subsampling natively, so each attempt only re-runs the AV1 encode.
+ * maxDimension > 0 downscales from the original pixels during that conversion, so
+ * callers can retry with smaller limits without rescaling on the Java side.
+ * strategy: 0=SMART (highest quality within target), 1=STRICT (smallest size)
+ * alphaQuality (< 0 = follow the searched quality) and lossless apply to every
+ * attempt, as in nativeEncode; lossless encodes once since only dimensions can
+ * change its size.
+ * orientation (Exif 1-8) is stored as irot/imir, exif and icc (or null) as metadata.
+ * Their bytes count against the target, so callers pass exif only when asked to keep it.
+ *
+ * Returns a TargetSizeEncodeResult with the best bitstream and chosen parameters.
+ * If the target cannot be met the smallest candidate is returned with targetMet=false
+ * so the caller can decide whether to shrink dimensions.
+ */
+JNIEXPORT jobject JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeEncodeToTargetSize(
+    JNIEnv* env,
+    jobject /* this */,
+    jobject bitmap,
+    jint maxDimension,
+    jint quality,
+    jint alphaQuality,
+    jint speed,
+    jint subsample,
+    jboolean lossless,
+    jint orientation,
+    jbyteArray exif,
+    jbyteArray icc,
+    jlong targetSize,
+    jint strategy) {
+
+    LOGI("nativeEncodeToTargetSize: maxDimension=%d, quality=%d, alphaQuality=%d, speed=%d, subsample=%d, "
+         "lossless=%d, target=%lld, strategy=%d",
+         maxDimension, quality, alphaQuality, speed, subsample, lossless, static_cast<long long>(targetSize),
+         strategy);
+
+#if HAVE_LIBAVIF
+    // ==========================================
+    // PRODUCTION: Using libavif
+    // ==========================================
+
+    if (targetSize <= 0) {
+        LOGE("Invalid target size: %lld", static_cast<long long>(targetSize));
         return nullptr;
     }
 
-    LOGI("Decode successful - image dimensions: %dx%d, depth: %d",
-         decoder->image->width, decoder->image->height, decoder->image->depth);
+    // Pixels stay locked for the whole search; conversions happen lazily per chroma format
+    ScopedBitmapPixels bitmapPixels(env, bitmap);
+    if (!bitmapPixels.pixels()) {
+        return nullptr;
+    }
+    const AndroidBitmapInfo& info = bitmapPixels.info();
+
+    RgbSource source;
+    source.pixels = bitmapPixels.pixels();
+    source.rowBytes = info.stride;
+    source.format = AVIF_RGB_FORMAT_RGBA;
+    source.alphaPremultiplied = bitmapPixels.premultiplied();
+
+    uint32_t dstWidth;
+    uint32_t dstHeight;
+    resample::scaledSize(info.width, info.height, maxDimension, maxDimension, 0, &dstWidth, &dstHeight);
+
+    TargetSizeSearch search(env, source, info.width, info.height, dstWidth, dstHeight, orientation, exif, icc,
+                            static_cast<size_t>(targetSize), encodeSettings(quality, alphaQuality, speed, lossless));
+    EncodeCandidate best;
+    bool targetMet = false;
+
+    bool ok;
+    if (search.lossless()) {
+        ok = searchLossless(search, quality, speed, &best, &targetMet);
+    } else if (strategy == 1) {
+        ok = searchStrict(search, quality, speed, subsample, &best, &targetMet);
+    } else {
+        ok = searchSmart(search, speed, subsample, &best, &targetMet);
+    }
+    if (!ok || best.data.empty()) {
+        LOGE("Size-targeted encoding failed after %d attempts", search.attempts());
+        return nullptr;
+    }
 
-    // Get decoded image
-    avifImage* image = decoder->image;
+    LOGI("Size search finished: quality=%d, speed=%d, subsample=%d, size=%zu, met=%d, attempts=%d",
+         best.quality, best.speed, best.subsample, best.data.size(), targetMet, search.attempts());
 
-    // Setup RGB conversion
-    avifRGBImage rgb;
-    avifRGBImageSetDefaults(&rgb, image);
-    rgb.format = AVIF_RGB_FORMAT_RGBA;
-    rgb.depth = 8;
+    jclass resultClass = env->FindClass("com/alfikri/rizky/avifkit/TargetSizeEncodeResult");
+    if (!resultClass) {
+        LOGE("Failed to find TargetSizeEncodeResult class");
+        clearPendingException(env);
+        return nullptr;
+    }
 
-    // Allocate RGB buffer
-    avifResult allocResult = avifRGBImageAllocatePixels(&rgb);
-    if (allocResult != AVIF_RESULT_OK) {
-        avifDecoderDestroy(decoder);
-        env->ReleaseByteArrayElements(avifData, data, JNI_ABORT);
-        LOGE("Failed to allocate RGB pixels: %s", avifResultToString(allocResult));
+    jmethodID constructor = env->GetMethodID(resultClass, "<init>", "([BIIIIZ)V");
+    if (!constructor) {
+        LOGE("Failed to find TargetSizeEncodeResult constructor");
+        clearPendingException(env);
         return nullptr;
     }
 
-    // Convert YUV to RGB
-    avifResult convertResult = avifImageYUVToRGB(image, &rgb);
-    if (convertResult != AVIF_RESULT_OK) {
-        avifRGBImageFreePixels(&rgb);
-        avifDecoderDestroy(decoder);
-        env->ReleaseByteArrayElements(avifData, data, JNI_ABORT);
-        LOGE("Failed to convert YUV to RGB: %s", avifResultToString(convertResult));
+    jbyteArray data = env->NewByteArray(best.data.size());
+    if (!data) {
+        LOGE("Failed to allocate Java byte array for encoded data");
         return nullptr;
     }
+    env->SetByteArrayRegion(data, 0, best.data.size(),
+                            reinterpret_cast<const jbyte*>(best.data.data()));
 
-    // Convert to Android Bitmap format (ARGB_8888)
-    int width = rgb.width;
-    int height = rgb.height;
-    std::vector<int32_t> pixels(width * height);
+    return env->NewObject(resultClass, constructor, data,
+                          best.quality, best.speed, best.subsample,
+                          search.attempts(), targetMet ? JNI_TRUE : JNI_FALSE);
+
+#else
+    // ==========================================
+    // PLACEHOLDER: No native search without libavif
+    // ==========================================
+
+    LOGW("PLACEHOLDER: libavif not available, size-targeted encoding not supported");
+    return nullptr;
+#endif
+}
 
-    uint8_t* src = rgb.pixels;
-    for (int i = 0; i < width * height; i++) {
-        uint8_t r = src[i * 4 + 0];
-        uint8_t g = src[i * 4 + 1];
-        uint8_t b = src[i * 4 + 2];
-        uint8_t a = src[i * 4 + 3];
+/**
+ * Native decoding function with libavif support
+ * irot/imir (or, without them, the Exif orientation) are applied while converting
+ * from YUV, so the result is already in display orientation.
+ */
+JNIEXPORT jobject JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeDecode(
+    JNIEnv* env,
+    jobject /* this */,
+    jbyteArray avifData) {
+
+    LOGI("nativeDecode called");
 
-        // Pack as ARGB (Android Bitmap format)
-        pixels[i] = (a << 24) | (r << 16) | (g << 8) | b;
+    // Get AVIF data from Java
+    jbyte* data = env->GetByteArrayElements(avifData, nullptr);
+    jsize dataLength = env->GetArrayLength(avifData);
+
+    if (!data) {
+        LOGE("Failed to get AVIF data");
+        return nullptr;
     }
 
-    // Clean up
-    avifRGBImageFreePixels(&rgb);
-    avifDecoderDestroy(decoder);
-    env->ReleaseByteArrayElements(avifData, data, JNI_ABORT);
+#if HAVE_LIBAVIF
+    // ==========================================
+    // PRODUCTION: Using libavif
+    // ==========================================
 
-    // Create DecodedImage object
-    jclass decodedImageClass = env->FindClass("com/alfikri/rizky/avifkit/DecodedImage");
-    if (!decodedImageClass) {
-        LOGE("Failed to find DecodedImage class");
-        // Check for pending JNI exceptions
-        if (env->ExceptionCheck()) {
-            env->ExceptionDescribe();
-            env->ExceptionClear();
-        }
+    LOGI("Using libavif for decoding");
+
+    // Check decoder codec availability
+    const char* codecName = decoderCodecName();
+    if (codecName[0] != '\0') {
+        LOGD("Available decoder codec: %s", codecName);
+    } else {
+        env->ReleaseByteArrayElements(avifData, data, JNI_ABORT);
+        LOGE("No decoder codec available! AOM decoder not found.");
         return nullptr;
     }
 
-    jmethodID constructor = env->GetMethodID(decodedImageClass, "<init>", "([III)V");
-    if (!constructor) {
-        LOGE("Failed to find DecodedImage constructor");
-        // Check for pending JNI exceptions
-        if (env->ExceptionCheck()) {
-            env->ExceptionDescribe();
-            env->ExceptionClear();
-        }
+    // Create decoder
+    AvifDecoderPtr decoder(avifDecoderCreate());
+    if (!decoder) {
+        env->ReleaseByteArrayElements(avifData, data, JNI_ABORT);
+        LOGE("Failed to create AVIF decoder");
         return nullptr;
     }
+    configureDecoder(decoder.get(), AVIF_CODEC_CHOICE_AUTO);
 
-    // Create int array for pixels
-    jintArray pixelArray = env->NewIntArray(pixels.size());
-    if (!pixelArray) {
-        LOGE("Failed to allocate pixel array");
+    avifResult decodeResult = decodeFirstImage(
+        decoder.get(), reinterpret_cast<const uint8_t*>(data), dataLength);
+    if (decodeResult != AVIF_RESULT_OK) {
+        env->ReleaseByteArrayElements(avifData, data, JNI_ABORT);
         return nullptr;
     }
 
-    env->SetIntArrayRegion(pixelArray, 0, pixels.size(), reinterpret_cast<const jint*>(pixels.data()));
+    // Convert YUV to packed ARGB, rotated/mirrored for display on the way
+    const int exifOrientation = orientation::displayOrientation(decoder->image);
+    std::vector<int32_t> pixels;
+    avifResult convertResult = convertImageToArgb(decoder->image, pixels, exifOrientation);
+    uint32_t width;
+    uint32_t height;
+    orientation::displaySize(exifOrientation, decoder->image->width, decoder->image->height, &width, &height);
+
+    // Clean up
+    decoder.reset();
+    env->ReleaseByteArrayElements(avifData, data, JNI_ABORT);
 
-    // Create and return DecodedImage object
-    jobject result = env->NewObject(decodedImageClass, constructor,
-                                    pixelArray, width, height);
+    if (convertResult != AVIF_RESULT_OK) {
+        return nullptr;
+    }
 
+    // Create DecodedImage object
+    jobject result = newDecodedImage(env, pixels.data(), width, height);
     if (!result) {
-        LOGE("Failed to create DecodedImage object");
-        // Check for pending JNI exceptions
-        if (env->ExceptionCheck()) {
-            env->ExceptionDescribe();
-            env->ExceptionClear();
-        }
         return nullptr;
     }
 
-    LOGI("Successfully decoded AVIF: %dx%d", width, height);
+    LOGI("Successfully decoded AVIF: %ux%u (orientation %d)", width, height, exifOrientation);
 
     return result;
 
@@ -414,42 +981,284 @@ Java_com_alfikri_rizky_avifkit_AvifConverter_nativeDecode(
     }
 
     // Create DecodedImage object
-    jclass decodedImageClass = env->FindClass("com/alfikri/rizky/avifkit/DecodedImage");
-    if (!decodedImageClass) {
-        LOGE("Failed to find DecodedImage class");
+    jobject result = newDecodedImage(env, pixels.data(), width, height);
+    if (!result) {
         return nullptr;
     }
 
-    jmethodID constructor = env->GetMethodID(decodedImageClass, "<init>", "([III)V");
-    if (!constructor) {
-        LOGE("Failed to find DecodedImage constructor");
-        return nullptr;
+    LOGI("Returned placeholder test image: %dx%d", width, height);
+
+    return result;
+#endif
+}
+
+/**
+ * Decode with a downscale to a target box or by a sample factor
+ * YUV and alpha planes are resampled before YUV->RGB, so only the small RGB image
+ * is ever produced and copied to Java. filter: 0=AUTO, 1=AREA, 2=LANCZOS3.
+ */
+JNIEXPORT jobject JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeDecodeScaled(
+    JNIEnv* env,
+    jobject /* this */,
+    jbyteArray avifData,
+    jint targetWidth,
+    jint targetHeight,
+    jint sampleSize,
+    jint filter) {
+
+#if HAVE_LIBAVIF
+    std::vector<int32_t> pixels;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    {
+        ScopedByteArrayElements data(env, avifData);
+        if (!data.data()) {
+            LOGE("Failed to get AVIF data");
+            return nullptr;
+        }
+
+        AvifDecoderPtr decoder = decodeFromMemory(data.data(), data.length());
+        if (!decoder ||
+            !scaledArgbFromImage(decoder->image, targetWidth, targetHeight, sampleSize, filter,
+                                 orientation::displayOrientation(decoder->image), pixels, &width, &height)) {
+            return nullptr;
+        }
+        // Decoder and AVIF data are released before the Java pixel array is allocated
     }
 
-    jintArray pixelArray = env->NewIntArray(pixels.size());
-    if (!pixelArray) {
-        LOGE("Failed to allocate pixel array");
-        return nullptr;
+    return newDecodedImage(env, pixels.data(), width, height);
+#else
+    LOGW("PLACEHOLDER: libavif not available, scaled decoding not supported");
+    return nullptr;
+#endif
+}
+
+/**
+ * Decode from a file descriptor (e.g. ParcelFileDescriptor.getFd()) without loading the file
+ *
+ * libavif reads only the boxes and item extents it needs through an mmap/pread backed
+ * avifIO, so unused items (large Exif blocks, alternate tracks) are never read and the
+ * file never reaches the Java heap. The fd is not closed. targetWidth/targetHeight/
+ * sampleSize downscale as in nativeDecodeScaled (0, 0, 1 = full size).
+ */
+JNIEXPORT jobject JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeDecodeFd(
+    JNIEnv* env,
+    jobject /* this */,
+    jint fd,
+    jint targetWidth,
+    jint targetHeight,
+    jint sampleSize,
+    jint filter) {
+
+#if HAVE_LIBAVIF
+    std::vector<int32_t> pixels;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    {
+        AvifDecoderPtr decoder = decodeFromFd(fd);
+        if (!decoder ||
+            !scaledArgbFromImage(decoder->image, targetWidth, targetHeight, sampleSize, filter,
+                                 orientation::displayOrientation(decoder->image), pixels, &width, &height)) {
+            return nullptr;
+        }
+        LOGD("Decoded AVIF from fd %d: read %zu color + %zu alpha OBU bytes",
+             fd, decoder->ioStats.colorOBUSize, decoder->ioStats.alphaOBUSize);
     }
 
-    env->SetIntArrayRegion(pixelArray, 0, pixels.size(), reinterpret_cast<const jint*>(pixels.data()));
+    return newDecodedImage(env, pixels.data(), width, height);
+#else
+    LOGW("PLACEHOLDER: libavif not available, file descriptor decoding not supported");
+    return nullptr;
+#endif
+}
 
-    jobject result = env->NewObject(decodedImageClass, constructor,
-                                    pixelArray, width, height);
+/**
+ * Decode the rectangle (x, y, width, height) of an image, divided by sampleSize
+ * Only the grid cell rows down to the bottom of the rectangle are decoded, and
+ * the decoded image is cropped before YUV->RGB, so conversion cost follows the
+ * rectangle, not the image. Coordinates and output are in display orientation
+ * (irot/imir applied), matching the probed width and height; the rectangle is
+ * clipped to that size. Returns a DecodedImage or null on failure.
+ */
+JNIEXPORT jobject JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeDecodeRegion(
+    JNIEnv* env,
+    jobject /* this */,
+    jbyteArray avifData,
+    jint x,
+    jint y,
+    jint width,
+    jint height,
+    jint sampleSize,
+    jint filter) {
 
-    if (!result) {
-        LOGE("Failed to create DecodedImage object");
+#if HAVE_LIBAVIF
+    if (x < 0 || y < 0 || width <= 0 || height <= 0) {
+        LOGE("Invalid region: %d,%d %dx%d", x, y, width, height);
         return nullptr;
     }
 
-    LOGI("Returned placeholder test image: %dx%d", width, height);
+    std::vector<int32_t> pixels;
+    uint32_t outWidth = 0;
+    uint32_t outHeight = 0;
+    {
+        ScopedByteArrayElements data(env, avifData);
+        if (!data.data()) {
+            LOGE("Failed to get AVIF data");
+            return nullptr;
+        }
 
-    return result;
+        // The displayed rectangle clipped to the displayed size, and the stored rectangle it shows
+        int exifOrientation = 1;
+        avifCropRect displayed = {};
+        avifCropRect stored = {};
+        AvifDecoderPtr decoder = decodeTopRowsFromMemory(data.data(), data.length(), [&](const avifImage* image) {
+            exifOrientation = orientation::displayOrientation(image);
+            uint32_t displayWidth;
+            uint32_t displayHeight;
+            orientation::displaySize(exifOrientation, image->width, image->height, &displayWidth, &displayHeight);
+            if (static_cast<uint32_t>(x) >= displayWidth || static_cast<uint32_t>(y) >= displayHeight) {
+                return 0u;  // outside the image: stop as early as possible
+            }
+            displayed = {static_cast<uint32_t>(x), static_cast<uint32_t>(y),
+                         std::min(static_cast<uint32_t>(width), displayWidth - x),
+                         std::min(static_cast<uint32_t>(height), displayHeight - y)};
+            orientation::storedRect(exifOrientation, image->width, image->height, displayed, &stored);
+            return stored.y + stored.height;
+        });
+        if (!decoder) {
+            return nullptr;
+        }
+
+        const avifImage* image = decoder->image;
+        if (displayed.width == 0) {
+            LOGE("Region %d,%d outside image of %ux%u stored pixels (orientation %d)",
+                 x, y, image->width, image->height, exifOrientation);
+            return nullptr;
+        }
+
+        // Views must start on a chroma sample; widen by a pixel and crop it after conversion
+        avifPixelFormatInfo formatInfo;
+        avifGetPixelFormatInfo(image->yuvFormat, &formatInfo);
+        const uint32_t alignedX = stored.x & ~static_cast<uint32_t>(formatInfo.chromaShiftX);
+        const uint32_t alignedY = stored.y & ~static_cast<uint32_t>(formatInfo.chromaShiftY);
+        const uint32_t extraX = stored.x - alignedX;
+        const uint32_t extraY = stored.y - alignedY;
+
+        AvifImagePtr region(avifImageCreateEmpty());
+        avifCropRect rect = {alignedX, alignedY, stored.width + extraX, stored.height + extraY};
+        if (!region || avifImageSetViewRect(region.get(), image, &rect) != AVIF_RESULT_OK) {
+            LOGE("Failed to crop %ux%u region at %u,%u", rect.width, rect.height, rect.x, rect.y);
+            return nullptr;
+        }
+        if (!scaledArgbFromImage(region.get(), 0, 0, sampleSize, filter, exifOrientation, pixels, &outWidth,
+                                 &outHeight)) {
+            return nullptr;
+        }
+
+        // Unscaled output: drop the alignment column/row so the result is exactly the region.
+        // Scaled output keeps it; the shift is below one output pixel.
+        uint32_t viewWidth;
+        uint32_t viewHeight;
+        orientation::displaySize(exifOrientation, rect.width, rect.height, &viewWidth, &viewHeight);
+        if ((extraX || extraY) && outWidth == viewWidth && outHeight == viewHeight) {
+            avifCropRect kept;
+            orientation::displayRect(exifOrientation, rect.width, rect.height,
+                                     {extraX, extraY, stored.width, stored.height}, &kept);
+            for (uint32_t row = 0; row < kept.height; row++) {
+                std::memmove(pixels.data() + static_cast<size_t>(row) * kept.width,
+                             pixels.data() + static_cast<size_t>(row + kept.y) * outWidth + kept.x,
+                             kept.width * sizeof(int32_t));
+            }
+            outWidth = kept.width;
+            outHeight = kept.height;
+        }
+        LOGD("Decoded region %u,%u %ux%u (stored %u,%u %ux%u, orientation %d) -> %ux%u",
+             displayed.x, displayed.y, displayed.width, displayed.height,
+             stored.x, stored.y, stored.width, stored.height, exifOrientation, outWidth, outHeight);
+    }
+
+    return newDecodedImage(env, pixels.data(), outWidth, outHeight);
+#else
+    LOGW("PLACEHOLDER: libavif not available, region decoding not supported");
+    return nullptr;
+#endif
+}
+
+/**
+ * Decode straight into a caller-supplied mutable ARGB_8888 Bitmap
+ * The final pixel layout is written once, directly from YUV; no Java pixel arrays are created.
+ * The bitmap receives the displayed (oriented) size.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeDecodeIntoBitmap(
+    JNIEnv* env,
+    jobject /* this */,
+    jbyteArray avifData,
+    jobject bitmap) {
+
+#if HAVE_LIBAVIF
+    ScopedByteArrayElements data(env, avifData);
+    if (!data.data()) {
+        LOGE("Failed to get AVIF data");
+        return JNI_FALSE;
+    }
+
+    AvifDecoderPtr decoder = decodeFromMemory(data.data(), data.length());
+    if (!decoder) {
+        return JNI_FALSE;
+    }
+
+    bool ok = decodedImageIntoBitmap(env, decoder->image, bitmap, orientation::displayOrientation(decoder->image));
+    if (ok) {
+        LOGD("Decoded AVIF into bitmap: %ux%u", decoder->image->width, decoder->image->height);
+    }
+    return ok ? JNI_TRUE : JNI_FALSE;
+#else
+    LOGW("PLACEHOLDER: libavif not available, decoding into bitmap not supported");
+    return JNI_FALSE;
 #endif
 }
 
 /**
- * Check if data is AVIF format
+ * Decode straight into a caller-supplied direct ByteBuffer in display orientation
+ * outInfo receives [width, height, hasAlpha] even when the buffer is too small.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeDecodeIntoBuffer(
+    JNIEnv* env,
+    jobject /* this */,
+    jbyteArray avifData,
+    jobject buffer,
+    jint rowBytes,
+    jint channelOrder,
+    jintArray outInfo) {
+
+#if HAVE_LIBAVIF
+    ScopedByteArrayElements data(env, avifData);
+    if (!data.data()) {
+        LOGE("Failed to get AVIF data");
+        return JNI_FALSE;
+    }
+
+    AvifDecoderPtr decoder = decodeFromMemory(data.data(), data.length());
+    if (!decoder) {
+        return JNI_FALSE;
+    }
+
+    return decodedImageIntoBuffer(env, decoder->image, decoder->alphaPresent, buffer, rowBytes, channelOrder,
+                                  outInfo, orientation::displayOrientation(decoder->image)) ? JNI_TRUE : JNI_FALSE;
+#else
+    LOGW("PLACEHOLDER: libavif not available, decoding into buffer not supported");
+    return JNI_FALSE;
+#endif
+}
+
+/**
+ * Check if data is AVIF format (avif or avis brand in ftyp)
+ * Copies only the ftyp prefix instead of pinning the whole array.
  */
 JNIEXPORT jboolean JNICALL
 Java_com_alfikri_rizky_avifkit_AvifConverter_nativeIsAvif(
@@ -459,20 +1268,118 @@ Java_com_alfikri_rizky_avifkit_AvifConverter_nativeIsAvif(
 
     if (!data) return JNI_FALSE;
 
-    jsize length = env->GetArrayLength(data);
-    if (length < 12) return JNI_FALSE;
+    uint8_t prefix[256];
+    jsize length = std::min<jsize>(env->GetArrayLength(data), sizeof(prefix));
+    env->GetByteArrayRegion(data, 0, length, reinterpret_cast<jbyte*>(prefix));
 
-    jbyte* bytes = env->GetByteArrayElements(data, nullptr);
+    return probe::hasAvifBrand(prefix, length) ? JNI_TRUE : JNI_FALSE;
+}
 
-    // Check AVIF file signature (ftypavif)
-    bool isAvif = (bytes[4] == 0x66 && bytes[5] == 0x74 &&
-                   bytes[6] == 0x79 && bytes[7] == 0x70 &&
-                   bytes[8] == 0x61 && bytes[9] == 0x76 &&
-                   bytes[10] == 0x69 && bytes[11] == 0x66);
+/**
+ * Read image properties from the container boxes without decoding
+ * outInfo (7 ints): width, height, depth, hasAlpha, frameCount, subsample, neededBytes,
+ * optionally followed by the nclx colour primaries and transfer characteristics (2 = unspecified).
+ * width and height are the displayed size (irot/imir applied), as decoded bitmaps have.
+ * Only the first `length` bytes of data are considered (the rest of the file need
+ * not be loaded). Returns the probe status; works without libavif.
+ */
+JNIEXPORT jint JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeProbe(
+    JNIEnv* env,
+    jobject /* this */,
+    jbyteArray data,
+    jint length,
+    jintArray outInfo) {
+
+    if (!data || !outInfo || env->GetArrayLength(outInfo) < 7) {
+        return static_cast<jint>(probe::Status::INVALID);
+    }
+    size_t available = static_cast<size_t>(std::max<jint>(0, std::min(length, env->GetArrayLength(data))));
+
+    // Most files keep ftyp+meta within the first few KB; only grow the copy if the boxes say so
+    std::vector<uint8_t> prefix(std::min(available, probe::kDefaultProbeBytes));
+    env->GetByteArrayRegion(data, 0, static_cast<jsize>(prefix.size()), reinterpret_cast<jbyte*>(prefix.data()));
+
+    probe::ImageProbe info;
+    probe::Status status = probe::probeAvif(prefix.data(), prefix.size(), &info);
+    if (status == probe::Status::NEED_MORE_DATA && prefix.size() < available) {
+        size_t grown = static_cast<size_t>(std::min<uint64_t>(info.neededBytes, available));
+        size_t copied = prefix.size();
+        prefix.resize(grown);
+        env->GetByteArrayRegion(data, static_cast<jsize>(copied), static_cast<jsize>(grown - copied),
+                                reinterpret_cast<jbyte*>(prefix.data() + copied));
+        status = probe::probeAvif(prefix.data(), prefix.size(), &info);
+    }
+
+    jint values[9] = {
+        static_cast<jint>(info.width),
+        static_cast<jint>(info.height),
+        static_cast<jint>(info.depth),
+        info.hasAlpha ? 1 : 0,
+        static_cast<jint>(info.frameCount),
+        info.subsample,
+        static_cast<jint>(std::min<uint64_t>(info.neededBytes, INT32_MAX)),
+        info.colorPrimaries,
+        info.transferCharacteristics
+    };
+    env->SetIntArrayRegion(outInfo, 0, std::min<jsize>(9, env->GetArrayLength(outInfo)), values);
+
+    LOGD("Probe: status=%d %ux%u depth=%u alpha=%d frames=%u",
+         static_cast<int>(status), info.width, info.height, info.depth, info.hasAlpha, info.frameCount);
+    return static_cast<jint>(status);
+}
+
+/**
+ * Repack Android ARGB ints (Bitmap.getPixels) into RGBA bytes
+ * Uses the SIMD swizzle kernel; works without libavif.
+ */
+JNIEXPORT void JNICALL
+Java_com_alfikri_rizky_avifkit_NativeInteropKt_nativeArgbToRgba(
+    JNIEnv* env,
+    jclass /* clazz */,
+    jintArray argbPixels,
+    jbyteArray rgbaBytes) {
+
+    jsize pixelCount = env->GetArrayLength(argbPixels);
+    if (env->GetArrayLength(rgbaBytes) < static_cast<jlong>(pixelCount) * 4) {
+        LOGE("RGBA array too small for %d pixels", pixelCount);
+        return;
+    }
+
+    // Critical sections: no JNI calls until both arrays are released
+    void* src = env->GetPrimitiveArrayCritical(argbPixels, nullptr);
+    void* dst = env->GetPrimitiveArrayCritical(rgbaBytes, nullptr);
+    if (src && dst) {
+        // ARGB ints are BGRA bytes on little-endian
+        kernels::swapRedBlue(static_cast<const uint8_t*>(src), static_cast<uint8_t*>(dst), pixelCount);
+    }
+    if (dst) env->ReleasePrimitiveArrayCritical(rgbaBytes, dst, 0);
+    if (src) env->ReleasePrimitiveArrayCritical(argbPixels, src, JNI_ABORT);
+}
+
+/**
+ * Cap the codec threads shared by all encodes and decodes (0 = detected budget)
+ * Returns the budget in effect afterwards.
+ */
+JNIEXPORT jint JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeSetThreadBudget(
+    JNIEnv* /* env */,
+    jobject /* this */,
+    jint maxThreads) {
+
+    threads::setCap(maxThreads);
+    return threads::budget();
+}
 
-    env->ReleaseByteArrayElements(data, bytes, JNI_ABORT);
+/**
+ * Codec threads currently available to the process
+ */
+JNIEXPORT jint JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeGetThreadBudget(
+    JNIEnv* /* env */,
+    jobject /* this */) {
 
-    return isAvif ? JNI_TRUE : JNI_FALSE;
+    return threads::budget();
 }
 
 /**
@@ -0,0 +1,74 @@
+#include "avif_metric.h"
+
+#include <algorithm>
+
+namespace avifkit {
+namespace metric {
+
+namespace {
+
+constexpr uint32_t kWindowSize = 8;
+constexpr uint32_t kWindowStep = 4;
+
+// (0.01 * 255)^2 and (0.03 * 255)^2
+constexpr double kC1 = 6.5025;
+constexpr double kC2 = 58.5225;
+
+double windowSsim(const uint8_t* a, size_t aRowBytes, const uint8_t* b, size_t bRowBytes,
+                  uint32_t windowWidth, uint32_t windowHeight) {
+    uint32_t sumA = 0, sumB = 0;
+    uint64_t sumAA = 0, sumBB = 0, sumAB = 0;
+    for (uint32_t y = 0; y < windowHeight; y++) {
+        const uint8_t* rowA = a + y * aRowBytes;
+        const uint8_t* rowB = b + y * bRowBytes;
+        for (uint32_t x = 0; x < windowWidth; x++) {
+            const uint32_t sa = rowA[x];
+            const uint32_t sb = rowB[x];
+            sumA += sa;
+            sumB += sb;
+            sumAA += sa * sa;
+            sumBB += sb * sb;
+            sumAB += sa * sb;
+        }
+    }
+
+    // Sums instead of means: every term is scaled by count^2, including the constants
+    const double count = static_cast<double>(windowWidth) * windowHeight;
+    const double c1 = kC1 * count * count;
+    const double c2 = kC2 * count * count;
+    const double meanProduct = static_cast<double>(sumA) * sumB;
+    const double numerator = (2.0 * meanProduct + c1) * (2.0 * (count * sumAB - meanProduct) + c2);
+    const double denominator =
+        (static_cast<double>(sumA) * sumA + static_cast<double>(sumB) * sumB + c1) *
+        (count * sumAA - static_cast<double>(sumA) * sumA + count * sumBB - static_cast<double>(sumB) * sumB + c2);
+    return numerator / denominator;
+}
+
+} // namespace
+
+double ssim(const uint8_t* a, size_t aRowBytes, const uint8_t* b, size_t bRowBytes,
+            uint32_t width, uint32_t height) {
+    if (width == 0 || height == 0) {
+        return 1.0;
+    }
+    const uint32_t windowWidth = std::min(kWindowSize, width);
+    const uint32_t windowHeight = std::min(kWindowSize, height);
+
+    double total = 0.0;
+    uint32_t windows = 0;
+    for (uint32_t y = 0; y + windowHeight <= height; y += kWindowStep) {
+        for (uint32_t x = 0; x + windowWidth <= width; x += kWindowStep) {
+            total += windowSsim(a + y * aRowBytes + x, aRowBytes, b + y * bRowBytes + x, bRowBytes,
+                                windowWidth, windowHeight);
+            windows++;
+        }
+    }
+    return total / windows;
+}
+
+double weightedYuvSsim(double y, double u, double v) {
+    return 0.8 * y + 0.1 * (u + v);
+}
+
+} // namespace metric
+} // namespace avifkit
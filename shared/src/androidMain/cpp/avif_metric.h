@@ -0,0 +1,35 @@
+#ifndef AVIFKIT_AVIF_METRIC_H
+#define AVIFKIT_AVIF_METRIC_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Full-reference image quality metrics on 8-bit planes
+ *
+ * Used to steer quality-targeted encodes: the encoder's YUV input is compared
+ * with the decoded candidate plane by plane. No libavif dependency.
+ */
+namespace avifkit {
+namespace metric {
+
+/**
+ * Mean SSIM of two planes of the same size, in 0..1 (1 = identical)
+ *
+ * Statistics are taken over 8x8 windows stepped by 4 pixels in each direction
+ * (the libvpx/libaom layout), with the usual C1/C2 stabilizers for 8-bit
+ * samples. Planes smaller than 8 pixels on a side use one window that size.
+ * Row strides are in bytes.
+ */
+double ssim(const uint8_t* a, size_t aRowBytes, const uint8_t* b, size_t bRowBytes,
+            uint32_t width, uint32_t height);
+
+/**
+ * Combine per-plane SSIM the way libvpx reports it: 0.8 luma + 0.1 per chroma plane
+ */
+double weightedYuvSsim(double y, double u, double v);
+
+} // namespace metric
+} // namespace avifkit
+
+#endif // AVIFKIT_AVIF_METRIC_H
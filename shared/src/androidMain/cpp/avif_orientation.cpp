@@ -0,0 +1,328 @@
+#include "avif_orientation.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace avifkit {
+namespace orientation {
+
+#if HAVE_LIBAVIF
+
+namespace {
+
+// Rows converted per strip before they are scattered into the oriented target
+constexpr uint32_t kOrientStripRows = 64;
+
+/**
+ * Exif orientation as anti-clockwise quarter turns followed by an optional
+ * top-to-bottom flip (every orientation can be written this way)
+ */
+void turnsForOrientation(int exifOrientation, int* quarterTurns, bool* flip) {
+    static const int kTurns[9] = {0, 0, 2, 2, 0, 1, 3, 3, 1};
+    static const bool kFlip[9] = {false, false, true, false, true, true, false, true, false};
+    int index = exifOrientation >= 1 && exifOrientation <= 8 ? exifOrientation : 1;
+    *quarterTurns = kTurns[index];
+    *flip = kFlip[index];
+}
+
+/**
+ * Maps stored (x, y) to displayed (dx, dy) = (xx*x + xy*y + x0, yx*x + yy*y + y0)
+ */
+struct Transform {
+    int xx = 1, xy = 0, yx = 0, yy = 1;
+    int x0 = 0, y0 = 0;
+    uint32_t width = 0;  // displayed size
+    uint32_t height = 0;
+};
+
+Transform transformFor(int exifOrientation, uint32_t width, uint32_t height) {
+    int turns;
+    bool flip;
+    turnsForOrientation(exifOrientation, &turns, &flip);
+
+    Transform t;
+    t.width = width;
+    t.height = height;
+    for (int i = 0; i < turns; i++) {
+        // Quarter turn anti-clockwise: (u, v) -> (v, width - 1 - u)
+        Transform r;
+        r.xx = t.yx;
+        r.xy = t.yy;
+        r.x0 = t.y0;
+        r.yx = -t.xx;
+        r.yy = -t.xy;
+        r.y0 = static_cast<int>(t.width) - 1 - t.x0;
+        r.width = t.height;
+        r.height = t.width;
+        t = r;
+    }
+    if (flip) {
+        // Top-to-bottom: v -> height - 1 - v
+        t.yx = -t.yx;
+        t.yy = -t.yy;
+        t.y0 = static_cast<int>(t.height) - 1 - t.y0;
+    }
+    return t;
+}
+
+/**
+ * Scatter converted rows [firstRow, firstRow + rows) of the stored image into the target
+ */
+template <size_t PixelBytes>
+void scatterRows(const uint8_t* strip, uint32_t stripRowBytes, uint32_t firstRow, uint32_t rows,
+                 uint32_t width, const Transform& t, uint8_t* pixels, uint32_t targetRowBytes) {
+    struct Pixel { uint8_t bytes[PixelBytes]; };
+    const ptrdiff_t rowBytes = static_cast<ptrdiff_t>(targetRowBytes);
+    auto at = [&](uint32_t x, uint32_t y) {
+        int dx = t.xx * static_cast<int>(x) + t.xy * static_cast<int>(y) + t.x0;
+        int dy = t.yx * static_cast<int>(x) + t.yy * static_cast<int>(y) + t.y0;
+        return pixels + dy * rowBytes + dx * static_cast<ptrdiff_t>(PixelBytes);
+    };
+
+    if (t.xy == 0) {
+        // Stored rows stay displayed rows, possibly reversed: walk each source row
+        const ptrdiff_t step = t.xx * static_cast<ptrdiff_t>(PixelBytes);
+        for (uint32_t r = 0; r < rows; r++) {
+            const Pixel* src = reinterpret_cast<const Pixel*>(strip + static_cast<size_t>(r) * stripRowBytes);
+            uint8_t* dst = at(0, firstRow + r);
+            if (step > 0) {
+                memcpy(dst, src, static_cast<size_t>(width) * PixelBytes);
+                continue;
+            }
+            for (uint32_t x = 0; x < width; x++, dst += step) {
+                memcpy(dst, &src[x], PixelBytes);
+            }
+        }
+        return;
+    }
+
+    // Stored columns become displayed rows: per column, the strip's pixels land
+    // next to each other in one displayed row, so writes stay sequential
+    const ptrdiff_t step = t.xy * static_cast<ptrdiff_t>(PixelBytes);
+    for (uint32_t x = 0; x < width; x++) {
+        uint8_t* dst = at(x, firstRow);
+        const uint8_t* src = strip + static_cast<size_t>(x) * PixelBytes;
+        for (uint32_t r = 0; r < rows; r++, dst += step, src += stripRowBytes) {
+            memcpy(dst, src, PixelBytes);
+        }
+    }
+}
+
+/**
+ * Rectangle spanned by two opposite corner pixels
+ */
+avifCropRect cornersToRect(int x0, int y0, int x1, int y1) {
+    avifCropRect rect;
+    rect.x = static_cast<uint32_t>(std::min(x0, x1));
+    rect.y = static_cast<uint32_t>(std::min(y0, y1));
+    rect.width = static_cast<uint32_t>(std::abs(x1 - x0)) + 1;
+    rect.height = static_cast<uint32_t>(std::abs(y1 - y0)) + 1;
+    return rect;
+}
+
+} // namespace
+
+void setTransforms(avifImage* image, int exifOrientation) {
+    image->transformFlags &= ~(AVIF_TRANSFORM_IROT | AVIF_TRANSFORM_IMIR);
+    image->irot.angle = 0;
+    image->imir.axis = 0;
+
+    // irot turns anti-clockwise in quarter turns and is applied before imir;
+    // imir axis 0 flips top-to-bottom, axis 1 left-to-right
+    switch (exifOrientation) {
+        case 2:  // mirror horizontal
+            image->transformFlags |= AVIF_TRANSFORM_IMIR;
+            image->imir.axis = 1;
+            break;
+        case 3:  // rotate 180
+            image->transformFlags |= AVIF_TRANSFORM_IROT;
+            image->irot.angle = 2;
+            break;
+        case 4:  // mirror vertical
+            image->transformFlags |= AVIF_TRANSFORM_IMIR;
+            image->imir.axis = 0;
+            break;
+        case 5:  // transpose
+            image->transformFlags |= AVIF_TRANSFORM_IROT | AVIF_TRANSFORM_IMIR;
+            image->irot.angle = 1;
+            image->imir.axis = 0;
+            break;
+        case 6:  // rotate 90 clockwise
+            image->transformFlags |= AVIF_TRANSFORM_IROT;
+            image->irot.angle = 3;
+            break;
+        case 7:  // transverse
+            image->transformFlags |= AVIF_TRANSFORM_IROT | AVIF_TRANSFORM_IMIR;
+            image->irot.angle = 3;
+            image->imir.axis = 0;
+            break;
+        case 8:  // rotate 270 clockwise
+            image->transformFlags |= AVIF_TRANSFORM_IROT;
+            image->irot.angle = 1;
+            break;
+        default:
+            break;
+    }
+}
+
+bool setSourceMetadata(JNIEnv* env, avifImage* image, jint exifOrientation, jbyteArray exif, jbyteArray icc) {
+    if (exif) {
+        ScopedByteArrayElements exifBytes(env, exif);
+        if (!exifBytes.data()) {
+            return false;
+        }
+        avifResult result = avifImageSetMetadataExif(image, exifBytes.data(),
+                                                     static_cast<size_t>(exifBytes.length()));
+        if (result != AVIF_RESULT_OK) {
+            LOGE("Failed to attach Exif metadata: %s", avifResultToString(result));
+            return false;
+        }
+    }
+    if (icc) {
+        ScopedByteArrayElements iccBytes(env, icc);
+        if (!iccBytes.data()) {
+            return false;
+        }
+        avifResult result = avifImageSetProfileICC(image, iccBytes.data(), static_cast<size_t>(iccBytes.length()));
+        if (result != AVIF_RESULT_OK) {
+            LOGE("Failed to attach ICC profile: %s", avifResultToString(result));
+            return false;
+        }
+    }
+    // After the Exif payload, so the transforms always match the orientation passed in
+    setTransforms(image, exifOrientation);
+    if (exifOrientation > 1) {
+        LOGD("Orientation %d stored as irot=%u imir=%u", exifOrientation,
+             (image->transformFlags & AVIF_TRANSFORM_IROT) ? image->irot.angle : 0u,
+             (image->transformFlags & AVIF_TRANSFORM_IMIR) ? image->imir.axis : 0u);
+    }
+    return true;
+}
+
+int displayOrientation(const avifImage* image) {
+    const bool rotated = (image->transformFlags & AVIF_TRANSFORM_IROT) != 0;
+    const bool mirrored = (image->transformFlags & AVIF_TRANSFORM_IMIR) != 0;
+    if (rotated || mirrored) {
+        // A left-to-right mirror is a half turn plus a top-to-bottom mirror
+        int turns = rotated ? image->irot.angle & 3 : 0;
+        if (mirrored && image->imir.axis == 1) {
+            turns = (turns + 2) & 3;
+        }
+        static const int kPlain[4] = {1, 8, 3, 6};
+        static const int kFlipped[4] = {4, 5, 2, 7};
+        return mirrored ? kFlipped[turns] : kPlain[turns];
+    }
+
+    if (image->exif.size > 0) {
+        size_t offset = 0;
+        if (avifGetExifOrientationOffset(image->exif.data, image->exif.size, &offset) == AVIF_RESULT_OK &&
+            offset < image->exif.size) {
+            int value = image->exif.data[offset];
+            if (value >= 1 && value <= 8) {
+                return value;
+            }
+        }
+    }
+    return 1;
+}
+
+bool swapsAxes(int exifOrientation) {
+    return exifOrientation >= 5 && exifOrientation <= 8;
+}
+
+void displaySize(int exifOrientation, uint32_t width, uint32_t height,
+                 uint32_t* displayWidth, uint32_t* displayHeight) {
+    const bool swap = swapsAxes(exifOrientation);
+    *displayWidth = swap ? height : width;
+    *displayHeight = swap ? width : height;
+}
+
+void displayRect(int exifOrientation, uint32_t width, uint32_t height, const avifCropRect& stored,
+                 avifCropRect* displayed) {
+    // Map two opposite corners; the transform keeps rectangles axis-aligned
+    const Transform t = transformFor(exifOrientation, width, height);
+    auto map = [&t](uint32_t x, uint32_t y, int* dx, int* dy) {
+        *dx = t.xx * static_cast<int>(x) + t.xy * static_cast<int>(y) + t.x0;
+        *dy = t.yx * static_cast<int>(x) + t.yy * static_cast<int>(y) + t.y0;
+    };
+    int x0, y0, x1, y1;
+    map(stored.x, stored.y, &x0, &y0);
+    map(stored.x + stored.width - 1, stored.y + stored.height - 1, &x1, &y1);
+    *displayed = cornersToRect(x0, y0, x1, y1);
+}
+
+void storedRect(int exifOrientation, uint32_t width, uint32_t height, const avifCropRect& displayed,
+                avifCropRect* stored) {
+    // The transform is a signed permutation plus an offset, so its inverse uses the transposed matrix
+    const Transform t = transformFor(exifOrientation, width, height);
+    auto unmap = [&t](uint32_t dx, uint32_t dy, int* x, int* y) {
+        const int u = static_cast<int>(dx) - t.x0;
+        const int v = static_cast<int>(dy) - t.y0;
+        *x = t.xx * u + t.yx * v;
+        *y = t.xy * u + t.yy * v;
+    };
+    int x0, y0, x1, y1;
+    unmap(displayed.x, displayed.y, &x0, &y0);
+    unmap(displayed.x + displayed.width - 1, displayed.y + displayed.height - 1, &x1, &y1);
+    *stored = cornersToRect(x0, y0, x1, y1);
+}
+
+avifResult convertOriented(const avifImage* image, int exifOrientation, uint32_t pixelBytes,
+                           uint8_t* pixels, uint32_t rowBytes, const StripConverter& convertStrip) {
+    const Transform t = transformFor(exifOrientation, image->width, image->height);
+    const uint32_t stripRowBytes = image->width * pixelBytes;
+    const uint32_t stripRows = std::min(kOrientStripRows + 2 * chromaContextRows(image), image->height);
+    std::vector<uint8_t> strip(static_cast<size_t>(stripRowBytes) * stripRows);
+
+    // kOrientStripRows is even, so every view starts on a chroma row. Each strip is
+    // converted with its chroma context and only its own rows are scattered, so
+    // strip edges match a conversion of the whole image.
+    AvifImagePtr view(avifImageCreateEmpty());
+    if (!view) {
+        return AVIF_RESULT_OUT_OF_MEMORY;
+    }
+    for (uint32_t y = 0; y < image->height; y += kOrientStripRows) {
+        const uint32_t rows = std::min(kOrientStripRows, image->height - y);
+        uint32_t skipRows = 0;
+        avifResult result = setContextView(view.get(), image, y, rows, image->height, &skipRows);
+        if (result == AVIF_RESULT_OK) {
+            result = convertStrip(view.get(), strip.data(), stripRowBytes);
+        }
+        if (result != AVIF_RESULT_OK) {
+            LOGE("Failed to convert rows %u..%u: %s", y, y + rows, avifResultToString(result));
+            return result;
+        }
+        const uint8_t* own = strip.data() + static_cast<size_t>(skipRows) * stripRowBytes;
+        switch (pixelBytes) {
+            case 3: scatterRows<3>(own, stripRowBytes, y, rows, image->width, t, pixels, rowBytes); break;
+            case 4: scatterRows<4>(own, stripRowBytes, y, rows, image->width, t, pixels, rowBytes); break;
+            case 8: scatterRows<8>(own, stripRowBytes, y, rows, image->width, t, pixels, rowBytes); break;
+            default:
+                LOGE("Unsupported pixel size for orientation: %u bytes", pixelBytes);
+                return AVIF_RESULT_NOT_IMPLEMENTED;
+        }
+    }
+    LOGD("Converted %ux%u with orientation %d", image->width, image->height, exifOrientation);
+    return AVIF_RESULT_OK;
+}
+
+avifResult convertImageIntoRgb(const avifImage* image, int exifOrientation, const RgbTarget& target) {
+    if (exifOrientation <= 1 || exifOrientation > 8) {
+        return avifkit::convertImageIntoRgb(image, target);
+    }
+
+    RgbTarget stripTarget = target;
+    return convertOriented(image, exifOrientation, avifRGBFormatChannelCount(target.format), target.pixels,
+                           target.rowBytes, [&stripTarget](avifImage* view, uint8_t* strip, uint32_t stripRowBytes) {
+        stripTarget.pixels = strip;
+        stripTarget.rowBytes = stripRowBytes;
+        return avifkit::convertImageIntoRgb(view, stripTarget);
+    });
+}
+
+#endif // HAVE_LIBAVIF
+
+} // namespace orientation
+} // namespace avifkit
@@ -0,0 +1,99 @@
+#ifndef AVIFKIT_AVIF_ORIENTATION_H
+#define AVIFKIT_AVIF_ORIENTATION_H
+
+#include "avif_common.h"
+
+#include <functional>
+
+/**
+ * Exif orientation <-> AVIF irot/imir transform properties
+ *
+ * Orientation values are the Exif ones (1 = normal ... 8 = rotate 270), which
+ * is also what Android's ExifInterface reports. On encode the pixels stay in
+ * sensor order and the orientation is written as transform properties; on
+ * decode the rotation/mirror is fused into YUV->RGB. Either way no rotated
+ * copy of the frame is ever made.
+ */
+namespace avifkit {
+namespace orientation {
+
+#if HAVE_LIBAVIF
+
+/**
+ * Set irot/imir on an image for an Exif orientation
+ * Orientation 1 and unknown values clear both transforms.
+ */
+void setTransforms(avifImage* image, int exifOrientation);
+
+/**
+ * Attach the source's orientation and (optionally) its Exif payload and ICC profile
+ * exif is the Exif block from the TIFF header on, or nullptr. It is stored
+ * unchanged; readers apply irot/imir and ignore the Exif orientation, as HEIF
+ * requires. icc (or nullptr) is written as the colr ICC profile. Returns false
+ * (and logs) if either could not be stored.
+ */
+bool setSourceMetadata(JNIEnv* env, avifImage* image, jint exifOrientation, jbyteArray exif, jbyteArray icc);
+
+/**
+ * Orientation a decoded image should be displayed in
+ * irot/imir take precedence; without them the Exif payload's orientation is
+ * used (files written by tools that only keep Exif). 1 if neither is present.
+ */
+int displayOrientation(const avifImage* image);
+
+/**
+ * True for the orientations that swap width and height (5-8)
+ */
+bool swapsAxes(int exifOrientation);
+
+/**
+ * Displayed size of a width x height image
+ */
+void displaySize(int exifOrientation, uint32_t width, uint32_t height,
+                 uint32_t* displayWidth, uint32_t* displayHeight);
+
+/**
+ * Displayed rectangle covered by the stored rectangle of a width x height image
+ * Orientations 1-4 map rows to rows, 5-8 map them to columns.
+ */
+void displayRect(int exifOrientation, uint32_t width, uint32_t height, const avifCropRect& stored,
+                 avifCropRect* displayed);
+
+/**
+ * Stored rectangle shown in the displayed rectangle of a width x height (stored size) image
+ * The inverse of displayRect.
+ */
+void storedRect(int exifOrientation, uint32_t width, uint32_t height, const avifCropRect& displayed,
+                avifCropRect* stored);
+
+/**
+ * Converts a view of stored rows into a packed strip (stripRowBytes per row)
+ */
+using StripConverter = std::function<avifResult(avifImage* view, uint8_t* strip, uint32_t stripRowBytes)>;
+
+/**
+ * Convert a decoded image into any pixelBytes-per-pixel layout in display orientation
+ * convertStrip fills strips of stored rows, which are then scattered to their
+ * rotated/mirrored position in pixels (displayed size, rowBytes per row). Views
+ * include chroma context rows (see setContextView) that are converted but not
+ * scattered, so the strip buffer has room for view->height rows. For
+ * layouts convertImageIntoRgb does not cover, e.g. 16-bit and half-float pixels.
+ */
+avifResult convertOriented(const avifImage* image, int exifOrientation, uint32_t pixelBytes,
+                           uint8_t* pixels, uint32_t rowBytes, const StripConverter& convertStrip);
+
+/**
+ * Convert a decoded image into caller memory laid out in display orientation
+ *
+ * The target has the displayed size. Rows are converted in strips into a small
+ * scratch buffer and scattered straight to their rotated/mirrored position, so
+ * the unrotated frame is never materialized. Orientation 1 converts directly.
+ */
+avifResult convertImageIntoRgb(const avifImage* image, int exifOrientation, const RgbTarget& target);
+
+#endif // HAVE_LIBAVIF
+
+} // namespace orientation
+} // namespace avifkit
+
+#endif // AVIFKIT_AVIF_ORIENTATION_H
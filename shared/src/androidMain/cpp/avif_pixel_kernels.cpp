@@ -0,0 +1,904 @@
+#include "avif_pixel_kernels.h"
+
+#include <android/log.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AVIFKIT_KERNELS_X86 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define AVIFKIT_KERNELS_NEON 1
+#endif
+
+#define KERNELS_LOG_TAG "AvifJNI"
+#define KLOGI(...) __android_log_print(ANDROID_LOG_INFO, KERNELS_LOG_TAG, __VA_ARGS__)
+#define KLOGW(...) __android_log_print(ANDROID_LOG_WARN, KERNELS_LOG_TAG, __VA_ARGS__)
+
+// NOTE: this file is compiled with -ffp-contract=off (see CMakeLists.txt) so the
+// compiler never fuses multiply-adds; scalar and SIMD float paths then round identically.
+
+namespace avifkit {
+namespace kernels {
+
+namespace {
+
+/**
+ * Derived constants for one conversion, computed the way libavif evaluates them
+ */
+struct Coeffs {
+    float kr, kg, kb;
+    float cbDenom, crDenom;      // 2 * (1 - kb), 2 * (1 - kr)
+    float krTerm, kbTerm;        // kr * (1 - kr), kb * (1 - kb)
+    float rangeY, biasY, rangeUV, biasUV;
+};
+
+Coeffs makeCoeffs(const YuvParams& params) {
+    Coeffs c;
+    c.kr = params.kr;
+    c.kb = params.kb;
+    c.kg = 1.0f - c.kr - c.kb;
+    c.cbDenom = 2 * (1 - c.kb);
+    c.crDenom = 2 * (1 - c.kr);
+    c.krTerm = c.kr * (1 - c.kr);
+    c.kbTerm = c.kb * (1 - c.kb);
+    if (params.fullRange) {
+        c.rangeY = 255.0f;
+        c.biasY = 0.0f;
+        c.rangeUV = 255.0f;
+    } else {
+        c.rangeY = 219.0f;
+        c.biasY = 16.0f;
+        c.rangeUV = 224.0f;
+    }
+    c.biasUV = 128.0f;
+    return c;
+}
+
+inline float roundHalfUp(float v) {
+    return std::floor(v + 0.5f);
+}
+
+inline uint8_t clampToByte(float v) {
+    int i = static_cast<int>(v);
+    return static_cast<uint8_t>(std::min(255, std::max(0, i)));
+}
+
+inline uint8_t yToUnorm(const Coeffs& c, float y) {
+    y = std::min(1.0f, std::max(0.0f, y));
+    return clampToByte(roundHalfUp(y * c.rangeY + c.biasY));
+}
+
+inline uint8_t uvToUnorm(const Coeffs& c, float uv) {
+    uv = std::min(0.5f, std::max(-0.5f, uv));
+    return clampToByte(roundHalfUp(uv * c.rangeUV + c.biasUV));
+}
+
+// ==========================================
+// Scalar kernels (reference output)
+// ==========================================
+
+void swapRedBlueScalar(const uint8_t* src, uint8_t* dst, size_t pixelCount) {
+    for (size_t i = 0; i < pixelCount; i++) {
+        uint8_t r = src[i * 4 + 0];
+        uint8_t g = src[i * 4 + 1];
+        uint8_t b = src[i * 4 + 2];
+        uint8_t a = src[i * 4 + 3];
+        dst[i * 4 + 0] = b;
+        dst[i * 4 + 1] = g;
+        dst[i * 4 + 2] = r;
+        dst[i * 4 + 3] = a;
+    }
+}
+
+bool alphaOpaqueScalar(const uint8_t* pixels, size_t pixelCount, int alphaOffset) {
+    uint8_t acc = 0xFF;
+    for (size_t i = 0; i < pixelCount; i++) {
+        acc &= pixels[i * 4 + alphaOffset];
+    }
+    return acc == 0xFF;
+}
+
+void premultiplyScalar(uint8_t* pixels, size_t pixelCount) {
+    for (size_t i = 0; i < pixelCount; i++) {
+        uint8_t* p = pixels + i * 4;
+        uint32_t a = p[3];
+        if (a == 255) continue;
+        // round(c * a / 255), exact integer form
+        for (int ch = 0; ch < 3; ch++) {
+            uint32_t t = p[ch] * a + 128;
+            p[ch] = static_cast<uint8_t>((t + (t >> 8)) >> 8);
+        }
+    }
+}
+
+void unpremultiplyScalar(uint8_t* pixels, size_t pixelCount) {
+    for (size_t i = 0; i < pixelCount; i++) {
+        uint8_t* p = pixels + i * 4;
+        uint8_t a = p[3];
+        if (a == 255) continue;
+        if (a == 0) {
+            p[0] = p[1] = p[2] = 0;
+            continue;
+        }
+        float c = 255.0f / static_cast<float>(a);
+        for (int ch = 0; ch < 3; ch++) {
+            p[ch] = static_cast<uint8_t>(std::min(roundHalfUp(static_cast<float>(p[ch]) * c), 255.0f));
+        }
+    }
+}
+
+/**
+ * One row RGBA -> Y bytes plus unquantized Cb/Cr per pixel
+ */
+void rgbaRowToYuvScalar(const uint8_t* rgba, uint32_t width, const Coeffs& c,
+                        uint8_t* yOut, float* cbOut, float* crOut) {
+    for (uint32_t x = 0; x < width; x++) {
+        float r = static_cast<float>(rgba[x * 4 + 0]) / 255.0f;
+        float g = static_cast<float>(rgba[x * 4 + 1]) / 255.0f;
+        float b = static_cast<float>(rgba[x * 4 + 2]) / 255.0f;
+        float y = (c.kr * r) + (c.kg * g) + (c.kb * b);
+        yOut[x] = yToUnorm(c, y);
+        cbOut[x] = (b - y) / c.cbDenom;
+        crOut[x] = (r - y) / c.crDenom;
+    }
+}
+
+/**
+ * One row Y bytes plus upsampled Cb/Cr -> RGBA
+ */
+void yuvRowToRgbaScalar(const uint8_t* yIn, const float* cbIn, const float* crIn, const uint8_t* aIn,
+                        uint32_t width, const Coeffs& c, uint8_t* rgba) {
+    for (uint32_t x = 0; x < width; x++) {
+        float y = (static_cast<float>(yIn[x]) - c.biasY) / c.rangeY;
+        float cb = cbIn[x];
+        float cr = crIn[x];
+        float r = y + c.crDenom * cr;
+        float b = y + c.cbDenom * cb;
+        float g = y - ((2 * ((c.krTerm * cr) + (c.kbTerm * cb))) / c.kg);
+        r = std::min(1.0f, std::max(0.0f, r));
+        g = std::min(1.0f, std::max(0.0f, g));
+        b = std::min(1.0f, std::max(0.0f, b));
+        rgba[x * 4 + 0] = static_cast<uint8_t>(0.5f + (r * 255.0f));
+        rgba[x * 4 + 1] = static_cast<uint8_t>(0.5f + (g * 255.0f));
+        rgba[x * 4 + 2] = static_cast<uint8_t>(0.5f + (b * 255.0f));
+        rgba[x * 4 + 3] = aIn ? aIn[x] : 255;
+    }
+}
+
+// ==========================================
+// x86: SSE4.1 and AVX2
+// ==========================================
+#if AVIFKIT_KERNELS_X86
+
+__attribute__((target("sse4.1")))
+void swapRedBlueSse41(const uint8_t* src, uint8_t* dst, size_t pixelCount) {
+    const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    size_t i = 0;
+    for (; i + 4 <= pixelCount; i += 4) {
+        __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_shuffle_epi8(px, shuffle));
+    }
+    swapRedBlueScalar(src + i * 4, dst + i * 4, pixelCount - i);
+}
+
+__attribute__((target("avx2")))
+void swapRedBlueAvx2(const uint8_t* src, uint8_t* dst, size_t pixelCount) {
+    const __m256i shuffle = _mm256_setr_epi8(
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    size_t i = 0;
+    for (; i + 8 <= pixelCount; i += 8) {
+        __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_shuffle_epi8(px, shuffle));
+    }
+    swapRedBlueSse41(src + i * 4, dst + i * 4, pixelCount - i);
+}
+
+/**
+ * AND of all 4-byte groups in a 16-byte accumulator, checked at the alpha lanes
+ */
+inline bool alphaLanesOpaque(const uint8_t* acc, size_t laneCount, int alphaOffset) {
+    for (size_t i = static_cast<size_t>(alphaOffset); i < laneCount; i += 4) {
+        if (acc[i] != 0xFF) return false;
+    }
+    return true;
+}
+
+__attribute__((target("sse4.1")))
+bool alphaOpaqueSse41(const uint8_t* pixels, size_t pixelCount, int alphaOffset) {
+    __m128i acc = _mm_set1_epi8(-1);
+    size_t i = 0;
+    for (; i + 4 <= pixelCount; i += 4) {
+        acc = _mm_and_si128(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i * 4)));
+    }
+    alignas(16) uint8_t lanes[16];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc);
+    return alphaLanesOpaque(lanes, 16, alphaOffset) && alphaOpaqueScalar(pixels + i * 4, pixelCount - i, alphaOffset);
+}
+
+__attribute__((target("avx2")))
+bool alphaOpaqueAvx2(const uint8_t* pixels, size_t pixelCount, int alphaOffset) {
+    __m256i acc = _mm256_set1_epi8(-1);
+    size_t i = 0;
+    for (; i + 8 <= pixelCount; i += 8) {
+        acc = _mm256_and_si256(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + i * 4)));
+    }
+    alignas(32) uint8_t lanes[32];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    return alphaLanesOpaque(lanes, 32, alphaOffset) && alphaOpaqueScalar(pixels + i * 4, pixelCount - i, alphaOffset);
+}
+
+/**
+ * Premultiply 2 pixels held as 16-bit lanes; alpha lanes are left untouched
+ */
+__attribute__((target("sse4.1")))
+inline __m128i premultiplyLanesSse41(__m128i px16) {
+    // Broadcast alpha (lane 3 and 7) to the color lanes of each pixel
+    const __m128i alphaShuffle = _mm_setr_epi8(6, 7, 6, 7, 6, 7, 6, 7, 14, 15, 14, 15, 14, 15, 14, 15);
+    __m128i alpha = _mm_shuffle_epi8(px16, alphaShuffle);
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(px16, alpha), _mm_set1_epi16(128));
+    __m128i result = _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+    // Keep original alpha
+    return _mm_blend_epi16(result, px16, 0x88);
+}
+
+__attribute__((target("sse4.1")))
+void premultiplySse41(uint8_t* pixels, size_t pixelCount) {
+    size_t i = 0;
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 4 <= pixelCount; i += 4) {
+        __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i * 4));
+        __m128i lo = premultiplyLanesSse41(_mm_unpacklo_epi8(px, zero));
+        __m128i hi = premultiplyLanesSse41(_mm_unpackhi_epi8(px, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i * 4), _mm_packus_epi16(lo, hi));
+    }
+    premultiplyScalar(pixels + i * 4, pixelCount - i);
+}
+
+__attribute__((target("avx2")))
+void premultiplyAvx2(uint8_t* pixels, size_t pixelCount) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i alphaShuffle = _mm256_setr_epi8(
+        6, 7, 6, 7, 6, 7, 6, 7, 14, 15, 14, 15, 14, 15, 14, 15,
+        6, 7, 6, 7, 6, 7, 6, 7, 14, 15, 14, 15, 14, 15, 14, 15);
+    const __m256i bias = _mm256_set1_epi16(128);
+    size_t i = 0;
+    for (; i + 8 <= pixelCount; i += 8) {
+        __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + i * 4));
+        __m256i halves[2] = { _mm256_unpacklo_epi8(px, zero), _mm256_unpackhi_epi8(px, zero) };
+        for (__m256i& px16 : halves) {
+            __m256i alpha = _mm256_shuffle_epi8(px16, alphaShuffle);
+            __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(px16, alpha), bias);
+            __m256i result = _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+            px16 = _mm256_blend_epi16(result, px16, 0x88);
+        }
+        // unpack/pack operate per 128-bit lane, so the pixel order is preserved
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels + i * 4), _mm256_packus_epi16(halves[0], halves[1]));
+    }
+    premultiplySse41(pixels + i * 4, pixelCount - i);
+}
+
+__attribute__((target("sse4.1")))
+void unpremultiplySse41(uint8_t* pixels, size_t pixelCount) {
+    const __m128i byteMask = _mm_set1_epi32(0xFF);
+    const __m128 max = _mm_set1_ps(255.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 zero = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= pixelCount; i += 4) {
+        __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i * 4));
+        __m128i a = _mm_srli_epi32(px, 24);
+        __m128 af = _mm_cvtepi32_ps(a);
+        __m128 scale = _mm_div_ps(max, af);
+        __m128 zeroAlpha = _mm_cmpeq_ps(af, zero);
+        __m128i out = _mm_slli_epi32(a, 24);
+        for (int ch = 0; ch < 3; ch++) {
+            __m128 c = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(px, ch * 8), byteMask));
+            __m128 v = _mm_min_ps(_mm_floor_ps(_mm_add_ps(_mm_mul_ps(c, scale), half)), max);
+            v = _mm_andnot_ps(zeroAlpha, v);
+            out = _mm_or_si128(out, _mm_slli_epi32(_mm_cvttps_epi32(v), ch * 8));
+        }
+        // Opaque pixels are left untouched (as in the scalar path)
+        __m128i opaque = _mm_cmpeq_epi32(a, byteMask);
+        out = _mm_blendv_epi8(out, px, opaque);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i * 4), out);
+    }
+    unpremultiplyScalar(pixels + i * 4, pixelCount - i);
+}
+
+__attribute__((target("sse4.1")))
+void rgbaRowToYuvSse41(const uint8_t* rgba, uint32_t width, const Coeffs& c,
+                       uint8_t* yOut, float* cbOut, float* crOut) {
+    const __m128i byteMask = _mm_set1_epi32(0xFF);
+    const __m128 max = _mm_set1_ps(255.0f);
+    const __m128 kr = _mm_set1_ps(c.kr), kg = _mm_set1_ps(c.kg), kb = _mm_set1_ps(c.kb);
+    const __m128 cbDenom = _mm_set1_ps(c.cbDenom), crDenom = _mm_set1_ps(c.crDenom);
+    const __m128 rangeY = _mm_set1_ps(c.rangeY), biasY = _mm_set1_ps(c.biasY);
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), half = _mm_set1_ps(0.5f);
+    uint32_t x = 0;
+    for (; x + 4 <= width; x += 4) {
+        __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + x * 4));
+        __m128 r = _mm_div_ps(_mm_cvtepi32_ps(_mm_and_si128(px, byteMask)), max);
+        __m128 g = _mm_div_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(px, 8), byteMask)), max);
+        __m128 b = _mm_div_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(px, 16), byteMask)), max);
+        __m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(kr, r), _mm_mul_ps(kg, g)), _mm_mul_ps(kb, b));
+        _mm_storeu_ps(cbOut + x, _mm_div_ps(_mm_sub_ps(b, y), cbDenom));
+        _mm_storeu_ps(crOut + x, _mm_div_ps(_mm_sub_ps(r, y), crDenom));
+
+        __m128 yc = _mm_min_ps(one, _mm_max_ps(zero, y));
+        __m128i yi = _mm_cvttps_epi32(_mm_floor_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(yc, rangeY), biasY), half)));
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(yi, yi), _mm_setzero_si128());
+        int32_t bytes = _mm_cvtsi128_si32(packed);
+        std::memcpy(yOut + x, &bytes, 4);
+    }
+    rgbaRowToYuvScalar(rgba + x * 4, width - x, c, yOut + x, cbOut + x, crOut + x);
+}
+
+__attribute__((target("avx2")))
+void rgbaRowToYuvAvx2(const uint8_t* rgba, uint32_t width, const Coeffs& c,
+                      uint8_t* yOut, float* cbOut, float* crOut) {
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+    const __m256 max = _mm256_set1_ps(255.0f);
+    const __m256 kr = _mm256_set1_ps(c.kr), kg = _mm256_set1_ps(c.kg), kb = _mm256_set1_ps(c.kb);
+    const __m256 cbDenom = _mm256_set1_ps(c.cbDenom), crDenom = _mm256_set1_ps(c.crDenom);
+    const __m256 rangeY = _mm256_set1_ps(c.rangeY), biasY = _mm256_set1_ps(c.biasY);
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f), half = _mm256_set1_ps(0.5f);
+    uint32_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rgba + x * 4));
+        __m256 r = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_and_si256(px, byteMask)), max);
+        __m256 g = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(px, 8), byteMask)), max);
+        __m256 b = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(px, 16), byteMask)), max);
+        __m256 y = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(kr, r), _mm256_mul_ps(kg, g)), _mm256_mul_ps(kb, b));
+        _mm256_storeu_ps(cbOut + x, _mm256_div_ps(_mm256_sub_ps(b, y), cbDenom));
+        _mm256_storeu_ps(crOut + x, _mm256_div_ps(_mm256_sub_ps(r, y), crDenom));
+
+        __m256 yc = _mm256_min_ps(one, _mm256_max_ps(zero, y));
+        __m256i yi = _mm256_cvttps_epi32(
+            _mm256_floor_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(yc, rangeY), biasY), half)));
+        // Narrow 8 x int32 to bytes (values already within 0..255)
+        __m128i lo = _mm256_castsi256_si128(yi);
+        __m128i hi = _mm256_extracti128_si256(yi, 1);
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(lo, hi), _mm_setzero_si128());
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(yOut + x), packed);
+    }
+    rgbaRowToYuvSse41(rgba + x * 4, width - x, c, yOut + x, cbOut + x, crOut + x);
+}
+
+__attribute__((target("sse4.1")))
+void yuvRowToRgbaSse41(const uint8_t* yIn, const float* cbIn, const float* crIn, const uint8_t* aIn,
+                       uint32_t width, const Coeffs& c, uint8_t* rgba) {
+    const __m128 biasY = _mm_set1_ps(c.biasY), rangeY = _mm_set1_ps(c.rangeY);
+    const __m128 crDenom = _mm_set1_ps(c.crDenom), cbDenom = _mm_set1_ps(c.cbDenom);
+    const __m128 krTerm = _mm_set1_ps(c.krTerm), kbTerm = _mm_set1_ps(c.kbTerm);
+    const __m128 kg = _mm_set1_ps(c.kg), two = _mm_set1_ps(2.0f);
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), half = _mm_set1_ps(0.5f);
+    const __m128 max = _mm_set1_ps(255.0f);
+    uint32_t x = 0;
+    for (; x + 4 <= width; x += 4) {
+        int32_t yBytes;
+        std::memcpy(&yBytes, yIn + x, 4);
+        __m128 y = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(yBytes)));
+        y = _mm_div_ps(_mm_sub_ps(y, biasY), rangeY);
+        __m128 cb = _mm_loadu_ps(cbIn + x);
+        __m128 cr = _mm_loadu_ps(crIn + x);
+        __m128 r = _mm_add_ps(y, _mm_mul_ps(crDenom, cr));
+        __m128 b = _mm_add_ps(y, _mm_mul_ps(cbDenom, cb));
+        __m128 g = _mm_sub_ps(y, _mm_div_ps(
+            _mm_mul_ps(two, _mm_add_ps(_mm_mul_ps(krTerm, cr), _mm_mul_ps(kbTerm, cb))), kg));
+
+        __m128i ri = _mm_cvttps_epi32(_mm_floor_ps(_mm_add_ps(half, _mm_mul_ps(_mm_min_ps(one, _mm_max_ps(zero, r)), max))));
+        __m128i gi = _mm_cvttps_epi32(_mm_floor_ps(_mm_add_ps(half, _mm_mul_ps(_mm_min_ps(one, _mm_max_ps(zero, g)), max))));
+        __m128i bi = _mm_cvttps_epi32(_mm_floor_ps(_mm_add_ps(half, _mm_mul_ps(_mm_min_ps(one, _mm_max_ps(zero, b)), max))));
+        __m128i ai;
+        if (aIn) {
+            int32_t aBytes;
+            std::memcpy(&aBytes, aIn + x, 4);
+            ai = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(aBytes));
+        } else {
+            ai = _mm_set1_epi32(255);
+        }
+        __m128i px = _mm_or_si128(_mm_or_si128(ri, _mm_slli_epi32(gi, 8)),
+                                  _mm_or_si128(_mm_slli_epi32(bi, 16), _mm_slli_epi32(ai, 24)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + x * 4), px);
+    }
+    yuvRowToRgbaScalar(yIn + x, cbIn + x, crIn + x, aIn ? aIn + x : nullptr, width - x, c, rgba + x * 4);
+}
+
+__attribute__((target("avx2")))
+void yuvRowToRgbaAvx2(const uint8_t* yIn, const float* cbIn, const float* crIn, const uint8_t* aIn,
+                      uint32_t width, const Coeffs& c, uint8_t* rgba) {
+    const __m256 biasY = _mm256_set1_ps(c.biasY), rangeY = _mm256_set1_ps(c.rangeY);
+    const __m256 crDenom = _mm256_set1_ps(c.crDenom), cbDenom = _mm256_set1_ps(c.cbDenom);
+    const __m256 krTerm = _mm256_set1_ps(c.krTerm), kbTerm = _mm256_set1_ps(c.kbTerm);
+    const __m256 kg = _mm256_set1_ps(c.kg), two = _mm256_set1_ps(2.0f);
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f), half = _mm256_set1_ps(0.5f);
+    const __m256 max = _mm256_set1_ps(255.0f);
+    uint32_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m256 y = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(yIn + x))));
+        y = _mm256_div_ps(_mm256_sub_ps(y, biasY), rangeY);
+        __m256 cb = _mm256_loadu_ps(cbIn + x);
+        __m256 cr = _mm256_loadu_ps(crIn + x);
+        __m256 r = _mm256_add_ps(y, _mm256_mul_ps(crDenom, cr));
+        __m256 b = _mm256_add_ps(y, _mm256_mul_ps(cbDenom, cb));
+        __m256 g = _mm256_sub_ps(y, _mm256_div_ps(
+            _mm256_mul_ps(two, _mm256_add_ps(_mm256_mul_ps(krTerm, cr), _mm256_mul_ps(kbTerm, cb))), kg));
+
+        __m256i ri = _mm256_cvttps_epi32(_mm256_floor_ps(_mm256_add_ps(half, _mm256_mul_ps(_mm256_min_ps(one, _mm256_max_ps(zero, r)), max))));
+        __m256i gi = _mm256_cvttps_epi32(_mm256_floor_ps(_mm256_add_ps(half, _mm256_mul_ps(_mm256_min_ps(one, _mm256_max_ps(zero, g)), max))));
+        __m256i bi = _mm256_cvttps_epi32(_mm256_floor_ps(_mm256_add_ps(half, _mm256_mul_ps(_mm256_min_ps(one, _mm256_max_ps(zero, b)), max))));
+        __m256i ai = aIn
+            ? _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(aIn + x)))
+            : _mm256_set1_epi32(255);
+        __m256i px = _mm256_or_si256(_mm256_or_si256(ri, _mm256_slli_epi32(gi, 8)),
+                                     _mm256_or_si256(_mm256_slli_epi32(bi, 16), _mm256_slli_epi32(ai, 24)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgba + x * 4), px);
+    }
+    yuvRowToRgbaSse41(yIn + x, cbIn + x, crIn + x, aIn ? aIn + x : nullptr, width - x, c, rgba + x * 4);
+}
+
+#endif // AVIFKIT_KERNELS_X86
+
+// ==========================================
+// ARM: NEON
+// ==========================================
+#if AVIFKIT_KERNELS_NEON
+
+void swapRedBlueNeon(const uint8_t* src, uint8_t* dst, size_t pixelCount) {
+    size_t i = 0;
+    for (; i + 16 <= pixelCount; i += 16) {
+        uint8x16x4_t px = vld4q_u8(src + i * 4);
+        uint8x16_t r = px.val[0];
+        px.val[0] = px.val[2];
+        px.val[2] = r;
+        vst4q_u8(dst + i * 4, px);
+    }
+    swapRedBlueScalar(src + i * 4, dst + i * 4, pixelCount - i);
+}
+
+bool alphaOpaqueNeon(const uint8_t* pixels, size_t pixelCount, int alphaOffset) {
+    uint8x16_t acc = vdupq_n_u8(0xFF);
+    size_t i = 0;
+    for (; i + 16 <= pixelCount; i += 16) {
+        acc = vandq_u8(acc, vld4q_u8(pixels + i * 4).val[alphaOffset]);
+    }
+    uint8_t lanes[16];
+    vst1q_u8(lanes, acc);
+    uint8_t all = 0xFF;
+    for (uint8_t lane : lanes) all &= lane;
+    return all == 0xFF && alphaOpaqueScalar(pixels + i * 4, pixelCount - i, alphaOffset);
+}
+
+void premultiplyNeon(uint8_t* pixels, size_t pixelCount) {
+    const uint16x8_t bias = vdupq_n_u16(128);
+    size_t i = 0;
+    for (; i + 8 <= pixelCount; i += 8) {
+        uint8x8x4_t px = vld4_u8(pixels + i * 4);
+        for (int ch = 0; ch < 3; ch++) {
+            uint16x8_t t = vaddq_u16(vmull_u8(px.val[ch], px.val[3]), bias);
+            px.val[ch] = vshrn_n_u16(vaddq_u16(t, vshrq_n_u16(t, 8)), 8);
+        }
+        vst4_u8(pixels + i * 4, px);
+    }
+    premultiplyScalar(pixels + i * 4, pixelCount - i);
+}
+
+#if defined(__aarch64__)
+
+void unpremultiplyNeon(uint8_t* pixels, size_t pixelCount) {
+    const float32x4_t max = vdupq_n_f32(255.0f);
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    size_t i = 0;
+    for (; i + 4 <= pixelCount; i += 4) {
+        uint32x4_t px = vld1q_u32(reinterpret_cast<const uint32_t*>(pixels + i * 4));
+        uint32x4_t a = vshrq_n_u32(px, 24);
+        float32x4_t scale = vdivq_f32(max, vcvtq_f32_u32(a));
+        uint32x4_t zeroAlpha = vceqq_u32(a, vdupq_n_u32(0));
+        uint32x4_t out = vshlq_n_u32(a, 24);
+        for (int ch = 0; ch < 3; ch++) {
+            uint32x4_t channel = vandq_u32(vshlq_u32(px, vdupq_n_s32(-8 * ch)), vdupq_n_u32(0xFF));
+            float32x4_t v = vminq_f32(vrndmq_f32(vaddq_f32(vmulq_f32(vcvtq_f32_u32(channel), scale), half)), max);
+            uint32x4_t vi = vbicq_u32(vcvtq_u32_f32(v), zeroAlpha);
+            out = vorrq_u32(out, vshlq_u32(vi, vdupq_n_s32(8 * ch)));
+        }
+        // Opaque pixels are left untouched (as in the scalar path)
+        out = vbslq_u32(vceqq_u32(a, vdupq_n_u32(255)), px, out);
+        vst1q_u32(reinterpret_cast<uint32_t*>(pixels + i * 4), out);
+    }
+    unpremultiplyScalar(pixels + i * 4, pixelCount - i);
+}
+
+void rgbaRowToYuvNeon(const uint8_t* rgba, uint32_t width, const Coeffs& c,
+                      uint8_t* yOut, float* cbOut, float* crOut) {
+    const float32x4_t max = vdupq_n_f32(255.0f);
+    const float32x4_t kr = vdupq_n_f32(c.kr), kg = vdupq_n_f32(c.kg), kb = vdupq_n_f32(c.kb);
+    const float32x4_t cbDenom = vdupq_n_f32(c.cbDenom), crDenom = vdupq_n_f32(c.crDenom);
+    const float32x4_t rangeY = vdupq_n_f32(c.rangeY), biasY = vdupq_n_f32(c.biasY);
+    const float32x4_t zero = vdupq_n_f32(0.0f), one = vdupq_n_f32(1.0f), half = vdupq_n_f32(0.5f);
+    uint32_t x = 0;
+    for (; x + 4 <= width; x += 4) {
+        uint32x4_t px = vld1q_u32(reinterpret_cast<const uint32_t*>(rgba + x * 4));
+        uint32x4_t mask = vdupq_n_u32(0xFF);
+        float32x4_t r = vdivq_f32(vcvtq_f32_u32(vandq_u32(px, mask)), max);
+        float32x4_t g = vdivq_f32(vcvtq_f32_u32(vandq_u32(vshrq_n_u32(px, 8), mask)), max);
+        float32x4_t b = vdivq_f32(vcvtq_f32_u32(vandq_u32(vshrq_n_u32(px, 16), mask)), max);
+        float32x4_t y = vaddq_f32(vaddq_f32(vmulq_f32(kr, r), vmulq_f32(kg, g)), vmulq_f32(kb, b));
+        vst1q_f32(cbOut + x, vdivq_f32(vsubq_f32(b, y), cbDenom));
+        vst1q_f32(crOut + x, vdivq_f32(vsubq_f32(r, y), crDenom));
+
+        float32x4_t yc = vminq_f32(one, vmaxq_f32(zero, y));
+        uint32x4_t yi = vcvtq_u32_f32(vrndmq_f32(vaddq_f32(vaddq_f32(vmulq_f32(yc, rangeY), biasY), half)));
+        uint16x4_t y16 = vqmovn_u32(yi);
+        uint8x8_t y8 = vqmovn_u16(vcombine_u16(y16, y16));
+        vst1_lane_u32(reinterpret_cast<uint32_t*>(yOut + x), vreinterpret_u32_u8(y8), 0);
+    }
+    rgbaRowToYuvScalar(rgba + x * 4, width - x, c, yOut + x, cbOut + x, crOut + x);
+}
+
+void yuvRowToRgbaNeon(const uint8_t* yIn, const float* cbIn, const float* crIn, const uint8_t* aIn,
+                      uint32_t width, const Coeffs& c, uint8_t* rgba) {
+    const float32x4_t biasY = vdupq_n_f32(c.biasY), rangeY = vdupq_n_f32(c.rangeY);
+    const float32x4_t crDenom = vdupq_n_f32(c.crDenom), cbDenom = vdupq_n_f32(c.cbDenom);
+    const float32x4_t krTerm = vdupq_n_f32(c.krTerm), kbTerm = vdupq_n_f32(c.kbTerm);
+    const float32x4_t kg = vdupq_n_f32(c.kg), two = vdupq_n_f32(2.0f);
+    const float32x4_t zero = vdupq_n_f32(0.0f), one = vdupq_n_f32(1.0f), half = vdupq_n_f32(0.5f);
+    const float32x4_t max = vdupq_n_f32(255.0f);
+    uint32_t x = 0;
+    for (; x + 4 <= width; x += 4) {
+        uint32x4_t yi = {yIn[x], yIn[x + 1], yIn[x + 2], yIn[x + 3]};
+        float32x4_t y = vdivq_f32(vsubq_f32(vcvtq_f32_u32(yi), biasY), rangeY);
+        float32x4_t cb = vld1q_f32(cbIn + x);
+        float32x4_t cr = vld1q_f32(crIn + x);
+        float32x4_t r = vaddq_f32(y, vmulq_f32(crDenom, cr));
+        float32x4_t b = vaddq_f32(y, vmulq_f32(cbDenom, cb));
+        float32x4_t g = vsubq_f32(y, vdivq_f32(
+            vmulq_f32(two, vaddq_f32(vmulq_f32(krTerm, cr), vmulq_f32(kbTerm, cb))), kg));
+
+        uint32x4_t ri = vcvtq_u32_f32(vrndmq_f32(vaddq_f32(half, vmulq_f32(vminq_f32(one, vmaxq_f32(zero, r)), max))));
+        uint32x4_t gi = vcvtq_u32_f32(vrndmq_f32(vaddq_f32(half, vmulq_f32(vminq_f32(one, vmaxq_f32(zero, g)), max))));
+        uint32x4_t bi = vcvtq_u32_f32(vrndmq_f32(vaddq_f32(half, vmulq_f32(vminq_f32(one, vmaxq_f32(zero, b)), max))));
+        uint32x4_t ai = aIn ? uint32x4_t{aIn[x], aIn[x + 1], aIn[x + 2], aIn[x + 3]} : vdupq_n_u32(255);
+        uint32x4_t px = vorrq_u32(vorrq_u32(ri, vshlq_n_u32(gi, 8)),
+                                  vorrq_u32(vshlq_n_u32(bi, 16), vshlq_n_u32(ai, 24)));
+        vst1q_u32(reinterpret_cast<uint32_t*>(rgba + x * 4), px);
+    }
+    yuvRowToRgbaScalar(yIn + x, cbIn + x, crIn + x, aIn ? aIn + x : nullptr, width - x, c, rgba + x * 4);
+}
+
+#endif // __aarch64__
+#endif // AVIFKIT_KERNELS_NEON
+
+// ==========================================
+// Runtime dispatch
+// ==========================================
+
+using RgbaRowToYuvFn = void (*)(const uint8_t*, uint32_t, const Coeffs&, uint8_t*, float*, float*);
+using YuvRowToRgbaFn = void (*)(const uint8_t*, const float*, const float*, const uint8_t*,
+                                uint32_t, const Coeffs&, uint8_t*);
+
+struct KernelTable {
+    Isa isa = Isa::SCALAR;
+    void (*swapRedBlue)(const uint8_t*, uint8_t*, size_t) = swapRedBlueScalar;
+    void (*premultiply)(uint8_t*, size_t) = premultiplyScalar;
+    bool (*alphaOpaque)(const uint8_t*, size_t, int) = alphaOpaqueScalar;
+    void (*unpremultiply)(uint8_t*, size_t) = unpremultiplyScalar;
+    RgbaRowToYuvFn rgbaRowToYuv = rgbaRowToYuvScalar;
+    YuvRowToRgbaFn yuvRowToRgba = yuvRowToRgbaScalar;
+};
+
+#if AVIFKIT_KERNELS_X86
+constexpr Isa kWidestIsa = Isa::AVX2;
+#elif AVIFKIT_KERNELS_NEON
+constexpr Isa kWidestIsa = Isa::NEON;
+#else
+constexpr Isa kWidestIsa = Isa::SCALAR;
+#endif
+
+/**
+ * Kernels for the widest instruction set the CPU supports, up to `limit`
+ */
+KernelTable detectKernels(Isa limit) {
+    KernelTable table;
+#if AVIFKIT_KERNELS_X86
+    __builtin_cpu_init();
+    if (limit == Isa::AVX2 && __builtin_cpu_supports("avx2")) {
+        table.isa = Isa::AVX2;
+        table.swapRedBlue = swapRedBlueAvx2;
+        table.premultiply = premultiplyAvx2;
+        table.alphaOpaque = alphaOpaqueAvx2;
+        table.unpremultiply = unpremultiplySse41;
+        table.rgbaRowToYuv = rgbaRowToYuvAvx2;
+        table.yuvRowToRgba = yuvRowToRgbaAvx2;
+    } else if ((limit == Isa::AVX2 || limit == Isa::SSE41) && __builtin_cpu_supports("sse4.1")) {
+        table.isa = Isa::SSE41;
+        table.swapRedBlue = swapRedBlueSse41;
+        table.premultiply = premultiplySse41;
+        table.alphaOpaque = alphaOpaqueSse41;
+        table.unpremultiply = unpremultiplySse41;
+        table.rgbaRowToYuv = rgbaRowToYuvSse41;
+        table.yuvRowToRgba = yuvRowToRgbaSse41;
+    }
+#elif AVIFKIT_KERNELS_NEON
+    if (limit == Isa::NEON) {
+        table.isa = Isa::NEON;
+        table.swapRedBlue = swapRedBlueNeon;
+        table.premultiply = premultiplyNeon;
+        table.alphaOpaque = alphaOpaqueNeon;
+#if defined(__aarch64__)
+        table.unpremultiply = unpremultiplyNeon;
+        table.rgbaRowToYuv = rgbaRowToYuvNeon;
+        table.yuvRowToRgba = yuvRowToRgbaNeon;
+#endif
+    }
+#endif
+    return table;
+}
+
+/**
+ * Deterministic test pattern covering every byte value and odd remainders
+ */
+std::vector<uint8_t> testPixels(size_t pixelCount) {
+    std::vector<uint8_t> pixels(pixelCount * 4);
+    uint32_t state = 0x12345678u;
+    for (size_t i = 0; i < pixels.size(); i++) {
+        state = state * 1664525u + 1013904223u;
+        pixels[i] = (i < 1024) ? static_cast<uint8_t>(i * 7) : static_cast<uint8_t>(state >> 24);
+    }
+    return pixels;
+}
+
+/**
+ * Compare every SIMD kernel against its scalar reference; mismatches fall back to scalar
+ */
+void verifyKernels(KernelTable& table) {
+    const size_t count = 1027;  // not a multiple of any vector width
+    std::vector<uint8_t> input = testPixels(count);
+    std::vector<uint8_t> expected(input.size()), actual(input.size());
+
+    swapRedBlueScalar(input.data(), expected.data(), count);
+    table.swapRedBlue(input.data(), actual.data(), count);
+    if (expected != actual) {
+        KLOGW("SIMD swapRedBlue mismatch, using scalar");
+        table.swapRedBlue = swapRedBlueScalar;
+    }
+
+    expected = input;
+    actual = input;
+    premultiplyScalar(expected.data(), count);
+    table.premultiply(actual.data(), count);
+    if (expected != actual) {
+        KLOGW("SIMD premultiply mismatch, using scalar");
+        table.premultiply = premultiplyScalar;
+    }
+
+    // One translucent pixel at each position must be found, and none in an opaque copy
+    std::vector<uint8_t> opaque(input.size(), 0xFF);
+    for (int offset : {0, 3}) {
+        bool agrees = table.alphaOpaque(opaque.data(), count, offset);
+        for (size_t i = 0; i < count && agrees; i++) {
+            opaque[i * 4 + offset] = 0xFE;
+            agrees = table.alphaOpaque(opaque.data(), count, offset) == alphaOpaqueScalar(opaque.data(), count, offset);
+            opaque[i * 4 + offset] = 0xFF;
+        }
+        if (!agrees) {
+            KLOGW("SIMD opaque scan mismatch, using scalar");
+            table.alphaOpaque = alphaOpaqueScalar;
+        }
+    }
+
+    expected = input;
+    actual = input;
+    unpremultiplyScalar(expected.data(), count);
+    table.unpremultiply(actual.data(), count);
+    if (expected != actual) {
+        KLOGW("SIMD unpremultiply mismatch, using scalar");
+        table.unpremultiply = unpremultiplyScalar;
+    }
+
+    YuvParams params[2];
+    params[1].kr = 0.2126f;
+    params[1].kb = 0.0722f;
+    params[1].fullRange = false;
+    for (const YuvParams& p : params) {
+        Coeffs c = makeCoeffs(p);
+
+        std::vector<uint8_t> yExpected(count), yActual(count);
+        std::vector<float> cbExpected(count), crExpected(count), cbActual(count), crActual(count);
+        rgbaRowToYuvScalar(input.data(), count, c, yExpected.data(), cbExpected.data(), crExpected.data());
+        table.rgbaRowToYuv(input.data(), count, c, yActual.data(), cbActual.data(), crActual.data());
+        if (yExpected != yActual ||
+            std::memcmp(cbExpected.data(), cbActual.data(), count * sizeof(float)) != 0 ||
+            std::memcmp(crExpected.data(), crActual.data(), count * sizeof(float)) != 0) {
+            KLOGW("SIMD RGB->YUV mismatch, using scalar");
+            table.rgbaRowToYuv = rgbaRowToYuvScalar;
+        }
+
+        std::vector<uint8_t> alpha(count);
+        for (size_t i = 0; i < count; i++) alpha[i] = input[i * 4 + 3];
+        for (const uint8_t* a : {static_cast<const uint8_t*>(nullptr), static_cast<const uint8_t*>(alpha.data())}) {
+            yuvRowToRgbaScalar(yExpected.data(), cbExpected.data(), crExpected.data(), a, count, c, expected.data());
+            table.yuvRowToRgba(yExpected.data(), cbExpected.data(), crExpected.data(), a, count, c, actual.data());
+            if (expected != actual) {
+                KLOGW("SIMD YUV->RGB mismatch, using scalar");
+                table.yuvRowToRgba = yuvRowToRgbaScalar;
+            }
+        }
+    }
+}
+
+KernelTable& kernelTable() {
+    static KernelTable table;
+    return table;
+}
+
+const KernelTable& kernels() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        KernelTable& table = kernelTable();
+        table = detectKernels(kWidestIsa);
+        if (table.isa != Isa::SCALAR) {
+            verifyKernels(table);
+        }
+        KLOGI("Pixel kernels: %s", isaName(table.isa));
+    });
+    return kernelTable();
+}
+
+} // namespace
+
+Isa activeIsa() {
+    return kernels().isa;
+}
+
+void limitIsa(Isa isa) {
+    kernels();
+    kernelTable() = detectKernels(isa);
+    KLOGI("Pixel kernels limited to %s", isaName(kernelTable().isa));
+}
+
+const char* isaName(Isa isa) {
+    switch (isa) {
+        case Isa::SSE41: return "SSE4.1";
+        case Isa::AVX2: return "AVX2";
+        case Isa::NEON: return "NEON";
+        case Isa::SCALAR:
+        default: return "scalar";
+    }
+}
+
+void swapRedBlue(const uint8_t* src, uint8_t* dst, size_t pixelCount) {
+    kernels().swapRedBlue(src, dst, pixelCount);
+}
+
+void premultiplyAlpha(uint8_t* pixels, size_t pixelCount) {
+    kernels().premultiply(pixels, pixelCount);
+}
+
+void unpremultiplyAlpha(uint8_t* pixels, size_t pixelCount) {
+    kernels().unpremultiply(pixels, pixelCount);
+}
+
+bool isOpaque(const uint8_t* pixels, uint32_t rowBytes, uint32_t width, uint32_t height, int alphaOffset) {
+    const KernelTable& table = kernels();
+    for (uint32_t y = 0; y < height; y++) {
+        if (!table.alphaOpaque(pixels + static_cast<size_t>(y) * rowBytes, width, alphaOffset)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void rgbaToYuv8(const uint8_t* rgba, uint32_t rowBytes, uint32_t width, uint32_t height,
+                const YuvParams& params, const Yuv8Planes& out) {
+    const KernelTable& table = kernels();
+    const Coeffs c = makeCoeffs(params);
+    const uint32_t rowsPerBlock = 1u << params.chromaShiftY;
+
+    // Unquantized chroma for the rows of one chroma block
+    std::vector<float> cb(static_cast<size_t>(width) * rowsPerBlock);
+    std::vector<float> cr(cb.size());
+
+    for (uint32_t blockY = 0; blockY < height; blockY += rowsPerBlock) {
+        uint32_t blockH = std::min(rowsPerBlock, height - blockY);
+        for (uint32_t row = 0; row < blockH; row++) {
+            uint32_t y = blockY + row;
+            const uint8_t* src = rgba + static_cast<size_t>(y) * rowBytes;
+            table.rgbaRowToYuv(src, width, c, out.y + static_cast<size_t>(y) * out.yRowBytes,
+                               cb.data() + row * width, cr.data() + row * width);
+            if (out.a) {
+                uint8_t* alpha = out.a + static_cast<size_t>(y) * out.aRowBytes;
+                for (uint32_t x = 0; x < width; x++) alpha[x] = src[x * 4 + 3];
+            }
+        }
+
+        uint32_t uvY = blockY >> params.chromaShiftY;
+        uint8_t* uRow = out.u + static_cast<size_t>(uvY) * out.uRowBytes;
+        uint8_t* vRow = out.v + static_cast<size_t>(uvY) * out.vRowBytes;
+        if (params.chromaShiftX == 0) {
+            // 4:4:4
+            for (uint32_t x = 0; x < width; x++) {
+                uRow[x] = uvToUnorm(c, cb[x]);
+                vRow[x] = uvToUnorm(c, cr[x]);
+            }
+            continue;
+        }
+
+        // 4:2:2 / 4:2:0: average the block (row-major summation, as libavif)
+        for (uint32_t blockX = 0; blockX < width; blockX += 2) {
+            uint32_t blockW = std::min(2u, width - blockX);
+            float sumU = 0.0f;
+            float sumV = 0.0f;
+            for (uint32_t row = 0; row < blockH; row++) {
+                for (uint32_t col = 0; col < blockW; col++) {
+                    sumU += cb[row * width + blockX + col];
+                    sumV += cr[row * width + blockX + col];
+                }
+            }
+            float totalSamples = static_cast<float>(blockW * blockH);
+            uRow[blockX >> 1] = uvToUnorm(c, sumU / totalSamples);
+            vRow[blockX >> 1] = uvToUnorm(c, sumV / totalSamples);
+        }
+    }
+}
+
+void yuv8ToRgba(const Yuv8Planes& in, uint32_t width, uint32_t height,
+                const YuvParams& params, uint8_t* rgba, uint32_t rowBytes) {
+    const KernelTable& table = kernels();
+    const Coeffs c = makeCoeffs(params);
+
+    float uvTable[256];
+    for (int i = 0; i < 256; i++) {
+        uvTable[i] = (static_cast<float>(i) - c.biasUV) / c.rangeUV;
+    }
+
+    const uint32_t uvWidth = (width + (1u << params.chromaShiftX) - 1) >> params.chromaShiftX;
+    std::vector<float> cb(width);
+    std::vector<float> cr(width);
+
+    for (uint32_t y = 0; y < height; y++) {
+        uint32_t uvY = y >> params.chromaShiftY;
+        const uint8_t* u0 = in.u + static_cast<size_t>(uvY) * in.uRowBytes;
+        const uint8_t* v0 = in.v + static_cast<size_t>(uvY) * in.vRowBytes;
+
+        if (params.chromaShiftX == 0) {
+            // 4:4:4: no upsampling
+            for (uint32_t x = 0; x < width; x++) {
+                cb[x] = uvTable[u0[x]];
+                cr[x] = uvTable[v0[x]];
+            }
+        } else {
+            // Bilinear: 9/16 nearest, 3/16 each adjacent column/row, 1/16 diagonal
+            uint32_t adjY = uvY;
+            if (params.chromaShiftY != 0 && y != 0 && !(y == height - 1 && (y & 1))) {
+                adjY = (y & 1) ? uvY + 1 : uvY - 1;
+            }
+            const uint8_t* u1 = in.u + static_cast<size_t>(adjY) * in.uRowBytes;
+            const uint8_t* v1 = in.v + static_cast<size_t>(adjY) * in.vRowBytes;
+            for (uint32_t x = 0; x < width; x++) {
+                uint32_t uvX = x >> 1;
+                uint32_t adjX = uvX;
+                if (x != 0 && !(x == width - 1 && (x & 1))) {
+                    adjX = (x & 1) ? uvX + 1 : uvX - 1;
+                }
+                adjX = std::min(adjX, uvWidth - 1);
+                cb[x] = (uvTable[u0[uvX]] * (9.0f / 16.0f)) + (uvTable[u0[adjX]] * (3.0f / 16.0f)) +
+                        (uvTable[u1[uvX]] * (3.0f / 16.0f)) + (uvTable[u1[adjX]] * (1.0f / 16.0f));
+                cr[x] = (uvTable[v0[uvX]] * (9.0f / 16.0f)) + (uvTable[v0[adjX]] * (3.0f / 16.0f)) +
+                        (uvTable[v1[uvX]] * (3.0f / 16.0f)) + (uvTable[v1[adjX]] * (1.0f / 16.0f));
+            }
+        }
+
+        const uint8_t* alpha = in.a ? in.a + static_cast<size_t>(y) * in.aRowBytes : nullptr;
+        table.yuvRowToRgba(in.y + static_cast<size_t>(y) * in.yRowBytes, cb.data(), cr.data(), alpha,
+                           width, c, rgba + static_cast<size_t>(y) * rowBytes);
+    }
+}
+
+} // namespace kernels
+} // namespace avifkit
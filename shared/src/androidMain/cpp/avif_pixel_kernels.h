@@ -0,0 +1,108 @@
+#ifndef AVIFKIT_AVIF_PIXEL_KERNELS_H
+#define AVIFKIT_AVIF_PIXEL_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Pixel conversion kernels with NEON, SSE4.1/AVX2 and scalar variants
+ *
+ * The scalar variants define the output. SIMD variants are selected at runtime
+ * (CPU feature detection on x86, NEON on ARM builds that have it) and are checked
+ * bit-for-bit against the scalar variants on first use; any mismatch falls back
+ * to scalar. The YUV kernels follow libavif's built-in (non-libyuv) conversion;
+ * callers confirm they match libavif for a given format before relying on them.
+ *
+ * This file has no libavif dependency so it builds in placeholder mode too.
+ */
+namespace avifkit {
+namespace kernels {
+
+enum class Isa {
+    SCALAR,
+    SSE41,
+    AVX2,
+    NEON
+};
+
+/**
+ * Instruction set used by the kernels in this process
+ */
+Isa activeIsa();
+const char* isaName(Isa isa);
+
+/**
+ * Use `isa` from now on if the CPU supports it (AVX2 may fall back to SSE4.1),
+ * otherwise scalar; SCALAR selects the reference variants
+ * For tests and benchmarks comparing variants: the SIMD variants are not checked
+ * against scalar, and switching while other threads convert is unsafe.
+ */
+void limitIsa(Isa isa);
+
+/**
+ * Swap the 1st and 3rd byte of every 4-byte pixel (RGBA <-> BGRA)
+ * On little-endian this also converts RGBA bytes <-> Android ARGB ints.
+ * src and dst may be the same buffer.
+ */
+void swapRedBlue(const uint8_t* src, uint8_t* dst, size_t pixelCount);
+
+/**
+ * Premultiply color by alpha in place (alpha in the 4th byte)
+ * Matches avifRGBImagePremultiplyAlpha for 8-bit.
+ */
+void premultiplyAlpha(uint8_t* pixels, size_t pixelCount);
+
+/**
+ * Undo premultiplication in place (alpha in the 4th byte)
+ * Matches avifRGBImageUnpremultiplyAlpha for 8-bit.
+ */
+void unpremultiplyAlpha(uint8_t* pixels, size_t pixelCount);
+
+/**
+ * True if the alpha byte (at alphaOffset in every 4-byte pixel) is 255 for all pixels
+ * Scanning stops at the first row with a translucent pixel.
+ */
+bool isOpaque(const uint8_t* pixels, uint32_t rowBytes, uint32_t width, uint32_t height, int alphaOffset = 3);
+
+/**
+ * YCbCr coefficients and quantization range for 8-bit conversion
+ */
+struct YuvParams {
+    float kr = 0.299f;
+    float kb = 0.114f;
+    bool fullRange = true;
+    int chromaShiftX = 1;  // 0 for 4:4:4
+    int chromaShiftY = 1;  // 0 for 4:4:4 and 4:2:2
+};
+
+/**
+ * 8-bit planes of a YUV(A) image (alpha optional)
+ */
+struct Yuv8Planes {
+    uint8_t* y = nullptr;
+    uint8_t* u = nullptr;
+    uint8_t* v = nullptr;
+    uint8_t* a = nullptr;
+    uint32_t yRowBytes = 0;
+    uint32_t uRowBytes = 0;
+    uint32_t vRowBytes = 0;
+    uint32_t aRowBytes = 0;
+};
+
+/**
+ * RGBA (straight alpha) to YUV(A), chroma downsampled by averaging
+ */
+void rgbaToYuv8(const uint8_t* rgba, uint32_t rowBytes, uint32_t width, uint32_t height,
+                const YuvParams& params, const Yuv8Planes& out);
+
+/**
+ * YUV(A) to RGBA (straight alpha), chroma upsampled bilinearly
+ * Alpha is 255 when the planes have no alpha.
+ */
+void yuv8ToRgba(const Yuv8Planes& in, uint32_t width, uint32_t height,
+                const YuvParams& params, uint8_t* rgba, uint32_t rowBytes);
+
+} // namespace kernels
+} // namespace avifkit
+
+#endif // AVIFKIT_AVIF_PIXEL_KERNELS_H
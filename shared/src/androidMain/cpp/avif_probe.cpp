@@ -0,0 +1,615 @@
+#include "avif_probe.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace avifkit {
+namespace probe {
+
+namespace {
+
+constexpr uint32_t fourcc(const char (&s)[5]) {
+    return (static_cast<uint32_t>(static_cast<uint8_t>(s[0])) << 24) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(s[1])) << 16) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(s[2])) << 8) |
+           static_cast<uint32_t>(static_cast<uint8_t>(s[3]));
+}
+
+/**
+ * Bounds-checked big-endian reader over a byte range
+ */
+class Reader {
+public:
+    Reader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+    size_t remaining() const { return size_ - pos_; }
+    size_t position() const { return pos_; }
+    const uint8_t* current() const { return data_ + pos_; }
+
+    bool skip(size_t n) {
+        if (n > remaining()) return false;
+        pos_ += n;
+        return true;
+    }
+    bool u8(uint8_t* v) {
+        if (remaining() < 1) return false;
+        *v = data_[pos_++];
+        return true;
+    }
+    bool u16(uint16_t* v) {
+        if (remaining() < 2) return false;
+        *v = static_cast<uint16_t>((data_[pos_] << 8) | data_[pos_ + 1]);
+        pos_ += 2;
+        return true;
+    }
+    bool u32(uint32_t* v) {
+        if (remaining() < 4) return false;
+        *v = (static_cast<uint32_t>(data_[pos_]) << 24) | (static_cast<uint32_t>(data_[pos_ + 1]) << 16) |
+             (static_cast<uint32_t>(data_[pos_ + 2]) << 8) | data_[pos_ + 3];
+        pos_ += 4;
+        return true;
+    }
+    bool u64(uint64_t* v) {
+        uint32_t hi, lo;
+        if (!u32(&hi) || !u32(&lo)) return false;
+        *v = (static_cast<uint64_t>(hi) << 32) | lo;
+        return true;
+    }
+    /**
+     * Item IDs and counts are 16-bit in version 0 boxes and 32-bit otherwise
+     */
+    bool uVar(bool wide, uint32_t* v) {
+        if (wide) return u32(v);
+        uint16_t narrow;
+        if (!u16(&narrow)) return false;
+        *v = narrow;
+        return true;
+    }
+    /**
+     * Version byte of a FullBox (flags are returned too)
+     */
+    bool fullBox(uint8_t* version, uint32_t* flags) {
+        uint32_t word;
+        if (!u32(&word)) return false;
+        *version = static_cast<uint8_t>(word >> 24);
+        *flags = word & 0xFFFFFF;
+        return true;
+    }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_ = 0;
+};
+
+struct BoxHeader {
+    uint32_t type = 0;
+    uint64_t size = 0;      // whole box, header included
+    size_t headerSize = 0;
+    bool toEnd = false;     // size 0: the box runs to the end of its parent (or file)
+};
+
+/**
+ * Read a box header; size 0 ("to the end") is resolved against parentRemaining
+ */
+bool readBoxHeader(Reader& r, uint64_t parentRemaining, BoxHeader* box) {
+    uint32_t size32;
+    if (!r.u32(&size32) || !r.u32(&box->type)) return false;
+    box->headerSize = 8;
+    if (size32 == 1) {
+        if (!r.u64(&box->size)) return false;
+        box->headerSize = 16;
+    } else if (size32 == 0) {
+        box->size = parentRemaining;
+        box->toEnd = true;
+    } else {
+        box->size = size32;
+    }
+    if (box->type == fourcc("uuid")) {
+        if (!r.skip(16)) return false;
+        box->headerSize += 16;
+    }
+    return box->size >= box->headerSize;
+}
+
+/**
+ * Iterate child boxes of a fully available container; returns false if malformed
+ */
+template <typename Visitor>
+bool forEachChild(Reader content, Visitor visit) {
+    while (content.remaining() >= 8) {
+        BoxHeader box;
+        if (!readBoxHeader(content, content.remaining(), &box)) return false;
+        uint64_t payload = box.size - box.headerSize;
+        if (payload > content.remaining()) return false;
+        Reader child(content.current(), static_cast<size_t>(payload));
+        if (!visit(box.type, child)) return false;
+        content.skip(static_cast<size_t>(payload));
+    }
+    return true;
+}
+
+// ==========================================
+// meta (still images)
+// ==========================================
+
+struct Property {
+    uint32_t type;
+    Reader content;
+};
+
+struct Association {
+    uint32_t itemId;
+    std::vector<uint16_t> properties;  // 1-based ipco indices
+};
+
+struct Reference {
+    uint32_t type;
+    uint32_t fromId;
+    uint32_t toId;
+};
+
+struct MetaInfo {
+    bool present = false;
+    uint32_t primaryId = 0;
+    std::vector<std::pair<uint32_t, uint32_t>> itemTypes;  // item ID -> item type
+    std::vector<Property> properties;
+    std::vector<Association> associations;
+    std::vector<Reference> references;
+
+    const Reader* findProperty(uint32_t itemId, uint32_t type) const {
+        for (const Association& association : associations) {
+            if (association.itemId != itemId) continue;
+            for (uint16_t index : association.properties) {
+                if (index >= 1 && index <= properties.size() && properties[index - 1].type == type) {
+                    return &properties[index - 1].content;
+                }
+            }
+        }
+        return nullptr;
+    }
+};
+
+bool parseIinf(Reader r, MetaInfo* meta) {
+    uint8_t version;
+    uint32_t flags;
+    uint32_t entryCount;
+    if (!r.fullBox(&version, &flags) || !r.uVar(version != 0, &entryCount)) return false;
+    return forEachChild(r, [&](uint32_t type, Reader infe) {
+        if (type != fourcc("infe")) return true;
+        uint8_t infeVersion;
+        uint32_t infeFlags;
+        uint32_t itemId;
+        uint16_t protectionIndex;
+        uint32_t itemType;
+        if (!infe.fullBox(&infeVersion, &infeFlags)) return false;
+        if (infeVersion < 2) return true;  // no item_type before version 2
+        if (!infe.uVar(infeVersion >= 3, &itemId) || !infe.u16(&protectionIndex) || !infe.u32(&itemType)) {
+            return false;
+        }
+        meta->itemTypes.emplace_back(itemId, itemType);
+        return true;
+    });
+}
+
+bool parseIref(Reader r, MetaInfo* meta) {
+    uint8_t version;
+    uint32_t flags;
+    if (!r.fullBox(&version, &flags)) return false;
+    return forEachChild(r, [&](uint32_t type, Reader ref) {
+        uint32_t fromId;
+        uint16_t count;
+        if (!ref.uVar(version != 0, &fromId) || !ref.u16(&count)) return false;
+        for (uint16_t i = 0; i < count; i++) {
+            uint32_t toId;
+            if (!ref.uVar(version != 0, &toId)) return false;
+            meta->references.push_back({type, fromId, toId});
+        }
+        return true;
+    });
+}
+
+bool parseIpma(Reader r, MetaInfo* meta) {
+    uint8_t version;
+    uint32_t flags;
+    uint32_t entryCount;
+    if (!r.fullBox(&version, &flags) || !r.u32(&entryCount)) return false;
+    for (uint32_t i = 0; i < entryCount; i++) {
+        Association association;
+        uint8_t count;
+        if (!r.uVar(version >= 1, &association.itemId) || !r.u8(&count)) return false;
+        for (uint8_t j = 0; j < count; j++) {
+            if (flags & 1) {
+                uint16_t value;
+                if (!r.u16(&value)) return false;
+                association.properties.push_back(value & 0x7FFF);
+            } else {
+                uint8_t value;
+                if (!r.u8(&value)) return false;
+                association.properties.push_back(value & 0x7F);
+            }
+        }
+        meta->associations.push_back(std::move(association));
+    }
+    return true;
+}
+
+bool parseMeta(Reader r, MetaInfo* meta) {
+    uint8_t version;
+    uint32_t flags;
+    if (!r.fullBox(&version, &flags)) return false;
+    meta->present = true;
+    return forEachChild(r, [&](uint32_t type, Reader child) {
+        if (type == fourcc("pitm")) {
+            uint8_t pitmVersion;
+            uint32_t pitmFlags;
+            return child.fullBox(&pitmVersion, &pitmFlags) && child.uVar(pitmVersion != 0, &meta->primaryId);
+        }
+        if (type == fourcc("iinf")) return parseIinf(child, meta);
+        if (type == fourcc("iref")) return parseIref(child, meta);
+        if (type == fourcc("iprp")) {
+            return forEachChild(child, [&](uint32_t iprpType, Reader iprpChild) {
+                if (iprpType == fourcc("ipco")) {
+                    return forEachChild(iprpChild, [&](uint32_t propertyType, Reader property) {
+                        meta->properties.push_back({propertyType, property});
+                        return true;
+                    });
+                }
+                if (iprpType == fourcc("ipma")) return parseIpma(iprpChild, meta);
+                return true;
+            });
+        }
+        return true;
+    });
+}
+
+// ==========================================
+// moov (image sequences)
+// ==========================================
+
+struct TrackInfo {
+    uint32_t handler = 0;
+    bool auxiliary = false;   // tref auxl
+    uint32_t width = 0;
+    uint32_t height = 0;
+    bool hasAv1C = false;
+    Reader av1C{nullptr, 0};
+    uint32_t sampleCount = 0;
+};
+
+bool parseSampleEntry(Reader entry, TrackInfo* track) {
+    uint16_t width, height;
+    // VisualSampleEntry: 24 bytes of reserved/predefined fields before width/height
+    if (!entry.skip(24) || !entry.u16(&width) || !entry.u16(&height)) return false;
+    track->width = width;
+    track->height = height;
+    // 50 more bytes (resolution, frame_count, compressorname, depth, pre_defined) precede child boxes
+    if (!entry.skip(50)) return false;
+    return forEachChild(entry, [&](uint32_t type, Reader child) {
+        if (type == fourcc("av1C")) {
+            track->av1C = child;
+            track->hasAv1C = true;
+        }
+        return true;
+    });
+}
+
+bool parseStbl(Reader r, TrackInfo* track) {
+    return forEachChild(r, [&](uint32_t type, Reader child) {
+        uint8_t version;
+        uint32_t flags;
+        if (type == fourcc("stsd")) {
+            uint32_t entryCount;
+            if (!child.fullBox(&version, &flags) || !child.u32(&entryCount)) return false;
+            return forEachChild(child, [&](uint32_t entryType, Reader entry) {
+                if (entryType == fourcc("av01") && track->width == 0) return parseSampleEntry(entry, track);
+                return true;
+            });
+        }
+        if (type == fourcc("stsz")) {
+            uint32_t sampleSize;
+            return child.fullBox(&version, &flags) && child.u32(&sampleSize) && child.u32(&track->sampleCount);
+        }
+        if (type == fourcc("stz2")) {
+            return child.fullBox(&version, &flags) && child.skip(4) && child.u32(&track->sampleCount);
+        }
+        return true;
+    });
+}
+
+bool parseTrak(Reader r, TrackInfo* track) {
+    return forEachChild(r, [&](uint32_t type, Reader child) {
+        if (type == fourcc("tref")) {
+            return forEachChild(child, [&](uint32_t refType, Reader) {
+                if (refType == fourcc("auxl")) track->auxiliary = true;
+                return true;
+            });
+        }
+        if (type == fourcc("mdia")) {
+            return forEachChild(child, [&](uint32_t mdiaType, Reader mdiaChild) {
+                if (mdiaType == fourcc("hdlr")) {
+                    uint8_t version;
+                    uint32_t flags;
+                    uint32_t preDefined;
+                    return mdiaChild.fullBox(&version, &flags) && mdiaChild.u32(&preDefined) &&
+                           mdiaChild.u32(&track->handler);
+                }
+                if (mdiaType == fourcc("minf")) {
+                    return forEachChild(mdiaChild, [&](uint32_t minfType, Reader stbl) {
+                        return minfType != fourcc("stbl") || parseStbl(stbl, track);
+                    });
+                }
+                return true;
+            });
+        }
+        return true;
+    });
+}
+
+// ==========================================
+// Property decoding
+// ==========================================
+
+/**
+ * Depth and chroma subsampling from an AV1CodecConfigurationRecord
+ */
+bool readAv1C(Reader r, ImageProbe* out) {
+    uint8_t markerVersion, profileLevel, flags;
+    if (!r.u8(&markerVersion) || !r.u8(&profileLevel) || !r.u8(&flags)) return false;
+    bool highBitDepth = flags & 0x40;
+    bool twelveBit = flags & 0x20;
+    bool monochrome = flags & 0x10;
+    bool subsamplingX = flags & 0x08;
+    bool subsamplingY = flags & 0x04;
+    if (out->depth == 0) {
+        out->depth = twelveBit ? 12 : (highBitDepth ? 10 : 8);
+    }
+    if (monochrome) {
+        out->subsample = 3;
+    } else if (subsamplingX && subsamplingY) {
+        out->subsample = 2;
+    } else if (subsamplingX) {
+        out->subsample = 1;
+    } else {
+        out->subsample = 0;
+    }
+    return true;
+}
+
+/**
+ * Colour primaries and transfer from the item's nclx colr box (ICC colr boxes are skipped)
+ */
+void readNclx(const MetaInfo& meta, uint32_t itemId, ImageProbe* out) {
+    for (const Association& association : meta.associations) {
+        if (association.itemId != itemId) continue;
+        for (uint16_t index : association.properties) {
+            if (index < 1 || index > meta.properties.size() || meta.properties[index - 1].type != fourcc("colr")) {
+                continue;
+            }
+            Reader colr = meta.properties[index - 1].content;
+            uint32_t colourType;
+            uint16_t primaries, transfer;
+            if (colr.u32(&colourType) && colourType == fourcc("nclx") && colr.u16(&primaries) && colr.u16(&transfer)) {
+                out->colorPrimaries = primaries;
+                out->transferCharacteristics = transfer;
+                return;
+            }
+        }
+    }
+}
+
+bool isAlphaAuxType(Reader auxC) {
+    uint8_t version;
+    uint32_t flags;
+    if (!auxC.fullBox(&version, &flags)) return false;
+    const char* text = reinterpret_cast<const char*>(auxC.current());
+    size_t length = strnlen(text, auxC.remaining());
+    static const char* const kAlphaUrns[] = {
+        "urn:mpeg:mpegB:cicp:systems:auxiliary:alpha",
+        "urn:mpeg:hevc:2015:auxid:1"
+    };
+    for (const char* urn : kAlphaUrns) {
+        if (length == std::strlen(urn) && std::memcmp(text, urn, length) == 0) return true;
+    }
+    return false;
+}
+
+/**
+ * a + b, saturating (box sizes come from the file and may be anything)
+ */
+uint64_t addClamped(uint64_t a, uint64_t b) {
+    return b > UINT64_MAX - a ? UINT64_MAX : a + b;
+}
+
+/**
+ * Exif orientation for the irot/imir properties of an item (1 without either)
+ * irot turns anti-clockwise in quarter turns before imir mirrors about axis 0
+ * (top-to-bottom) or 1 (left-to-right).
+ */
+int readOrientation(const MetaInfo& meta, uint32_t itemId) {
+    int turns = 0;
+    bool mirrored = false;
+    uint8_t value;
+    if (const Reader* irot = meta.findProperty(itemId, fourcc("irot"))) {
+        Reader irotReader = *irot;
+        if (irotReader.u8(&value)) turns = value & 3;
+    }
+    if (const Reader* imir = meta.findProperty(itemId, fourcc("imir"))) {
+        Reader imirReader = *imir;
+        if (imirReader.u8(&value)) {
+            mirrored = true;
+            // A left-to-right mirror is a half turn plus a top-to-bottom mirror
+            if (value & 1) turns = (turns + 2) & 3;
+        }
+    }
+    static const int kPlain[4] = {1, 8, 3, 6};
+    static const int kFlipped[4] = {4, 5, 2, 7};
+    return mirrored ? kFlipped[turns] : kPlain[turns];
+}
+
+bool fillFromMeta(const MetaInfo& meta, ImageProbe* out) {
+    const uint32_t primary = meta.primaryId;
+    const Reader* ispe = meta.findProperty(primary, fourcc("ispe"));
+    if (!ispe) return false;
+    Reader ispeReader = *ispe;
+    uint8_t version;
+    uint32_t flags;
+    if (!ispeReader.fullBox(&version, &flags) || !ispeReader.u32(&out->width) || !ispeReader.u32(&out->height)) {
+        return false;
+    }
+    out->orientation = readOrientation(meta, primary);
+    if (out->orientation >= 5) {
+        std::swap(out->width, out->height);
+    }
+
+    if (const Reader* pixi = meta.findProperty(primary, fourcc("pixi"))) {
+        Reader pixiReader = *pixi;
+        uint8_t channels, bits;
+        if (pixiReader.fullBox(&version, &flags) && pixiReader.u8(&channels) && channels > 0 && pixiReader.u8(&bits)) {
+            out->depth = bits;
+        }
+    }
+
+    // Grids carry av1C on their tiles (dimg references from the grid item)
+    const Reader* av1C = meta.findProperty(primary, fourcc("av1C"));
+    for (const Reference& ref : meta.references) {
+        if (av1C) break;
+        if (ref.type == fourcc("dimg") && ref.fromId == primary) {
+            av1C = meta.findProperty(ref.toId, fourcc("av1C"));
+        }
+    }
+    if (av1C) {
+        readAv1C(*av1C, out);
+    }
+    readNclx(meta, primary, out);
+
+    for (const Reference& ref : meta.references) {
+        if (ref.type != fourcc("auxl") || ref.toId != primary) continue;
+        const Reader* auxC = meta.findProperty(ref.fromId, fourcc("auxC"));
+        if (auxC && isAlphaAuxType(*auxC)) {
+            out->hasAlpha = true;
+            break;
+        }
+    }
+    out->frameCount = 1;
+    return true;
+}
+
+} // namespace
+
+bool hasAvifBrand(const uint8_t* data, size_t size) {
+    Reader r(data, size);
+    BoxHeader box;
+    if (!readBoxHeader(r, size, &box) || box.type != fourcc("ftyp")) return false;
+    // Brands may run past the data we were given; check what is there
+    size_t payload = static_cast<size_t>(std::min<uint64_t>(box.size - box.headerSize, r.remaining()));
+    Reader ftyp(r.current(), payload);
+    uint32_t brand;
+    for (int i = 0; ftyp.u32(&brand); i++) {
+        if (i == 1) continue;  // minor_version
+        if (brand == fourcc("avif") || brand == fourcc("avis")) return true;
+    }
+    return false;
+}
+
+Status probeAvif(const uint8_t* data, size_t size, ImageProbe* out) {
+    *out = ImageProbe();
+    if (!hasAvifBrand(data, size)) {
+        // Too short to hold an ftyp box: ask for more rather than guessing
+        if (size < 16) {
+            out->neededBytes = kDefaultProbeBytes;
+            return Status::NEED_MORE_DATA;
+        }
+        return Status::NOT_AVIF;
+    }
+
+    MetaInfo meta;
+    TrackInfo colorTrack;
+    bool haveColorTrack = false;
+    bool moovParsed = false;
+    uint64_t resumeAt = 0;  // where a longer read would continue, 0 if everything was seen
+
+    Reader top(data, size);
+    while (top.remaining() > 0) {
+        const size_t boxStart = top.position();
+        BoxHeader box;
+        if (!readBoxHeader(top, size - boxStart, &box)) {
+            resumeAt = addClamped(boxStart, kDefaultProbeBytes);
+            break;
+        }
+        const uint64_t boxEnd = addClamped(boxStart, box.size);
+        const size_t available = static_cast<size_t>(std::min<uint64_t>(box.size - box.headerSize, top.remaining()));
+
+        if (box.type == fourcc("ftyp")) {
+            Reader ftyp(top.current(), available);
+            uint32_t brand;
+            for (int i = 0; ftyp.u32(&brand); i++) {
+                if (i != 1 && brand == fourcc("avis")) out->isSequence = true;
+            }
+        } else if (box.type == fourcc("meta") || box.type == fourcc("moov")) {
+            if (boxEnd > size) {
+                out->neededBytes = boxEnd;
+                return Status::NEED_MORE_DATA;
+            }
+            Reader content(top.current(), available);
+            if (box.type == fourcc("meta")) {
+                if (!parseMeta(content, &meta)) return Status::INVALID;
+            } else {
+                moovParsed = true;
+                out->isSequence = true;
+                bool ok = forEachChild(content, [&](uint32_t type, Reader trak) {
+                    if (type != fourcc("trak")) return true;
+                    TrackInfo track;
+                    if (!parseTrak(trak, &track)) return false;
+                    if (track.auxiliary || track.handler == fourcc("auxv")) {
+                        out->hasAlpha = true;
+                    } else if (track.handler == fourcc("pict") && !haveColorTrack) {
+                        colorTrack = track;
+                        haveColorTrack = true;
+                    }
+                    return true;
+                });
+                if (!ok) return Status::INVALID;
+            }
+        }
+
+        if (box.toEnd) break;
+        if (boxEnd >= size) {
+            // Anything after this box (e.g. a moov behind mdat) is out of reach
+            resumeAt = addClamped(boxEnd, kDefaultProbeBytes);
+            break;
+        }
+        top.skip(static_cast<size_t>(boxEnd) - top.position());
+    }
+
+    bool haveImage = meta.present && fillFromMeta(meta, out);
+    if (haveColorTrack) {
+        if (!haveImage) {
+            out->width = colorTrack.width;
+            out->height = colorTrack.height;
+            if (colorTrack.hasAv1C) readAv1C(colorTrack.av1C, out);
+            haveImage = out->width > 0 && out->height > 0;
+        }
+        out->frameCount = colorTrack.sampleCount;
+    } else if (out->isSequence && !moovParsed) {
+        // Still-image properties are known but the track has not been seen
+        out->frameCount = 0;
+    }
+
+    if (!haveImage) {
+        // A complete meta without usable primary item properties will not get better
+        // with more data (unless the image is in a track that has not been seen yet)
+        bool metaUnusable = meta.present && !(out->isSequence && !moovParsed);
+        if (resumeAt != 0 && !metaUnusable) {
+            out->neededBytes = resumeAt;
+            return Status::NEED_MORE_DATA;
+        }
+        return Status::INVALID;
+    }
+    return Status::OK;
+}
+
+} // namespace probe
+} // namespace avifkit
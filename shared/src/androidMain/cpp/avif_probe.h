@@ -0,0 +1,56 @@
+#ifndef AVIFKIT_AVIF_PROBE_H
+#define AVIFKIT_AVIF_PROBE_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Header-only AVIF probe
+ *
+ * Walks the ISOBMFF boxes (ftyp, meta, moov) of the first bytes of a file and
+ * reports what a decoder would find, without touching any AV1 data. No libavif
+ * dependency, so it also works in placeholder builds.
+ */
+namespace avifkit {
+namespace probe {
+
+enum class Status {
+    OK = 0,
+    NOT_AVIF = 1,        // no avif/avis brand in ftyp
+    NEED_MORE_DATA = 2,  // a required box extends past the data; see neededBytes
+    INVALID = 3          // malformed boxes or no primary image properties
+};
+
+struct ImageProbe {
+    uint32_t width = 0;         // displayed size: swapped when irot turns the image a quarter
+    uint32_t height = 0;
+    int orientation = 1;        // irot/imir of the primary item as an Exif orientation (1 = none)
+    uint32_t depth = 0;         // 8, 10 or 12; 0 if unknown
+    int subsample = -1;         // 0=444, 1=422, 2=420, 3=400 (monochrome), -1 if unknown
+    bool hasAlpha = false;
+    bool isSequence = false;    // avis brand or an image track
+    uint32_t frameCount = 0;    // 1 for still images, track sample count for sequences, 0 if unknown
+    uint16_t colorPrimaries = 2;           // CICP from an nclx colr box; 2 (unspecified) if absent
+    uint16_t transferCharacteristics = 2;
+    uint64_t neededBytes = 0;   // with NEED_MORE_DATA: bytes from the start that must be available
+};
+
+/**
+ * Smallest prefix worth probing: enough for ftyp and meta of typical files
+ */
+constexpr size_t kDefaultProbeBytes = 64 * 1024;
+
+/**
+ * True if data starts with an ftyp box listing avif or avis (major or compatible brand)
+ */
+bool hasAvifBrand(const uint8_t* data, size_t size);
+
+/**
+ * Probe the first `size` bytes of a file (size may be less than the file length)
+ */
+Status probeAvif(const uint8_t* data, size_t size, ImageProbe* out);
+
+} // namespace probe
+} // namespace avifkit
+
+#endif // AVIFKIT_AVIF_PROBE_H
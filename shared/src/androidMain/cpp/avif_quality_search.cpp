@@ -0,0 +1,260 @@
+#include "avif_common.h"
+#include "avif_metric.h"
+#include "avif_orientation.h"
+
+#include <android/bitmap.h>
+#include <vector>
+
+using namespace avifkit;
+
+#if HAVE_LIBAVIF
+namespace {
+
+// Long side of the planes the metric is computed on; larger images are area-downscaled first
+constexpr uint32_t kProxyDimension = 512;
+
+// Quality range searched; 7 bisections cover it
+constexpr int kMinQuality = 0;
+constexpr int kMaxQuality = 100;
+constexpr int kMaxAttempts = 8;
+
+struct ProxyPlane {
+    std::vector<uint8_t> pixels;
+    uint32_t width = 0;
+    uint32_t height = 0;
+};
+
+/**
+ * Y, U and V of an 8-bit image, area-downscaled so the luma's long side is at most
+ * kProxyDimension
+ * Reducing both the reference and the candidate the same way keeps the metric cheap
+ * and weights it towards structure visible at a normal viewing size. Monochrome
+ * images have no chroma proxies.
+ */
+class YuvProxy {
+public:
+    bool build(const avifImage* image) {
+        if (image->depth != 8) {
+            LOGE("Quality metric needs 8-bit planes, got %u-bit", image->depth);
+            return false;
+        }
+        uint32_t width, height;
+        resample::scaledSize(image->width, image->height, kProxyDimension, kProxyDimension, 0, &width, &height);
+
+        avifPixelFormatInfo formatInfo;
+        avifGetPixelFormatInfo(image->yuvFormat, &formatInfo);
+        planeCount_ = formatInfo.monochrome ? 1 : 3;
+        for (int channel = 0; channel < planeCount_; channel++) {
+            const bool chroma = channel != AVIF_CHAN_Y;
+            const uint32_t shiftX = chroma ? formatInfo.chromaShiftX : 0;
+            const uint32_t shiftY = chroma ? formatInfo.chromaShiftY : 0;
+            ProxyPlane& plane = planes_[channel];
+            plane.width = (width + shiftX) >> shiftX;
+            plane.height = (height + shiftY) >> shiftY;
+            plane.pixels.resize(static_cast<size_t>(plane.width) * plane.height);
+            resample::scale8(image->yuvPlanes[channel], image->yuvRowBytes[channel],
+                             (image->width + shiftX) >> shiftX, (image->height + shiftY) >> shiftY,
+                             plane.pixels.data(), plane.width, plane.width, plane.height, 1,
+                             resample::Filter::AREA);
+        }
+        return true;
+    }
+
+    /**
+     * Weighted YUV SSIM against another proxy of the same image
+     */
+    double ssim(const YuvProxy& other) const {
+        double scores[3] = {1.0, 1.0, 1.0};
+        for (int channel = 0; channel < planeCount_; channel++) {
+            const ProxyPlane& a = planes_[channel];
+            const ProxyPlane& b = other.planes_[channel];
+            scores[channel] = metric::ssim(a.pixels.data(), a.width, b.pixels.data(), b.width, a.width, a.height);
+        }
+        return planeCount_ == 1 ? scores[0] : metric::weightedYuvSsim(scores[0], scores[1], scores[2]);
+    }
+
+private:
+    ProxyPlane planes_[3];
+    int planeCount_ = 0;
+};
+
+struct QualityCandidate {
+    int quality = -1;
+    double score = 0.0;
+    std::vector<uint8_t> data;
+};
+
+/**
+ * Encode `image` at `quality`, decode the result and score it against `reference`
+ */
+bool scoreCandidate(const avifImage* image, const YuvProxy& reference, int quality, int speed,
+                    QualityCandidate* out) {
+    EncodeSettings settings;
+    settings.quality = quality;
+    settings.speed = speed;
+
+    ScopedRWData output;
+    avifResult result = encodeImage(image, settings, &output.data);
+    if (result != AVIF_RESULT_OK) {
+        LOGE("Failed to encode AVIF: %s", avifResultToString(result));
+        return false;
+    }
+
+    AvifDecoderPtr decoder(avifDecoderCreate());
+    if (!decoder) {
+        LOGE("Failed to create AVIF decoder");
+        return false;
+    }
+    configureDecoder(decoder.get(), AVIF_CODEC_CHOICE_AUTO);
+    if (decodeFirstImage(decoder.get(), output.data.data, output.data.size) != AVIF_RESULT_OK) {
+        return false;
+    }
+    YuvProxy decoded;
+    if (!decoded.build(decoder->image)) {
+        return false;
+    }
+
+    out->quality = quality;
+    out->score = reference.ssim(decoded);
+    out->data.assign(output.data.data, output.data.data + output.data.size);
+    return true;
+}
+
+} // namespace
+#endif
+
+extern "C" {
+
+/**
+ * Quality-targeted encoding in a single native call
+ *
+ * Converts the bitmap to YUV once (downscaling so neither side exceeds maxDimension)
+ * and bisects quality for the lowest value whose decoded result reaches
+ * targetScore. The score is the weighted YUV SSIM (0.8 Y + 0.1 U + 0.1 V) between
+ * the encoder input and the decoded candidate, measured on area-downscaled proxies
+ * of at most 512 pixels. Each attempt re-runs only the encode, a decode and the
+ * metric.
+ * orientation (Exif 1-8) is stored as irot/imir, exif and icc (or null) as metadata.
+ *
+ * Returns a TargetQualityEncodeResult. If even the highest quality misses the
+ * target, the best-scoring candidate is returned with targetMet=false.
+ */
+JNIEXPORT jobject JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeEncodeToTargetQuality(
+    JNIEnv* env,
+    jobject /* this */,
+    jobject bitmap,
+    jint maxDimension,
+    jint speed,
+    jint subsample,
+    jint orientation,
+    jbyteArray exif,
+    jbyteArray icc,
+    jfloat targetScore) {
+
+    LOGI("nativeEncodeToTargetQuality: maxDimension=%d, speed=%d, subsample=%d, target=%.4f",
+         maxDimension, speed, subsample, targetScore);
+
+#if HAVE_LIBAVIF
+    if (encoderCodecName()[0] == '\0' || decoderCodecName()[0] == '\0') {
+        LOGE("Quality search needs both an encoder and a decoder codec");
+        return nullptr;
+    }
+    if (!(targetScore > 0.0f && targetScore < 1.0f)) {
+        LOGE("Invalid target score: %f", targetScore);
+        return nullptr;
+    }
+
+    AvifImagePtr image;
+    {
+        ScopedBitmapPixels bitmapPixels(env, bitmap);
+        if (!bitmapPixels.pixels()) {
+            return nullptr;
+        }
+        const AndroidBitmapInfo& info = bitmapPixels.info();
+
+        RgbSource source;
+        source.pixels = bitmapPixels.pixels();
+        source.rowBytes = info.stride;
+        source.format = AVIF_RGB_FORMAT_RGBA;
+        source.alphaPremultiplied = bitmapPixels.premultiplied();
+
+        uint32_t dstWidth;
+        uint32_t dstHeight;
+        resample::scaledSize(info.width, info.height, maxDimension, maxDimension, 0, &dstWidth, &dstHeight);
+        image = createScaledImageFromRgb(source, info.width, info.height, dstWidth, dstHeight,
+                                         pixelFormatFromSubsample(subsample));
+    }
+    if (!image || !orientation::setSourceMetadata(env, image.get(), orientation, exif, icc)) {
+        return nullptr;
+    }
+
+    YuvProxy reference;
+    if (!reference.build(image.get())) {
+        return nullptr;
+    }
+
+    // Lowest passing quality; the best score is kept in case nothing passes
+    QualityCandidate best;
+    QualityCandidate bestScoring;
+    QualityCandidate candidate;
+    int attempts = 0;
+    int low = kMinQuality;
+    int high = kMaxQuality;
+    while (low <= high && attempts < kMaxAttempts) {
+        const int quality = (low + high) / 2;
+        if (!scoreCandidate(image.get(), reference, quality, speed, &candidate)) {
+            return nullptr;
+        }
+        attempts++;
+        LOGI("Quality search attempt %d: quality=%d, ssim=%.4f, size=%zu", attempts, quality, candidate.score,
+             candidate.data.size());
+
+        if (candidate.score >= targetScore) {
+            best = candidate;
+            high = quality - 1;
+        } else {
+            if (bestScoring.quality < 0 || candidate.score > bestScoring.score) {
+                bestScoring = candidate;
+            }
+            low = quality + 1;
+        }
+    }
+    const bool targetMet = best.quality >= 0;
+    if (!targetMet) {
+        best = std::move(bestScoring);
+    }
+
+    LOGI("Quality search finished: quality=%d, ssim=%.4f, size=%zu, met=%d, attempts=%d",
+         best.quality, best.score, best.data.size(), targetMet, attempts);
+
+    jclass resultClass = env->FindClass("com/alfikri/rizky/avifkit/TargetQualityEncodeResult");
+    if (!resultClass) {
+        LOGE("Failed to find TargetQualityEncodeResult class");
+        clearPendingException(env);
+        return nullptr;
+    }
+
+    jmethodID constructor = env->GetMethodID(resultClass, "<init>", "([BIFIZ)V");
+    if (!constructor) {
+        LOGE("Failed to find TargetQualityEncodeResult constructor");
+        clearPendingException(env);
+        return nullptr;
+    }
+
+    jbyteArray data = env->NewByteArray(best.data.size());
+    if (!data) {
+        LOGE("Failed to allocate Java byte array for encoded data");
+        return nullptr;
+    }
+    env->SetByteArrayRegion(data, 0, best.data.size(), reinterpret_cast<const jbyte*>(best.data.data()));
+
+    return env->NewObject(resultClass, constructor, data, best.quality, static_cast<jfloat>(best.score),
+                          attempts, targetMet ? JNI_TRUE : JNI_FALSE);
+#else
+    LOGW("PLACEHOLDER: libavif not available, quality-targeted encoding not supported");
+    return nullptr;
+#endif
+}
+
+} // extern "C"
@@ -0,0 +1,245 @@
+#include "avif_resample.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace avifkit {
+namespace resample {
+
+namespace {
+
+constexpr int kWeightBits = 14;
+constexpr int32_t kWeightOne = 1 << kWeightBits;
+constexpr double kPi = 3.14159265358979323846;
+
+/**
+ * Source span and fixed-point weights for every output position along one axis
+ */
+struct Contributions {
+    std::vector<uint32_t> start;
+    std::vector<uint32_t> count;
+    std::vector<int32_t> weights;  // taps per output position, zero padded
+    uint32_t taps = 0;
+};
+
+double sinc(double x) {
+    if (x == 0.0) return 1.0;
+    x *= kPi;
+    return std::sin(x) / x;
+}
+
+double lanczos3(double x) {
+    if (x <= -3.0 || x >= 3.0) return 0.0;
+    return sinc(x) * sinc(x / 3.0);
+}
+
+/**
+ * Quantize one output position's weights so they sum to exactly kWeightOne
+ * (flat areas stay flat)
+ */
+void storeWeights(const std::vector<double>& raw, uint32_t count, int32_t* out) {
+    double total = 0.0;
+    for (uint32_t i = 0; i < count; i++) total += raw[i];
+    if (total == 0.0) total = 1.0;
+
+    int32_t sum = 0;
+    uint32_t largest = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        out[i] = static_cast<int32_t>(std::lround(raw[i] / total * kWeightOne));
+        sum += out[i];
+        if (out[i] > out[largest]) largest = i;
+    }
+    out[largest] += kWeightOne - sum;
+}
+
+Contributions computeContributions(uint32_t inSize, uint32_t outSize, Filter filter) {
+    Contributions c;
+    c.start.resize(outSize);
+    c.count.resize(outSize);
+
+    const double scale = static_cast<double>(inSize) / outSize;
+    const double filterScale = std::max(scale, 1.0);
+    const double support = (filter == Filter::AREA) ? filterScale * 0.5 : 3.0 * filterScale;
+    c.taps = static_cast<uint32_t>(std::ceil(support)) * 2 + 2;
+    c.weights.assign(static_cast<size_t>(outSize) * c.taps, 0);
+
+    std::vector<double> raw(c.taps);
+    for (uint32_t o = 0; o < outSize; o++) {
+        const double center = (o + 0.5) * scale;
+        int64_t first = static_cast<int64_t>(std::floor(center - support));
+        int64_t last = static_cast<int64_t>(std::ceil(center + support));
+        first = std::max<int64_t>(first, 0);
+        last = std::min<int64_t>(last, inSize);
+        uint32_t count = static_cast<uint32_t>(std::min<int64_t>(last - first, c.taps));
+
+        for (uint32_t i = 0; i < count; i++) {
+            double pixel = static_cast<double>(first + i);
+            if (filter == Filter::AREA) {
+                // Overlap of source pixel [pixel, pixel + 1) with the output footprint
+                double left = std::max(pixel, center - support);
+                double right = std::min(pixel + 1.0, center + support);
+                raw[i] = std::max(0.0, right - left);
+            } else {
+                raw[i] = lanczos3((pixel + 0.5 - center) / filterScale);
+            }
+        }
+
+        // Trim zero-weight taps at both ends
+        uint32_t begin = 0;
+        while (begin + 1 < count && raw[begin] == 0.0) begin++;
+        while (count > begin + 1 && raw[count - 1] == 0.0) count--;
+        if (begin > 0) {
+            std::copy(raw.begin() + begin, raw.begin() + count, raw.begin());
+            count -= begin;
+        }
+
+        c.start[o] = static_cast<uint32_t>(first) + begin;
+        c.count[o] = count;
+        storeWeights(raw, count, &c.weights[static_cast<size_t>(o) * c.taps]);
+    }
+    return c;
+}
+
+/**
+ * Core resampler; rowFor(y) returns where output row y is written and done(y)
+ * is called once it is complete
+ *
+ * The intermediate row keeps the vertical pass at full kWeightBits precision and
+ * unclamped, so Lanczos lobes from both passes combine before the single round
+ * and clamp at the end. That fits int32 for samples up to 16 bits (the sum of
+ * positive Lanczos3 weights stays well below 2).
+ */
+template <typename T, typename Acc, typename RowFor, typename Done>
+void scaleImpl(const T* src, size_t srcRowBytes, uint32_t srcWidth, uint32_t srcHeight,
+               uint32_t dstWidth, uint32_t dstHeight, uint32_t channels, int32_t maxValue,
+               Filter filter, RowFor rowFor, Done done) {
+    const uint8_t* srcBytes = reinterpret_cast<const uint8_t*>(src);
+
+    if (srcWidth == dstWidth && srcHeight == dstHeight) {
+        for (uint32_t y = 0; y < dstHeight; y++) {
+            std::memcpy(rowFor(y), srcBytes + y * srcRowBytes, static_cast<size_t>(dstWidth) * channels * sizeof(T));
+            done(y);
+        }
+        return;
+    }
+
+    filter = resolveFilter(filter, srcWidth, srcHeight, dstWidth, dstHeight);
+    const Contributions horizontal = computeContributions(srcWidth, dstWidth, filter);
+    const Contributions vertical = computeContributions(srcHeight, dstHeight, filter);
+
+    const size_t rowSamples = static_cast<size_t>(srcWidth) * channels;
+    std::vector<Acc> accumulator(rowSamples);
+    std::vector<int32_t> row(rowSamples);
+    const int64_t rounding = static_cast<int64_t>(1) << (2 * kWeightBits - 1);
+
+    for (uint32_t y = 0; y < dstHeight; y++) {
+        // Vertical taps over full source rows (contiguous, vectorizes well)
+        std::fill(accumulator.begin(), accumulator.end(), 0);
+        const int32_t* vWeights = &vertical.weights[static_cast<size_t>(y) * vertical.taps];
+        for (uint32_t t = 0; t < vertical.count[y]; t++) {
+            const Acc weight = vWeights[t];
+            const T* srcRow = reinterpret_cast<const T*>(srcBytes + (vertical.start[y] + t) * srcRowBytes);
+            Acc* acc = accumulator.data();
+            for (size_t i = 0; i < rowSamples; i++) {
+                acc[i] += weight * static_cast<Acc>(srcRow[i]);
+            }
+        }
+        std::copy(accumulator.begin(), accumulator.end(), row.begin());
+
+        // Horizontal taps within the intermediate row; the only rounding and clamping
+        T* dstRow = rowFor(y);
+        for (uint32_t x = 0; x < dstWidth; x++) {
+            const int32_t* hWeights = &horizontal.weights[static_cast<size_t>(x) * horizontal.taps];
+            const int32_t* first = &row[static_cast<size_t>(horizontal.start[x]) * channels];
+            for (uint32_t ch = 0; ch < channels; ch++) {
+                int64_t sum = rounding;
+                for (uint32_t t = 0; t < horizontal.count[x]; t++) {
+                    sum += static_cast<int64_t>(hWeights[t]) * first[t * channels + ch];
+                }
+                dstRow[x * channels + ch] =
+                    static_cast<T>(std::min<int64_t>(std::max<int64_t>(sum >> (2 * kWeightBits), 0), maxValue));
+            }
+        }
+        done(y);
+    }
+}
+
+/**
+ * Write rows into an output image with the given stride
+ */
+template <typename T>
+struct ImageRows {
+    uint8_t* base;
+    size_t rowBytes;
+    T* operator()(uint32_t y) const { return reinterpret_cast<T*>(base + y * rowBytes); }
+};
+
+void noop(uint32_t) {}
+
+} // namespace
+
+Filter filterFromNative(int value) {
+    switch (value) {
+        case 1: return Filter::AREA;
+        case 2: return Filter::LANCZOS3;
+        case 0:
+        default: return Filter::AUTO;
+    }
+}
+
+Filter resolveFilter(Filter filter, uint32_t srcWidth, uint32_t srcHeight, uint32_t dstWidth, uint32_t dstHeight) {
+    if (filter != Filter::AUTO) {
+        return filter;
+    }
+    // Large reductions: area averaging is both faster and alias-free
+    bool large = static_cast<uint64_t>(dstWidth) * 2 <= srcWidth || static_cast<uint64_t>(dstHeight) * 2 <= srcHeight;
+    return large ? Filter::AREA : Filter::LANCZOS3;
+}
+
+void scaledSize(uint32_t width, uint32_t height, int targetWidth, int targetHeight, int sampleSize,
+                uint32_t* outWidth, uint32_t* outHeight) {
+    *outWidth = width;
+    *outHeight = height;
+
+    if (targetWidth > 0 || targetHeight > 0) {
+        double scale = 1.0;
+        if (targetWidth > 0) scale = std::min(scale, static_cast<double>(targetWidth) / width);
+        if (targetHeight > 0) scale = std::min(scale, static_cast<double>(targetHeight) / height);
+        if (scale < 1.0) {
+            *outWidth = std::max<uint32_t>(1, static_cast<uint32_t>(std::lround(width * scale)));
+            *outHeight = std::max<uint32_t>(1, static_cast<uint32_t>(std::lround(height * scale)));
+        }
+    } else if (sampleSize > 1) {
+        *outWidth = (width + sampleSize - 1) / sampleSize;
+        *outHeight = (height + sampleSize - 1) / sampleSize;
+    }
+}
+
+void scale8(const uint8_t* src, size_t srcRowBytes, uint32_t srcWidth, uint32_t srcHeight,
+            uint8_t* dst, size_t dstRowBytes, uint32_t dstWidth, uint32_t dstHeight,
+            uint32_t channels, Filter filter) {
+    scaleImpl<uint8_t, int32_t>(src, srcRowBytes, srcWidth, srcHeight, dstWidth, dstHeight, channels, 255,
+                                filter, ImageRows<uint8_t>{dst, dstRowBytes}, noop);
+}
+
+void scale8Rows(const uint8_t* src, size_t srcRowBytes, uint32_t srcWidth, uint32_t srcHeight,
+                uint32_t dstWidth, uint32_t dstHeight, uint32_t channels, Filter filter,
+                const RowSink& sink) {
+    std::vector<uint8_t> row(static_cast<size_t>(dstWidth) * channels);
+    scaleImpl<uint8_t, int32_t>(src, srcRowBytes, srcWidth, srcHeight, dstWidth, dstHeight, channels, 255,
+                                filter, [&](uint32_t) { return row.data(); },
+                                [&](uint32_t y) { sink(y, row.data()); });
+}
+
+void scale16(const uint16_t* src, size_t srcRowBytes, uint32_t srcWidth, uint32_t srcHeight,
+             uint16_t* dst, size_t dstRowBytes, uint32_t dstWidth, uint32_t dstHeight,
+             uint32_t channels, uint32_t maxValue, Filter filter) {
+    scaleImpl<uint16_t, int64_t>(src, srcRowBytes, srcWidth, srcHeight, dstWidth, dstHeight, channels,
+                                 static_cast<int32_t>(maxValue), filter,
+                                 ImageRows<uint16_t>{reinterpret_cast<uint8_t*>(dst), dstRowBytes}, noop);
+}
+
+} // namespace resample
+} // namespace avifkit
@@ -0,0 +1,77 @@
+#ifndef AVIFKIT_AVIF_RESAMPLE_H
+#define AVIFKIT_AVIF_RESAMPLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/**
+ * Separable image downscaler for 8/16-bit planes and interleaved pixels
+ *
+ * Works one output row at a time (vertical taps first, then horizontal), so the
+ * only scratch memory is a couple of source-width rows. Weights are fixed-point.
+ * No libavif dependency.
+ */
+namespace avifkit {
+namespace resample {
+
+/**
+ * Values match the Kotlin ResizeFilter enum order
+ */
+enum class Filter {
+    AUTO = 0,      // AREA for reductions of 2x or more, LANCZOS3 otherwise
+    AREA = 1,      // Exact pixel-area averaging; best for large reductions
+    LANCZOS3 = 2   // Sharper, for small reductions
+};
+
+Filter filterFromNative(int value);
+
+/**
+ * Resolve AUTO for a given reduction
+ */
+Filter resolveFilter(Filter filter, uint32_t srcWidth, uint32_t srcHeight, uint32_t dstWidth, uint32_t dstHeight);
+
+/**
+ * Output size for a decode-time downscale request
+ *
+ * targetWidth/targetHeight (either may be <= 0 for "unconstrained") define a box the
+ * image is fitted into with its aspect ratio kept; otherwise sampleSize > 1 divides
+ * both dimensions (rounding up). Never upscales.
+ */
+void scaledSize(uint32_t width, uint32_t height, int targetWidth, int targetHeight, int sampleSize,
+                uint32_t* outWidth, uint32_t* outHeight);
+
+/**
+ * Resample 8-bit pixels with `channels` interleaved samples per pixel
+ * Row strides are in bytes.
+ */
+void scale8(const uint8_t* src, size_t srcRowBytes, uint32_t srcWidth, uint32_t srcHeight,
+            uint8_t* dst, size_t dstRowBytes, uint32_t dstWidth, uint32_t dstHeight,
+            uint32_t channels, Filter filter);
+
+/**
+ * Receives each 8-bit output row, in order, during a streaming resample
+ * The row pointer is only valid for the duration of the call.
+ */
+using RowSink = std::function<void(uint32_t y, const uint8_t* row)>;
+
+/**
+ * Like scale8, but hands rows to `sink` instead of writing an output image
+ * Lets callers fuse the next step (e.g. RGB->YUV) without a full-size buffer.
+ */
+void scale8Rows(const uint8_t* src, size_t srcRowBytes, uint32_t srcWidth, uint32_t srcHeight,
+                uint32_t dstWidth, uint32_t dstHeight, uint32_t channels, Filter filter,
+                const RowSink& sink);
+
+/**
+ * Resample 16-bit samples (e.g. 10/12-bit planes) clamped to maxValue
+ * Row strides are in bytes.
+ */
+void scale16(const uint16_t* src, size_t srcRowBytes, uint32_t srcWidth, uint32_t srcHeight,
+             uint16_t* dst, size_t dstRowBytes, uint32_t dstWidth, uint32_t dstHeight,
+             uint32_t channels, uint32_t maxValue, Filter filter);
+
+} // namespace resample
+} // namespace avifkit
+
+#endif // AVIFKIT_AVIF_RESAMPLE_H
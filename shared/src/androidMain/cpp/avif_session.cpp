@@ -0,0 +1,290 @@
+#include "avif_common.h"
+#include "avif_orientation.h"
+
+#include <mutex>
+
+using namespace avifkit;
+
+#if HAVE_LIBAVIF
+namespace {
+
+/**
+ * Long-lived encode/decode state behind an AvifSession handle
+ *
+ * Keeps the decoder object, the resolved codec choice and all scratch buffers
+ * alive between calls. Encoders are still created per bitstream because
+ * libavif encoders are single-use, but the YUV image is reused whenever the
+ * dimensions match the previous encode.
+ */
+struct Session {
+    std::mutex lock;
+    EncodeSettings settings;
+    avifPixelFormat pixelFormat = AVIF_PIXEL_FORMAT_YUV420;
+    avifCodecChoice decodeCodecChoice = AVIF_CODEC_CHOICE_AUTO;
+    AvifDecoderPtr decoder;
+    AvifImagePtr encodeImage;
+    std::vector<int32_t> argbScratch;
+};
+
+Session* fromHandle(jlong handle) {
+    return reinterpret_cast<Session*>(static_cast<intptr_t>(handle));
+}
+
+avifCodecChoice resolveCodecChoice(const char* codecName) {
+    if (codecName[0] == '\0') return AVIF_CODEC_CHOICE_AUTO;
+    return avifCodecChoiceFromName(codecName);
+}
+
+} // namespace
+#endif
+
+extern "C" {
+
+/**
+ * Create a reusable encode/decode session
+ * Returns 0 if the session cannot be created (e.g. libavif not available)
+ */
+JNIEXPORT jlong JNICALL
+Java_com_alfikri_rizky_avifkit_AvifSession_nativeCreateSession(
+    JNIEnv* /* env */,
+    jobject /* this */,
+    jint quality,
+    jint speed,
+    jint subsample) {
+
+#if HAVE_LIBAVIF
+    const char* encoderName = encoderCodecName();
+    const char* decoderName = decoderCodecName();
+    if (encoderName[0] == '\0' && decoderName[0] == '\0') {
+        LOGE("No AVIF codec available! AOM codec not found.");
+        return 0;
+    }
+
+    auto* session = new Session();
+    session->settings.quality = quality;
+    session->settings.speed = speed;
+    session->settings.codecChoice = resolveCodecChoice(encoderName);
+    session->pixelFormat = pixelFormatFromSubsample(subsample);
+    session->decodeCodecChoice = resolveCodecChoice(decoderName);
+
+    session->decoder.reset(avifDecoderCreate());
+    if (!session->decoder) {
+        LOGE("Failed to create AVIF decoder");
+        delete session;
+        return 0;
+    }
+    configureDecoder(session->decoder.get(), session->decodeCodecChoice);
+
+    LOGI("Created AVIF session: encoder=%s, decoder=%s, quality=%d, speed=%d, subsample=%d",
+         encoderName, decoderName, quality, speed, subsample);
+    return static_cast<jlong>(reinterpret_cast<intptr_t>(session));
+#else
+    LOGW("PLACEHOLDER: libavif not available, sessions not supported");
+    return 0;
+#endif
+}
+
+/**
+ * Encode an ARGB_8888 Bitmap with the session settings
+ * The pixels are converted straight from the locked bitmap memory; premultiplied
+ * alpha is undone during RGB->YUV conversion.
+ */
+JNIEXPORT jbyteArray JNICALL
+Java_com_alfikri_rizky_avifkit_AvifSession_nativeSessionEncode(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong handle,
+    jobject bitmap) {
+
+#if HAVE_LIBAVIF
+    Session* session = fromHandle(handle);
+    if (!session) {
+        LOGE("Invalid session handle");
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> guard(session->lock);
+
+    avifImage* image;
+    {
+        ScopedBitmapPixels bitmapPixels(env, bitmap);
+        if (!bitmapPixels.pixels()) {
+            return nullptr;
+        }
+        const AndroidBitmapInfo& info = bitmapPixels.info();
+
+        RgbSource source;
+        source.pixels = bitmapPixels.pixels();
+        source.rowBytes = info.stride;
+        source.format = AVIF_RGB_FORMAT_RGBA;
+        source.alphaPremultiplied = bitmapPixels.premultiplied();
+
+        // Reuse the planes of the previous encode when the geometry and alpha match
+        const bool opaque = isOpaqueSource(source, info.width, info.height);
+        image = session->encodeImage.get();
+        if (image && image->width == info.width && image->height == info.height &&
+            (image->alphaPlane != nullptr) == !opaque) {
+            source.alphaPremultiplied = source.alphaPremultiplied && !opaque;  // moot without alpha
+            if (convertRgbIntoImage(image, source) != AVIF_RESULT_OK) {
+                return nullptr;
+            }
+        } else {
+            session->encodeImage = createImageFromRgb(source, info.width, info.height, session->pixelFormat);
+            image = session->encodeImage.get();
+            if (!image) {
+                return nullptr;
+            }
+        }
+    }
+
+    ScopedRWData output;
+    avifResult encodeResult = encodeImage(image, session->settings, &output.data);
+    if (encodeResult != AVIF_RESULT_OK) {
+        LOGE("Failed to encode AVIF: %s", avifResultToString(encodeResult));
+        return nullptr;
+    }
+
+    LOGD("Session encoded AVIF: %ux%u, output size=%zu bytes", image->width, image->height, output.data.size);
+    return toJavaByteArray(env, output.data);
+#else
+    LOGW("PLACEHOLDER: libavif not available, sessions not supported");
+    return nullptr;
+#endif
+}
+
+/**
+ * Decode AVIF data with the session's long-lived decoder
+ */
+JNIEXPORT jobject JNICALL
+Java_com_alfikri_rizky_avifkit_AvifSession_nativeSessionDecode(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong handle,
+    jbyteArray avifData) {
+
+#if HAVE_LIBAVIF
+    Session* session = fromHandle(handle);
+    if (!session) {
+        LOGE("Invalid session handle");
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> guard(session->lock);
+
+    ScopedByteArrayElements data(env, avifData);
+    if (!data.data()) {
+        LOGE("Failed to get AVIF data");
+        return nullptr;
+    }
+
+    avifDecoder* decoder = session->decoder.get();
+    if (decodeFirstImage(decoder, data.data(), data.length()) != AVIF_RESULT_OK) {
+        return nullptr;
+    }
+
+    const int exifOrientation = orientation::displayOrientation(decoder->image);
+    if (convertImageToArgb(decoder->image, session->argbScratch, exifOrientation) != AVIF_RESULT_OK) {
+        return nullptr;
+    }
+
+    uint32_t width;
+    uint32_t height;
+    orientation::displaySize(exifOrientation, decoder->image->width, decoder->image->height, &width, &height);
+    LOGD("Session decoded AVIF: %ux%u", width, height);
+    return newDecodedImage(env, session->argbScratch.data(), width, height);
+#else
+    LOGW("PLACEHOLDER: libavif not available, sessions not supported");
+    return nullptr;
+#endif
+}
+
+/**
+ * Decode with the session's decoder straight into a mutable ARGB_8888 Bitmap
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_alfikri_rizky_avifkit_AvifSession_nativeSessionDecodeIntoBitmap(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong handle,
+    jbyteArray avifData,
+    jobject bitmap) {
+
+#if HAVE_LIBAVIF
+    Session* session = fromHandle(handle);
+    if (!session) {
+        LOGE("Invalid session handle");
+        return JNI_FALSE;
+    }
+    std::lock_guard<std::mutex> guard(session->lock);
+
+    ScopedByteArrayElements data(env, avifData);
+    if (!data.data()) {
+        LOGE("Failed to get AVIF data");
+        return JNI_FALSE;
+    }
+
+    avifDecoder* decoder = session->decoder.get();
+    if (decodeFirstImage(decoder, data.data(), data.length()) != AVIF_RESULT_OK) {
+        return JNI_FALSE;
+    }
+    return decodedImageIntoBitmap(env, decoder->image, bitmap, orientation::displayOrientation(decoder->image))
+        ? JNI_TRUE : JNI_FALSE;
+#else
+    LOGW("PLACEHOLDER: libavif not available, sessions not supported");
+    return JNI_FALSE;
+#endif
+}
+
+/**
+ * Decode with the session's decoder straight into a direct ByteBuffer
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_alfikri_rizky_avifkit_AvifSession_nativeSessionDecodeIntoBuffer(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong handle,
+    jbyteArray avifData,
+    jobject buffer,
+    jint rowBytes,
+    jint channelOrder,
+    jintArray outInfo) {
+
+#if HAVE_LIBAVIF
+    Session* session = fromHandle(handle);
+    if (!session) {
+        LOGE("Invalid session handle");
+        return JNI_FALSE;
+    }
+    std::lock_guard<std::mutex> guard(session->lock);
+
+    ScopedByteArrayElements data(env, avifData);
+    if (!data.data()) {
+        LOGE("Failed to get AVIF data");
+        return JNI_FALSE;
+    }
+
+    avifDecoder* decoder = session->decoder.get();
+    if (decodeFirstImage(decoder, data.data(), data.length()) != AVIF_RESULT_OK) {
+        return JNI_FALSE;
+    }
+    return decodedImageIntoBuffer(env, decoder->image, decoder->alphaPresent, buffer, rowBytes, channelOrder,
+                                  outInfo, orientation::displayOrientation(decoder->image)) ? JNI_TRUE : JNI_FALSE;
+#else
+    LOGW("PLACEHOLDER: libavif not available, sessions not supported");
+    return JNI_FALSE;
+#endif
+}
+
+/**
+ * Release a session and everything it owns
+ */
+JNIEXPORT void JNICALL
+Java_com_alfikri_rizky_avifkit_AvifSession_nativeCloseSession(
+    JNIEnv* /* env */,
+    jobject /* this */,
+    jlong handle) {
+
+#if HAVE_LIBAVIF
+    delete fromHandle(handle);
+#endif
+}
+
+} // extern "C"
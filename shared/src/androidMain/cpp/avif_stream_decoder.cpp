@@ -0,0 +1,317 @@
+#include "avif_common.h"
+#include "avif_io.h"
+#include "avif_orientation.h"
+#include "avif_threads.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace avifkit;
+
+#if HAVE_LIBAVIF
+namespace {
+
+constexpr jint kStreamWaiting = 0;
+constexpr jint kStreamComplete = 1;
+constexpr jint kStreamFailed = -1;
+
+/**
+ * Incremental decode state behind an AvifStreamDecoder handle
+ *
+ * Bytes are appended to a stream reader as they arrive and the decoder is
+ * resumed after each chunk. With allowIncremental, libavif decodes grid cells
+ * as soon as their data is present, so the top rows of a grid image are
+ * available long before the download completes. Non-grid images become
+ * available all at once when their data is complete. libavif fixes a codec's
+ * thread count when the codec is created, so the handle leases its share of the
+ * thread budget once, when it is created, and returns it as soon as the decode
+ * completes or fails.
+ */
+struct Stream {
+    std::mutex lock;
+    std::unique_ptr<threads::Lease> lease;
+    AvifDecoderPtr decoder;
+    avifIO* reader = nullptr;  // owned by decoder
+    bool parsed = false;
+    jint state = kStreamWaiting;
+};
+
+Stream* fromHandle(jlong handle) {
+    return reinterpret_cast<Stream*>(static_cast<intptr_t>(handle));
+}
+
+/**
+ * Parse and decode as far as the received bytes allow
+ */
+jint advance(Stream* stream) {
+    if (stream->state != kStreamWaiting) {
+        return stream->state;
+    }
+    avifDecoder* decoder = stream->decoder.get();
+
+    avifResult result = AVIF_RESULT_OK;
+    if (!stream->parsed) {
+        result = avifDecoderParse(decoder);
+        if (result == AVIF_RESULT_OK) {
+            stream->parsed = true;
+            LOGD("Stream header parsed after %llu bytes: %ux%u",
+                 static_cast<unsigned long long>(io::streamSize(stream->reader)),
+                 decoder->image->width, decoder->image->height);
+        }
+    }
+    if (stream->parsed) {
+        result = avifDecoderNextImage(decoder);
+    }
+
+    if (result == AVIF_RESULT_WAITING_ON_IO) {
+        return kStreamWaiting;
+    }
+    if (result != AVIF_RESULT_OK) {
+        LOGE("Stream decode failed after %llu bytes: %s",
+             static_cast<unsigned long long>(io::streamSize(stream->reader)), avifResultToString(result));
+        stream->state = kStreamFailed;
+        stream->lease.reset();
+        return stream->state;
+    }
+    stream->state = kStreamComplete;
+    stream->lease.reset();
+    LOGD("Stream decode complete: %ux%u", decoder->image->width, decoder->image->height);
+    return stream->state;
+}
+
+} // namespace
+#endif
+
+extern "C" {
+
+/**
+ * Create a streaming decoder; expectedSize is the total size if known (e.g. Content-Length) or 0
+ * Returns 0 on failure.
+ */
+JNIEXPORT jlong JNICALL
+Java_com_alfikri_rizky_avifkit_AvifStreamDecoder_nativeCreate(
+    JNIEnv* /* env */,
+    jobject /* this */,
+    jlong expectedSize) {
+
+#if HAVE_LIBAVIF
+    if (decoderCodecName()[0] == '\0') {
+        LOGE("No decoder codec available! AOM decoder not found.");
+        return 0;
+    }
+
+    std::unique_ptr<Stream> stream(new Stream());
+    stream->decoder.reset(avifDecoderCreate());
+    if (!stream->decoder) {
+        LOGE("Failed to create AVIF decoder");
+        return 0;
+    }
+    avifDecoder* decoder = stream->decoder.get();
+    configureDecoder(decoder, AVIF_CODEC_CHOICE_AUTO);
+    decoder->allowIncremental = AVIF_TRUE;
+    stream->lease.reset(new threads::Lease());
+    decoder->maxThreads = stream->lease->count();
+
+    stream->reader = io::createStreamReader(expectedSize > 0 ? static_cast<uint64_t>(expectedSize) : 0);
+    avifDecoderSetIO(decoder, stream->reader);
+    return static_cast<jlong>(reinterpret_cast<intptr_t>(stream.release()));
+#else
+    LOGW("PLACEHOLDER: libavif not available, streaming decode not supported");
+    return 0;
+#endif
+}
+
+/**
+ * Append bytes[offset, offset + length) and decode as far as possible
+ * endOfStream marks the data complete. outInfo (5 ints) receives the displayed width
+ * and height (0 until the header is parsed), decoded rows, hasAlpha and the stored
+ * row count. Rows are counted in stored order, which irot/imir may turn into columns.
+ * Returns 0 while waiting for more data, 1 once fully decoded, -1 on error.
+ */
+JNIEXPORT jint JNICALL
+Java_com_alfikri_rizky_avifkit_AvifStreamDecoder_nativeAppend(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong handle,
+    jbyteArray bytes,
+    jint offset,
+    jint length,
+    jboolean endOfStream,
+    jintArray outInfo) {
+
+#if HAVE_LIBAVIF
+    Stream* stream = fromHandle(handle);
+    if (!stream || env->GetArrayLength(outInfo) < 5) {
+        return kStreamFailed;
+    }
+    std::lock_guard<std::mutex> guard(stream->lock);
+
+    if (length > 0 && stream->state == kStreamWaiting) {
+        if (offset < 0 || length > env->GetArrayLength(bytes) - offset) {
+            LOGE("Invalid chunk: offset=%d, length=%d", offset, length);
+            return kStreamFailed;
+        }
+        uint8_t* received = io::extendStream(stream->reader, static_cast<size_t>(length));
+        env->GetByteArrayRegion(bytes, offset, length, reinterpret_cast<jbyte*>(received));
+    }
+    if (endOfStream == JNI_TRUE) {
+        io::endStream(stream->reader);
+    }
+
+    jint state = advance(stream);
+
+    const avifDecoder* decoder = stream->decoder.get();
+    jint info[5] = {0, 0, 0, 0, 0};
+    if (stream->parsed) {
+        const avifImage* image = decoder->image;
+        uint32_t width;
+        uint32_t height;
+        orientation::displaySize(orientation::displayOrientation(image), image->width, image->height, &width, &height);
+        info[0] = static_cast<jint>(width);
+        info[1] = static_cast<jint>(height);
+        info[2] = static_cast<jint>(state == kStreamComplete ? image->height : avifDecoderDecodedRowCount(decoder));
+        info[3] = decoder->alphaPresent ? 1 : 0;
+        info[4] = static_cast<jint>(image->height);
+    }
+    env->SetIntArrayRegion(outInfo, 0, 5, info);
+    return state;
+#else
+    return -1;
+#endif
+}
+
+/**
+ * Convert decoded stored rows [fromRow, toRow) into an ARGB_8888 Bitmap of the
+ * displayed size, at their displayed position (rows, or columns when irot/imir
+ * swap the axes). Rows past the decoded count are rejected.
+ *
+ * Returns how many rows from the top are final, or -1 on failure. Rows just above
+ * the decoded edge are converted without the chroma row below them and must be
+ * drawn again once more rows arrive; the result is below toRow in that case.
+ */
+JNIEXPORT jint JNICALL
+Java_com_alfikri_rizky_avifkit_AvifStreamDecoder_nativeDrawRows(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong handle,
+    jobject bitmap,
+    jint fromRow,
+    jint toRow) {
+
+#if HAVE_LIBAVIF
+    Stream* stream = fromHandle(handle);
+    if (!stream) {
+        LOGE("Invalid stream decoder handle");
+        return -1;
+    }
+    std::lock_guard<std::mutex> guard(stream->lock);
+    if (!stream->parsed || stream->state == kStreamFailed) {
+        return -1;
+    }
+
+    const avifImage* image = stream->decoder->image;
+    uint32_t decodedRows = stream->state == kStreamComplete
+        ? image->height : avifDecoderDecodedRowCount(stream->decoder.get());
+    uint32_t from = static_cast<uint32_t>(std::max(0, fromRow));
+    uint32_t to = static_cast<uint32_t>(std::max(0, toRow));
+    if (image->yuvFormat == AVIF_PIXEL_FORMAT_YUV420) {
+        from &= ~1u;  // views must start on a chroma row
+    }
+    if (from >= to || to > decodedRows) {
+        LOGE("Invalid row range %u..%u (decoded=%u)", from, to, decodedRows);
+        return -1;
+    }
+
+    ScopedBitmapPixels bitmapPixels(env, bitmap);
+    if (!bitmapPixels.pixels()) {
+        return -1;
+    }
+    const AndroidBitmapInfo& info = bitmapPixels.info();
+    const int exifOrientation = orientation::displayOrientation(image);
+    uint32_t displayWidth;
+    uint32_t displayHeight;
+    orientation::displaySize(exifOrientation, image->width, image->height, &displayWidth, &displayHeight);
+    if (info.width != displayWidth || info.height != displayHeight) {
+        LOGE("Bitmap %ux%u does not match image %ux%u", info.width, info.height, displayWidth, displayHeight);
+        return -1;
+    }
+
+    // Convert with chroma context and keep [from, to) only, so the rows match a
+    // conversion of the whole image
+    const uint32_t context = chromaContextRows(image);
+    uint32_t skipRows = 0;
+    AvifImagePtr rows(avifImageCreateEmpty());
+    if (!rows || setContextView(rows.get(), image, from, to - from, decodedRows, &skipRows) != AVIF_RESULT_OK) {
+        LOGE("Failed to create view of rows %u..%u", from, to);
+        return -1;
+    }
+    const uint32_t contextFrom = from - skipRows;
+    const uint32_t contextTo = contextFrom + rows->height;
+
+    // Where rows [from, to) land in the bitmap and in the oriented conversion of the view
+    avifCropRect drawn;
+    avifCropRect kept;
+    orientation::displayRect(exifOrientation, image->width, image->height, {0, from, image->width, to - from},
+                             &drawn);
+    orientation::displayRect(exifOrientation, image->width, contextTo - contextFrom,
+                             {0, skipRows, image->width, to - from}, &kept);
+    uint8_t* drawnPixels = bitmapPixels.mutablePixels() + static_cast<size_t>(drawn.y) * info.stride +
+                           static_cast<size_t>(drawn.x) * 4;
+
+    uint32_t viewWidth;
+    uint32_t viewHeight;
+    orientation::displaySize(exifOrientation, image->width, contextTo - contextFrom, &viewWidth, &viewHeight);
+    const size_t viewRowBytes = static_cast<size_t>(viewWidth) * 4;
+    std::vector<uint8_t> converted;
+    RgbTarget target;
+    target.format = AVIF_RGB_FORMAT_RGBA;
+    target.alphaPremultiplied = bitmapPixels.premultiplied();
+    if (context == 0) {
+        // The view is exactly the drawn rectangle
+        target.pixels = drawnPixels;
+        target.rowBytes = info.stride;
+    } else {
+        converted.resize(viewRowBytes * viewHeight);
+        target.pixels = converted.data();
+        target.rowBytes = static_cast<uint32_t>(viewRowBytes);
+    }
+    if (orientation::convertImageIntoRgb(rows.get(), exifOrientation, target) != AVIF_RESULT_OK) {
+        return -1;
+    }
+    if (context != 0) {
+        for (uint32_t y = 0; y < kept.height; y++) {
+            std::memcpy(drawnPixels + static_cast<size_t>(y) * info.stride,
+                        converted.data() + (kept.y + y) * viewRowBytes + static_cast<size_t>(kept.x) * 4,
+                        static_cast<size_t>(kept.width) * 4);
+        }
+    }
+
+    // Rows within `context` of a decoded edge that is not the image edge are provisional
+    uint32_t finalRows = to;
+    if (contextTo < image->height && contextTo - to < context) {
+        finalRows = std::max(from, contextTo > context ? contextTo - context : 0);
+    }
+    return static_cast<jint>(finalRows);
+#else
+    return -1;
+#endif
+}
+
+/**
+ * Release the decoder and the received bytes
+ */
+JNIEXPORT void JNICALL
+Java_com_alfikri_rizky_avifkit_AvifStreamDecoder_nativeClose(
+    JNIEnv* /* env */,
+    jobject /* this */,
+    jlong handle) {
+
+#if HAVE_LIBAVIF
+    delete fromHandle(handle);
+#endif
+}
+
+} // extern "C"
@@ -0,0 +1,131 @@
+#include "avif_threads.h"
+#include "avif_common.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <sched.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace avifkit {
+namespace threads {
+
+namespace {
+
+/**
+ * Maximum frequency of a CPU in kHz, or 0 when cpufreq is not visible (e.g. SELinux)
+ */
+long maxFrequency(int cpu) {
+    char path[96];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", cpu);
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        return 0;
+    }
+    long frequency = 0;
+    if (fscanf(file, "%ld", &frequency) != 1) {
+        frequency = 0;
+    }
+    fclose(file);
+    return frequency;
+}
+
+int detectBudget() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+        }
+    }
+    if (cpus.empty()) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        int count = online > 0 ? static_cast<int>(online) : static_cast<int>(std::thread::hardware_concurrency());
+        LOGI("Thread budget: %d cores (no affinity mask)", std::max(1, count));
+        return std::max(1, count);
+    }
+
+    std::vector<long> frequencies;
+    for (int cpu : cpus) {
+        long frequency = maxFrequency(cpu);
+        if (frequency <= 0) {
+            frequencies.clear();
+            break;
+        }
+        frequencies.push_back(frequency);
+    }
+
+    int total = static_cast<int>(cpus.size());
+    if (frequencies.empty()) {
+        LOGI("Thread budget: %d cores (topology not visible)", total);
+        return total;
+    }
+
+    long slowest = *std::min_element(frequencies.begin(), frequencies.end());
+    int little = static_cast<int>(std::count(frequencies.begin(), frequencies.end(), slowest));
+    if (little == total) {
+        LOGI("Thread budget: %d cores (symmetric)", total);
+        return total;
+    }
+    int budget = (total - little) + (little + 1) / 2;
+    LOGI("Thread budget: %d threads (%d big, %d little cores)", budget, total - little, little);
+    return budget;
+}
+
+struct Governor {
+    std::mutex lock;
+    int detected = detectBudget();
+    int cap = 0;
+    int activeJobs = 0;
+    int threadsInUse = 0;
+
+    int budget() const { return cap > 0 ? std::min(cap, detected) : detected; }
+};
+
+Governor& governor() {
+    static Governor instance;
+    return instance;
+}
+
+} // namespace
+
+int budget() {
+    Governor& g = governor();
+    std::lock_guard<std::mutex> guard(g.lock);
+    return g.budget();
+}
+
+void setCap(int maxThreads) {
+    Governor& g = governor();
+    std::lock_guard<std::mutex> guard(g.lock);
+    g.cap = std::max(0, maxThreads);
+    LOGI("Thread budget cap: %d (budget=%d)", g.cap, g.budget());
+}
+
+Lease::Lease(int requested) {
+    Governor& g = governor();
+    std::lock_guard<std::mutex> guard(g.lock);
+    int budget = g.budget();
+    int fairShare = budget / (g.activeJobs + 1);
+    int free = budget - g.threadsInUse;
+    count_ = std::max(1, std::min(fairShare, free));
+    if (requested > 0) {
+        count_ = std::min(count_, requested);
+    }
+    g.activeJobs++;
+    g.threadsInUse += count_;
+    LOGD("Thread lease: %d threads (%d jobs, %d/%d in use)", count_, g.activeJobs, g.threadsInUse, budget);
+}
+
+Lease::~Lease() {
+    Governor& g = governor();
+    std::lock_guard<std::mutex> guard(g.lock);
+    g.activeJobs--;
+    g.threadsInUse -= count_;
+}
+
+} // namespace threads
+} // namespace avifkit
@@ -0,0 +1,59 @@
+#ifndef AVIFKIT_AVIF_THREADS_H
+#define AVIFKIT_AVIF_THREADS_H
+
+/**
+ * Process-wide codec thread budget
+ *
+ * Every encode or decode leases its codec thread count from one budget sized
+ * to the cores we are allowed to run on, so parallel conversions split the
+ * cores instead of each starting its own full set of threads. A one-shot job
+ * keeps its share until it finishes. libavif fixes a codec's thread count when
+ * the codec is created, so long-lived handles (stream and animation decoders,
+ * sequence encoders) lease once when they are created and keep their share
+ * until they are closed or finished. Jobs that start later see whatever earlier
+ * jobs have returned.
+ */
+namespace avifkit {
+namespace threads {
+
+/**
+ * Codec threads available to the whole process
+ *
+ * Derived from the CPUs in our affinity mask. When cpufreq exposes a
+ * big.LITTLE topology, the slowest cluster only counts for half its cores:
+ * codec threads there finish last and stretch the tail of every frame.
+ * Never exceeds the cap set with setCap.
+ */
+int budget();
+
+/**
+ * Limit the budget to maxThreads (0 restores the detected budget)
+ * Applies to jobs started afterwards.
+ */
+void setCap(int maxThreads);
+
+/**
+ * A share of the budget, held for one encode or decode (or one open handle)
+ *
+ * The share is the budget split evenly across active jobs, limited to what is
+ * still free, and never less than one thread. requested > 0 bounds the share
+ * further.
+ */
+class Lease {
+public:
+    explicit Lease(int requested = 0);
+    ~Lease();
+
+    Lease(const Lease&) = delete;
+    Lease& operator=(const Lease&) = delete;
+
+    int count() const { return count_; }
+
+private:
+    int count_;
+};
+
+} // namespace threads
+} // namespace avifkit
+
+#endif // AVIFKIT_AVIF_THREADS_H
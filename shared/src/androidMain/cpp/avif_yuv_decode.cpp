@@ -0,0 +1,250 @@
+#include "avif_common.h"
+#include "avif_io.h"
+#include "avif_orientation.h"
+
+#include <unistd.h>
+
+using namespace avifkit;
+
+#if HAVE_LIBAVIF
+namespace {
+
+// Ints written by nativeGetInfo
+constexpr jsize kYuvInfoSize = 14;
+
+/**
+ * Decoded frame behind an AvifYuvImage handle
+ *
+ * The planes handed to Java are direct buffers over decoder->image, which the
+ * codec owns, so the decoder lives exactly as long as the handle. Nothing is
+ * decoded after open, so no lock is needed.
+ */
+struct YuvImage {
+    AvifDecoderPtr decoder;
+    std::vector<uint8_t> data;  // owned copy for byte array sources
+    int fd = -1;                // dup'ed descriptor for file sources
+
+    ~YuvImage() {
+        decoder.reset();  // the IO may still reference data or fd
+        if (fd >= 0) close(fd);
+    }
+};
+
+YuvImage* fromHandle(jlong handle) {
+    return reinterpret_cast<YuvImage*>(static_cast<intptr_t>(handle));
+}
+
+/**
+ * Decode the first image from the IO set up by attachIO and return the handle
+ */
+template <typename AttachIO>
+jlong openYuvImage(YuvImage* yuvImage, AttachIO attachIO) {
+    std::unique_ptr<YuvImage> owner(yuvImage);
+    if (decoderCodecName()[0] == '\0') {
+        LOGE("No decoder codec available! AOM decoder not found.");
+        return 0;
+    }
+
+    owner->decoder.reset(avifDecoderCreate());
+    if (!owner->decoder) {
+        LOGE("Failed to create AVIF decoder");
+        return 0;
+    }
+    configureDecoder(owner->decoder.get(), AVIF_CODEC_CHOICE_AUTO);
+    if (!attachIO(owner->decoder.get()) || decodeFirstImage(owner->decoder.get()) != AVIF_RESULT_OK) {
+        return 0;
+    }
+
+    const avifImage* image = owner->decoder->image;
+    LOGI("Decoded AVIF to YUV: %ux%u, depth=%u, format=%s, range=%s", image->width, image->height, image->depth,
+         avifPixelFormatToString(image->yuvFormat), image->yuvRange == AVIF_RANGE_FULL ? "full" : "limited");
+    return static_cast<jlong>(reinterpret_cast<intptr_t>(owner.release()));
+}
+
+/**
+ * Probe-style subsample value: 0=444, 1=422, 2=420, 3=monochrome
+ */
+jint subsampleFromPixelFormat(avifPixelFormat format) {
+    switch (format) {
+        case AVIF_PIXEL_FORMAT_YUV444: return 0;
+        case AVIF_PIXEL_FORMAT_YUV422: return 1;
+        case AVIF_PIXEL_FORMAT_YUV420: return 2;
+        default: return 3;
+    }
+}
+
+} // namespace
+#endif
+
+extern "C" {
+
+/**
+ * Decode the first image of an AVIF held in a byte array, keeping it as YUV
+ * The bytes are copied once into native memory. Returns 0 on failure.
+ */
+JNIEXPORT jlong JNICALL
+Java_com_alfikri_rizky_avifkit_AvifYuvImage_nativeOpen(
+    JNIEnv* env,
+    jobject /* this */,
+    jbyteArray avifData) {
+
+#if HAVE_LIBAVIF
+    auto* yuvImage = new YuvImage();
+    jsize length = env->GetArrayLength(avifData);
+    yuvImage->data.resize(length);
+    env->GetByteArrayRegion(avifData, 0, length, reinterpret_cast<jbyte*>(yuvImage->data.data()));
+
+    return openYuvImage(yuvImage, [yuvImage](avifDecoder* decoder) {
+        avifResult result = avifDecoderSetIOMemory(decoder, yuvImage->data.data(), yuvImage->data.size());
+        if (result != AVIF_RESULT_OK) {
+            LOGE("Failed to set decoder IO: %s", avifResultToString(result));
+            return false;
+        }
+        return true;
+    });
+#else
+    LOGW("PLACEHOLDER: libavif not available, YUV decoding not supported");
+    return 0;
+#endif
+}
+
+/**
+ * Decode the first image of an AVIF file descriptor (duplicated; the caller may close theirs)
+ * Returns 0 on failure.
+ */
+JNIEXPORT jlong JNICALL
+Java_com_alfikri_rizky_avifkit_AvifYuvImage_nativeOpenFd(
+    JNIEnv* /* env */,
+    jobject /* this */,
+    jint fd) {
+
+#if HAVE_LIBAVIF
+    auto* yuvImage = new YuvImage();
+    yuvImage->fd = dup(fd);
+    if (yuvImage->fd < 0) {
+        LOGE("Failed to duplicate file descriptor %d", fd);
+        delete yuvImage;
+        return 0;
+    }
+
+    return openYuvImage(yuvImage, [yuvImage](avifDecoder* decoder) {
+        avifIO* reader = io::createFdReader(yuvImage->fd);
+        if (!reader) {
+            return false;
+        }
+        avifDecoderSetIO(decoder, reader);
+        return true;
+    });
+#else
+    LOGW("PLACEHOLDER: libavif not available, YUV decoding not supported");
+    return 0;
+#endif
+}
+
+/**
+ * Layout and colour description of the decoded planes
+ * outInfo (14 ints): width, height, depth, subsample (0=444, 1=422, 2=420,
+ * 3=monochrome), fullRange, colorPrimaries, transferCharacteristics,
+ * matrixCoefficients (CICP codes), hasAlpha, alphaPremultiplied, orientation
+ * (Exif), then the Y, chroma and alpha row strides in bytes.
+ */
+JNIEXPORT jboolean JNICALL
+Java_com_alfikri_rizky_avifkit_AvifYuvImage_nativeGetInfo(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong handle,
+    jintArray outInfo) {
+
+#if HAVE_LIBAVIF
+    YuvImage* yuvImage = fromHandle(handle);
+    if (!yuvImage || env->GetArrayLength(outInfo) < kYuvInfoSize) {
+        return JNI_FALSE;
+    }
+
+    const avifImage* image = yuvImage->decoder->image;
+    jint info[kYuvInfoSize] = {
+        static_cast<jint>(image->width),
+        static_cast<jint>(image->height),
+        static_cast<jint>(image->depth),
+        subsampleFromPixelFormat(image->yuvFormat),
+        image->yuvRange == AVIF_RANGE_FULL ? 1 : 0,
+        static_cast<jint>(image->colorPrimaries),
+        static_cast<jint>(image->transferCharacteristics),
+        static_cast<jint>(image->matrixCoefficients),
+        image->alphaPlane ? 1 : 0,
+        image->alphaPremultiplied ? 1 : 0,
+        orientation::displayOrientation(image),
+        static_cast<jint>(image->yuvRowBytes[AVIF_CHAN_Y]),
+        static_cast<jint>(image->yuvRowBytes[AVIF_CHAN_U]),
+        static_cast<jint>(image->alphaRowBytes)
+    };
+    env->SetIntArrayRegion(outInfo, 0, kYuvInfoSize, info);
+    return JNI_TRUE;
+#else
+    return JNI_FALSE;
+#endif
+}
+
+/**
+ * Direct ByteBuffer over one decoded plane (0=Y, 1=U, 2=V, 3=alpha), without copying
+ * The buffer ends at the plane's last sample. Samples wider than 8 bits are
+ * little-endian uint16. Returns null if the plane does not exist.
+ */
+JNIEXPORT jobject JNICALL
+Java_com_alfikri_rizky_avifkit_AvifYuvImage_nativePlane(
+    JNIEnv* env,
+    jobject /* this */,
+    jlong handle,
+    jint channel) {
+
+#if HAVE_LIBAVIF
+    YuvImage* yuvImage = fromHandle(handle);
+    if (!yuvImage || channel < 0 || channel > 3) {
+        return nullptr;
+    }
+
+    const avifImage* image = yuvImage->decoder->image;
+    uint8_t* plane;
+    uint32_t rowBytes;
+    uint32_t width = image->width;
+    uint32_t height = image->height;
+    if (channel == 3) {
+        plane = image->alphaPlane;
+        rowBytes = image->alphaRowBytes;
+    } else {
+        plane = image->yuvPlanes[channel];
+        rowBytes = image->yuvRowBytes[channel];
+        if (channel != AVIF_CHAN_Y) {
+            avifPixelFormatInfo formatInfo;
+            avifGetPixelFormatInfo(image->yuvFormat, &formatInfo);
+            width = (width + formatInfo.chromaShiftX) >> formatInfo.chromaShiftX;
+            height = (height + formatInfo.chromaShiftY) >> formatInfo.chromaShiftY;
+        }
+    }
+    if (!plane || width == 0 || height == 0) {
+        return nullptr;
+    }
+
+    const jlong sampleBytes = image->depth > 8 ? 2 : 1;
+    const jlong span = static_cast<jlong>(rowBytes) * (height - 1) + width * sampleBytes;
+    return env->NewDirectByteBuffer(plane, span);
+#else
+    return nullptr;
+#endif
+}
+
+/**
+ * Release the decoder, and with it the plane memory
+ */
+JNIEXPORT void JNICALL
+Java_com_alfikri_rizky_avifkit_AvifYuvImage_nativeClose(
+    JNIEnv* /* env */,
+    jobject /* this */,
+    jlong handle) {
+
+#if HAVE_LIBAVIF
+    delete fromHandle(handle);
+#endif
+}
+
+} // extern "C"
@@ -0,0 +1,317 @@
+#include "avif_common.h"
+#include "avif_orientation.h"
+
+#include <vector>
+
+using namespace avifkit;
+
+#if HAVE_LIBAVIF
+namespace {
+
+/**
+ * Values match the Kotlin YuvLayout enum order
+ */
+enum class YuvLayout {
+    I420 = 0,  // Y, then U, then V planes
+    NV12 = 1,  // Y, then interleaved UV
+    NV21 = 2   // Y, then interleaved VU (Camera1 / YuvImage default)
+};
+
+/**
+ * 8-bit 4:2:0 planes in caller memory, laid out like android.media.Image.Plane
+ * uvPixelStride is the distance between neighbouring chroma samples (1 for
+ * planar, 2 for interleaved); U and V share the row and pixel strides.
+ */
+struct YuvPlanes {
+    const uint8_t* y = nullptr;
+    uint32_t yRowBytes = 0;
+    const uint8_t* u = nullptr;
+    const uint8_t* v = nullptr;
+    uint32_t uvRowBytes = 0;
+    uint32_t uvPixelStride = 1;
+};
+
+uint32_t chromaSize(uint32_t size) {
+    return (size + 1) / 2;
+}
+
+/**
+ * Bytes a plane of the given geometry spans, from its first sample to its last
+ */
+jlong planeSpan(uint32_t width, uint32_t height, uint32_t rowBytes, uint32_t pixelStride) {
+    return static_cast<jlong>(rowBytes) * (height - 1) + static_cast<jlong>(width - 1) * pixelStride + 1;
+}
+
+/**
+ * Tag range, matrix and primaries; every matrix gets explicit primaries so readers never guess
+ * BT.601 frames from Android cameras are sRGB, whose primaries are BT.709's.
+ */
+void setColorDescription(avifImage* image, bool fullRange, jint matrix) {
+    image->yuvRange = fullRange ? AVIF_RANGE_FULL : AVIF_RANGE_LIMITED;
+    switch (matrix) {
+        case 1:
+            image->colorPrimaries = AVIF_COLOR_PRIMARIES_BT709;
+            image->matrixCoefficients = AVIF_MATRIX_COEFFICIENTS_BT709;
+            break;
+        case 2:
+            image->colorPrimaries = AVIF_COLOR_PRIMARIES_BT2020;
+            image->matrixCoefficients = AVIF_MATRIX_COEFFICIENTS_BT2020_NCL;
+            break;
+        default:
+            image->colorPrimaries = AVIF_COLOR_PRIMARIES_BT709;
+            image->matrixCoefficients = AVIF_MATRIX_COEFFICIENTS_BT601;
+            break;
+    }
+}
+
+/**
+ * Wrap caller planes in a 4:2:0 image without converting them
+ *
+ * Luma is always referenced in place, as is planar chroma. Interleaved chroma
+ * (NV12/NV21, or an Image with pixelStride 2) is split into U and V in one pass
+ * over `chroma`, which must outlive the image. The image never owns the planes.
+ */
+AvifImagePtr wrapYuv420(const YuvPlanes& planes, uint32_t width, uint32_t height, bool fullRange, jint matrix,
+                        std::vector<uint8_t>* chroma) {
+    AvifImagePtr image(avifImageCreate(width, height, 8, AVIF_PIXEL_FORMAT_YUV420));
+    if (!image) {
+        LOGE("Failed to create AVIF image");
+        return nullptr;
+    }
+    setColorDescription(image.get(), fullRange, matrix);
+
+    image->yuvPlanes[AVIF_CHAN_Y] = const_cast<uint8_t*>(planes.y);
+    image->yuvRowBytes[AVIF_CHAN_Y] = planes.yRowBytes;
+
+    if (planes.uvPixelStride == 1) {
+        image->yuvPlanes[AVIF_CHAN_U] = const_cast<uint8_t*>(planes.u);
+        image->yuvPlanes[AVIF_CHAN_V] = const_cast<uint8_t*>(planes.v);
+        image->yuvRowBytes[AVIF_CHAN_U] = planes.uvRowBytes;
+        image->yuvRowBytes[AVIF_CHAN_V] = planes.uvRowBytes;
+    } else {
+        const uint32_t chromaWidth = chromaSize(width);
+        const uint32_t chromaHeight = chromaSize(height);
+        const size_t planeBytes = static_cast<size_t>(chromaWidth) * chromaHeight;
+        chroma->resize(planeBytes * 2);
+        uint8_t* u = chroma->data();
+        uint8_t* v = u + planeBytes;
+        for (uint32_t row = 0; row < chromaHeight; row++) {
+            const uint8_t* srcU = planes.u + static_cast<size_t>(row) * planes.uvRowBytes;
+            const uint8_t* srcV = planes.v + static_cast<size_t>(row) * planes.uvRowBytes;
+            uint8_t* dstU = u + static_cast<size_t>(row) * chromaWidth;
+            uint8_t* dstV = v + static_cast<size_t>(row) * chromaWidth;
+            for (uint32_t x = 0; x < chromaWidth; x++) {
+                dstU[x] = srcU[static_cast<size_t>(x) * planes.uvPixelStride];
+                dstV[x] = srcV[static_cast<size_t>(x) * planes.uvPixelStride];
+            }
+        }
+        image->yuvPlanes[AVIF_CHAN_U] = u;
+        image->yuvPlanes[AVIF_CHAN_V] = v;
+        image->yuvRowBytes[AVIF_CHAN_U] = chromaWidth;
+        image->yuvRowBytes[AVIF_CHAN_V] = chromaWidth;
+    }
+    image->imageOwnsYUVPlanes = AVIF_FALSE;
+    return image;
+}
+
+/**
+ * Downscale (if maxDimension asks for it), tag the orientation and encode
+ */
+jbyteArray encodeYuv(JNIEnv* env, avifImage* image, jint orientation, jint quality, jint speed,
+                     jint maxDimension) {
+    AvifImagePtr scaled;
+    uint32_t dstWidth, dstHeight;
+    resample::scaledSize(image->width, image->height, maxDimension, maxDimension, 0, &dstWidth, &dstHeight);
+    if (dstWidth != image->width || dstHeight != image->height) {
+        scaled = scaleImage(image, dstWidth, dstHeight, resample::Filter::AUTO);
+        if (!scaled) {
+            return nullptr;
+        }
+        image = scaled.get();
+    }
+    orientation::setTransforms(image, orientation);
+
+    EncodeSettings settings;
+    settings.quality = quality;
+    settings.speed = speed;
+
+    ScopedRWData output;
+    avifResult result = encodeImage(image, settings, &output.data);
+    if (result != AVIF_RESULT_OK) {
+        LOGE("Failed to encode YUV image: %s", avifResultToString(result));
+        return nullptr;
+    }
+    LOGD("Encoded YUV AVIF: %ux%u, output size=%zu bytes", image->width, image->height, output.data.size);
+    return toJavaByteArray(env, output.data);
+}
+
+const uint8_t* directBufferAddress(JNIEnv* env, jobject buffer, jlong* capacity) {
+    void* address = buffer ? env->GetDirectBufferAddress(buffer) : nullptr;
+    *capacity = buffer ? env->GetDirectBufferCapacity(buffer) : -1;
+    return *capacity < 0 ? nullptr : static_cast<const uint8_t*>(address);
+}
+
+} // namespace
+#endif
+
+extern "C" {
+
+/**
+ * Encode 8-bit 4:2:0 planes from direct ByteBuffers (android.media.Image / YUV_420_888 layout)
+ *
+ * The planes are encoded as they are, with no RGB round trip: luma and planar
+ * chroma are read in place, interleaved chroma (uvPixelStride 2) is split once.
+ * matrix: 0=BT.601, 1=BT.709, 2=BT.2020. orientation is an Exif orientation and
+ * is stored as irot/imir. maxDimension > 0 downscales the planes first.
+ */
+JNIEXPORT jbyteArray JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeEncodeYuvPlanes(
+    JNIEnv* env,
+    jobject /* this */,
+    jobject yBuffer,
+    jobject uBuffer,
+    jobject vBuffer,
+    jint width,
+    jint height,
+    jint yRowStride,
+    jint uvRowStride,
+    jint uvPixelStride,
+    jboolean fullRange,
+    jint matrix,
+    jint orientation,
+    jint quality,
+    jint speed,
+    jint maxDimension) {
+
+    LOGD("nativeEncodeYuvPlanes: %dx%d, strides=%d/%d/%d, fullRange=%d, matrix=%d, orientation=%d, maxDimension=%d",
+         width, height, yRowStride, uvRowStride, uvPixelStride, fullRange, matrix, orientation, maxDimension);
+
+#if HAVE_LIBAVIF
+    if (encoderCodecName()[0] == '\0') {
+        LOGE("No encoder codec available! AOM codec not found.");
+        return nullptr;
+    }
+
+    jlong yCapacity, uCapacity, vCapacity;
+    YuvPlanes planes;
+    planes.y = directBufferAddress(env, yBuffer, &yCapacity);
+    planes.u = directBufferAddress(env, uBuffer, &uCapacity);
+    planes.v = directBufferAddress(env, vBuffer, &vCapacity);
+    if (!planes.y || !planes.u || !planes.v) {
+        LOGE("Planes are not direct ByteBuffers");
+        return nullptr;
+    }
+    if (width <= 0 || height <= 0 || yRowStride < width || uvPixelStride < 1 ||
+        uvRowStride < static_cast<jlong>(chromaSize(width) - 1) * uvPixelStride + 1) {
+        LOGE("Invalid YUV geometry: %dx%d, strides=%d/%d/%d", width, height, yRowStride, uvRowStride, uvPixelStride);
+        return nullptr;
+    }
+    planes.yRowBytes = yRowStride;
+    planes.uvRowBytes = uvRowStride;
+    planes.uvPixelStride = uvPixelStride;
+
+    // Image planes end at their last sample, not at a full final row
+    const jlong chromaSpan = planeSpan(chromaSize(width), chromaSize(height), uvRowStride, uvPixelStride);
+    if (yCapacity < planeSpan(width, height, yRowStride, 1) || uCapacity < chromaSpan || vCapacity < chromaSpan) {
+        LOGE("Plane buffers too small: capacities=%lld/%lld/%lld", static_cast<long long>(yCapacity),
+             static_cast<long long>(uCapacity), static_cast<long long>(vCapacity));
+        return nullptr;
+    }
+
+    std::vector<uint8_t> chroma;
+    AvifImagePtr image = wrapYuv420(planes, width, height, fullRange == JNI_TRUE, matrix, &chroma);
+    if (!image) {
+        return nullptr;
+    }
+    return encodeYuv(env, image.get(), orientation, quality, speed, maxDimension);
+#else
+    LOGW("PLACEHOLDER: libavif not available, YUV encoding not supported");
+    return nullptr;
+#endif
+}
+
+/**
+ * Encode a packed 8-bit 4:2:0 frame (I420, NV12 or NV21) from a byte array
+ * Rows are tightly packed; chroma is ceil(width / 2) x ceil(height / 2).
+ * layout, matrix, orientation and maxDimension are as for nativeEncodeYuvPlanes.
+ */
+JNIEXPORT jbyteArray JNICALL
+Java_com_alfikri_rizky_avifkit_AvifConverter_nativeEncodeYuvArray(
+    JNIEnv* env,
+    jobject /* this */,
+    jbyteArray yuvData,
+    jint width,
+    jint height,
+    jint layout,
+    jboolean fullRange,
+    jint matrix,
+    jint orientation,
+    jint quality,
+    jint speed,
+    jint maxDimension) {
+
+    LOGD("nativeEncodeYuvArray: %dx%d, layout=%d, fullRange=%d, matrix=%d, orientation=%d, maxDimension=%d",
+         width, height, layout, fullRange, matrix, orientation, maxDimension);
+
+#if HAVE_LIBAVIF
+    if (encoderCodecName()[0] == '\0') {
+        LOGE("No encoder codec available! AOM codec not found.");
+        return nullptr;
+    }
+    if (width <= 0 || height <= 0 || layout < 0 || layout > static_cast<jint>(YuvLayout::NV21)) {
+        LOGE("Invalid YUV frame: %dx%d, layout=%d", width, height, layout);
+        return nullptr;
+    }
+
+    ScopedByteArrayElements data(env, yuvData);
+    if (!data.data()) {
+        LOGE("Failed to get YUV data");
+        return nullptr;
+    }
+    const uint32_t chromaWidth = chromaSize(width);
+    const uint32_t chromaHeight = chromaSize(height);
+    const size_t lumaBytes = static_cast<size_t>(width) * height;
+    const size_t chromaBytes = static_cast<size_t>(chromaWidth) * chromaHeight;
+    if (static_cast<size_t>(data.length()) < lumaBytes + chromaBytes * 2) {
+        LOGE("YUV data too small: %d bytes for %dx%d", data.length(), width, height);
+        return nullptr;
+    }
+
+    YuvPlanes planes;
+    planes.y = data.data();
+    planes.yRowBytes = width;
+    const uint8_t* chromaStart = data.data() + lumaBytes;
+    switch (static_cast<YuvLayout>(layout)) {
+        case YuvLayout::I420:
+            planes.u = chromaStart;
+            planes.v = chromaStart + chromaBytes;
+            planes.uvRowBytes = chromaWidth;
+            planes.uvPixelStride = 1;
+            break;
+        case YuvLayout::NV12:
+            planes.u = chromaStart;
+            planes.v = chromaStart + 1;
+            planes.uvRowBytes = chromaWidth * 2;
+            planes.uvPixelStride = 2;
+            break;
+        case YuvLayout::NV21:
+            planes.v = chromaStart;
+            planes.u = chromaStart + 1;
+            planes.uvRowBytes = chromaWidth * 2;
+            planes.uvPixelStride = 2;
+            break;
+    }
+
+    std::vector<uint8_t> chroma;
+    AvifImagePtr image = wrapYuv420(planes, width, height, fullRange == JNI_TRUE, matrix, &chroma);
+    if (!image) {
+        return nullptr;
+    }
+    return encodeYuv(env, image.get(), orientation, quality, speed, maxDimension);
+#else
+    LOGW("PLACEHOLDER: libavif not available, YUV encoding not supported");
+    return nullptr;
+#endif
+}
+
+} // extern "C"
@@ -0,0 +1,137 @@
+#include "avif_metric.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+using namespace avifkit;
+
+namespace {
+
+struct Plane {
+    std::vector<uint8_t> pixels;
+    uint32_t width;
+    uint32_t height;
+    size_t rowBytes;
+
+    Plane(uint32_t w, uint32_t h, size_t padding = 0)
+        : pixels((w + padding) * h), width(w), height(h), rowBytes(w + padding) {}
+
+    uint8_t& at(uint32_t x, uint32_t y) { return pixels[y * rowBytes + x]; }
+};
+
+/**
+ * Gradients with hard edges, so every window has some structure
+ */
+Plane pattern(uint32_t width, uint32_t height, size_t padding = 0) {
+    Plane plane(width, height, padding);
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            plane.at(x, y) = static_cast<uint8_t>((x * 7 + y * 3) % 200 + ((x / 5 + y / 3) % 2) * 40);
+        }
+    }
+    return plane;
+}
+
+/**
+ * The plane plus fixed pseudo-random noise scaled by amplitude, clamped to 0..255
+ */
+Plane withNoise(const Plane& source, int amplitude) {
+    Plane out = source;
+    uint32_t state = 12345;
+    for (uint32_t y = 0; y < out.height; y++) {
+        for (uint32_t x = 0; x < out.width; x++) {
+            state = state * 1103515245u + 12345u;
+            int noise = static_cast<int>((state >> 16) % 201) - 100;  // -100..100
+            int value = out.at(x, y) + noise * amplitude / 100;
+            out.at(x, y) = static_cast<uint8_t>(std::clamp(value, 0, 255));
+        }
+    }
+    return out;
+}
+
+double ssim(const Plane& a, const Plane& b) {
+    return metric::ssim(a.pixels.data(), a.rowBytes, b.pixels.data(), b.rowBytes, a.width, a.height);
+}
+
+} // namespace
+
+TEST(MetricTest, IdenticalPlanesScoreOne) {
+    Plane plane = pattern(67, 45);
+    EXPECT_DOUBLE_EQ(ssim(plane, plane), 1.0);
+
+    Plane copy = plane;
+    EXPECT_DOUBLE_EQ(ssim(plane, copy), 1.0);
+}
+
+TEST(MetricTest, IdenticalConstantPlanesScoreOne) {
+    Plane black(16, 16);
+    Plane white(16, 16);
+    std::fill(white.pixels.begin(), white.pixels.end(), 255);
+    EXPECT_DOUBLE_EQ(ssim(black, black), 1.0);
+    EXPECT_DOUBLE_EQ(ssim(white, white), 1.0);
+    EXPECT_LT(ssim(black, white), 0.01);
+}
+
+TEST(MetricTest, RowPaddingIsSkipped) {
+    Plane packed = pattern(40, 24);
+    Plane padded = pattern(40, 24, 13);
+    // Garbage in the padding must not count
+    for (uint32_t y = 0; y < padded.height; y++) {
+        std::fill(padded.pixels.begin() + y * padded.rowBytes + padded.width,
+                  padded.pixels.begin() + (y + 1) * padded.rowBytes, 0xEE);
+    }
+    EXPECT_DOUBLE_EQ(metric::ssim(packed.pixels.data(), packed.rowBytes, padded.pixels.data(), padded.rowBytes,
+                                  packed.width, packed.height), 1.0);
+}
+
+TEST(MetricTest, ScoreFallsAsNoiseGrows) {
+    Plane reference = pattern(96, 64);
+    double previous = 1.0;
+    for (int amplitude : {2, 8, 24, 64, 160}) {
+        SCOPED_TRACE(amplitude);
+        double score = ssim(reference, withNoise(reference, amplitude));
+        EXPECT_LT(score, previous);
+        EXPECT_GT(score, -1.0);
+        previous = score;
+    }
+}
+
+TEST(MetricTest, IsSymmetricAndBounded) {
+    Plane a = pattern(33, 29);
+    Plane b = withNoise(a, 50);
+    const double ab = ssim(a, b);
+    EXPECT_DOUBLE_EQ(ab, ssim(b, a));
+    EXPECT_LT(ab, 1.0);
+    EXPECT_GE(ab, -1.0);
+
+    // Inverting the structure is as far from the reference as SSIM gets
+    Plane inverted = a;
+    for (uint8_t& value : inverted.pixels) value = static_cast<uint8_t>(255 - value);
+    const double inverse = ssim(a, inverted);
+    EXPECT_LT(inverse, 0.0);
+    EXPECT_GE(inverse, -1.0);
+}
+
+TEST(MetricTest, PlanesSmallerThanAWindow) {
+    Plane tiny = pattern(5, 3);
+    EXPECT_DOUBLE_EQ(ssim(tiny, tiny), 1.0);
+    EXPECT_LT(ssim(tiny, withNoise(tiny, 80)), 1.0);
+
+    Plane narrow = pattern(3, 40);
+    EXPECT_DOUBLE_EQ(ssim(narrow, narrow), 1.0);
+    EXPECT_LT(ssim(narrow, withNoise(narrow, 80)), 1.0);
+}
+
+TEST(MetricTest, EmptyPlanesScoreOne) {
+    EXPECT_DOUBLE_EQ(metric::ssim(nullptr, 0, nullptr, 0, 0, 0), 1.0);
+}
+
+TEST(MetricTest, WeightedYuvSsim) {
+    EXPECT_DOUBLE_EQ(metric::weightedYuvSsim(1.0, 1.0, 1.0), 1.0);
+    EXPECT_DOUBLE_EQ(metric::weightedYuvSsim(0.5, 1.0, 1.0), 0.6);
+    EXPECT_DOUBLE_EQ(metric::weightedYuvSsim(1.0, 0.0, 0.0), 0.8);
+    EXPECT_DOUBLE_EQ(metric::weightedYuvSsim(0.9, 0.8, 0.7), 0.8 * 0.9 + 0.1 * 0.8 + 0.1 * 0.7);
+}
@@ -0,0 +1,449 @@
+#include "avif_image_kernels.h"
+#include "avif_pixel_kernels.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace avifkit;
+using kernels::Isa;
+
+namespace {
+
+struct Size {
+    uint32_t width;
+    uint32_t height;
+};
+
+// Odd sizes, and widths that leave every vector width a remainder
+constexpr Size kSizes[] = {{1, 1}, {3, 5}, {17, 9}, {37, 11}, {64, 3}, {131, 7}};
+
+struct Matrix {
+    const char* name;
+    float kr;
+    float kb;
+};
+
+constexpr Matrix kMatrices[] = {
+    {"BT601", 0.299f, 0.114f},
+    {"BT709", 0.2126f, 0.0722f},
+    {"BT2020", 0.2627f, 0.0593f}
+};
+
+struct Subsampling {
+    const char* name;
+    int shiftX;
+    int shiftY;
+};
+
+constexpr Subsampling kSubsamplings[] = {{"444", 0, 0}, {"422", 1, 0}, {"420", 1, 1}};
+
+/**
+ * Pseudo-random RGBA with alpha 0 and 255 forced into every row
+ */
+std::vector<uint8_t> testRgba(uint32_t width, uint32_t height, uint32_t seed) {
+    std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+    uint32_t state = seed;
+    for (uint8_t& value : rgba) {
+        state = state * 1664525u + 1013904223u;
+        value = static_cast<uint8_t>(state >> 24);
+    }
+    for (uint32_t y = 0; width > 0 && y < height; y++) {
+        rgba[(static_cast<size_t>(y) * width) * 4 + 3] = 0;
+        rgba[(static_cast<size_t>(y) * width + width - 1) * 4 + 3] = 255;
+    }
+    return rgba;
+}
+
+/**
+ * 8-bit YUVA planes with padded rows, so strides differ from widths
+ */
+struct YuvBuffers {
+    YuvBuffers(uint32_t width, uint32_t height, const kernels::YuvParams& params, bool withAlpha)
+        : width(width), height(height),
+          uvWidth((width + params.chromaShiftX) >> params.chromaShiftX),
+          uvHeight((height + params.chromaShiftY) >> params.chromaShiftY) {
+        y.assign(static_cast<size_t>(width + 3) * height, 0);
+        u.assign(static_cast<size_t>(uvWidth + 5) * uvHeight, 0);
+        v.assign(static_cast<size_t>(uvWidth + 5) * uvHeight, 0);
+        planes.y = y.data();
+        planes.u = u.data();
+        planes.v = v.data();
+        planes.yRowBytes = width + 3;
+        planes.uRowBytes = uvWidth + 5;
+        planes.vRowBytes = uvWidth + 5;
+        if (withAlpha) {
+            a.assign(static_cast<size_t>(width + 1) * height, 0);
+            planes.a = a.data();
+            planes.aRowBytes = width + 1;
+        }
+    }
+
+    uint32_t width;
+    uint32_t height;
+    uint32_t uvWidth;
+    uint32_t uvHeight;
+    std::vector<uint8_t> y, u, v, a;
+    kernels::Yuv8Planes planes;
+};
+
+/**
+ * Compare the visible samples of two planes (padding is ignored)
+ */
+::testing::AssertionResult planesEqual(const uint8_t* expected, uint32_t expectedRowBytes, const uint8_t* actual,
+                                       uint32_t actualRowBytes, uint32_t width, uint32_t height) {
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            uint8_t e = expected[static_cast<size_t>(y) * expectedRowBytes + x];
+            uint8_t a = actual[static_cast<size_t>(y) * actualRowBytes + x];
+            if (e != a) {
+                return ::testing::AssertionFailure() << "at (" << x << ", " << y << "): expected " << int(e)
+                                                     << ", got " << int(a);
+            }
+        }
+    }
+    return ::testing::AssertionSuccess();
+}
+
+void expectSameYuv(const YuvBuffers& expected, const YuvBuffers& actual) {
+    EXPECT_TRUE(planesEqual(expected.planes.y, expected.planes.yRowBytes, actual.planes.y, actual.planes.yRowBytes,
+                            expected.width, expected.height)) << "Y";
+    EXPECT_TRUE(planesEqual(expected.planes.u, expected.planes.uRowBytes, actual.planes.u, actual.planes.uRowBytes,
+                            expected.uvWidth, expected.uvHeight)) << "U";
+    EXPECT_TRUE(planesEqual(expected.planes.v, expected.planes.vRowBytes, actual.planes.v, actual.planes.vRowBytes,
+                            expected.uvWidth, expected.uvHeight)) << "V";
+    if (expected.planes.a) {
+        EXPECT_TRUE(planesEqual(expected.planes.a, expected.planes.aRowBytes, actual.planes.a,
+                                actual.planes.aRowBytes, expected.width, expected.height)) << "A";
+    }
+}
+
+/**
+ * RGBA to YUV the way avif_common converts: premultiplied input is unpremultiplied first
+ */
+void rgbaToYuv(const std::vector<uint8_t>& rgba, uint32_t width, uint32_t height, const kernels::YuvParams& params,
+               bool premultiplied, YuvBuffers* out) {
+    std::vector<uint8_t> straight(rgba);
+    if (premultiplied) {
+        kernels::unpremultiplyAlpha(straight.data(), static_cast<size_t>(width) * height);
+    }
+    kernels::rgbaToYuv8(straight.data(), width * 4, width, height, params, out->planes);
+}
+
+/**
+ * YUV to RGBA the way avif_common converts: premultiplied output is premultiplied last
+ */
+std::vector<uint8_t> yuvToRgba(const YuvBuffers& yuv, const kernels::YuvParams& params, bool premultiplied) {
+    std::vector<uint8_t> rgba(static_cast<size_t>(yuv.width) * yuv.height * 4);
+    kernels::yuv8ToRgba(yuv.planes, yuv.width, yuv.height, params, rgba.data(), yuv.width * 4);
+    if (premultiplied) {
+        kernels::premultiplyAlpha(rgba.data(), static_cast<size_t>(yuv.width) * yuv.height);
+    }
+    return rgba;
+}
+
+/**
+ * Run `body` once per layout: subsampling x matrix x range x premultiplied x size
+ */
+template <typename Body>
+void forEachLayout(Body body) {
+    for (const Subsampling& subsampling : kSubsamplings) {
+        for (const Matrix& matrix : kMatrices) {
+            for (bool fullRange : {true, false}) {
+                for (bool premultiplied : {false, true}) {
+                    for (const Size& size : kSizes) {
+                        kernels::YuvParams params;
+                        params.kr = matrix.kr;
+                        params.kb = matrix.kb;
+                        params.fullRange = fullRange;
+                        params.chromaShiftX = subsampling.shiftX;
+                        params.chromaShiftY = subsampling.shiftY;
+                        SCOPED_TRACE(std::string(subsampling.name) + " " + matrix.name +
+                                     (fullRange ? " full" : " limited") +
+                                     (premultiplied ? " premultiplied " : " straight ") +
+                                     std::to_string(size.width) + "x" + std::to_string(size.height));
+                        body(params, premultiplied, size.width, size.height);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Restores the process-wide kernel selection after each test
+ */
+class PixelKernelsTest : public ::testing::Test {
+protected:
+    void SetUp() override { initialIsa_ = kernels::activeIsa(); }
+    void TearDown() override { kernels::limitIsa(initialIsa_); }
+
+    /**
+     * SIMD instruction sets this CPU can run
+     */
+    static std::vector<Isa> simdIsas() {
+        std::vector<Isa> supported;
+        for (Isa isa : {Isa::SSE41, Isa::AVX2, Isa::NEON}) {
+            kernels::limitIsa(isa);
+            if (kernels::activeIsa() == isa) {
+                supported.push_back(isa);
+            }
+        }
+        return supported;
+    }
+
+private:
+    Isa initialIsa_ = Isa::SCALAR;
+};
+
+TEST_F(PixelKernelsTest, SimdSwizzleAndAlphaMatchScalar) {
+    const std::vector<Isa> isas = simdIsas();
+    if (isas.empty()) GTEST_SKIP() << "No SIMD kernels on this CPU";
+
+    for (size_t count : {size_t{0}, size_t{1}, size_t{7}, size_t{31}, size_t{33}, size_t{1027}}) {
+        const std::vector<uint8_t> input = testRgba(static_cast<uint32_t>(count), 1, 0x2545F491u);
+
+        kernels::limitIsa(Isa::SCALAR);
+        std::vector<uint8_t> swapped(input.size()), premultiplied(input), unpremultiplied(input);
+        kernels::swapRedBlue(input.data(), swapped.data(), count);
+        kernels::premultiplyAlpha(premultiplied.data(), count);
+        kernels::unpremultiplyAlpha(unpremultiplied.data(), count);
+
+        for (Isa isa : isas) {
+            SCOPED_TRACE(std::string(kernels::isaName(isa)) + ", " + std::to_string(count) + " pixels");
+            kernels::limitIsa(isa);
+            std::vector<uint8_t> actual(input.size());
+            kernels::swapRedBlue(input.data(), actual.data(), count);
+            EXPECT_EQ(swapped, actual);
+
+            actual = input;
+            kernels::premultiplyAlpha(actual.data(), count);
+            EXPECT_EQ(premultiplied, actual);
+
+            actual = input;
+            kernels::unpremultiplyAlpha(actual.data(), count);
+            EXPECT_EQ(unpremultiplied, actual);
+
+            // One translucent pixel anywhere must be found
+            std::vector<uint8_t> opaque(count * 4, 0xFF);
+            EXPECT_TRUE(kernels::isOpaque(opaque.data(), static_cast<uint32_t>(count * 4),
+                                          static_cast<uint32_t>(count), 1));
+            for (size_t i = 0; i < count; i++) {
+                opaque[i * 4 + 3] = 0xFE;
+                EXPECT_FALSE(kernels::isOpaque(opaque.data(), static_cast<uint32_t>(count * 4),
+                                               static_cast<uint32_t>(count), 1)) << "pixel " << i;
+                opaque[i * 4 + 3] = 0xFF;
+            }
+        }
+    }
+}
+
+TEST_F(PixelKernelsTest, SimdRgbToYuvMatchesScalar) {
+    const std::vector<Isa> isas = simdIsas();
+    if (isas.empty()) GTEST_SKIP() << "No SIMD kernels on this CPU";
+
+    forEachLayout([&](const kernels::YuvParams& params, bool premultiplied, uint32_t width, uint32_t height) {
+        const std::vector<uint8_t> rgba = testRgba(width, height, width * 31 + height);
+
+        kernels::limitIsa(Isa::SCALAR);
+        YuvBuffers expected(width, height, params, true);
+        rgbaToYuv(rgba, width, height, params, premultiplied, &expected);
+
+        for (Isa isa : isas) {
+            SCOPED_TRACE(kernels::isaName(isa));
+            kernels::limitIsa(isa);
+            YuvBuffers actual(width, height, params, true);
+            rgbaToYuv(rgba, width, height, params, premultiplied, &actual);
+            expectSameYuv(expected, actual);
+        }
+    });
+}
+
+TEST_F(PixelKernelsTest, SimdYuvToRgbMatchesScalar) {
+    const std::vector<Isa> isas = simdIsas();
+    if (isas.empty()) GTEST_SKIP() << "No SIMD kernels on this CPU";
+
+    forEachLayout([&](const kernels::YuvParams& params, bool premultiplied, uint32_t width, uint32_t height) {
+        for (bool withAlpha : {false, true}) {
+            SCOPED_TRACE(withAlpha ? "with alpha" : "without alpha");
+            // Arbitrary plane contents, including chroma outside the limited range
+            YuvBuffers yuv(width, height, params, withAlpha);
+            uint32_t state = width * 131 + height;
+            for (std::vector<uint8_t>* plane : {&yuv.y, &yuv.u, &yuv.v, &yuv.a}) {
+                for (uint8_t& value : *plane) {
+                    state = state * 1664525u + 1013904223u;
+                    value = static_cast<uint8_t>(state >> 24);
+                }
+            }
+
+            kernels::limitIsa(Isa::SCALAR);
+            const std::vector<uint8_t> expected = yuvToRgba(yuv, params, premultiplied);
+            for (Isa isa : isas) {
+                SCOPED_TRACE(kernels::isaName(isa));
+                kernels::limitIsa(isa);
+                EXPECT_EQ(expected, yuvToRgba(yuv, params, premultiplied));
+            }
+        }
+    });
+}
+
+#if HAVE_LIBAVIF
+
+struct ImageDeleter {
+    void operator()(avifImage* image) const { avifImageDestroy(image); }
+};
+using ImagePtr = std::unique_ptr<avifImage, ImageDeleter>;
+
+avifMatrixCoefficients matrixCoefficients(const Matrix& matrix) {
+    if (std::strcmp(matrix.name, "BT709") == 0) return AVIF_MATRIX_COEFFICIENTS_BT709;
+    if (std::strcmp(matrix.name, "BT2020") == 0) return AVIF_MATRIX_COEFFICIENTS_BT2020_NCL;
+    return AVIF_MATRIX_COEFFICIENTS_BT601;
+}
+
+avifPixelFormat pixelFormat(const kernels::YuvParams& params) {
+    if (params.chromaShiftX == 0) return AVIF_PIXEL_FORMAT_YUV444;
+    return params.chromaShiftY == 0 ? AVIF_PIXEL_FORMAT_YUV422 : AVIF_PIXEL_FORMAT_YUV420;
+}
+
+/**
+ * An 8-bit YUVA image laid out like `params` describes
+ */
+ImagePtr makeImage(const kernels::YuvParams& params, avifMatrixCoefficients matrix, uint32_t width, uint32_t height) {
+    ImagePtr image(avifImageCreate(width, height, 8, pixelFormat(params)));
+    image->matrixCoefficients = matrix;
+    image->yuvRange = params.fullRange ? AVIF_RANGE_FULL : AVIF_RANGE_LIMITED;
+    EXPECT_EQ(avifImageAllocatePlanes(image.get(), AVIF_PLANES_ALL), AVIF_RESULT_OK);
+    return image;
+}
+
+/**
+ * Run `body` for every layout the kernels take over from libavif, with libavif's matrix enum
+ */
+template <typename Body>
+void forEachLibavifLayout(Body body) {
+    forEachLayout([&](const kernels::YuvParams& params, bool premultiplied, uint32_t width, uint32_t height) {
+        for (const Matrix& matrix : kMatrices) {
+            if (matrix.kr == params.kr && matrix.kb == params.kb) {
+                body(params, matrixCoefficients(matrix), premultiplied, width, height);
+            }
+        }
+    });
+}
+
+std::vector<Isa> allIsas() {
+    std::vector<Isa> isas = {Isa::SCALAR};
+    for (Isa isa : {Isa::SSE41, Isa::AVX2, Isa::NEON}) {
+        kernels::limitIsa(isa);
+        if (kernels::activeIsa() == isa) isas.push_back(isa);
+    }
+    return isas;
+}
+
+TEST_F(PixelKernelsTest, RgbToYuvMatchesLibavif) {
+    const std::vector<Isa> isas = allIsas();
+    forEachLibavifLayout([&](const kernels::YuvParams& params, avifMatrixCoefficients matrix, bool premultiplied,
+                             uint32_t width, uint32_t height) {
+        std::vector<uint8_t> rgba = testRgba(width, height, width * 7 + height);
+        ImagePtr reference = makeImage(params, matrix, width, height);
+
+        kernels::YuvParams imageParams;
+        ASSERT_TRUE(kernels::paramsForImage(reference.get(), &imageParams));
+        EXPECT_EQ(imageParams.kr, params.kr);
+        EXPECT_EQ(imageParams.kb, params.kb);
+
+        avifRGBImage rgb;
+        avifRGBImageSetDefaults(&rgb, reference.get());
+        rgb.format = AVIF_RGB_FORMAT_RGBA;
+        rgb.depth = 8;
+        rgb.pixels = rgba.data();
+        rgb.rowBytes = width * 4;
+        rgb.alphaPremultiplied = premultiplied ? AVIF_TRUE : AVIF_FALSE;
+        ASSERT_EQ(avifImageRGBToYUV(reference.get(), &rgb), AVIF_RESULT_OK);
+
+        YuvBuffers expected(width, height, params, true);
+        expected.planes = kernels::planesOf(reference.get());
+        for (Isa isa : isas) {
+            SCOPED_TRACE(kernels::isaName(isa));
+            kernels::limitIsa(isa);
+            YuvBuffers actual(width, height, params, true);
+            rgbaToYuv(rgba, width, height, params, premultiplied, &actual);
+            expectSameYuv(expected, actual);
+        }
+    });
+}
+
+TEST_F(PixelKernelsTest, YuvToRgbMatchesLibavif) {
+    const std::vector<Isa> isas = allIsas();
+    forEachLibavifLayout([&](const kernels::YuvParams& params, avifMatrixCoefficients matrix, bool premultiplied,
+                             uint32_t width, uint32_t height) {
+        ImagePtr image = makeImage(params, matrix, width, height);
+        uint32_t state = width * 17 + height;
+        for (int channel = 0; channel < 4; channel++) {
+            uint8_t* plane = channel < 3 ? image->yuvPlanes[channel] : image->alphaPlane;
+            uint32_t rowBytes = channel < 3 ? image->yuvRowBytes[channel] : image->alphaRowBytes;
+            uint32_t rows = channel == 1 || channel == 2 ? (height + params.chromaShiftY) >> params.chromaShiftY
+                                                         : height;
+            for (size_t i = 0; i < static_cast<size_t>(rowBytes) * rows; i++) {
+                state = state * 1664525u + 1013904223u;
+                plane[i] = static_cast<uint8_t>(state >> 24);
+            }
+        }
+
+        std::vector<uint8_t> expected(static_cast<size_t>(width) * height * 4);
+        avifRGBImage rgb;
+        avifRGBImageSetDefaults(&rgb, image.get());
+        rgb.format = AVIF_RGB_FORMAT_RGBA;
+        rgb.depth = 8;
+        rgb.pixels = expected.data();
+        rgb.rowBytes = width * 4;
+        rgb.alphaPremultiplied = premultiplied ? AVIF_TRUE : AVIF_FALSE;
+        ASSERT_EQ(avifImageYUVToRGB(image.get(), &rgb), AVIF_RESULT_OK);
+
+        YuvBuffers yuv(width, height, params, true);
+        yuv.planes = kernels::planesOf(image.get());
+        for (Isa isa : isas) {
+            SCOPED_TRACE(kernels::isaName(isa));
+            kernels::limitIsa(isa);
+            EXPECT_EQ(expected, yuvToRgba(yuv, params, premultiplied));
+        }
+    });
+}
+
+TEST_F(PixelKernelsTest, UseForImageAcceptsLayoutsThatMatchLibavif) {
+    forEachLibavifLayout([&](const kernels::YuvParams& params, avifMatrixCoefficients matrix, bool premultiplied,
+                             uint32_t width, uint32_t height) {
+        ImagePtr image = makeImage(params, matrix, width, height);
+        kernels::YuvParams imageParams;
+        EXPECT_TRUE(kernels::useForImage(image.get(), true, premultiplied, &imageParams));
+        EXPECT_TRUE(kernels::useForImage(image.get(), false, premultiplied, &imageParams));
+    });
+}
+
+TEST_F(PixelKernelsTest, OtherLayoutsAreLeftToLibavif) {
+    kernels::YuvParams params;
+
+    ImagePtr identity(avifImageCreate(9, 5, 8, AVIF_PIXEL_FORMAT_YUV444));
+    identity->matrixCoefficients = AVIF_MATRIX_COEFFICIENTS_IDENTITY;
+    EXPECT_FALSE(kernels::paramsForImage(identity.get(), &params));
+    EXPECT_FALSE(kernels::useForImage(identity.get(), true, false, &params));
+
+    ImagePtr monochrome(avifImageCreate(9, 5, 8, AVIF_PIXEL_FORMAT_YUV400));
+    monochrome->matrixCoefficients = AVIF_MATRIX_COEFFICIENTS_BT601;
+    EXPECT_FALSE(kernels::paramsForImage(monochrome.get(), &params));
+
+    ImagePtr highDepth(avifImageCreate(9, 5, 10, AVIF_PIXEL_FORMAT_YUV420));
+    highDepth->matrixCoefficients = AVIF_MATRIX_COEFFICIENTS_BT709;
+    EXPECT_FALSE(kernels::paramsForImage(highDepth.get(), &params));
+
+    ImagePtr premultipliedPlanes(avifImageCreate(9, 5, 8, AVIF_PIXEL_FORMAT_YUV420));
+    premultipliedPlanes->matrixCoefficients = AVIF_MATRIX_COEFFICIENTS_BT709;
+    premultipliedPlanes->alphaPremultiplied = AVIF_TRUE;
+    EXPECT_FALSE(kernels::paramsForImage(premultipliedPlanes.get(), &params));
+}
+
+#endif // HAVE_LIBAVIF
+
+} // namespace
@@ -0,0 +1,555 @@
+#include "avif_probe.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+using namespace avifkit;
+using probe::ImageProbe;
+using probe::Status;
+
+namespace {
+
+using Bytes = std::vector<uint8_t>;
+
+// ==========================================
+// ISOBMFF builders
+// ==========================================
+
+void put8(Bytes& out, uint32_t v) { out.push_back(static_cast<uint8_t>(v)); }
+void put16(Bytes& out, uint32_t v) { put8(out, v >> 8); put8(out, v); }
+void put32(Bytes& out, uint32_t v) { put16(out, v >> 16); put16(out, v); }
+void putType(Bytes& out, const char* type) { out.insert(out.end(), type, type + 4); }
+void putString(Bytes& out, const std::string& s) { out.insert(out.end(), s.begin(), s.end()); out.push_back(0); }
+void append(Bytes& out, const Bytes& more) { out.insert(out.end(), more.begin(), more.end()); }
+
+Bytes concat(std::initializer_list<Bytes> parts) {
+    Bytes out;
+    for (const Bytes& part : parts) append(out, part);
+    return out;
+}
+
+Bytes box(const char* type, const Bytes& payload) {
+    Bytes out;
+    put32(out, static_cast<uint32_t>(payload.size() + 8));
+    putType(out, type);
+    append(out, payload);
+    return out;
+}
+
+Bytes fullBox(const char* type, uint8_t version, uint32_t flags, const Bytes& payload) {
+    Bytes body;
+    put32(body, (static_cast<uint32_t>(version) << 24) | flags);
+    append(body, payload);
+    return box(type, body);
+}
+
+Bytes ftyp(const char* major) {
+    Bytes p;
+    putType(p, major);
+    put32(p, 0);
+    putType(p, "mif1");
+    putType(p, "miaf");
+    putType(p, major);
+    return box("ftyp", p);
+}
+
+Bytes hdlr(const char* handler) {
+    Bytes p;
+    put32(p, 0);
+    putType(p, handler);
+    for (int i = 0; i < 3; i++) put32(p, 0);
+    putString(p, "");
+    return fullBox("hdlr", 0, 0, p);
+}
+
+Bytes pitm(uint32_t id) {
+    Bytes p;
+    put16(p, id);
+    return fullBox("pitm", 0, 0, p);
+}
+
+struct Item {
+    uint32_t id;
+    const char* type;
+};
+
+Bytes iinf(std::initializer_list<Item> items) {
+    Bytes p;
+    put16(p, static_cast<uint32_t>(items.size()));
+    for (const Item& item : items) {
+        Bytes infe;
+        put16(infe, item.id);
+        put16(infe, 0);
+        putType(infe, item.type);
+        putString(infe, "");
+        append(p, fullBox("infe", 2, 0, infe));
+    }
+    return fullBox("iinf", 0, 0, p);
+}
+
+Bytes reference(const char* type, uint32_t from, std::initializer_list<uint32_t> to) {
+    Bytes p;
+    put16(p, from);
+    put16(p, static_cast<uint32_t>(to.size()));
+    for (uint32_t id : to) put16(p, id);
+    return box(type, p);
+}
+
+Bytes iref(std::initializer_list<Bytes> references) {
+    return fullBox("iref", 0, 0, concat(references));
+}
+
+Bytes ispe(uint32_t width, uint32_t height) {
+    Bytes p;
+    put32(p, width);
+    put32(p, height);
+    return fullBox("ispe", 0, 0, p);
+}
+
+/**
+ * AV1CodecConfigurationRecord; subsample 0=444, 1=422, 2=420, 3=400
+ */
+Bytes av1C(uint32_t depth, int subsample) {
+    Bytes p;
+    put8(p, 0x81);
+    put8(p, depth == 12 ? 0x40 : 0x00);
+    uint8_t flags = 0;
+    if (depth > 8) flags |= 0x40;
+    if (depth == 12) flags |= 0x20;
+    if (subsample == 3) flags |= 0x10 | 0x08 | 0x04;
+    if (subsample == 1 || subsample == 2) flags |= 0x08;
+    if (subsample == 2) flags |= 0x04;
+    put8(p, flags);
+    put8(p, 0);
+    return box("av1C", p);
+}
+
+Bytes pixi(uint32_t depth) {
+    Bytes p;
+    put8(p, 3);
+    for (int i = 0; i < 3; i++) put8(p, depth);
+    return fullBox("pixi", 0, 0, p);
+}
+
+Bytes nclx(uint32_t primaries, uint32_t transfer) {
+    Bytes p;
+    putType(p, "nclx");
+    put16(p, primaries);
+    put16(p, transfer);
+    put16(p, 6);
+    put8(p, 0x80);
+    return box("colr", p);
+}
+
+Bytes auxC(const std::string& urn) {
+    Bytes p;
+    putString(p, urn);
+    return fullBox("auxC", 0, 0, p);
+}
+
+Bytes irot(uint32_t angle) {
+    Bytes p;
+    put8(p, angle);
+    return box("irot", p);
+}
+
+Bytes imir(uint32_t axis) {
+    Bytes p;
+    put8(p, axis);
+    return box("imir", p);
+}
+
+struct ItemProperties {
+    uint32_t itemId;
+    std::vector<uint8_t> indices;  // 1-based ipco indices
+};
+
+Bytes iprp(std::initializer_list<Bytes> properties, std::initializer_list<ItemProperties> associations) {
+    Bytes ipma;
+    put32(ipma, static_cast<uint32_t>(associations.size()));
+    for (const ItemProperties& association : associations) {
+        put16(ipma, association.itemId);
+        put8(ipma, static_cast<uint32_t>(association.indices.size()));
+        for (uint8_t index : association.indices) put8(ipma, 0x80 | index);
+    }
+    return box("iprp", concat({box("ipco", concat(properties)), fullBox("ipma", 0, 0, ipma)}));
+}
+
+Bytes meta(std::initializer_list<Bytes> children) {
+    return fullBox("meta", 0, 0, concat({hdlr("pict"), concat(children)}));
+}
+
+Bytes mdat(size_t size) {
+    return box("mdat", Bytes(size, 0x5A));
+}
+
+Bytes trak(const char* handler, uint32_t width, uint32_t height, uint32_t depth, uint32_t samples, bool auxiliary) {
+    Bytes entry(6, 0);
+    put16(entry, 1);                        // data_reference_index
+    entry.resize(entry.size() + 16, 0);     // pre_defined / reserved
+    put16(entry, width);
+    put16(entry, height);
+    entry.resize(entry.size() + 50, 0);     // resolution, frame_count, compressorname, depth, pre_defined
+    append(entry, av1C(depth, 2));
+
+    Bytes stsd;
+    put32(stsd, 1);
+    append(stsd, box("av01", entry));
+
+    Bytes stsz;
+    put32(stsz, 0);
+    put32(stsz, samples);
+    for (uint32_t i = 0; i < samples; i++) put32(stsz, 100);
+
+    Bytes stbl = box("stbl", concat({fullBox("stsd", 0, 0, stsd), fullBox("stsz", 0, 0, stsz)}));
+    Bytes mdia = box("mdia", concat({hdlr(handler), box("minf", stbl)}));
+    if (!auxiliary) return box("trak", mdia);
+
+    Bytes auxl;
+    put32(auxl, 1);
+    return box("trak", concat({box("tref", box("auxl", auxl)), mdia}));
+}
+
+// ==========================================
+// Fixtures
+// ==========================================
+
+const char* const kAlphaUrn = "urn:mpeg:mpegB:cicp:systems:auxiliary:alpha";
+
+Bytes stillFile() {
+    return concat({
+        ftyp("avif"),
+        meta({pitm(1), iinf({{1, "av01"}}),
+              iprp({ispe(64, 48), av1C(8, 2), pixi(8), nclx(9, 16)}, {{1, {1, 2, 3, 4}}})}),
+        mdat(256),
+    });
+}
+
+Bytes gridFile() {
+    return concat({
+        ftyp("avif"),
+        meta({pitm(1), iinf({{1, "grid"}, {2, "av01"}, {3, "av01"}}), iref({reference("dimg", 1, {2, 3})}),
+              iprp({ispe(128, 48), ispe(64, 48), av1C(8, 0)}, {{1, {1}}, {2, {2, 3}}, {3, {2, 3}}})}),
+        mdat(512),
+    });
+}
+
+Bytes alphaFile() {
+    return concat({
+        ftyp("avif"),
+        meta({pitm(1), iinf({{1, "av01"}, {2, "av01"}}), iref({reference("auxl", 2, {1})}),
+              iprp({ispe(32, 32), av1C(8, 2), av1C(8, 3), auxC(kAlphaUrn)}, {{1, {1, 2}}, {2, {1, 3, 4}}})}),
+        mdat(256),
+    });
+}
+
+Bytes tenBitFile() {
+    return concat({
+        ftyp("avif"),
+        meta({pitm(1), iinf({{1, "av01"}}), iprp({ispe(20, 10), av1C(10, 1), pixi(10)}, {{1, {1, 2, 3}}})}),
+        mdat(256),
+    });
+}
+
+Bytes sequenceFile() {
+    return concat({
+        ftyp("avis"),
+        box("moov", concat({trak("pict", 40, 30, 8, 5, false), trak("auxv", 40, 30, 8, 5, true)})),
+        mdat(1024),
+    });
+}
+
+/**
+ * A 64x48 still image with the irot/imir the encoder writes for an Exif orientation
+ */
+Bytes orientedFile(int exifOrientation) {
+    // {irot angle, imir axis}, -1 = property absent
+    static const int kTransforms[9][2] = {
+        {-1, -1}, {-1, -1}, {-1, 1}, {2, -1}, {-1, 0}, {1, 0}, {3, -1}, {3, 0}, {1, -1}};
+    const int angle = kTransforms[exifOrientation][0];
+    const int axis = kTransforms[exifOrientation][1];
+
+    Bytes properties = concat({ispe(64, 48), av1C(8, 2)});
+    std::vector<uint8_t> indices = {1, 2};
+    if (angle >= 0) {
+        append(properties, irot(static_cast<uint32_t>(angle)));
+        indices.push_back(static_cast<uint8_t>(indices.size() + 1));
+    }
+    if (axis >= 0) {
+        append(properties, imir(static_cast<uint32_t>(axis)));
+        indices.push_back(static_cast<uint8_t>(indices.size() + 1));
+    }
+    return concat({
+        ftyp("avif"),
+        meta({pitm(1), iinf({{1, "av01"}}), iprp({properties}, {{1, indices}})}),
+        mdat(256),
+    });
+}
+
+/**
+ * Probe an exact-size heap copy, so AddressSanitizer flags any read past the end
+ */
+Status probeCopy(const Bytes& data, size_t size, ImageProbe* out) {
+    Bytes copy(data.begin(), data.begin() + size);
+    return probe::probeAvif(copy.data(), copy.size(), out);
+}
+
+Status probeAll(const Bytes& data, ImageProbe* out) {
+    return probeCopy(data, data.size(), out);
+}
+
+/**
+ * Offset just past the first top-level box of the given type
+ */
+size_t boxEnd(const Bytes& data, const char* type) {
+    size_t pos = 0;
+    while (pos + 8 <= data.size()) {
+        uint32_t size = (static_cast<uint32_t>(data[pos]) << 24) | (data[pos + 1] << 16) | (data[pos + 2] << 8) |
+                        data[pos + 3];
+        if (std::memcmp(&data[pos + 4], type, 4) == 0) return pos + size;
+        pos += size;
+    }
+    return 0;
+}
+
+// ==========================================
+// Well-formed files
+// ==========================================
+
+TEST(ProbeTest, StillImage) {
+    ImageProbe info;
+    ASSERT_EQ(probeAll(stillFile(), &info), Status::OK);
+    EXPECT_EQ(info.width, 64u);
+    EXPECT_EQ(info.height, 48u);
+    EXPECT_EQ(info.depth, 8u);
+    EXPECT_EQ(info.subsample, 2);
+    EXPECT_FALSE(info.hasAlpha);
+    EXPECT_FALSE(info.isSequence);
+    EXPECT_EQ(info.frameCount, 1u);
+    EXPECT_EQ(info.colorPrimaries, 9);
+    EXPECT_EQ(info.transferCharacteristics, 16);
+}
+
+TEST(ProbeTest, OrientationReportsDisplayedSize) {
+    for (int orientation = 1; orientation <= 8; orientation++) {
+        SCOPED_TRACE(orientation);
+        ImageProbe info;
+        ASSERT_EQ(probeAll(orientedFile(orientation), &info), Status::OK);
+        EXPECT_EQ(info.orientation, orientation);
+        EXPECT_EQ(info.width, orientation >= 5 ? 48u : 64u);
+        EXPECT_EQ(info.height, orientation >= 5 ? 64u : 48u);
+        EXPECT_EQ(info.subsample, 2);
+    }
+}
+
+TEST(ProbeTest, IrotReservedBitsAreIgnored) {
+    Bytes file = concat({
+        ftyp("avif"),
+        meta({pitm(1), iinf({{1, "av01"}}), iprp({ispe(64, 48), irot(0xFD)}, {{1, {1, 2}}})}),
+        mdat(16),
+    });
+    ImageProbe info;
+    ASSERT_EQ(probeAll(file, &info), Status::OK);
+    EXPECT_EQ(info.orientation, 8);
+    EXPECT_EQ(info.width, 48u);
+    EXPECT_EQ(info.height, 64u);
+}
+
+TEST(ProbeTest, GridTakesSizeFromGridAndFormatFromTiles) {
+    ImageProbe info;
+    ASSERT_EQ(probeAll(gridFile(), &info), Status::OK);
+    EXPECT_EQ(info.width, 128u);
+    EXPECT_EQ(info.height, 48u);
+    EXPECT_EQ(info.depth, 8u);
+    EXPECT_EQ(info.subsample, 0);
+    EXPECT_EQ(info.colorPrimaries, 2);
+    EXPECT_EQ(info.frameCount, 1u);
+}
+
+TEST(ProbeTest, AlphaAuxiliaryImage) {
+    ImageProbe info;
+    ASSERT_EQ(probeAll(alphaFile(), &info), Status::OK);
+    EXPECT_EQ(info.width, 32u);
+    EXPECT_EQ(info.height, 32u);
+    EXPECT_EQ(info.subsample, 2);
+    EXPECT_TRUE(info.hasAlpha);
+}
+
+TEST(ProbeTest, TenBit) {
+    ImageProbe info;
+    ASSERT_EQ(probeAll(tenBitFile(), &info), Status::OK);
+    EXPECT_EQ(info.width, 20u);
+    EXPECT_EQ(info.height, 10u);
+    EXPECT_EQ(info.depth, 10u);
+    EXPECT_EQ(info.subsample, 1);
+}
+
+TEST(ProbeTest, Sequence) {
+    ImageProbe info;
+    ASSERT_EQ(probeAll(sequenceFile(), &info), Status::OK);
+    EXPECT_EQ(info.width, 40u);
+    EXPECT_EQ(info.height, 30u);
+    EXPECT_EQ(info.depth, 8u);
+    EXPECT_EQ(info.subsample, 2);
+    EXPECT_TRUE(info.isSequence);
+    EXPECT_TRUE(info.hasAlpha);
+    EXPECT_EQ(info.frameCount, 5u);
+}
+
+TEST(ProbeTest, NotAvif) {
+    Bytes png = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A, 0, 0, 0, 13, 'I', 'H', 'D', 'R', 0, 0, 1, 0};
+    ImageProbe info;
+    EXPECT_EQ(probeAll(png, &info), Status::NOT_AVIF);
+    EXPECT_EQ(probeAll(concat({ftyp("heic"), mdat(16)}), &info), Status::NOT_AVIF);
+}
+
+// ==========================================
+// Truncated and malformed input
+// ==========================================
+
+TEST(ProbeTest, TruncatedPrefixesAskForMoreData) {
+    struct Fixture {
+        const char* name;
+        Bytes data;
+        const char* headerBox;  // the box that must be complete before the probe succeeds
+    };
+    const Fixture fixtures[] = {
+        {"still", stillFile(), "meta"},
+        {"grid", gridFile(), "meta"},
+        {"alpha", alphaFile(), "meta"},
+        {"10-bit", tenBitFile(), "meta"},
+        {"sequence", sequenceFile(), "moov"},
+    };
+    for (const Fixture& fixture : fixtures) {
+        ImageProbe full;
+        ASSERT_EQ(probeAll(fixture.data, &full), Status::OK) << fixture.name;
+        const size_t required = boxEnd(fixture.data, fixture.headerBox);
+        ASSERT_GT(required, 0u);
+
+        for (size_t size = 0; size <= fixture.data.size(); size++) {
+            SCOPED_TRACE(testing::Message() << fixture.name << " prefix " << size);
+            ImageProbe info;
+            Status status = probeCopy(fixture.data, size, &info);
+            if (size < required) {
+                ASSERT_EQ(status, Status::NEED_MORE_DATA);
+                ASSERT_GT(info.neededBytes, size);
+            } else {
+                ASSERT_EQ(status, Status::OK);
+                EXPECT_EQ(info.width, full.width);
+                EXPECT_EQ(info.height, full.height);
+                EXPECT_EQ(info.depth, full.depth);
+                EXPECT_EQ(info.hasAlpha, full.hasAlpha);
+            }
+        }
+    }
+}
+
+/**
+ * Overwrite the 32-bit size of the first box of `type`
+ */
+Bytes withBoxSize(Bytes data, const char* type, uint32_t size) {
+    for (size_t pos = 4; pos + 4 <= data.size(); pos++) {
+        if (std::memcmp(&data[pos], type, 4) == 0) {
+            data[pos - 4] = static_cast<uint8_t>(size >> 24);
+            data[pos - 3] = static_cast<uint8_t>(size >> 16);
+            data[pos - 2] = static_cast<uint8_t>(size >> 8);
+            data[pos - 1] = static_cast<uint8_t>(size);
+            return data;
+        }
+    }
+    ADD_FAILURE() << "no " << type << " box";
+    return data;
+}
+
+TEST(ProbeTest, ChildBoxLargerThanParentIsInvalid) {
+    ImageProbe info;
+    EXPECT_EQ(probeAll(withBoxSize(stillFile(), "iprp", 0x7FFFFFFF), &info), Status::INVALID);
+    EXPECT_EQ(probeAll(withBoxSize(stillFile(), "ispe", 0x1000), &info), Status::INVALID);
+    EXPECT_EQ(probeAll(withBoxSize(sequenceFile(), "stsd", 0x1000), &info), Status::INVALID);
+}
+
+TEST(ProbeTest, BoxSizeSmallerThanHeaderFails) {
+    for (uint32_t size : {2u, 7u}) {
+        ImageProbe info;
+        EXPECT_NE(probeAll(withBoxSize(stillFile(), "pitm", size), &info), Status::OK) << size;
+        EXPECT_NE(probeAll(withBoxSize(stillFile(), "meta", size), &info), Status::OK) << size;
+    }
+}
+
+TEST(ProbeTest, HugeTopLevelSizesDoNotWrap) {
+    // size32 == 1 selects a 64-bit size; one near UINT64_MAX must not wrap the end offset
+    Bytes data = stillFile();
+    const size_t metaStart = boxEnd(data, "ftyp");
+    Bytes large = {0, 0, 0, 1, 'm', 'e', 't', 'a', 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0};
+    Bytes patched(data.begin(), data.begin() + metaStart);
+    append(patched, large);
+    patched.insert(patched.end(), data.begin() + metaStart + 8, data.end());
+
+    ImageProbe info;
+    Status status = probeAll(patched, &info);
+    EXPECT_NE(status, Status::OK);
+    if (status == Status::NEED_MORE_DATA) {
+        EXPECT_GT(info.neededBytes, patched.size());
+    }
+}
+
+TEST(ProbeTest, MalformedPropertiesAreInvalid) {
+    ImageProbe info;
+
+    // Association points past the property container
+    Bytes dangling = concat({ftyp("avif"), meta({pitm(1), iinf({{1, "av01"}}), iprp({ispe(8, 8)}, {{1, {5}}})})});
+    EXPECT_EQ(probeAll(dangling, &info), Status::INVALID);
+
+    // Primary item without ispe
+    Bytes noIspe = concat({ftyp("avif"), meta({pitm(1), iinf({{1, "av01"}}), iprp({av1C(8, 2)}, {{1, {1}}})})});
+    EXPECT_EQ(probeAll(noIspe, &info), Status::INVALID);
+
+    // ipma claims far more entries than it holds
+    Bytes ipma;
+    put32(ipma, 0xFFFFFFFF);
+    put16(ipma, 1);
+    put8(ipma, 1);
+    put8(ipma, 0x81);
+    Bytes manyEntries = concat({ftyp("avif"),
+                                meta({pitm(1), iinf({{1, "av01"}}),
+                                      box("iprp", concat({box("ipco", ispe(8, 8)), fullBox("ipma", 0, 0, ipma)}))})});
+    EXPECT_EQ(probeAll(manyEntries, &info), Status::INVALID);
+
+    // Truncated ispe payload
+    Bytes shortIspe = concat({ftyp("avif"), meta({pitm(1), iinf({{1, "av01"}}),
+                                                  iprp({fullBox("ispe", 0, 0, {0, 0, 0, 8})}, {{1, {1}}})})});
+    EXPECT_EQ(probeAll(shortIspe, &info), Status::INVALID);
+
+    // Sample entry too short for its fixed fields
+    Bytes shortEntry = concat({ftyp("avis"),
+                               box("moov", box("trak", box("mdia", concat({hdlr("pict"),
+                                   box("minf", box("stbl", fullBox("stsd", 0, 0, concat({{0, 0, 0, 1},
+                                       box("av01", Bytes(20, 0))}))))}))))});
+    EXPECT_EQ(probeAll(shortEntry, &info), Status::INVALID);
+}
+
+TEST(ProbeTest, UnterminatedAuxTypeIsNotAlpha) {
+    // auxC whose URN runs to the end of the box without a terminator
+    Bytes urn(kAlphaUrn, kAlphaUrn + std::strlen(kAlphaUrn) - 1);
+    Bytes data = concat({
+        ftyp("avif"),
+        meta({pitm(1), iinf({{1, "av01"}, {2, "av01"}}), iref({reference("auxl", 2, {1})}),
+              iprp({ispe(32, 32), fullBox("auxC", 0, 0, urn)}, {{1, {1}}, {2, {1, 2}}})}),
+    });
+    ImageProbe info;
+    ASSERT_EQ(probeAll(data, &info), Status::OK);
+    EXPECT_FALSE(info.hasAlpha);
+}
+
+TEST(ProbeTest, ShortOrMissingFtyp) {
+    ImageProbe info;
+    EXPECT_EQ(probeCopy(stillFile(), 0, &info), Status::NEED_MORE_DATA);
+    EXPECT_EQ(probeCopy(stillFile(), 7, &info), Status::NEED_MORE_DATA);
+    EXPECT_EQ(probeAll(concat({mdat(64), stillFile()}), &info), Status::NOT_AVIF);
+}
+
+} // namespace
@@ -0,0 +1,258 @@
+#include "avif_resample.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace avifkit;
+using resample::Filter;
+
+namespace {
+
+struct Size {
+    uint32_t width;
+    uint32_t height;
+};
+
+uint32_t lcg(uint32_t* state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 24;
+}
+
+std::vector<uint8_t> scaled8(const std::vector<uint8_t>& src, Size from, Size to, uint32_t channels, Filter filter) {
+    std::vector<uint8_t> dst(static_cast<size_t>(to.width) * to.height * channels);
+    resample::scale8(src.data(), from.width * channels, from.width, from.height, dst.data(), to.width * channels,
+                     to.width, to.height, channels, filter);
+    return dst;
+}
+
+/**
+ * Separable Lanczos3 in double precision, never clamped before the end
+ */
+std::vector<double> lanczosWeights(uint32_t inSize, uint32_t outSize, uint32_t o, uint32_t* first) {
+    const double kPi = 3.14159265358979323846;
+    auto sinc = [&](double x) { return x == 0.0 ? 1.0 : std::sin(x * kPi) / (x * kPi); };
+    const double scale = static_cast<double>(inSize) / outSize;
+    const double filterScale = std::max(scale, 1.0);
+    const double center = (o + 0.5) * scale;
+    const int64_t begin = std::max<int64_t>(0, static_cast<int64_t>(std::floor(center - 3.0 * filterScale)));
+    const int64_t end = std::min<int64_t>(inSize, static_cast<int64_t>(std::ceil(center + 3.0 * filterScale)));
+    std::vector<double> weights;
+    double total = 0.0;
+    for (int64_t i = begin; i < end; i++) {
+        double x = (i + 0.5 - center) / filterScale;
+        double w = (x <= -3.0 || x >= 3.0) ? 0.0 : sinc(x) * sinc(x / 3.0);
+        weights.push_back(w);
+        total += w;
+    }
+    for (double& w : weights) w /= total;
+    *first = static_cast<uint32_t>(begin);
+    return weights;
+}
+
+std::vector<uint8_t> referenceLanczos(const std::vector<uint8_t>& src, Size from, Size to) {
+    std::vector<double> rows(static_cast<size_t>(to.height) * from.width);
+    for (uint32_t y = 0; y < to.height; y++) {
+        uint32_t first;
+        std::vector<double> weights = lanczosWeights(from.height, to.height, y, &first);
+        for (uint32_t x = 0; x < from.width; x++) {
+            double sum = 0.0;
+            for (size_t t = 0; t < weights.size(); t++) sum += weights[t] * src[(first + t) * from.width + x];
+            rows[static_cast<size_t>(y) * from.width + x] = sum;
+        }
+    }
+    std::vector<uint8_t> dst(static_cast<size_t>(to.width) * to.height);
+    for (uint32_t x = 0; x < to.width; x++) {
+        uint32_t first;
+        std::vector<double> weights = lanczosWeights(from.width, to.width, x, &first);
+        for (uint32_t y = 0; y < to.height; y++) {
+            double sum = 0.0;
+            for (size_t t = 0; t < weights.size(); t++) sum += weights[t] * rows[y * from.width + first + t];
+            dst[static_cast<size_t>(y) * to.width + x] = static_cast<uint8_t>(std::min(255.0, std::max(0.0, std::round(sum))));
+        }
+    }
+    return dst;
+}
+
+TEST(ResampleTest, ScaledSizeFitsBoxAndKeepsAspectRatio) {
+    uint32_t width, height;
+    resample::scaledSize(4000, 3000, 1000, 1000, 0, &width, &height);
+    EXPECT_EQ(width, 1000u);
+    EXPECT_EQ(height, 750u);
+
+    resample::scaledSize(3000, 4000, 1000, 0, 0, &width, &height);
+    EXPECT_EQ(width, 1000u);
+    EXPECT_EQ(height, 1333u);
+
+    resample::scaledSize(3000, 4000, 0, 1000, 0, &width, &height);
+    EXPECT_EQ(width, 750u);
+    EXPECT_EQ(height, 1000u);
+}
+
+TEST(ResampleTest, ScaledSizeNeverUpscalesOrCollapses) {
+    uint32_t width, height;
+    resample::scaledSize(640, 480, 4096, 4096, 0, &width, &height);
+    EXPECT_EQ(width, 640u);
+    EXPECT_EQ(height, 480u);
+
+    resample::scaledSize(640, 480, 0, 0, 0, &width, &height);
+    EXPECT_EQ(width, 640u);
+    EXPECT_EQ(height, 480u);
+
+    resample::scaledSize(10000, 3, 100, 100, 0, &width, &height);
+    EXPECT_EQ(width, 100u);
+    EXPECT_EQ(height, 1u);
+}
+
+TEST(ResampleTest, ScaledSizeSampleSizeRoundsUp) {
+    uint32_t width, height;
+    resample::scaledSize(1001, 999, 0, 0, 4, &width, &height);
+    EXPECT_EQ(width, 251u);
+    EXPECT_EQ(height, 250u);
+
+    // A target box takes precedence over the sample size
+    resample::scaledSize(1000, 1000, 500, 0, 8, &width, &height);
+    EXPECT_EQ(width, 500u);
+    EXPECT_EQ(height, 500u);
+}
+
+TEST(ResampleTest, AutoPicksAreaForLargeReductions) {
+    EXPECT_EQ(resample::resolveFilter(Filter::AUTO, 1000, 1000, 500, 500), Filter::AREA);
+    EXPECT_EQ(resample::resolveFilter(Filter::AUTO, 1000, 1000, 800, 400), Filter::AREA);
+    EXPECT_EQ(resample::resolveFilter(Filter::AUTO, 1000, 1000, 501, 501), Filter::LANCZOS3);
+    EXPECT_EQ(resample::resolveFilter(Filter::LANCZOS3, 1000, 1000, 10, 10), Filter::LANCZOS3);
+}
+
+TEST(ResampleTest, ConstantColorStaysConstant) {
+    const uint8_t color[4] = {0, 37, 200, 255};
+    const Size sources[] = {{97, 61}, {64, 64}, {5, 301}};
+    const Size targets[] = {{48, 30}, {13, 7}, {1, 1}, {90, 60}, {3, 150}};
+    for (Filter filter : {Filter::AREA, Filter::LANCZOS3}) {
+        for (uint32_t channels : {1u, 3u, 4u}) {
+            for (const Size& from : sources) {
+                std::vector<uint8_t> src(static_cast<size_t>(from.width) * from.height * channels);
+                for (size_t i = 0; i < src.size(); i++) src[i] = color[i % channels];
+                for (const Size& to : targets) {
+                    if (to.width > from.width || to.height > from.height) continue;
+                    SCOPED_TRACE(testing::Message() << "filter=" << static_cast<int>(filter) << " channels="
+                                                    << channels << " " << from.width << "x" << from.height
+                                                    << " -> " << to.width << "x" << to.height);
+                    std::vector<uint8_t> dst = scaled8(src, from, to, channels, filter);
+                    for (size_t i = 0; i < dst.size(); i++) {
+                        ASSERT_EQ(dst[i], color[i % channels]) << "sample " << i;
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(ResampleTest, ConstantColorStaysConstant16) {
+    const Size from = {77, 41};
+    const Size to = {30, 40};
+    for (uint32_t maxValue : {1023u, 4095u, 65535u}) {
+        for (Filter filter : {Filter::AREA, Filter::LANCZOS3}) {
+            std::vector<uint16_t> src(static_cast<size_t>(from.width) * from.height, static_cast<uint16_t>(maxValue));
+            std::vector<uint16_t> dst(static_cast<size_t>(to.width) * to.height);
+            resample::scale16(src.data(), from.width * 2, from.width, from.height, dst.data(), to.width * 2,
+                              to.width, to.height, 1, maxValue, filter);
+            for (uint16_t value : dst) ASSERT_EQ(value, maxValue);
+        }
+    }
+}
+
+TEST(ResampleTest, SameSizeCopiesRows) {
+    const Size size = {13, 5};
+    std::vector<uint8_t> src(static_cast<size_t>(size.width + 3) * size.height * 4);
+    uint32_t state = 7;
+    for (uint8_t& value : src) value = static_cast<uint8_t>(lcg(&state));
+    std::vector<uint8_t> dst(static_cast<size_t>(size.width) * size.height * 4);
+    resample::scale8(src.data(), (size.width + 3) * 4, size.width, size.height, dst.data(), size.width * 4,
+                     size.width, size.height, 4, Filter::LANCZOS3);
+    for (uint32_t y = 0; y < size.height; y++) {
+        EXPECT_TRUE(std::equal(dst.begin() + y * size.width * 4, dst.begin() + (y + 1) * size.width * 4,
+                               src.begin() + y * (size.width + 3) * 4));
+    }
+}
+
+TEST(ResampleTest, AreaAveragesExactBlocks) {
+    // 2x2 blocks of 0/100/200/255 average to 139 (555 / 4 = 138.75)
+    const Size from = {6, 4};
+    const uint8_t block[4] = {0, 100, 200, 255};
+    std::vector<uint8_t> src(static_cast<size_t>(from.width) * from.height);
+    for (uint32_t y = 0; y < from.height; y++) {
+        for (uint32_t x = 0; x < from.width; x++) src[y * from.width + x] = block[(y % 2) * 2 + x % 2];
+    }
+    for (uint8_t value : scaled8(src, from, {3, 2}, 1, Filter::AREA)) EXPECT_EQ(value, 139);
+}
+
+TEST(ResampleTest, EdgesKeepTheirValues) {
+    // Left half black, right half white: the outermost columns and rows must stay
+    // exactly black / white (taps are clipped to the image, not wrapped or zero padded)
+    const Size from = {64, 40};
+    std::vector<uint8_t> src(static_cast<size_t>(from.width) * from.height);
+    for (uint32_t y = 0; y < from.height; y++) {
+        for (uint32_t x = 0; x < from.width; x++) src[y * from.width + x] = x < from.width / 2 ? 0 : 255;
+    }
+    for (Filter filter : {Filter::AREA, Filter::LANCZOS3}) {
+        for (const Size& to : {Size{40, 25}, Size{21, 13}, Size{8, 5}}) {
+            SCOPED_TRACE(testing::Message() << "filter=" << static_cast<int>(filter) << " " << to.width << "x"
+                                            << to.height);
+            std::vector<uint8_t> dst = scaled8(src, from, to, 1, filter);
+            for (uint32_t y = 0; y < to.height; y++) {
+                EXPECT_EQ(dst[y * to.width], 0);
+                EXPECT_EQ(dst[y * to.width + to.width - 1], 255);
+            }
+            // Rows are identical: vertical filtering of a constant column changes nothing
+            for (uint32_t y = 1; y < to.height; y++) {
+                EXPECT_TRUE(std::equal(dst.begin(), dst.begin() + to.width, dst.begin() + y * to.width));
+            }
+        }
+    }
+}
+
+TEST(ResampleTest, LanczosClampsOnceAtTheEnd) {
+    // High-contrast detail makes both passes overshoot; the fixed-point result must
+    // track an unclamped double-precision reference to within rounding
+    const Size from = {41, 37};
+    std::vector<uint8_t> src(static_cast<size_t>(from.width) * from.height);
+    uint32_t state = 99;
+    for (uint32_t y = 0; y < from.height; y++) {
+        for (uint32_t x = 0; x < from.width; x++) {
+            bool on = ((x / 2) + (y / 3)) % 2 == 0 || lcg(&state) < 16;
+            src[y * from.width + x] = on ? 255 : 0;
+        }
+    }
+    for (const Size& to : {Size{30, 29}, Size{37, 20}, Size{25, 33}}) {
+        SCOPED_TRACE(testing::Message() << to.width << "x" << to.height);
+        std::vector<uint8_t> expected = referenceLanczos(src, from, to);
+        std::vector<uint8_t> actual = scaled8(src, from, to, 1, Filter::LANCZOS3);
+        for (size_t i = 0; i < actual.size(); i++) {
+            ASSERT_LE(std::abs(actual[i] - expected[i]), 1) << "sample " << i;
+        }
+    }
+}
+
+TEST(ResampleTest, RowSinkMatchesImageOutput) {
+    const Size from = {50, 31};
+    const Size to = {33, 20};
+    std::vector<uint8_t> src(static_cast<size_t>(from.width) * from.height * 4);
+    uint32_t state = 3;
+    for (uint8_t& value : src) value = static_cast<uint8_t>(lcg(&state));
+
+    std::vector<uint8_t> expected = scaled8(src, from, to, 4, Filter::LANCZOS3);
+    std::vector<uint8_t> actual(expected.size());
+    uint32_t nextRow = 0;
+    resample::scale8Rows(src.data(), from.width * 4, from.width, from.height, to.width, to.height, 4,
+                         Filter::LANCZOS3, [&](uint32_t y, const uint8_t* row) {
+        EXPECT_EQ(y, nextRow++);
+        std::copy(row, row + to.width * 4, actual.begin() + y * to.width * 4);
+    });
+    EXPECT_EQ(nextRow, to.height);
+    EXPECT_EQ(expected, actual);
+}
+
+} // namespace
@@ -0,0 +1,28 @@
+#ifndef AVIFKIT_TESTS_HOST_ANDROID_LOG_H
+#define AVIFKIT_TESTS_HOST_ANDROID_LOG_H
+
+#include <cstdarg>
+#include <cstdio>
+
+/**
+ * Host stand-in for the NDK's <android/log.h>: messages go to stderr
+ */
+enum android_LogPriority {
+    ANDROID_LOG_DEBUG = 3,
+    ANDROID_LOG_INFO = 4,
+    ANDROID_LOG_WARN = 5,
+    ANDROID_LOG_ERROR = 6
+};
+
+inline int __android_log_print(int priority, const char* tag, const char* format, ...) {
+    static const char kLevels[] = "??VDIWEF";
+    std::fprintf(stderr, "%c/%s: ", priority >= 0 && priority < 8 ? kLevels[priority] : '?', tag);
+    va_list args;
+    va_start(args, format);
+    int written = std::vfprintf(stderr, format, args);
+    va_end(args);
+    std::fputc('\n', stderr);
+    return written;
+}
+
+#endif // AVIFKIT_TESTS_HOST_ANDROID_LOG_H
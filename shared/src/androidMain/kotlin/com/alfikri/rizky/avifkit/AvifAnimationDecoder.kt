@@ -0,0 +1,194 @@
+package com.alfikri.rizky.avifkit
+
+import android.graphics.Bitmap
+import android.os.ParcelFileDescriptor
+import android.util.Log
+import java.io.Closeable
+
+/**
+ * A decoded frame of an AVIF image sequence
+ *
+ * @param index Frame index (0-based)
+ * @param bitmap Bitmap holding the frame; the same bitmap is reused for later frames
+ * @param durationMillis Presentation duration of the frame
+ * @param isKeyframe Whether the frame decodes without earlier frames
+ */
+data class AvifFrame(
+    val index: Int,
+    val bitmap: Bitmap,
+    val durationMillis: Long,
+    val isKeyframe: Boolean
+)
+
+/**
+ * Incremental decoder for animated AVIF (avis) image sequences
+ *
+ * The container is parsed once and frames are decoded lazily, one at a time, into a
+ * single reused Bitmap, so memory stays constant regardless of the frame count.
+ * Sequential access ([nextFrame]) is cheapest; [decodeFrame] can seek, restarting
+ * from the nearest keyframe. Still images open as a single-frame sequence.
+ * Calls are serialized; always [close] the decoder when done.
+ *
+ * @throws AvifError.DecodingFailed if the data cannot be parsed or libavif is not available
+ */
+class AvifAnimationDecoder private constructor() : Closeable {
+
+    private external fun nativeOpen(avifData: ByteArray): Long
+
+    private external fun nativeOpenFd(fd: Int): Long
+
+    private external fun nativeGetInfo(handle: Long, outInfo: IntArray): Boolean
+
+    private external fun nativeFrameDurationMs(handle: Long, index: Int): Long
+
+    private external fun nativeIsKeyframe(handle: Long, index: Int): Boolean
+
+    private external fun nativeDecodeFrame(handle: Long, index: Int, bitmap: Bitmap): Boolean
+
+    private external fun nativeClose(handle: Long)
+
+    private var handle: Long = 0
+    private var target: Bitmap? = null
+    private var nextIndex = 0
+
+    /** Displayed width in pixels (irot/imir applied, like the frame bitmaps) */
+    var width: Int = 0
+        private set
+
+    /** Displayed height in pixels */
+    var height: Int = 0
+        private set
+
+    /** Number of frames (1 for still images) */
+    var frameCount: Int = 0
+        private set
+
+    /** Whether frames carry alpha */
+    var hasAlpha: Boolean = false
+        private set
+
+    /** Loop count from the container: -1 = infinite, -2 = unknown */
+    var repetitionCount: Int = 0
+        private set
+
+    /**
+     * Open a sequence held in memory (copied once into native memory)
+     */
+    constructor(avifData: ByteArray) : this() {
+        open { nativeOpen(avifData) }
+    }
+
+    /**
+     * Open a sequence from a file descriptor; frames are read from the file on demand
+     * The descriptor is duplicated, so the caller may close theirs afterwards.
+     */
+    constructor(descriptor: ParcelFileDescriptor) : this() {
+        open { nativeOpenFd(descriptor.fd) }
+    }
+
+    private inline fun open(openNative: () -> Long) {
+        // Touching AvifConverter loads the native library
+        if (!AvifConverter.isNativeLibraryLoaded()) {
+            throw AvifError.DecodingFailed("Native library not loaded")
+        }
+        handle = openNative()
+        if (handle == 0L) {
+            throw AvifError.DecodingFailed("Failed to open AVIF sequence")
+        }
+        val info = IntArray(6)
+        nativeGetInfo(handle, info)
+        width = info[0]
+        height = info[1]
+        frameCount = info[2]
+        hasAlpha = info[3] != 0
+        repetitionCount = info[4]
+    }
+
+    /**
+     * Presentation duration of a frame, read from the container without decoding
+     */
+    @Synchronized
+    fun frameDurationMillis(index: Int): Long {
+        val currentHandle = checkOpen()
+        checkIndex(index)
+        return nativeFrameDurationMs(currentHandle, index)
+    }
+
+    /**
+     * Whether a frame decodes without earlier frames (cheap seek target)
+     */
+    @Synchronized
+    fun isKeyframe(index: Int): Boolean {
+        val currentHandle = checkOpen()
+        checkIndex(index)
+        return nativeIsKeyframe(currentHandle, index)
+    }
+
+    /**
+     * Decode the frame after the last decoded one, or null after the last frame
+     */
+    @Synchronized
+    fun nextFrame(): AvifFrame? {
+        if (nextIndex >= frameCount) return null
+        return decodeFrame(nextIndex)
+    }
+
+    /**
+     * Decode a specific frame
+     *
+     * The returned bitmap is shared by all frames of this decoder and is overwritten
+     * by the next decode; copy it if it must outlive that.
+     */
+    @Synchronized
+    fun decodeFrame(index: Int): AvifFrame {
+        val currentHandle = checkOpen()
+        checkIndex(index)
+        val bitmap = target ?: try {
+            Bitmap.createBitmap(width, height, Bitmap.Config.ARGB_8888).also { target = it }
+        } catch (e: OutOfMemoryError) {
+            Log.e(TAG, "OutOfMemoryError allocating frame bitmap", e)
+            throw AvifError.OutOfMemory
+        }
+
+        if (!nativeDecodeFrame(currentHandle, index, bitmap)) {
+            throw AvifError.DecodingFailed("Failed to decode frame $index")
+        }
+        nextIndex = index + 1
+        return AvifFrame(
+            index = index,
+            bitmap = bitmap,
+            durationMillis = nativeFrameDurationMs(currentHandle, index),
+            isKeyframe = nativeIsKeyframe(currentHandle, index)
+        )
+    }
+
+    /**
+     * Restart [nextFrame] from the first frame
+     */
+    @Synchronized
+    fun rewind() {
+        nextIndex = 0
+    }
+
+    @Synchronized
+    override fun close() {
+        if (handle != 0L) {
+            nativeClose(handle)
+            handle = 0
+        }
+        target = null
+    }
+
+    private fun checkOpen(): Long {
+        if (handle == 0L) throw AvifError.Unknown("AVIF animation decoder is closed")
+        return handle
+    }
+
+    private fun checkIndex(index: Int) {
+        if (index !in 0 until frameCount) throw AvifError.InvalidInput
+    }
+
+    private companion object {
+        const val TAG = "AvifAnimationDecoder"
+    }
+}
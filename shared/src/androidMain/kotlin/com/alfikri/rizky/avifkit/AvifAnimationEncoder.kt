@@ -0,0 +1,213 @@
+package com.alfikri.rizky.avifkit
+
+import android.graphics.Bitmap
+import android.util.Log
+import java.io.Closeable
+import java.io.File
+import java.nio.ByteBuffer
+
+/**
+ * Incremental encoder for animated AVIF (avis) image sequences
+ *
+ * Frames are appended one at a time and compressed immediately, so only the
+ * current frame is resident; callers can stream frames from a video or GIF
+ * decoder without holding the whole clip. All frames must have the same size.
+ * The first frame decides whether the sequence has alpha: if it is fully opaque,
+ * the alpha of later frames is dropped. Finish with [finish] (or [finishToFile]) and always [close] the encoder.
+ *
+ * Only quality, speed, subsample and maxDimension of [options] apply.
+ *
+ * @param options Encoding options shared by all frames
+ * @param timescale Ticks per second for frame durations (default 1000 = milliseconds)
+ * @param keyframeInterval Maximum frames between keyframes (0 = codec default)
+ * @param repetitionCount Loop count stored in the file (-1 = loop forever)
+ * @throws AvifError.EncodingFailed if the native library or libavif is not available
+ */
+class AvifAnimationEncoder(
+    options: EncodingOptions = EncodingOptions(),
+    val timescale: Long = 1000,
+    keyframeInterval: Int = 0,
+    repetitionCount: Int = -1
+) : Closeable {
+
+    private external fun nativeCreate(
+        quality: Int,
+        speed: Int,
+        subsample: Int,
+        maxDimension: Int,
+        timescale: Long,
+        keyframeInterval: Int,
+        repetitionCount: Int
+    ): Long
+
+    private external fun nativeAddBitmap(
+        handle: Long,
+        bitmap: Bitmap,
+        duration: Long,
+        forceKeyframe: Boolean
+    ): Boolean
+
+    private external fun nativeAddBuffer(
+        handle: Long,
+        buffer: ByteBuffer,
+        width: Int,
+        height: Int,
+        rowBytes: Int,
+        channelOrder: Int,
+        alphaPremultiplied: Boolean,
+        duration: Long,
+        forceKeyframe: Boolean
+    ): Boolean
+
+    private external fun nativeFinish(handle: Long): ByteArray?
+
+    private external fun nativeFinishToPath(handle: Long, path: String, sync: Boolean): Long
+
+    private external fun nativeClose(handle: Long)
+
+    private var handle: Long = 0
+
+    /** Number of frames appended so far */
+    var frameCount: Int = 0
+        private set
+
+    init {
+        require(timescale > 0) { "Timescale must be positive" }
+        require(keyframeInterval >= 0) { "Keyframe interval must not be negative" }
+        // Touching AvifConverter loads the native library
+        if (!AvifConverter.isNativeLibraryLoaded()) {
+            throw AvifError.EncodingFailed("Native library not loaded")
+        }
+        handle = nativeCreate(
+            options.quality,
+            options.speed,
+            options.subsample.toNativeValue(),
+            options.maxDimension ?: 0,
+            timescale,
+            keyframeInterval,
+            repetitionCount
+        )
+        if (handle == 0L) {
+            throw AvifError.EncodingFailed("Failed to create AVIF sequence encoder (libavif not available)")
+        }
+    }
+
+    /**
+     * Append a frame from a Bitmap
+     *
+     * ARGB_8888 bitmaps are read in place; other configs are copied once.
+     *
+     * @param duration Display duration in [timescale] ticks
+     * @param forceKeyframe Start a new keyframe at this frame (e.g. a scene cut)
+     */
+    @Synchronized
+    fun addFrame(bitmap: Bitmap, duration: Long, forceKeyframe: Boolean = false) {
+        val currentHandle = checkOpen()
+        val directBitmap = if (bitmap.config == Bitmap.Config.ARGB_8888) {
+            bitmap
+        } else {
+            bitmap.copy(Bitmap.Config.ARGB_8888, false)
+        }
+        try {
+            if (!nativeAddBitmap(currentHandle, directBitmap, duration, forceKeyframe)) {
+                throw AvifError.EncodingFailed("Failed to add frame $frameCount")
+            }
+            frameCount++
+        } catch (e: OutOfMemoryError) {
+            Log.e(TAG, "OutOfMemoryError adding frame", e)
+            throw AvifError.OutOfMemory
+        } finally {
+            if (directBitmap !== bitmap) {
+                directBitmap.recycle()
+            }
+        }
+    }
+
+    /**
+     * Append a frame from a direct ByteBuffer holding 8-bit pixels
+     *
+     * @param duration Display duration in [timescale] ticks
+     * @param forceKeyframe Start a new keyframe at this frame
+     */
+    @Synchronized
+    fun addFrame(
+        buffer: ByteBuffer,
+        width: Int,
+        height: Int,
+        rowBytes: Int,
+        duration: Long,
+        channelOrder: ChannelOrder = ChannelOrder.RGBA,
+        alphaPremultiplied: Boolean = false,
+        forceKeyframe: Boolean = false
+    ) {
+        val currentHandle = checkOpen()
+        if (!buffer.isDirect) {
+            throw AvifError.InvalidInput
+        }
+        val added = nativeAddBuffer(
+            currentHandle,
+            buffer,
+            width,
+            height,
+            rowBytes,
+            channelOrder.toNativeValue(),
+            alphaPremultiplied,
+            duration,
+            forceKeyframe
+        )
+        if (!added) {
+            throw AvifError.EncodingFailed("Failed to add frame $frameCount")
+        }
+        frameCount++
+    }
+
+    /**
+     * Finish the sequence and return the encoded file
+     * No frames can be added afterwards.
+     */
+    @Synchronized
+    fun finish(): ByteArray {
+        val currentHandle = checkOpen()
+        try {
+            return nativeFinish(currentHandle)
+                ?: throw AvifError.EncodingFailed("Failed to finish AVIF sequence")
+        } catch (e: OutOfMemoryError) {
+            Log.e(TAG, "OutOfMemoryError finishing sequence", e)
+            throw AvifError.OutOfMemory
+        }
+    }
+
+    /**
+     * Finish the sequence and write it straight to a file (atomically replaced)
+     * The bitstream never becomes a Java byte array.
+     *
+     * @return Number of bytes written
+     */
+    @Synchronized
+    fun finishToFile(outputPath: String, sync: Boolean = false): Long {
+        val currentHandle = checkOpen()
+        File(outputPath).parentFile?.mkdirs()
+        val written = nativeFinishToPath(currentHandle, outputPath, sync)
+        if (written < 0) {
+            throw AvifError.EncodingFailed("Failed to write AVIF sequence to $outputPath")
+        }
+        return written
+    }
+
+    @Synchronized
+    override fun close() {
+        if (handle != 0L) {
+            nativeClose(handle)
+            handle = 0
+        }
+    }
+
+    private fun checkOpen(): Long {
+        if (handle == 0L) throw AvifError.Unknown("AVIF animation encoder is closed")
+        return handle
+    }
+
+    private companion object {
+        const val TAG = "AvifAnimationEncoder"
+    }
+}
@@ -2,17 +2,125 @@ package com.alfikri.rizky.avifkit
 
 import android.graphics.Bitmap
 import android.graphics.BitmapFactory
+import android.graphics.BitmapRegionDecoder
+import android.graphics.ColorSpace
 import android.graphics.Matrix
+import android.graphics.Rect
+import android.media.Image
 import android.os.Build
+import android.os.ParcelFileDescriptor
 import android.util.Log
+import androidx.annotation.RequiresApi
 import androidx.exifinterface.media.ExifInterface
 import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.ensureActive
+import kotlinx.coroutines.isActive
+import kotlinx.coroutines.joinAll
+import kotlinx.coroutines.launch
 import kotlinx.coroutines.withContext
 import java.io.File
 import java.io.ByteArrayInputStream
+import java.io.DataInputStream
+import java.io.IOException
+import java.io.InputStream
+import java.io.RandomAccessFile
+import java.nio.ByteBuffer
+import java.util.concurrent.atomic.AtomicInteger
+import kotlin.coroutines.cancellation.CancellationException
 // Import FileKit extension functions
 import io.github.vinceglb.filekit.*
 
+/**
+ * One plane of a YUV frame, laid out like android.media.Image.Plane
+ *
+ * Passed to [AvifConverter.encodeYuv] (8-bit samples) and returned by [AvifYuvImage].
+ *
+ * @param buffer Direct ByteBuffer holding the plane, starting at its first sample
+ * @param rowStride Distance between rows in bytes
+ * @param pixelStride Distance between neighbouring samples in bytes (2 for interleaved chroma or 16-bit samples)
+ */
+data class YuvPlane(
+    val buffer: ByteBuffer,
+    val rowStride: Int,
+    val pixelStride: Int = 1
+)
+
+/**
+ * Byte order of 8-bit pixels in a raw buffer passed to the encoder
+ */
+enum class ChannelOrder {
+    RGBA, BGRA, ARGB, ABGR, RGB, BGR
+}
+
+/**
+ * Resampling filter used when images are downscaled natively
+ *
+ * AUTO uses AREA for reductions of 2x or more and LANCZOS3 otherwise.
+ * AREA averages exact pixel areas (fast, alias-free for thumbnails).
+ * LANCZOS3 is sharper and suited to small reductions.
+ */
+enum class ResizeFilter {
+    AUTO, AREA, LANCZOS3
+}
+
+/**
+ * Outcome of one item of a batch conversion
+ *
+ * @param index Position of the item in the input list
+ * @param outputPath File the item was (or would have been) written to
+ * @param bytesWritten Size of the written file, or -1 if the item failed
+ * @param error Why the item failed, or null on success
+ */
+data class BatchItemResult(
+    val index: Int,
+    val outputPath: String,
+    val bytesWritten: Long,
+    val error: AvifError? = null
+) {
+    val isSuccess: Boolean get() = error == null
+}
+
+/**
+ * Pixel format of high-bit-depth decode output
+ *
+ * RGBA_1010102 packs 10-bit color and a 2-bit alpha into 4 bytes per pixel, the
+ * same memory as 8-bit RGBA. RGBA_F16 stores half floats in 8 bytes per pixel and
+ * keeps alpha at full precision.
+ */
+enum class HighBitDepthFormat {
+    RGBA_1010102, RGBA_F16
+}
+
+/**
+ * Sample type of 16-bit-per-channel RGBA buffers passed to the high-bit-depth encoder
+ *
+ * UINT16 spans 0..65535; HALF_FLOAT spans 0.0..1.0 (values outside are clamped).
+ */
+enum class HighBitDepthSample {
+    UINT16, HALF_FLOAT
+}
+
+/**
+ * Memory layout of a packed 8-bit 4:2:0 camera frame
+ *
+ * I420 stores the Y, U and V planes one after another. NV12 and NV21 follow Y with
+ * a single interleaved chroma plane, in UV and VU order respectively (NV21 is the
+ * Camera1 and YuvImage default).
+ */
+enum class YuvLayout {
+    I420, NV12, NV21
+}
+
+/**
+ * Matrix used to derive YUV from RGB in a source frame
+ *
+ * Android camera output is BT601; BT709 and BT2020 are used by video pipelines.
+ */
+enum class YuvMatrix {
+    BT601, BT709, BT2020
+}
+
 actual class AvifConverter {
 
     // Native methods - implemented in C++ via JNI
@@ -22,22 +130,304 @@ actual class AvifConverter {
         width: Int,
         height: Int,
         quality: Int,
+        alphaQuality: Int,
+        speed: Int,
+        subsample: Int,
+        lossless: Boolean,
+        maxDimension: Int,
+        orientation: Int,
+        exif: ByteArray?,
+        icc: ByteArray?
+    ): ByteArray?
+
+    private external fun nativeEncodeBitmap(
+        bitmap: Bitmap,
+        quality: Int,
+        alphaQuality: Int,
+        speed: Int,
+        subsample: Int,
+        lossless: Boolean,
+        maxDimension: Int,
+        orientation: Int,
+        exif: ByteArray?,
+        icc: ByteArray?
+    ): ByteArray?
+
+    private external fun nativeEncodeBitmapToFd(
+        bitmap: Bitmap,
+        quality: Int,
+        alphaQuality: Int,
+        speed: Int,
+        subsample: Int,
+        lossless: Boolean,
+        maxDimension: Int,
+        orientation: Int,
+        exif: ByteArray?,
+        icc: ByteArray?,
+        fd: Int,
+        sync: Boolean
+    ): Long
+
+    private external fun nativeEncodeBitmapToPath(
+        bitmap: Bitmap,
+        quality: Int,
+        alphaQuality: Int,
+        speed: Int,
+        subsample: Int,
+        lossless: Boolean,
+        maxDimension: Int,
+        orientation: Int,
+        exif: ByteArray?,
+        icc: ByteArray?,
+        path: String,
+        sync: Boolean,
+        atomic: Boolean
+    ): Long
+
+    private external fun nativeEncodeBuffer(
+        buffer: ByteBuffer,
+        width: Int,
+        height: Int,
+        rowBytes: Int,
+        channelOrder: Int,
+        alphaPremultiplied: Boolean,
+        quality: Int,
+        alphaQuality: Int,
+        speed: Int,
+        subsample: Int,
+        lossless: Boolean
+    ): ByteArray?
+
+    private external fun nativeEncodeHighDepthBuffer(
+        buffer: ByteBuffer,
+        width: Int,
+        height: Int,
+        rowBytes: Int,
+        halfFloat: Boolean,
+        alphaPremultiplied: Boolean,
+        depth: Int,
+        colorPrimaries: Int,
+        transfer: Int,
+        quality: Int,
+        speed: Int,
+        subsample: Int
+    ): ByteArray?
+
+    private external fun nativeEncodeHighDepthBitmap(
+        bitmap: Bitmap,
+        depth: Int,
+        colorPrimaries: Int,
+        transfer: Int,
+        quality: Int,
         speed: Int,
         subsample: Int
     ): ByteArray?
 
+    private external fun nativeEncodeYuvPlanes(
+        yBuffer: ByteBuffer,
+        uBuffer: ByteBuffer,
+        vBuffer: ByteBuffer,
+        width: Int,
+        height: Int,
+        yRowStride: Int,
+        uvRowStride: Int,
+        uvPixelStride: Int,
+        fullRange: Boolean,
+        matrix: Int,
+        orientation: Int,
+        quality: Int,
+        speed: Int,
+        maxDimension: Int
+    ): ByteArray?
+
+    private external fun nativeEncodeYuvArray(
+        yuvData: ByteArray,
+        width: Int,
+        height: Int,
+        layout: Int,
+        fullRange: Boolean,
+        matrix: Int,
+        orientation: Int,
+        quality: Int,
+        speed: Int,
+        maxDimension: Int
+    ): ByteArray?
+
+    private external fun nativeEncodeToTargetSize(
+        bitmap: Bitmap,
+        maxDimension: Int,
+        quality: Int,
+        alphaQuality: Int,
+        speed: Int,
+        subsample: Int,
+        lossless: Boolean,
+        orientation: Int,
+        exif: ByteArray?,
+        icc: ByteArray?,
+        targetSize: Long,
+        strategy: Int
+    ): TargetSizeEncodeResult?
+
+    private external fun nativeEncodeToTargetQuality(
+        bitmap: Bitmap,
+        maxDimension: Int,
+        speed: Int,
+        subsample: Int,
+        orientation: Int,
+        exif: ByteArray?,
+        icc: ByteArray?,
+        targetScore: Float
+    ): TargetQualityEncodeResult?
+
+    private external fun nativeBatchCreate(
+        quality: Int,
+        alphaQuality: Int,
+        speed: Int,
+        subsample: Int,
+        lossless: Boolean,
+        maxDimension: Int,
+        workers: Int,
+        queueCapacity: Int
+    ): Long
+
+    private external fun nativeBatchSubmit(
+        handle: Long,
+        index: Int,
+        bitmap: Bitmap,
+        orientation: Int,
+        exif: ByteArray?,
+        icc: ByteArray?,
+        outputPath: String
+    ): Boolean
+
+    private external fun nativeBatchCloseInput(handle: Long)
+
+    private external fun nativeBatchPoll(
+        handle: Long,
+        timeoutMs: Int,
+        outResult: LongArray
+    ): Int
+
+    private external fun nativeBatchDestroy(handle: Long)
+
+    private external fun nativeGridCreate(
+        width: Int,
+        height: Int,
+        cellSize: Int,
+        quality: Int,
+        alphaQuality: Int,
+        speed: Int,
+        subsample: Int,
+        lossless: Boolean
+    ): Long
+
+    private external fun nativeGridAddRows(
+        handle: Long,
+        bitmap: Bitmap,
+        sourceTop: Int,
+        top: Int,
+        rowCount: Int
+    ): Boolean
+
+    private external fun nativeGridFinishToPath(handle: Long, path: String, sync: Boolean): Long
+
+    private external fun nativeGridClose(handle: Long)
+
     private external fun nativeDecode(
         avifData: ByteArray
     ): DecodedImage?
 
+    private external fun nativeDecodeScaled(
+        avifData: ByteArray,
+        targetWidth: Int,
+        targetHeight: Int,
+        sampleSize: Int,
+        filter: Int
+    ): DecodedImage?
+
+    private external fun nativeDecodeFd(
+        fd: Int,
+        targetWidth: Int,
+        targetHeight: Int,
+        sampleSize: Int,
+        filter: Int
+    ): DecodedImage?
+
+    private external fun nativeDecodeRegion(
+        avifData: ByteArray,
+        x: Int,
+        y: Int,
+        width: Int,
+        height: Int,
+        sampleSize: Int,
+        filter: Int
+    ): DecodedImage?
+
+    private external fun nativeDecodeIntoBitmap(
+        avifData: ByteArray,
+        bitmap: Bitmap
+    ): Boolean
+
+    private external fun nativeDecodeHighDepthIntoBitmap(
+        avifData: ByteArray,
+        bitmap: Bitmap
+    ): Boolean
+
+    private external fun nativeDecodeIntoBuffer(
+        avifData: ByteArray,
+        buffer: ByteBuffer,
+        rowBytes: Int,
+        channelOrder: Int,
+        outInfo: IntArray
+    ): Boolean
+
     private external fun nativeIsAvif(
         data: ByteArray
     ): Boolean
 
+    private external fun nativeProbe(
+        data: ByteArray,
+        length: Int,
+        outInfo: IntArray
+    ): Int
+
     private external fun nativeGetVersion(): String
 
+    private external fun nativeSetThreadBudget(maxThreads: Int): Int
+
+    private external fun nativeGetThreadBudget(): Int
+
     companion object {
         private const val TAG = "AvifConverter"
+        private const val MAX_NATIVE_RESIZE_ROUNDS = 4
+
+        // Native probe: prefix read first, and the most a probe may ask to read
+        private const val PROBE_PREFIX_BYTES = 64 * 1024
+        private const val MAX_PROBE_BYTES = 16 * 1024 * 1024
+        private const val PROBE_OK = 0
+        private const val PROBE_NEED_MORE_DATA = 2
+        private const val PROBE_INFO_SIZE = 9
+        private const val FTYP_PREFIX_BYTES = 64
+        private const val FTYP = 0x66747970        // 'ftyp'
+        private const val BRAND_AVIF = 0x61766966  // 'avif'
+        private const val BRAND_AVIS = 0x61766973  // 'avis'
+        private const val BATCH_POLL_MS = 100
+        private const val DEFAULT_GRID_CELL_SIZE = 512
+        private const val BATCH_POLL_RESULT = 1
+        private const val BATCH_POLL_DONE = -1
+
+        // JPEG markers and the APP1/APP2 headers in front of the Exif block and ICC chunks
+        private const val JPEG_SOI = 0xD8
+        private const val JPEG_EOI = 0xD9
+        private const val JPEG_SOS = 0xDA
+        private const val JPEG_APP1 = 0xE1
+        private const val JPEG_APP2 = 0xE2
+        private val EXIF_HEADER = byteArrayOf(0x45, 0x78, 0x69, 0x66, 0, 0)  // "Exif\0\0"
+        private val ICC_HEADER = "ICC_PROFILE\u0000".toByteArray(Charsets.US_ASCII)
+
+        // libjpeg-turbo scales by 1/2, 1/4 and 1/8 during the IDCT
+        private const val MAX_JPEG_SCALE_DENOMINATOR = 8
+
         private var nativeLibraryLoaded = false
 
         init {
@@ -61,84 +451,961 @@ actual class AvifConverter {
     ): PlatformBitmap = withContext(Dispatchers.IO) {
         val encodingOptions = options ?: EncodingOptions.fromPriority(priority)
 
-        // Handle maxSize if specified
-        val avifData = if (encodingOptions.maxSize != null) {
+        // Handle maxSize / targetQuality if specified
+        val avifData = if (encodingOptions.needsSearch) {
             convertWithAdaptiveCompression(input, encodingOptions)
         } else {
             convertStandard(input, encodingOptions)
         }
 
-        // Decode AVIF to Bitmap
-        decodeAvifToBitmap(avifData)
+        // Decode AVIF to Bitmap
+        decodeAvifToBitmap(avifData)
+    }
+
+    actual suspend fun convertToFile(
+        input: ImageInput,
+        outputPath: String,
+        priority: Priority,
+        options: EncodingOptions?
+    ): String = withContext(Dispatchers.IO) {
+        val encodingOptions = options ?: EncodingOptions.fromPriority(priority)
+        val outputFile = File(outputPath).apply { parentFile?.mkdirs() }
+
+        // Handle maxSize / targetQuality if specified
+        val avifData = if (encodingOptions.needsSearch) {
+            convertWithAdaptiveCompression(input, encodingOptions)
+        } else {
+            when (val source = loadSource(input, encodingOptions.preserveMetadata, encodingOptions.maxDimension)) {
+                is SourceImage.Avif -> source.data
+                is SourceImage.Pixels -> {
+                    // The bitstream goes from native memory straight to disk (temp file + rename)
+                    val written = encodeBitmapNatively(source.bitmap) { bitmap ->
+                        nativeEncodeBitmapToPath(
+                            bitmap,
+                            encodingOptions.quality,
+                            encodingOptions.alphaQuality,
+                            encodingOptions.speed,
+                            encodingOptions.subsample.toNativeValue(),
+                            encodingOptions.lossless,
+                            encodingOptions.maxDimension ?: 0,
+                            source.orientation,
+                            source.exif,
+                            source.icc,
+                            outputFile.path,
+                            false,
+                            true
+                        )
+                    }
+                    if (written >= 0) return@withContext outputPath
+                    encodeBitmapToAvif(source.bitmap, encodingOptions, source.orientation, source.exif, source.icc)
+                }
+            }
+        }
+
+        // Save to file
+        outputFile.writeBytes(avifData)
+
+        outputPath
+    }
+
+    /**
+     * Convert to AVIF and write it to an open file descriptor
+     *
+     * Android-only. The encoded bitstream is written from native memory straight to the
+     * descriptor at its current position and never becomes a Java byte array (except for
+     * size-targeted encodes and AVIF inputs, which are already bytes). The descriptor
+     * stays open and owned by the caller.
+     *
+     * @param input Can be ByteArray, Bitmap, file path, or PlatformFile
+     * @param descriptor Writable descriptor, e.g. opened with MODE_WRITE_ONLY | MODE_TRUNCATE
+     * @param priority Quick preset for common scenarios (default: BALANCED)
+     * @param options Custom encoding options (overrides priority if provided)
+     * @param sync Whether to fsync the descriptor after writing
+     * @return Number of bytes written
+     */
+    suspend fun convertToFile(
+        input: ImageInput,
+        descriptor: ParcelFileDescriptor,
+        priority: Priority = Priority.BALANCED,
+        options: EncodingOptions? = null,
+        sync: Boolean = false
+    ): Long = withContext(Dispatchers.IO) {
+        val encodingOptions = options ?: EncodingOptions.fromPriority(priority)
+
+        val avifData = if (encodingOptions.needsSearch) {
+            convertWithAdaptiveCompression(input, encodingOptions)
+        } else {
+            when (val source = loadSource(input, encodingOptions.preserveMetadata, encodingOptions.maxDimension)) {
+                is SourceImage.Avif -> source.data
+                is SourceImage.Pixels -> {
+                    val written = encodeBitmapNatively(source.bitmap) { bitmap ->
+                        nativeEncodeBitmapToFd(
+                            bitmap,
+                            encodingOptions.quality,
+                            encodingOptions.alphaQuality,
+                            encodingOptions.speed,
+                            encodingOptions.subsample.toNativeValue(),
+                            encodingOptions.lossless,
+                            encodingOptions.maxDimension ?: 0,
+                            source.orientation,
+                            source.exif,
+                            source.icc,
+                            descriptor.fd,
+                            sync
+                        )
+                    }
+                    if (written >= 0) return@withContext written
+                    encodeBitmapToAvif(source.bitmap, encodingOptions, source.orientation, source.exif, source.icc)
+                }
+            }
+        }
+
+        // The stream does not own the descriptor, so it is left open
+        java.io.FileOutputStream(descriptor.fileDescriptor).write(avifData)
+        if (sync) {
+            descriptor.fileDescriptor.sync()
+        }
+        avifData.size.toLong()
+    }
+
+    /**
+     * Android-only. Convert many images to AVIF files in [outputDir]
+     *
+     * Items flow through a pipeline: [parallelism] workers read and decode sources and
+     * convert them to YUV, while native encoder threads encode and write earlier items.
+     * A bounded queue between the stages holds at most [parallelism] converted images,
+     * so memory stays flat however long the list is. A failing item is reported in its
+     * [BatchItemResult] and does not stop the batch.
+     *
+     * Outputs are named after the input file (`photo.jpg` -> `photo.avif`), or
+     * `image_<index>.avif` for in-memory inputs; existing files are replaced.
+     *
+     * @param inputs Images to convert
+     * @param outputDir Directory for the AVIF files (created if missing)
+     * @param options Encoding options applied to every item
+     * @param parallelism Number of decode workers and encoder threads
+     * @param onItemComplete Called once per item as it finishes, in completion order
+     * @return One result per input, in input order
+     */
+    suspend fun convertBatch(
+        inputs: List<ImageInput>,
+        outputDir: String,
+        options: EncodingOptions = EncodingOptions(),
+        parallelism: Int = Runtime.getRuntime().availableProcessors(),
+        onItemComplete: (BatchItemResult) -> Unit = {}
+    ): List<BatchItemResult> = withContext(Dispatchers.IO) {
+        if (inputs.isEmpty()) return@withContext emptyList()
+        val outputPaths = batchOutputPaths(inputs, File(outputDir).apply { mkdirs() })
+        val results = arrayOfNulls<BatchItemResult>(inputs.size)
+        val complete = { result: BatchItemResult ->
+            synchronized(results) {
+                results[result.index] = result
+                onItemComplete(result)
+            }
+        }
+
+        val workers = parallelism.coerceIn(1, inputs.size)
+        val handle = if (nativeLibraryLoaded && !options.needsSearch) {
+            nativeBatchCreate(
+                options.quality,
+                options.alphaQuality,
+                options.speed,
+                options.subsample.toNativeValue(),
+                options.lossless,
+                options.maxDimension ?: 0,
+                workers,
+                workers
+            )
+        } else {
+            0L
+        }
+
+        try {
+            coroutineScope {
+                val collector = if (handle != 0L) {
+                    launch {
+                        val result = LongArray(2)
+                        while (isActive) {
+                            when (nativeBatchPoll(handle, BATCH_POLL_MS, result)) {
+                                BATCH_POLL_RESULT -> {
+                                    val index = result[0].toInt()
+                                    complete(
+                                        if (result[1] >= 0) {
+                                            BatchItemResult(index, outputPaths[index], result[1])
+                                        } else {
+                                            BatchItemResult(index, outputPaths[index], -1,
+                                                AvifError.EncodingFailed("Failed to encode or write ${outputPaths[index]}"))
+                                        }
+                                    )
+                                }
+                                BATCH_POLL_DONE -> break
+                            }
+                        }
+                    }
+                } else {
+                    null
+                }
+
+                val next = AtomicInteger(0)
+                List(workers) {
+                    launch {
+                        while (true) {
+                            val index = next.getAndIncrement()
+                            if (index >= inputs.size) break
+                            ensureActive()
+                            val error = try {
+                                val written = convertBatchItem(handle, index, inputs[index], outputPaths[index], options)
+                                if (written != null) {
+                                    complete(BatchItemResult(index, outputPaths[index], written))
+                                }
+                                null
+                            } catch (e: CancellationException) {
+                                throw e
+                            } catch (e: AvifError) {
+                                e
+                            } catch (e: OutOfMemoryError) {
+                                Log.e(TAG, "OutOfMemoryError converting batch item $index", e)
+                                AvifError.OutOfMemory
+                            } catch (e: Exception) {
+                                AvifError.Unknown(e.message ?: "Failed to convert batch item $index")
+                            }
+                            if (error != null) {
+                                Log.w(TAG, "Batch item $index failed: ${error.message}")
+                                complete(BatchItemResult(index, outputPaths[index], -1, error))
+                            }
+                        }
+                    }
+                }.joinAll()
+
+                if (handle != 0L) {
+                    nativeBatchCloseInput(handle)
+                }
+                collector?.join()
+            }
+        } finally {
+            if (handle != 0L) {
+                nativeBatchDestroy(handle)
+            }
+        }
+
+        results.map { it ?: throw AvifError.Unknown("Batch item was not reported") }
+    }
+
+    /**
+     * Android-only. Encode a very large image (panoramas, scans) as an AVIF grid with bounded memory
+     *
+     * The image is split into cells of about [cellSize] pixels that are encoded as one
+     * AVIF grid image. File and byte inputs are decoded one strip of rows at a time
+     * with BitmapRegionDecoder and converted straight into the cells, so the full-size
+     * RGBA bitmap never exists: peak memory is the YUV cells (1.5 bytes per pixel at
+     * 4:2:0, plus 1 for alpha once a strip turns out translucent) plus one strip,
+     * instead of RGBA plus YUV for the whole frame. Strips are converted on several
+     * cores; cells are then compressed with the codec's threads.
+     *
+     * Only quality, alphaQuality, speed, subsample and lossless of [options] apply; the
+     * image is kept at full resolution and EXIF orientation is not applied. AVIF input
+     * is copied unchanged.
+     *
+     * @param cellSize Requested cell width and height in pixels (at least 64)
+     * @return Number of bytes written
+     */
+    suspend fun convertLargeImageToFile(
+        input: ImageInput,
+        outputPath: String,
+        options: EncodingOptions = EncodingOptions(),
+        cellSize: Int = DEFAULT_GRID_CELL_SIZE,
+        sync: Boolean = false
+    ): Long = withContext(Dispatchers.IO) {
+        if (!nativeLibraryLoaded) {
+            throw AvifError.EncodingFailed("Native library not loaded")
+        }
+        File(outputPath).parentFile?.mkdirs()
+
+        if (input is ImageInput.FromBitmap) {
+            return@withContext encodeGrid(input.bitmap.width, input.bitmap.height, cellSize, options, outputPath, sync) { handle ->
+                val directBitmap = toArgb8888(input.bitmap)
+                    ?: throw AvifError.EncodingFailed("Unsupported bitmap config: ${input.bitmap.config}")
+                try {
+                    nativeGridAddRows(handle, directBitmap, 0, 0, directBitmap.height)
+                } finally {
+                    if (directBitmap !== input.bitmap) {
+                        directBitmap.recycle()
+                    }
+                }
+            }
+        }
+
+        val path = (input as? ImageInput.FromPath)?.path
+        val data = when (input) {
+            is ImageInput.FromBytes -> input.data
+            is ImageInput.FromFile -> input.file.readBytes()
+            else -> null
+        }
+        val isAvif = if (path != null) File(path).extension.lowercase() == "avif" else isAvifFormat(data!!)
+        if (isAvif) {
+            val avifData = data ?: File(path!!).readBytes()
+            File(outputPath).writeBytes(avifData)
+            return@withContext avifData.size.toLong()
+        }
+
+        @Suppress("DEPRECATION")
+        val regionDecoder = try {
+            if (path != null) {
+                BitmapRegionDecoder.newInstance(path, false)
+            } else {
+                BitmapRegionDecoder.newInstance(data!!, 0, data.size, false)
+            }
+        } catch (e: IOException) {
+            throw AvifError.DecodingFailed("Failed to open image for region decoding: ${e.message}")
+        } ?: throw AvifError.DecodingFailed("Failed to open image for region decoding")
+
+        try {
+            val width = regionDecoder.width
+            val height = regionDecoder.height
+            encodeGrid(width, height, cellSize, options, outputPath, sync) { handle ->
+                // One strip per cell row; the strip bitmap is reused, the last strip may be shorter
+                val stripHeight = minOf(height, (maxOf(cellSize, 64) + 1) and 1.inv())
+                val decodeOptions = BitmapFactory.Options().apply {
+                    inPreferredConfig = Bitmap.Config.ARGB_8888
+                    inBitmap = Bitmap.createBitmap(width, stripHeight, Bitmap.Config.ARGB_8888)
+                }
+                try {
+                    var top = 0
+                    while (top < height) {
+                        val rows = minOf(stripHeight, height - top)
+                        val strip = regionDecoder.decodeRegion(Rect(0, top, width, top + rows), decodeOptions)
+                            ?: throw AvifError.DecodingFailed("Failed to decode rows $top..${top + rows}")
+                        if (!nativeGridAddRows(handle, strip, 0, top, rows)) return@encodeGrid false
+                        top += rows
+                    }
+                    true
+                } finally {
+                    decodeOptions.inBitmap?.recycle()
+                }
+            }
+        } finally {
+            regionDecoder.recycle()
+        }
+    }
+
+    /**
+     * Create a native grid, let [fill] add its rows and write the result to [outputPath]
+     */
+    private inline fun encodeGrid(
+        width: Int,
+        height: Int,
+        cellSize: Int,
+        options: EncodingOptions,
+        outputPath: String,
+        sync: Boolean,
+        fill: (Long) -> Boolean
+    ): Long {
+        val handle = nativeGridCreate(
+            width,
+            height,
+            cellSize,
+            options.quality,
+            options.alphaQuality,
+            options.speed,
+            options.subsample.toNativeValue(),
+            options.lossless
+        )
+        if (handle == 0L) {
+            throw AvifError.EncodingFailed("Failed to create ${width}x$height AVIF grid")
+        }
+        try {
+            if (!fill(handle)) {
+                throw AvifError.EncodingFailed("Failed to convert image rows into the AVIF grid")
+            }
+            val written = nativeGridFinishToPath(handle, outputPath, sync)
+            if (written < 0) {
+                throw AvifError.EncodingFailed("Failed to write AVIF grid to $outputPath")
+            }
+            Log.d(TAG, "Grid encode: ${width}x$height, $written bytes")
+            return written
+        } catch (e: OutOfMemoryError) {
+            Log.e(TAG, "OutOfMemoryError during grid encoding", e)
+            throw AvifError.OutOfMemory
+        } finally {
+            nativeGridClose(handle)
+        }
+    }
+
+    actual suspend fun convertToFile(
+        input: ImageInput,
+        output: PlatformFile,
+        priority: Priority,
+        options: EncodingOptions?
+    ): PlatformFile = withContext(Dispatchers.IO) {
+        val encodingOptions = options ?: EncodingOptions.fromPriority(priority)
+
+        // Handle maxSize / targetQuality if specified
+        val avifData = if (encodingOptions.needsSearch) {
+            convertWithAdaptiveCompression(input, encodingOptions)
+        } else {
+            convertStandard(input, encodingOptions)
+        }
+
+        // Save to PlatformFile
+        output.write(avifData)
+        output
+    }
+
+    actual suspend fun encodeAvif(
+        input: ImageInput,
+        priority: Priority,
+        options: EncodingOptions?
+    ): ByteArray = withContext(Dispatchers.IO) {
+        val encodingOptions = options ?: EncodingOptions.fromPriority(priority)
+
+        if (encodingOptions.needsSearch) {
+            convertWithAdaptiveCompression(input, encodingOptions)
+        } else {
+            convertStandard(input, encodingOptions)
+        }
+    }
+
+    /**
+     * Encode raw pixels from a direct ByteBuffer without copying them onto the Java heap
+     *
+     * Android-only. Resizing (maxDimension) and size targets (maxSize) are not applied
+     * on this path; quality, alphaQuality, speed, subsample and lossless are used.
+     *
+     * @param buffer Direct ByteBuffer holding 8-bit pixels
+     * @param width Image width in pixels
+     * @param height Image height in pixels
+     * @param rowBytes Stride between rows in bytes
+     * @param channelOrder Byte order of each pixel
+     * @param alphaPremultiplied Whether color channels are premultiplied by alpha
+     * @return AVIF encoded data as ByteArray
+     */
+    suspend fun encodeAvif(
+        buffer: ByteBuffer,
+        width: Int,
+        height: Int,
+        rowBytes: Int,
+        channelOrder: ChannelOrder = ChannelOrder.RGBA,
+        alphaPremultiplied: Boolean = false,
+        options: EncodingOptions = EncodingOptions()
+    ): ByteArray = withContext(Dispatchers.IO) {
+        if (!buffer.isDirect) {
+            throw AvifError.InvalidInput
+        }
+        if (!nativeLibraryLoaded) {
+            throw AvifError.EncodingFailed("Native library not loaded")
+        }
+
+        try {
+            nativeEncodeBuffer(
+                buffer,
+                width,
+                height,
+                rowBytes,
+                channelOrder.toNativeValue(),
+                alphaPremultiplied,
+                options.quality,
+                options.alphaQuality,
+                options.speed,
+                options.subsample.toNativeValue(),
+                options.lossless
+            ) ?: throw AvifError.EncodingFailed("Native buffer encoding failed")
+        } catch (e: OutOfMemoryError) {
+            Log.e(TAG, "OutOfMemoryError during AVIF encoding", e)
+            throw AvifError.OutOfMemory
+        }
+    }
+
+    /**
+     * Encode a 10- or 12-bit AVIF from an RGBA_F16 or RGBA_1010102 bitmap
+     *
+     * Android-only. The pixels are read in place without an 8-bit round trip, and the
+     * bitmap's ColorSpace is written as the file's colour information (BT2020_PQ and
+     * BT2020_HLG bitmaps produce HDR files). Extended-range F16 values outside 0..1
+     * are clamped. Resizing (maxDimension) and size targets (maxSize) are not applied
+     * on this path; only quality, speed and subsample are used.
+     *
+     * @param bitmap RGBA_F16 or RGBA_1010102 bitmap
+     * @param depth Bit depth of the encoded image (10 or 12)
+     * @return AVIF encoded data as ByteArray
+     */
+    @RequiresApi(Build.VERSION_CODES.O)
+    suspend fun encodeAvifHighBitDepth(
+        bitmap: Bitmap,
+        depth: Int = 10,
+        options: EncodingOptions = EncodingOptions()
+    ): ByteArray = withContext(Dispatchers.IO) {
+        if ((depth != 10 && depth != 12) || bitmap.isRecycled ||
+            (bitmap.config != Bitmap.Config.RGBA_F16 && !isRgba1010102(bitmap.config))
+        ) {
+            throw AvifError.InvalidInput
+        }
+        if (!nativeLibraryLoaded) {
+            throw AvifError.EncodingFailed("Native library not loaded")
+        }
+
+        val (primaries, transfer) = (bitmap.colorSpace ?: ColorSpace.get(ColorSpace.Named.SRGB)).toCicp()
+        try {
+            nativeEncodeHighDepthBitmap(
+                bitmap,
+                depth,
+                primaries,
+                transfer,
+                options.quality,
+                options.speed,
+                options.subsample.toNativeValue()
+            ) ?: throw AvifError.EncodingFailed("Native high bit depth encoding failed")
+        } catch (e: OutOfMemoryError) {
+            Log.e(TAG, "OutOfMemoryError during AVIF encoding", e)
+            throw AvifError.OutOfMemory
+        }
+    }
+
+    /**
+     * Encode a 10- or 12-bit AVIF from 16-bit-per-channel RGBA in a direct ByteBuffer
+     *
+     * Android-only. Use this for sources wider than 8 bits (16-bit PNG, camera RAW
+     * pipelines, HDR renders) so they are not quantized before encoding. Samples are
+     * native-endian uint16 or half floats in R, G, B, A order.
+     *
+     * @param buffer Direct ByteBuffer holding 8 bytes per pixel
+     * @param width Image width in pixels
+     * @param height Image height in pixels
+     * @param rowBytes Stride between rows in bytes
+     * @param sample Sample type of each channel
+     * @param colorSpace Colour space of the samples, written as the file's colour information
+     * @param alphaPremultiplied Whether color channels are premultiplied by alpha
+     * @param depth Bit depth of the encoded image (10 or 12)
+     * @return AVIF encoded data as ByteArray
+     */
+    @RequiresApi(Build.VERSION_CODES.O)
+    suspend fun encodeAvifHighBitDepth(
+        buffer: ByteBuffer,
+        width: Int,
+        height: Int,
+        rowBytes: Int,
+        sample: HighBitDepthSample,
+        colorSpace: ColorSpace = ColorSpace.get(ColorSpace.Named.SRGB),
+        alphaPremultiplied: Boolean = false,
+        depth: Int = 10,
+        options: EncodingOptions = EncodingOptions()
+    ): ByteArray = withContext(Dispatchers.IO) {
+        if (!buffer.isDirect || (depth != 10 && depth != 12)) {
+            throw AvifError.InvalidInput
+        }
+        if (!nativeLibraryLoaded) {
+            throw AvifError.EncodingFailed("Native library not loaded")
+        }
+
+        val (primaries, transfer) = colorSpace.toCicp()
+        try {
+            nativeEncodeHighDepthBuffer(
+                buffer,
+                width,
+                height,
+                rowBytes,
+                sample == HighBitDepthSample.HALF_FLOAT,
+                alphaPremultiplied,
+                depth,
+                primaries,
+                transfer,
+                options.quality,
+                options.speed,
+                options.subsample.toNativeValue()
+            ) ?: throw AvifError.EncodingFailed("Native high bit depth buffer encoding failed")
+        } catch (e: OutOfMemoryError) {
+            Log.e(TAG, "OutOfMemoryError during AVIF encoding", e)
+            throw AvifError.OutOfMemory
+        }
+    }
+
+    /**
+     * Encode an 8-bit 4:2:0 camera frame from its Y, U and V planes
+     *
+     * Android-only. The planes are encoded as they are, skipping the YUV -> RGB ->
+     * YUV round trip of going through a Bitmap: luma and planar chroma are read in
+     * place, and interleaved chroma (pixelStride 2, as most YUV_420_888 cameras
+     * deliver) is split into U and V in a single pass. The planes must stay
+     * unmodified until this returns.
+     *
+     * The output is always 4:2:0; subsample, lossless, alphaQuality and maxSize
+     * are not applied. quality, speed and maxDimension are.
+     *
+     * @param y Luma plane (pixelStride 1)
+     * @param u Cb plane
+     * @param v Cr plane; must share u's rowStride and pixelStride
+     * @param width Frame width in pixels
+     * @param height Frame height in pixels
+     * @param fullRange Whether samples span 0..255 (camera JPEG-style) rather than 16..235
+     * @param matrix Matrix the frame's YUV was derived with
+     * @param rotationDegrees Clockwise rotation needed to display the frame upright
+     *                        (0, 90, 180 or 270); stored as irot, the pixels are not rotated
+     * @return AVIF encoded data as ByteArray
+     */
+    suspend fun encodeYuv(
+        y: YuvPlane,
+        u: YuvPlane,
+        v: YuvPlane,
+        width: Int,
+        height: Int,
+        fullRange: Boolean = true,
+        matrix: YuvMatrix = YuvMatrix.BT601,
+        rotationDegrees: Int = 0,
+        options: EncodingOptions = EncodingOptions()
+    ): ByteArray = withContext(Dispatchers.IO) {
+        if (!y.buffer.isDirect || !u.buffer.isDirect || !v.buffer.isDirect || y.pixelStride != 1 ||
+            u.rowStride != v.rowStride || u.pixelStride != v.pixelStride
+        ) {
+            throw AvifError.InvalidInput
+        }
+        if (!nativeLibraryLoaded) {
+            throw AvifError.EncodingFailed("Native library not loaded")
+        }
+
+        try {
+            nativeEncodeYuvPlanes(
+                y.buffer,
+                u.buffer,
+                v.buffer,
+                width,
+                height,
+                y.rowStride,
+                u.rowStride,
+                u.pixelStride,
+                fullRange,
+                matrix.toNativeValue(),
+                exifOrientationForRotation(rotationDegrees),
+                options.quality,
+                options.speed,
+                options.maxDimension ?: 0
+            ) ?: throw AvifError.EncodingFailed("Native YUV encoding failed")
+        } catch (e: OutOfMemoryError) {
+            Log.e(TAG, "OutOfMemoryError during AVIF encoding", e)
+            throw AvifError.OutOfMemory
+        }
+    }
+
+    /**
+     * Encode a YUV_420_888 [Image] from CameraX or Camera2 without converting it to RGB
+     *
+     * Android-only. Same as [encodeYuv] with planes; pass the rotation the camera
+     * reports (e.g. ImageProxy.imageInfo.rotationDegrees). The image is not closed.
+     *
+     * @param image YUV_420_888 image
+     * @param fullRange Whether samples span 0..255 (the camera default) rather than 16..235
+     * @param matrix Matrix the frame's YUV was derived with
+     * @param rotationDegrees Clockwise rotation needed to display the frame upright
+     * @return AVIF encoded data as ByteArray
+     */
+    suspend fun encodeYuv(
+        image: Image,
+        fullRange: Boolean = true,
+        matrix: YuvMatrix = YuvMatrix.BT601,
+        rotationDegrees: Int = 0,
+        options: EncodingOptions = EncodingOptions()
+    ): ByteArray {
+        if (image.format != android.graphics.ImageFormat.YUV_420_888) {
+            throw AvifError.UnsupportedFormat
+        }
+        val planes = image.planes
+        return encodeYuv(
+            YuvPlane(planes[0].buffer, planes[0].rowStride, planes[0].pixelStride),
+            YuvPlane(planes[1].buffer, planes[1].rowStride, planes[1].pixelStride),
+            YuvPlane(planes[2].buffer, planes[2].rowStride, planes[2].pixelStride),
+            image.width,
+            image.height,
+            fullRange,
+            matrix,
+            rotationDegrees,
+            options
+        )
+    }
+
+    /**
+     * Encode a packed 8-bit 4:2:0 frame (I420, NV12 or NV21) from a byte array
+     *
+     * Android-only. Rows are tightly packed and the chroma planes are
+     * ceil(width / 2) x ceil(height / 2), as produced by Camera1 preview callbacks
+     * (NV21) and most software pipelines. Options are applied as in [encodeYuv].
+     *
+     * @param data Frame bytes: the Y plane followed by the chroma plane(s)
+     * @param width Frame width in pixels
+     * @param height Frame height in pixels
+     * @param layout Arrangement of the chroma samples
+     * @param fullRange Whether samples span 0..255 rather than 16..235
+     * @param matrix Matrix the frame's YUV was derived with
+     * @param rotationDegrees Clockwise rotation needed to display the frame upright
+     * @return AVIF encoded data as ByteArray
+     */
+    suspend fun encodeYuv(
+        data: ByteArray,
+        width: Int,
+        height: Int,
+        layout: YuvLayout = YuvLayout.NV21,
+        fullRange: Boolean = true,
+        matrix: YuvMatrix = YuvMatrix.BT601,
+        rotationDegrees: Int = 0,
+        options: EncodingOptions = EncodingOptions()
+    ): ByteArray = withContext(Dispatchers.IO) {
+        if (!nativeLibraryLoaded) {
+            throw AvifError.EncodingFailed("Native library not loaded")
+        }
+
+        try {
+            nativeEncodeYuvArray(
+                data,
+                width,
+                height,
+                layout.toNativeValue(),
+                fullRange,
+                matrix.toNativeValue(),
+                exifOrientationForRotation(rotationDegrees),
+                options.quality,
+                options.speed,
+                options.maxDimension ?: 0
+            ) ?: throw AvifError.EncodingFailed("Native YUV encoding failed")
+        } catch (e: OutOfMemoryError) {
+            Log.e(TAG, "OutOfMemoryError during AVIF encoding", e)
+            throw AvifError.OutOfMemory
+        }
+    }
+
+    actual suspend fun decodeAvif(input: ImageInput): PlatformBitmap = withContext(Dispatchers.IO) {
+        (input as? ImageInput.FromPath)?.let { decodeAvifFromPath(it.path, 0, 0, 1, ResizeFilter.AUTO) }
+            ?: decodeAvifToBitmap(readAvifInput(input))
+    }
+
+    /**
+     * Decode AVIF from an open file descriptor without reading the file onto the Java heap
+     *
+     * Android-only. libavif reads only the boxes and item extents it needs (the file is
+     * memory-mapped), so unused items such as large Exif blocks are skipped. The
+     * descriptor stays open and owned by the caller. Pass target sizes to downscale as in
+     * [decodeAvif] with targetWidth/targetHeight; 0 means unconstrained.
+     *
+     * @param descriptor Readable, seekable descriptor of an AVIF file
+     * @param targetWidth Maximum output width in pixels (0 = unconstrained)
+     * @param targetHeight Maximum output height in pixels (0 = unconstrained)
+     * @param filter Resampling filter
+     * @return Decoded Bitmap
+     */
+    suspend fun decodeAvif(
+        descriptor: ParcelFileDescriptor,
+        targetWidth: Int = 0,
+        targetHeight: Int = 0,
+        filter: ResizeFilter = ResizeFilter.AUTO
+    ): Bitmap = withContext(Dispatchers.IO) {
+        if (!nativeLibraryLoaded) {
+            throw AvifError.DecodingFailed("Native library not loaded")
+        }
+        decodeAvifFromFd(descriptor, targetWidth, targetHeight, 1, filter)
+            ?: throw AvifError.DecodingFailed("Native file descriptor decoding failed")
+    }
+
+    /**
+     * Decode AVIF downscaled to fit within a target size
+     *
+     * Android-only. The image is resampled natively before YUV->RGB conversion, so the
+     * full-resolution pixels never reach the Java heap. The aspect ratio is kept and
+     * images are never upscaled; pass 0 for a dimension that should not constrain.
+     * The target box applies to the image as displayed (after irot/imir).
+     *
+     * @param input AVIF data as ByteArray or file path
+     * @param targetWidth Maximum output width in pixels (0 = unconstrained)
+     * @param targetHeight Maximum output height in pixels (0 = unconstrained)
+     * @param filter Resampling filter
+     * @return Decoded, downscaled Bitmap
+     */
+    suspend fun decodeAvif(
+        input: ImageInput,
+        targetWidth: Int,
+        targetHeight: Int,
+        filter: ResizeFilter = ResizeFilter.AUTO
+    ): Bitmap = withContext(Dispatchers.IO) {
+        (input as? ImageInput.FromPath)?.let { decodeAvifFromPath(it.path, targetWidth, targetHeight, 1, filter) }
+            ?: decodeAvifScaled(readAvifInput(input), targetWidth, targetHeight, 1, filter)
+    }
+
+    /**
+     * Decode AVIF with both dimensions divided by [sampleSize] (rounded up)
+     *
+     * Android-only. Like BitmapFactory's inSampleSize, but any factor is allowed and
+     * the reduction is filtered rather than decimated.
+     *
+     * @param input AVIF data as ByteArray or file path
+     * @param sampleSize Reduction factor, 1 or more
+     * @param filter Resampling filter
+     * @return Decoded, downscaled Bitmap
+     */
+    suspend fun decodeAvif(
+        input: ImageInput,
+        sampleSize: Int,
+        filter: ResizeFilter = ResizeFilter.AUTO
+    ): Bitmap = withContext(Dispatchers.IO) {
+        if (sampleSize < 1) {
+            throw AvifError.InvalidInput
+        }
+        (input as? ImageInput.FromPath)?.let { decodeAvifFromPath(it.path, 0, 0, sampleSize, filter) }
+            ?: decodeAvifScaled(readAvifInput(input), 0, 0, sampleSize, filter)
+    }
+
+    /**
+     * Decode a rectangle of an AVIF image, like BitmapRegionDecoder does for JPEG
+     *
+     * Android-only. Large AVIF images are usually stored as grids of cells; only the
+     * cell rows down to the last stored row the rectangle covers are decoded, and the
+     * image is cropped before YUV->RGB, so conversion and copying scale with the
+     * rectangle rather than the image. Suited to pan/zoom viewers over very large images.
+     * Coordinates and output are in display orientation (irot/imir applied), matching
+     * [getImageInfo] and [decodeAvif].
+     *
+     * @param input AVIF data as ByteArray or file path
+     * @param x Left edge of the rectangle in image pixels
+     * @param y Top edge of the rectangle in image pixels
+     * @param width Rectangle width (clipped to the image)
+     * @param height Rectangle height (clipped to the image)
+     * @param sampleSize Reduction factor, 1 or more; the output is the rectangle divided by it
+     * @param filter Resampling filter used when [sampleSize] > 1
+     * @return Decoded rectangle
+     */
+    suspend fun decodeRegion(
+        input: ImageInput,
+        x: Int,
+        y: Int,
+        width: Int,
+        height: Int,
+        sampleSize: Int = 1,
+        filter: ResizeFilter = ResizeFilter.AUTO
+    ): Bitmap = withContext(Dispatchers.IO) {
+        if (x < 0 || y < 0 || width <= 0 || height <= 0 || sampleSize < 1) {
+            throw AvifError.InvalidInput
+        }
+        if (!nativeLibraryLoaded) {
+            throw AvifError.DecodingFailed("Native library not loaded")
+        }
+
+        try {
+            val decoded = nativeDecodeRegion(
+                readAvifInput(input),
+                x,
+                y,
+                width,
+                height,
+                sampleSize,
+                filter.toNativeValue()
+            ) ?: throw AvifError.DecodingFailed("Native region decoding failed")
+            Log.d(TAG, "nativeDecodeRegion succeeded: ${decoded.width}x${decoded.height}")
+            decoded.toBitmap()
+        } catch (e: OutOfMemoryError) {
+            Log.e(TAG, "OutOfMemoryError during AVIF region decoding", e)
+            throw AvifError.OutOfMemory
+        }
     }
 
-    actual suspend fun convertToFile(
-        input: ImageInput,
-        outputPath: String,
-        priority: Priority,
-        options: EncodingOptions?
-    ): String = withContext(Dispatchers.IO) {
-        val encodingOptions = options ?: EncodingOptions.fromPriority(priority)
-
-        // Handle maxSize if specified
-        val avifData = if (encodingOptions.maxSize != null) {
-            convertWithAdaptiveCompression(input, encodingOptions)
-        } else {
-            convertStandard(input, encodingOptions)
+    /**
+     * Decode AVIF straight into an existing mutable Bitmap
+     *
+     * Android-only. Pixels are written once, directly from YUV, with no intermediate
+     * arrays, already rotated/mirrored for display. The bitmap is reconfigured to the
+     * displayed size when needed, so it can be reused across images as long as its
+     * allocation is large enough.
+     *
+     * @param input AVIF data as ByteArray or file path
+     * @param target Mutable bitmap to decode into
+     * @return [target], holding the decoded image
+     */
+    suspend fun decodeAvifInto(input: ImageInput, target: Bitmap): Bitmap = withContext(Dispatchers.IO) {
+        if (!target.isMutable) {
+            throw AvifError.InvalidInput
         }
-
-        // Save to file
-        File(outputPath).apply {
-            parentFile?.mkdirs()
-            writeBytes(avifData)
+        if (!nativeLibraryLoaded) {
+            throw AvifError.DecodingFailed("Native library not loaded")
         }
 
-        outputPath
+        if (!nativeDecodeIntoBitmap(readAvifInput(input), target)) {
+            throw AvifError.DecodingFailed("Native decoding into bitmap failed")
+        }
+        target
     }
 
-    actual suspend fun convertToFile(
+    /**
+     * Decode AVIF straight into a direct ByteBuffer
+     *
+     * Android-only. Pixels are written in display orientation. The buffer can be reused
+     * across images; if it is too small the call fails with a message stating the
+     * required size.
+     *
+     * @param input AVIF data as ByteArray or file path
+     * @param buffer Direct ByteBuffer receiving 8-bit pixels (unpremultiplied)
+     * @param rowBytes Stride between rows in bytes
+     * @param channelOrder Byte order of each written pixel
+     * @return ImageInfo describing the decoded image
+     */
+    suspend fun decodeAvifInto(
         input: ImageInput,
-        output: PlatformFile,
-        priority: Priority,
-        options: EncodingOptions?
-    ): PlatformFile = withContext(Dispatchers.IO) {
-        val encodingOptions = options ?: EncodingOptions.fromPriority(priority)
-
-        // Handle maxSize if specified
-        val avifData = if (encodingOptions.maxSize != null) {
-            convertWithAdaptiveCompression(input, encodingOptions)
-        } else {
-            convertStandard(input, encodingOptions)
+        buffer: ByteBuffer,
+        rowBytes: Int,
+        channelOrder: ChannelOrder = ChannelOrder.RGBA
+    ): ImageInfo = withContext(Dispatchers.IO) {
+        if (!buffer.isDirect) {
+            throw AvifError.InvalidInput
+        }
+        if (!nativeLibraryLoaded) {
+            throw AvifError.DecodingFailed("Native library not loaded")
         }
 
-        // Save to PlatformFile
-        output.write(avifData)
-        output
+        val info = IntArray(3)
+        val success = nativeDecodeIntoBuffer(
+            readAvifInput(input),
+            buffer,
+            rowBytes,
+            channelOrder.toNativeValue(),
+            info
+        )
+        decodeIntoBufferResult(success, info, buffer, rowBytes, channelOrder)
     }
 
-    actual suspend fun encodeAvif(
+    /**
+     * Decode AVIF without reducing 10/12-bit images to 8 bits
+     *
+     * Android-only. RGBA_1010102 (API 33+) keeps 10 bits per color channel at 4 bytes
+     * per pixel, the same memory as the ARGB_8888 bitmaps [decodeAvif] returns;
+     * RGBA_F16 doubles that. The bitmap's ColorSpace comes from the file's colour
+     * information, so PQ and HLG images display as HDR (BT2020_PQ needs API 33 and
+     * BT2020_HLG API 34; older releases get plain BT2020). 8-bit files decode too.
+     * Like [decodeAvif], the bitmap is in display orientation.
+     *
+     * @param input AVIF data as ByteArray or file path
+     * @param format Output pixel format
+     * @return Decoded bitmap in the requested format
+     * @throws AvifError.UnsupportedFormat if this Android release lacks the format
+     */
+    @RequiresApi(Build.VERSION_CODES.O)
+    suspend fun decodeAvifHighBitDepth(
         input: ImageInput,
-        priority: Priority,
-        options: EncodingOptions?
-    ): ByteArray = withContext(Dispatchers.IO) {
-        val encodingOptions = options ?: EncodingOptions.fromPriority(priority)
-
-        if (encodingOptions.maxSize != null) {
-            convertWithAdaptiveCompression(input, encodingOptions)
-        } else {
-            convertStandard(input, encodingOptions)
+        format: HighBitDepthFormat = HighBitDepthFormat.RGBA_1010102
+    ): Bitmap = withContext(Dispatchers.IO) {
+        val config = format.toBitmapConfig() ?: throw AvifError.UnsupportedFormat
+        if (!nativeLibraryLoaded) {
+            throw AvifError.DecodingFailed("Native library not loaded")
         }
-    }
 
-    actual suspend fun decodeAvif(input: ImageInput): PlatformBitmap = withContext(Dispatchers.IO) {
-        val data = when (input) {
-            is ImageInput.FromBytes -> input.data
-            is ImageInput.FromPath -> File(input.path).readBytes()
-            is ImageInput.FromFile -> input.file.readBytes()
-            is ImageInput.FromBitmap -> throw AvifError.InvalidInput
+        val data = readAvifInput(input)
+        // The probe reports the displayed size, which the oriented decode fills
+        val info = IntArray(PROBE_INFO_SIZE)
+        if (nativeProbe(data, data.size, info) != PROBE_OK || info[0] <= 0 || info[1] <= 0) {
+            throw AvifError.DecodingFailed("Failed to read AVIF header")
         }
-
-        decodeAvifToBitmap(data)
+        val bitmap = try {
+            Bitmap.createBitmap(info[0], info[1], config, info[3] != 0, colorSpaceFromCicp(info[7], info[8]))
+        } catch (e: OutOfMemoryError) {
+            Log.e(TAG, "OutOfMemoryError allocating high bit depth bitmap", e)
+            throw AvifError.OutOfMemory
+        }
+        if (!nativeDecodeHighDepthIntoBitmap(data, bitmap)) {
+            bitmap.recycle()
+            throw AvifError.DecodingFailed("Native high bit depth decoding failed")
+        }
+        bitmap
     }
 
     actual fun isAvifSupported(): Boolean {
@@ -151,7 +1418,7 @@ actual class AvifConverter {
         return try {
             val data = when (input) {
                 is ImageInput.FromBytes -> input.data
-                is ImageInput.FromPath -> File(input.path).readBytes().take(12).toByteArray()
+                is ImageInput.FromPath -> readPrefix(File(input.path), FTYP_PREFIX_BYTES)
                 is ImageInput.FromFile -> kotlinx.coroutines.runBlocking {
                     input.file.readBytes().take(12).toByteArray()
                 }
@@ -166,53 +1433,34 @@ actual class AvifConverter {
     actual suspend fun getImageInfo(input: ImageInput): ImageInfo = withContext(Dispatchers.IO) {
         when (input) {
             is ImageInput.FromBytes -> {
-                val options = BitmapFactory.Options().apply {
-                    inJustDecodeBounds = true
-                }
-                BitmapFactory.decodeByteArray(input.data, 0, input.data.size, options)
-                ImageInfo(
-                    width = options.outWidth,
-                    height = options.outHeight,
-                    format = detectFormat(input.data),
-                    hasAlpha = if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.O) {
-                        options.outConfig == Bitmap.Config.ARGB_8888
-                    } else false,
-                    fileSize = input.data.size.toLong()
-                )
+                probeAvifBytes(input.data)
+                    ?: boundsInfo(input.data, detectFormat(input.data), input.data.size.toLong())
             }
 
             is ImageInput.FromPath -> {
                 val file = File(input.path)
-                val options = BitmapFactory.Options().apply {
-                    inJustDecodeBounds = true
+                probeAvifFile(file) ?: run {
+                    val options = BitmapFactory.Options().apply {
+                        inJustDecodeBounds = true
+                    }
+                    BitmapFactory.decodeFile(input.path, options)
+                    ImageInfo(
+                        width = options.outWidth,
+                        height = options.outHeight,
+                        format = detectFormatFromPath(input.path),
+                        hasAlpha = if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.O) {
+                            options.outConfig == Bitmap.Config.ARGB_8888
+                        } else false,
+                        fileSize = file.length()
+                    )
                 }
-                BitmapFactory.decodeFile(input.path, options)
-                ImageInfo(
-                    width = options.outWidth,
-                    height = options.outHeight,
-                    format = detectFormatFromPath(input.path),
-                    hasAlpha = if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.O) {
-                        options.outConfig == Bitmap.Config.ARGB_8888
-                    } else false,
-                    fileSize = file.length()
-                )
             }
 
             is ImageInput.FromFile -> {
+                // PlatformFile only offers whole-file reads here; the probe still avoids a decode
                 val data = input.file.readBytes()
-                val options = BitmapFactory.Options().apply {
-                    inJustDecodeBounds = true
-                }
-                BitmapFactory.decodeByteArray(data, 0, data.size, options)
-                ImageInfo(
-                    width = options.outWidth,
-                    height = options.outHeight,
-                    format = detectFormat(data),
-                    hasAlpha = if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.O) {
-                        options.outConfig == Bitmap.Config.ARGB_8888
-                    } else false,
-                    fileSize = input.file.size()
-                )
+                probeAvifBytes(data)?.copy(fileSize = input.file.size())
+                    ?: boundsInfo(data, detectFormat(data), input.file.size())
             }
 
             is ImageInput.FromBitmap -> {
@@ -228,11 +1476,100 @@ actual class AvifConverter {
 
     // Private helper methods
 
+    private fun boundsInfo(data: ByteArray, format: ImageFormat, fileSize: Long): ImageInfo {
+        val options = BitmapFactory.Options().apply {
+            inJustDecodeBounds = true
+        }
+        BitmapFactory.decodeByteArray(data, 0, data.size, options)
+        return ImageInfo(
+            width = options.outWidth,
+            height = options.outHeight,
+            format = format,
+            hasAlpha = if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.O) {
+                options.outConfig == Bitmap.Config.ARGB_8888
+            } else false,
+            fileSize = fileSize
+        )
+    }
+
+    /**
+     * Read AVIF properties from the container boxes, without decoding
+     * Returns null when the data is not AVIF, the native library is unavailable or the
+     * boxes cannot be parsed, so callers can fall back to BitmapFactory.
+     */
+    private fun probeAvifBytes(data: ByteArray): ImageInfo? {
+        if (!nativeLibraryLoaded || !isAvifFormat(data)) return null
+        val info = IntArray(PROBE_INFO_SIZE)
+        return if (nativeProbe(data, data.size, info) == PROBE_OK) {
+            imageInfoFromProbe(info, data.size.toLong())
+        } else null
+    }
+
+    /**
+     * Like probeAvifBytes, but reads only the start of the file
+     * (one retry with a longer prefix if meta/moov extend past the first read)
+     */
+    private fun probeAvifFile(file: File): ImageInfo? {
+        if (!nativeLibraryLoaded) return null
+        val fileSize = file.length()
+        var prefixSize = minOf(fileSize, PROBE_PREFIX_BYTES.toLong()).toInt()
+        repeat(2) {
+            val prefix = readPrefix(file, prefixSize)
+            if (!isAvifFormat(prefix)) return null
+            val info = IntArray(PROBE_INFO_SIZE)
+            when (nativeProbe(prefix, prefix.size, info)) {
+                PROBE_OK -> return imageInfoFromProbe(info, fileSize)
+                PROBE_NEED_MORE_DATA -> {
+                    val needed = minOf(info[6].toLong(), fileSize, MAX_PROBE_BYTES.toLong()).toInt()
+                    if (needed <= prefixSize) return null
+                    prefixSize = needed
+                }
+                else -> return null
+            }
+        }
+        return null
+    }
+
+    private fun imageInfoFromProbe(info: IntArray, fileSize: Long) = ImageInfo(
+        width = info[0],
+        height = info[1],
+        format = ImageFormat.AVIF,
+        hasAlpha = info[3] != 0,
+        fileSize = fileSize,
+        bitDepth = info[2].takeIf { it > 0 },
+        chromaSubsample = chromaSubsampleFromNative(info[5]),
+        frameCount = info[4].takeIf { it > 0 }
+    )
+
+    private fun readPrefix(file: File, size: Int): ByteArray {
+        val length = minOf(file.length(), size.toLong()).toInt()
+        val prefix = ByteArray(length)
+        RandomAccessFile(file, "r").use { it.readFully(prefix) }
+        return prefix
+    }
+
+    private suspend fun readAvifInput(input: ImageInput): ByteArray = when (input) {
+        is ImageInput.FromBytes -> input.data
+        is ImageInput.FromPath -> File(input.path).readBytes()
+        is ImageInput.FromFile -> input.file.readBytes()
+        is ImageInput.FromBitmap -> throw AvifError.InvalidInput
+    }
+
+    /**
+     * Whether the options ask for a search (size or quality target) instead of one encode
+     */
+    private val EncodingOptions.needsSearch: Boolean
+        get() = maxSize != null || targetQuality != null
+
     private suspend fun convertWithAdaptiveCompression(
         input: ImageInput,
         options: EncodingOptions
     ): ByteArray {
-        val targetSize = options.maxSize!!
+        val targetSize = options.maxSize
+            ?: return convertWithTargetQuality(input, options, options.targetQuality!!)
+
+        // Prefer the native search: source decoded once, RGB->YUV done once per chroma format
+        encodeToTargetSizeNative(input, options, targetSize)?.let { return it }
 
         return when (options.compressionStrategy) {
             CompressionStrategy.SMART -> convertWithSmartCompression(input, options, targetSize)
@@ -240,6 +1577,148 @@ actual class AvifConverter {
         }
     }
 
+    /**
+     * Size-targeted encoding using nativeEncodeToTargetSize
+     *
+     * The source is decoded once, with its orientation, ICC profile and (with
+     * preserveMetadata) Exif, like [convertWithTargetQuality]. The native side searches
+     * quality/speed/subsampling, and only when no parameters fit is the limit shrunk
+     * and the search repeated. Resizing happens natively from the decoded pixels,
+     * never on the Java heap.
+     * Returns null when the native search is unavailable so the caller can fall back
+     * to the Kotlin search loops.
+     */
+    private suspend fun encodeToTargetSizeNative(
+        input: ImageInput,
+        options: EncodingOptions,
+        targetSize: Long
+    ): ByteArray? {
+        if (!nativeLibraryLoaded) return null
+
+        val pixels = when (val loaded = loadSource(input, options.preserveMetadata, options.maxDimension)) {
+            is SourceImage.Avif -> return loaded.data
+            is SourceImage.Pixels -> loaded
+        }
+        val source = pixels.bitmap
+        val strategy = when (options.compressionStrategy) {
+            CompressionStrategy.SMART -> 0
+            CompressionStrategy.STRICT -> 1
+        }
+
+        val bitmap = toArgb8888(source) ?: return null
+        try {
+            // Every round downscales natively from the original pixels
+            var maxDim = minOf(options.maxDimension ?: Int.MAX_VALUE, maxOf(bitmap.width, bitmap.height))
+            repeat(MAX_NATIVE_RESIZE_ROUNDS) { round ->
+                val result = nativeEncodeToTargetSize(
+                    bitmap,
+                    maxDim,
+                    options.quality,
+                    options.alphaQuality,
+                    options.speed,
+                    options.subsample.toNativeValue(),
+                    options.lossless,
+                    pixels.orientation,
+                    pixels.exif,
+                    pixels.icc,
+                    targetSize,
+                    strategy
+                ) ?: return null
+
+                Log.d(
+                    TAG,
+                    "Native size search round $round: maxDimension=$maxDim, " +
+                        "quality=${result.quality}, size=${result.data.size}, " +
+                        "attempts=${result.attempts}, met=${result.targetMet}"
+                )
+
+                if (result.targetMet) {
+                    return result.data
+                }
+
+                // Parameters alone cannot reach the target - shrink and search again
+                maxDim = (maxDim * 0.75).toInt()
+            }
+        } catch (e: OutOfMemoryError) {
+            Log.e(TAG, "OutOfMemoryError during native size search", e)
+            throw AvifError.OutOfMemory
+        } finally {
+            if (bitmap !== source) {
+                bitmap.recycle()
+            }
+        }
+
+        Log.w(TAG, "Native size search failed to meet target, using fallback")
+        return convertStandard(input, getFallbackOptions())
+    }
+
+    /**
+     * Quality-targeted encoding using nativeEncodeToTargetQuality
+     *
+     * The source is converted to YUV once; the native side bisects quality for the
+     * smallest file whose decoded result reaches [targetQuality] (weighted YUV SSIM on
+     * a downscaled proxy). A source that misses the target even at the highest quality
+     * is returned at its best-scoring quality. Without the native search (placeholder
+     * build) the options' quality is used as is.
+     */
+    private suspend fun convertWithTargetQuality(
+        input: ImageInput,
+        options: EncodingOptions,
+        targetQuality: Float
+    ): ByteArray {
+        val pixels = when (val loaded = loadSource(input, options.preserveMetadata, options.maxDimension)) {
+            is SourceImage.Avif -> return loaded.data
+            is SourceImage.Pixels -> loaded
+        }
+        val source = pixels.bitmap
+        val result = encodeToTargetQuality(source, options, targetQuality, pixels.orientation, pixels.exif, pixels.icc)
+        if (result == null) {
+            Log.w(TAG, "Native quality search unavailable, encoding at quality ${options.quality}")
+            return encodeBitmapToAvif(source, options, pixels.orientation, pixels.exif, pixels.icc)
+        }
+        Log.d(
+            TAG,
+            "Native quality search: quality=${result.quality}, ssim=${result.score}, " +
+                "size=${result.data.size}, attempts=${result.attempts}, met=${result.targetMet}"
+        )
+        return result.data
+    }
+
+    /**
+     * Run the native quality search on [source], or null without it (placeholder build)
+     */
+    internal fun encodeToTargetQuality(
+        source: Bitmap,
+        options: EncodingOptions,
+        targetQuality: Float,
+        orientation: Int = ExifInterface.ORIENTATION_NORMAL,
+        exif: ByteArray? = null,
+        icc: ByteArray? = null
+    ): TargetQualityEncodeResult? {
+        val bitmap = if (nativeLibraryLoaded) toArgb8888(source) else null
+        return try {
+            bitmap?.let {
+                nativeEncodeToTargetQuality(
+                    it,
+                    options.maxDimension ?: 0,
+                    options.speed,
+                    options.subsample.toNativeValue(),
+                    orientation,
+                    exif,
+                    icc,
+                    targetQuality
+                )
+            }
+        } catch (e: OutOfMemoryError) {
+            Log.e(TAG, "OutOfMemoryError during native quality search", e)
+            throw AvifError.OutOfMemory
+        } finally {
+            if (bitmap != null && bitmap !== source) {
+                bitmap.recycle()
+            }
+        }
+    }
+
     /**
      * SMART compression: Find the highest quality image that still meets the target size
      * Uses binary search for optimal quality setting
@@ -396,26 +1875,101 @@ actual class AvifConverter {
         preserveMetadata = false
     )
 
-    private suspend fun convertStandard(
+    /**
+     * Decoded conversion source: AVIF input passes through untouched,
+     * everything else is decoded to a Bitmap in sensor order
+     *
+     * [orientation] is the Exif orientation, which the encoder stores as irot/imir
+     * instead of rotating the pixels. [exif] is the source's Exif block (TIFF header
+     * on) when metadata is preserved, otherwise null. [icc] is the source's ICC
+     * profile while the bitmap's pixels are still in that colour space.
+     */
+    private sealed class SourceImage {
+        class Avif(val data: ByteArray) : SourceImage()
+        class Pixels(
+            val bitmap: Bitmap,
+            val orientation: Int = ExifInterface.ORIENTATION_NORMAL,
+            val exif: ByteArray? = null,
+            val icc: ByteArray? = null
+        ) : SourceImage()
+    }
+
+    /**
+     * Exif block and ICC profile read from a JPEG's header segments
+     */
+    private class JpegMetadata(val exif: ByteArray?, val icc: ByteArray?)
+
+    /**
+     * Decode a non-AVIF source to pixels
+     *
+     * JPEGs larger than [maxDimension] are decoded at 1/2, 1/4 or 1/8 scale, which
+     * the platform's libjpeg-turbo performs in the DCT domain, skipping most of the
+     * IDCT and color conversion work. The reduction stops while the long side is
+     * still at least [maxDimension], so the native resampler makes the final,
+     * exact fit. [decode] runs BitmapFactory with the given options.
+     */
+    private inline fun decodePixels(
+        orientation: Int,
+        metadata: JpegMetadata?,
+        preserveMetadata: Boolean,
+        maxDimension: Int?,
+        decode: (BitmapFactory.Options) -> Bitmap?
+    ): SourceImage.Pixels? {
+        var sampleSize = 1
+        if (maxDimension != null) {
+            val bounds = BitmapFactory.Options().apply { inJustDecodeBounds = true }
+            decode(bounds)
+            if (bounds.outMimeType == "image/jpeg") {
+                val longSide = maxOf(bounds.outWidth, bounds.outHeight)
+                while (sampleSize < MAX_JPEG_SCALE_DENOMINATOR && longSide / (sampleSize * 2) >= maxDimension) {
+                    sampleSize *= 2
+                }
+            }
+        }
+
+        val bitmap = decode(BitmapFactory.Options().apply { inSampleSize = sampleSize }) ?: return null
+        if (sampleSize > 1) {
+            Log.d(TAG, "Decoded JPEG at 1/$sampleSize scale: ${bitmap.width}x${bitmap.height}")
+        }
+        return SourceImage.Pixels(
+            bitmap,
+            orientation,
+            if (preserveMetadata) metadata?.exif else null,
+            metadata?.icc?.takeIf { isInSourceColorSpace(bitmap) }
+        )
+    }
+
+    /**
+     * Whether a decoded bitmap's pixels are still in the source's embedded colour space
+     * From API 26 BitmapFactory converts profiles it cannot represent to sRGB (and
+     * reports sRGB), in which case the source profile no longer describes the pixels.
+     */
+    private fun isInSourceColorSpace(bitmap: Bitmap): Boolean =
+        Build.VERSION.SDK_INT < Build.VERSION_CODES.O || bitmap.colorSpace?.isSrgb == false
+
+    private suspend fun loadSource(
         input: ImageInput,
-        options: EncodingOptions
-    ): ByteArray = withContext(Dispatchers.IO) {
+        preserveMetadata: Boolean = false,
+        maxDimension: Int? = null
+    ): SourceImage = withContext(Dispatchers.IO) {
         when (input) {
             is ImageInput.FromBytes -> {
                 if (isAvifFormat(input.data)) {
-                    input.data
+                    SourceImage.Avif(input.data)
                 } else {
-                    val bitmap = BitmapFactory.decodeByteArray(input.data, 0, input.data.size)
+                    decodePixels(
+                        readExifOrientation(input.data),
+                        readJpegMetadata(input.data),
+                        preserveMetadata,
+                        maxDimension
+                    ) { options -> BitmapFactory.decodeByteArray(input.data, 0, input.data.size, options) }
                         ?: throw AvifError.DecodingFailed("Failed to decode input image")
-                    // Apply EXIF orientation if present
-                    val orientedBitmap = applyExifOrientation(bitmap, input.data)
-                    encodeBitmapToAvif(orientedBitmap, options)
                 }
             }
 
             is ImageInput.FromBitmap -> {
                 // Bitmap is already in memory, use as-is
-                encodeBitmapToAvif(input.bitmap, options)
+                SourceImage.Pixels(input.bitmap)
             }
 
             is ImageInput.FromPath -> {
@@ -424,64 +1978,207 @@ actual class AvifConverter {
                     throw AvifError.FileError("File not found: ${input.path}")
                 }
                 if (file.extension.lowercase() == "avif") {
-                    file.readBytes()
+                    SourceImage.Avif(file.readBytes())
                 } else {
-                    val bitmap = BitmapFactory.decodeFile(input.path)
+                    decodePixels(
+                        readExifOrientationFromFile(input.path),
+                        readJpegMetadataFromFile(input.path),
+                        preserveMetadata,
+                        maxDimension
+                    ) { options -> BitmapFactory.decodeFile(input.path, options) }
                         ?: throw AvifError.DecodingFailed("Failed to decode file: ${input.path}")
-                    // Apply EXIF orientation from file
-                    val orientedBitmap = applyExifOrientationFromFile(bitmap, input.path)
-                    encodeBitmapToAvif(orientedBitmap, options)
                 }
             }
 
             is ImageInput.FromFile -> {
                 val data = input.file.readBytes()
                 if (isAvifFormat(data)) {
-                    data
+                    SourceImage.Avif(data)
                 } else {
-                    val bitmap = BitmapFactory.decodeByteArray(data, 0, data.size)
+                    decodePixels(
+                        readExifOrientation(data),
+                        readJpegMetadata(data),
+                        preserveMetadata,
+                        maxDimension
+                    ) { options -> BitmapFactory.decodeByteArray(data, 0, data.size, options) }
                         ?: throw AvifError.DecodingFailed("Failed to decode file: ${input.file.name}")
-                    // Apply EXIF orientation if present
-                    val orientedBitmap = applyExifOrientation(bitmap, data)
-                    encodeBitmapToAvif(orientedBitmap, options)
                 }
             }
         }
     }
 
-    private fun encodeBitmapToAvif(bitmap: Bitmap, options: EncodingOptions): ByteArray {
+    /**
+     * Output file per batch input: the input's base name where it has one,
+     * suffixed with the index when two inputs share a name
+     */
+    private fun batchOutputPaths(inputs: List<ImageInput>, directory: File): List<String> {
+        val used = HashSet<String>()
+        return inputs.mapIndexed { index, input ->
+            val baseName = when (input) {
+                is ImageInput.FromPath -> File(input.path).nameWithoutExtension
+                is ImageInput.FromFile -> input.file.name.substringBeforeLast('.')
+                else -> ""
+            }.ifEmpty { "image_$index" }
+            val name = if (used.add(baseName)) baseName else "${baseName}_$index"
+            File(directory, "$name.avif").path
+        }
+    }
+
+    /**
+     * Decode one batch item and hand it to the encode stage
+     *
+     * Returns the bytes written when the item was finished here (AVIF pass-through,
+     * size-targeted encodes, or no native pipeline), or null once it is queued for
+     * the native encoder threads, which report it through the collector.
+     */
+    private suspend fun convertBatchItem(
+        handle: Long,
+        index: Int,
+        input: ImageInput,
+        outputPath: String,
+        options: EncodingOptions
+    ): Long? {
+        val avifData = if (options.needsSearch) {
+            convertWithAdaptiveCompression(input, options)
+        } else {
+            when (val source = loadSource(input, options.preserveMetadata, options.maxDimension)) {
+                is SourceImage.Avif -> source.data
+                is SourceImage.Pixels -> {
+                    if (handle == 0L) {
+                        encodeBitmapToAvif(source.bitmap, options, source.orientation, source.exif, source.icc)
+                    } else {
+                        val directBitmap = toArgb8888(source.bitmap)
+                            ?: throw AvifError.EncodingFailed("Unsupported bitmap config: ${source.bitmap.config}")
+                        try {
+                            // Blocks while the encode queue is full
+                            val submitted = nativeBatchSubmit(
+                                handle, index, directBitmap, source.orientation, source.exif, source.icc,
+                                outputPath
+                            )
+                            if (!submitted) {
+                                throw AvifError.EncodingFailed("Failed to convert batch item $index")
+                            }
+                        } finally {
+                            if (directBitmap !== source.bitmap) {
+                                directBitmap.recycle()
+                            }
+                            // The queued YUV copy replaces decoded sources; caller bitmaps are left alone
+                            if (input !is ImageInput.FromBitmap) {
+                                source.bitmap.recycle()
+                            }
+                        }
+                        return null
+                    }
+                }
+            }
+        }
+
+        File(outputPath).writeBytes(avifData)
+        return avifData.size.toLong()
+    }
+
+    private suspend fun convertStandard(
+        input: ImageInput,
+        options: EncodingOptions
+    ): ByteArray = when (val source = loadSource(input, options.preserveMetadata, options.maxDimension)) {
+        is SourceImage.Avif -> source.data
+        is SourceImage.Pixels -> encodeBitmapToAvif(source.bitmap, options, source.orientation, source.exif, source.icc)
+    }
+
+    /**
+     * Run a native encode that writes straight to disk
+     *
+     * [encodeToFile] receives an ARGB_8888 view of [bitmap] and returns the number of
+     * bytes written or -1. Returns -1 when the native path is unavailable or fails
+     * (e.g. placeholder build), so the caller can fall back to a byte array.
+     */
+    private fun encodeBitmapNatively(bitmap: Bitmap, encodeToFile: (Bitmap) -> Long): Long {
+        if (!nativeLibraryLoaded) return -1
+        val directBitmap = toArgb8888(bitmap) ?: return -1
         try {
-            // Resize if needed
-            val resizedBitmap = options.maxDimension?.let { maxDim ->
-                resizeBitmap(bitmap, maxDim)
-            } ?: bitmap
+            val written = encodeToFile(directBitmap)
+            Log.d(TAG, "Native encode to file: ${directBitmap.width}x${directBitmap.height}, $written bytes")
+            return written
+        } catch (e: OutOfMemoryError) {
+            Log.e(TAG, "OutOfMemoryError during AVIF encoding to file", e)
+            throw AvifError.OutOfMemory
+        } finally {
+            if (directBitmap !== bitmap) {
+                directBitmap.recycle()
+            }
+        }
+    }
 
+    /**
+     * Encode [bitmap] (in sensor order) to AVIF
+     *
+     * [orientation] is written as irot/imir and [exif] (or null) as Exif metadata,
+     * so rotated photos are encoded without a rotated copy of the frame. [icc] (or
+     * null) is written as the colour profile.
+     */
+    private fun encodeBitmapToAvif(
+        bitmap: Bitmap,
+        options: EncodingOptions,
+        orientation: Int = ExifInterface.ORIENTATION_NORMAL,
+        exif: ByteArray? = null,
+        icc: ByteArray? = null
+    ): ByteArray {
+        try {
             if (!nativeLibraryLoaded) {
                 // Fallback: encode as JPEG if native library not loaded
+                // JPEG has no transform properties, so the orientation is baked in here
                 Log.w(TAG, "Native library not loaded, using JPEG fallback")
+                val orientedBitmap = rotateImageIfRequired(bitmap, orientation)
+                val resizedBitmap = options.maxDimension?.let { maxDim ->
+                    resizeBitmap(orientedBitmap, maxDim)
+                } ?: orientedBitmap
                 val stream = java.io.ByteArrayOutputStream()
                 resizedBitmap.compress(Bitmap.CompressFormat.JPEG, options.quality, stream)
                 return stream.toByteArray()
             }
 
-            // Convert bitmap to byte array
-            val pixels = bitmapToByteArray(resizedBitmap)
-
-            // Get subsample value (0=444, 1=422, 2=420)
-            val subsampleValue = when (options.subsample) {
-                ChromaSubsample.YUV444 -> 0
-                ChromaSubsample.YUV422 -> 1
-                ChromaSubsample.YUV420 -> 2
+            // maxDimension is applied natively, fused with RGB->YUV (0 = no limit)
+            val maxDimension = options.maxDimension ?: 0
+
+            // Encode straight from the bitmap's pixel memory when possible
+            val directBitmap = toArgb8888(bitmap)
+            val encoded = directBitmap?.let {
+                nativeEncodeBitmap(
+                    it,
+                    options.quality,
+                    options.alphaQuality,
+                    options.speed,
+                    options.subsample.toNativeValue(),
+                    options.lossless,
+                    maxDimension,
+                    orientation,
+                    exif,
+                    icc
+                )
             }
+            if (directBitmap != null && directBitmap !== bitmap) {
+                directBitmap.recycle()
+            }
+            encoded?.let { return it }
+
+            // Fallback: convert bitmap to byte array
+            // (also the placeholder build's mock encoder path)
+            val pixels = bitmapToByteArray(bitmap)
 
             // Encode using native method (works with or without libavif)
             return nativeEncode(
                 pixels,
-                resizedBitmap.width,
-                resizedBitmap.height,
+                bitmap.width,
+                bitmap.height,
                 options.quality,
+                options.alphaQuality,
                 options.speed,
-                subsampleValue
+                options.subsample.toNativeValue(),
+                options.lossless,
+                maxDimension,
+                orientation,
+                exif,
+                icc
             ) ?: throw AvifError.EncodingFailed("Native encoding failed")
         } catch (e: OutOfMemoryError) {
             Log.e(TAG, "OutOfMemoryError during AVIF encoding", e)
@@ -524,12 +2221,7 @@ actual class AvifConverter {
                 throw AvifError.DecodingFailed("Native decoding failed: ${e.message}")
             }
 
-            return Bitmap.createBitmap(
-                decoded.pixels,
-                decoded.width,
-                decoded.height,
-                Bitmap.Config.ARGB_8888
-            )
+            return decoded.toBitmap()
         } catch (e: OutOfMemoryError) {
             Log.e(TAG, "OutOfMemoryError during AVIF decoding", e)
             throw AvifError.OutOfMemory
@@ -542,6 +2234,99 @@ actual class AvifConverter {
         }
     }
 
+    /**
+     * Decode a file through nativeDecodeFd
+     * Returns null when the native path is unavailable (no native library, placeholder
+     * build, missing file) so callers can fall back to reading the bytes.
+     */
+    private fun decodeAvifFromPath(
+        path: String,
+        targetWidth: Int,
+        targetHeight: Int,
+        sampleSize: Int,
+        filter: ResizeFilter
+    ): Bitmap? {
+        val file = File(path)
+        if (!nativeLibraryLoaded || !file.isFile) return null
+        return ParcelFileDescriptor.open(file, ParcelFileDescriptor.MODE_READ_ONLY).use { descriptor ->
+            decodeAvifFromFd(descriptor, targetWidth, targetHeight, sampleSize, filter)
+        }
+    }
+
+    private fun decodeAvifFromFd(
+        descriptor: ParcelFileDescriptor,
+        targetWidth: Int,
+        targetHeight: Int,
+        sampleSize: Int,
+        filter: ResizeFilter
+    ): Bitmap? {
+        try {
+            val decoded = nativeDecodeFd(
+                descriptor.fd,
+                targetWidth,
+                targetHeight,
+                sampleSize,
+                filter.toNativeValue()
+            ) ?: return null
+            Log.d(TAG, "nativeDecodeFd succeeded: ${decoded.width}x${decoded.height}")
+            return decoded.toBitmap()
+        } catch (e: OutOfMemoryError) {
+            Log.e(TAG, "OutOfMemoryError during file descriptor AVIF decoding", e)
+            throw AvifError.OutOfMemory
+        }
+    }
+
+    private fun decodeAvifScaled(
+        avifData: ByteArray,
+        targetWidth: Int,
+        targetHeight: Int,
+        sampleSize: Int,
+        filter: ResizeFilter
+    ): Bitmap {
+        if (!nativeLibraryLoaded) {
+            throw AvifError.DecodingFailed("Native library not loaded")
+        }
+
+        try {
+            val decoded = nativeDecodeScaled(
+                avifData,
+                targetWidth,
+                targetHeight,
+                sampleSize,
+                filter.toNativeValue()
+            ) ?: throw AvifError.DecodingFailed("Native scaled decoding failed")
+            Log.d(TAG, "nativeDecodeScaled succeeded: ${decoded.width}x${decoded.height}")
+            return decoded.toBitmap()
+        } catch (e: OutOfMemoryError) {
+            Log.e(TAG, "OutOfMemoryError during scaled AVIF decoding", e)
+            throw AvifError.OutOfMemory
+        }
+    }
+
+    /**
+     * Android-only. Cap the codec threads shared by every encode and decode in the process
+     *
+     * Each conversion leases a share of one process-wide budget (by default the
+     * cores this process may use, counting little cores at half), so running
+     * several conversions in parallel splits the cores instead of oversubscribing
+     * them. Lower the cap to leave room for other work; applies to conversions
+     * started afterwards.
+     *
+     * @param maxThreads Maximum codec threads, or 0 to restore the detected budget
+     * @return The budget now in effect (0 if the native library is not loaded)
+     */
+    fun setMaxCodecThreads(maxThreads: Int): Int {
+        require(maxThreads >= 0) { "maxThreads must not be negative" }
+        return if (nativeLibraryLoaded) nativeSetThreadBudget(maxThreads) else 0
+    }
+
+    /**
+     * Android-only. Codec threads currently shared by all conversions in the process
+     * (0 if the native library is not loaded)
+     */
+    fun getCodecThreadBudget(): Int =
+        if (nativeLibraryLoaded) nativeGetThreadBudget() else 0
+
     /**
      * Get the version of the native library
      * Useful for debugging whether libavif is integrated
@@ -558,20 +2343,20 @@ actual class AvifConverter {
         }
     }
 
-    private fun bitmapToByteArray(bitmap: Bitmap): ByteArray {
-        val pixels = IntArray(bitmap.width * bitmap.height)
-        bitmap.getPixels(pixels, 0, bitmap.width, 0, 0, bitmap.width, bitmap.height)
+    private fun isRgba1010102(config: Bitmap.Config?): Boolean =
+        Build.VERSION.SDK_INT >= Build.VERSION_CODES.TIRAMISU && config == Bitmap.Config.RGBA_1010102
 
-        // Convert to byte array (RGBA format)
-        return ByteArray(pixels.size * 4).apply {
-            pixels.forEachIndexed { i, pixel ->
-                this[i * 4] = (pixel shr 16 and 0xFF).toByte()     // R
-                this[i * 4 + 1] = (pixel shr 8 and 0xFF).toByte()  // G
-                this[i * 4 + 2] = (pixel and 0xFF).toByte()        // B
-                this[i * 4 + 3] = (pixel shr 24 and 0xFF).toByte() // A
-            }
+    /**
+     * Exif orientation for a camera's clockwise display rotation
+     */
+    private fun exifOrientationForRotation(rotationDegrees: Int): Int =
+        when (Math.floorMod(rotationDegrees, 360)) {
+            0 -> ExifInterface.ORIENTATION_NORMAL
+            90 -> ExifInterface.ORIENTATION_ROTATE_90
+            180 -> ExifInterface.ORIENTATION_ROTATE_180
+            270 -> ExifInterface.ORIENTATION_ROTATE_270
+            else -> throw AvifError.InvalidInput
         }
-    }
 
     private fun resizeBitmap(bitmap: Bitmap, maxDimension: Int): Bitmap {
         val width = bitmap.width
@@ -589,13 +2374,24 @@ actual class AvifConverter {
     }
 
     private fun isAvifFormat(data: ByteArray): Boolean {
-        // Check AVIF file signature
-        return data.size > 12 &&
-                data.sliceArray(4..11).contentEquals(
-                    byteArrayOf(0x66, 0x74, 0x79, 0x70, 0x61, 0x76, 0x69, 0x66)
-                )
+        // ftyp box first, with avif (still) or avis (sequence) as major or compatible brand
+        if (data.size < 16 || readBoxInt(data, 4) != FTYP) return false
+        val boxEnd = minOf(readBoxInt(data, 0).toLong() and 0xFFFFFFFFL, data.size.toLong()).toInt()
+        var offset = 8
+        while (offset + 4 <= boxEnd) {
+            val brand = readBoxInt(data, offset)
+            if (offset != 12 && (brand == BRAND_AVIF || brand == BRAND_AVIS)) return true
+            offset += 4
+        }
+        return false
     }
 
+    private fun readBoxInt(data: ByteArray, offset: Int): Int =
+        ((data[offset].toInt() and 0xFF) shl 24) or
+                ((data[offset + 1].toInt() and 0xFF) shl 16) or
+                ((data[offset + 2].toInt() and 0xFF) shl 8) or
+                (data[offset + 3].toInt() and 0xFF)
+
     private fun detectFormat(data: ByteArray): ImageFormat {
         if (data.size < 12) return ImageFormat.UNKNOWN
 
@@ -622,37 +2418,118 @@ actual class AvifConverter {
     }
 
     /**
-     * Apply EXIF orientation transformation to bitmap from byte array
-     * This ensures portrait photos display correctly after conversion
+     * Read the EXIF orientation from image bytes (ORIENTATION_NORMAL if absent or unreadable)
      */
-    private fun applyExifOrientation(bitmap: Bitmap, imageData: ByteArray): Bitmap {
+    private fun readExifOrientation(imageData: ByteArray): Int {
         return try {
-            val exif = ExifInterface(ByteArrayInputStream(imageData))
-            val orientation = exif.getAttributeInt(
+            ExifInterface(ByteArrayInputStream(imageData)).getAttributeInt(
                 ExifInterface.TAG_ORIENTATION,
                 ExifInterface.ORIENTATION_NORMAL
             )
-            rotateImageIfRequired(bitmap, orientation)
         } catch (e: Exception) {
             Log.w(TAG, "Failed to read EXIF orientation from byte array", e)
-            bitmap // Return original bitmap if EXIF reading fails
+            ExifInterface.ORIENTATION_NORMAL
         }
     }
 
     /**
-     * Apply EXIF orientation transformation to bitmap from file path
+     * Read the EXIF orientation from a file (ORIENTATION_NORMAL if absent or unreadable)
      */
-    private fun applyExifOrientationFromFile(bitmap: Bitmap, filePath: String): Bitmap {
+    private fun readExifOrientationFromFile(filePath: String): Int {
         return try {
-            val exif = ExifInterface(filePath)
-            val orientation = exif.getAttributeInt(
+            ExifInterface(filePath).getAttributeInt(
                 ExifInterface.TAG_ORIENTATION,
                 ExifInterface.ORIENTATION_NORMAL
             )
-            rotateImageIfRequired(bitmap, orientation)
         } catch (e: Exception) {
             Log.w(TAG, "Failed to read EXIF orientation from file: $filePath", e)
-            bitmap // Return original bitmap if EXIF reading fails
+            ExifInterface.ORIENTATION_NORMAL
+        }
+    }
+
+    /**
+     * Extract the raw Exif block (from the TIFF header on, the layout AVIF stores) and
+     * the ICC profile of a JPEG
+     * Returns null for other formats; either field is null when the JPEG lacks it.
+     */
+    private fun readJpegMetadata(imageData: ByteArray): JpegMetadata? =
+        readJpegMetadata(ByteArrayInputStream(imageData))
+
+    private fun readJpegMetadataFromFile(filePath: String): JpegMetadata? = try {
+        File(filePath).inputStream().buffered().use { readJpegMetadata(it) }
+    } catch (e: IOException) {
+        Log.w(TAG, "Failed to read JPEG metadata from file: $filePath", e)
+        null
+    }
+
+    /**
+     * Walk the JPEG marker segments up to the first scan, collecting APP1 "Exif\0\0"
+     * and the APP2 "ICC_PROFILE\0" chunks
+     * Only the header segments are read, never the entropy-coded data. A profile with
+     * missing or duplicate chunks is dropped.
+     */
+    private fun readJpegMetadata(stream: InputStream): JpegMetadata? {
+        val input = DataInputStream(stream)
+        var exif: ByteArray? = null
+        val iccChunks = HashMap<Int, ByteArray>()
+        var iccChunkCount = 0
+        try {
+            if (input.readUnsignedByte() != 0xFF || input.readUnsignedByte() != JPEG_SOI) return null
+            while (true) {
+                if (input.readUnsignedByte() != 0xFF) break
+                var marker = input.readUnsignedByte()
+                while (marker == 0xFF) marker = input.readUnsignedByte()  // fill bytes
+                if (marker == JPEG_SOS || marker == JPEG_EOI) break
+                if (marker == 0x01 || marker in 0xD0..0xD7) continue  // no length field
+
+                val length = input.readUnsignedShort() - 2
+                if (length < 0) break
+                if (marker == JPEG_APP1 && exif == null && length > EXIF_HEADER.size) {
+                    val segment = ByteArray(length)
+                    input.readFully(segment)
+                    if (segment.startsWith(EXIF_HEADER)) {
+                        exif = segment.copyOfRange(EXIF_HEADER.size, segment.size)
+                    }
+                } else if (marker == JPEG_APP2 && length > ICC_HEADER.size + 2) {
+                    val segment = ByteArray(length)
+                    input.readFully(segment)
+                    if (segment.startsWith(ICC_HEADER)) {
+                        // 1-based chunk number, then the chunk count
+                        val sequence = segment[ICC_HEADER.size].toInt() and 0xFF
+                        iccChunkCount = segment[ICC_HEADER.size + 1].toInt() and 0xFF
+                        iccChunks[sequence] = segment.copyOfRange(ICC_HEADER.size + 2, segment.size)
+                    }
+                } else {
+                    input.skipFully(length)
+                }
+            }
+        } catch (e: IOException) {
+            // Truncated; keep whatever was complete
+        }
+
+        val icc = if (iccChunkCount > 0 && iccChunks.size == iccChunkCount &&
+            (1..iccChunkCount).all { it in iccChunks }
+        ) {
+            (1..iccChunkCount).fold(ByteArray(0)) { profile, sequence -> profile + iccChunks.getValue(sequence) }
+        } else {
+            null
+        }
+        return JpegMetadata(exif, icc)
+    }
+
+    private fun ByteArray.startsWith(prefix: ByteArray): Boolean =
+        size >= prefix.size && prefix.indices.all { this[it] == prefix[it] }
+
+    private fun DataInputStream.skipFully(count: Int) {
+        var remaining = count
+        while (remaining > 0) {
+            val skipped = skipBytes(remaining)
+            if (skipped <= 0) {
+                readUnsignedByte()  // throws EOFException at the end of the stream
+                remaining--
+            } else {
+                remaining -= skipped
+            }
         }
     }
 
@@ -0,0 +1,170 @@
+package com.alfikri.rizky.avifkit
+
+import android.graphics.Bitmap
+import android.util.Log
+import java.io.Closeable
+import java.nio.ByteBuffer
+
+/**
+ * Reusable native encode/decode session
+ *
+ * Keeps the libavif decoder, the resolved codec and scratch buffers alive across
+ * calls, which removes per-image setup and teardown when processing many small
+ * images (e.g. a thumbnail feed). Calls on one session are serialized; use one
+ * session per worker for parallelism. Always [close] the session when done.
+ *
+ * Only quality, speed and subsample of [options] apply; resizing and size targets
+ * are handled by [AvifConverter].
+ *
+ * @throws AvifError.Unknown if the native library or libavif is not available
+ */
+class AvifSession(options: EncodingOptions = EncodingOptions()) : Closeable {
+
+    private external fun nativeCreateSession(
+        quality: Int,
+        speed: Int,
+        subsample: Int
+    ): Long
+
+    private external fun nativeSessionEncode(
+        handle: Long,
+        bitmap: Bitmap
+    ): ByteArray?
+
+    private external fun nativeSessionDecode(
+        handle: Long,
+        avifData: ByteArray
+    ): DecodedImage?
+
+    private external fun nativeSessionDecodeIntoBitmap(
+        handle: Long,
+        avifData: ByteArray,
+        bitmap: Bitmap
+    ): Boolean
+
+    private external fun nativeSessionDecodeIntoBuffer(
+        handle: Long,
+        avifData: ByteArray,
+        buffer: ByteBuffer,
+        rowBytes: Int,
+        channelOrder: Int,
+        outInfo: IntArray
+    ): Boolean
+
+    private external fun nativeCloseSession(handle: Long)
+
+    private var handle: Long = 0
+
+    init {
+        // Touching AvifConverter loads the native library
+        if (!AvifConverter.isNativeLibraryLoaded()) {
+            throw AvifError.Unknown("Native library not loaded")
+        }
+        handle = nativeCreateSession(options.quality, options.speed, options.subsample.toNativeValue())
+        if (handle == 0L) {
+            throw AvifError.Unknown("Failed to create AVIF session (libavif not available)")
+        }
+    }
+
+    /**
+     * Encode a Bitmap to AVIF with the session settings
+     *
+     * ARGB_8888 bitmaps are converted straight from their pixel memory; other
+     * configs are copied to ARGB_8888 first.
+     */
+    @Synchronized
+    fun encode(bitmap: Bitmap): ByteArray {
+        val currentHandle = checkOpen()
+        val directBitmap = toArgb8888(bitmap) ?: throw AvifError.EncodingFailed("Failed to copy bitmap to ARGB_8888")
+        try {
+            return nativeSessionEncode(currentHandle, directBitmap)
+                ?: throw AvifError.EncodingFailed("Native session encoding failed")
+        } catch (e: OutOfMemoryError) {
+            Log.e(TAG, "OutOfMemoryError during session encode", e)
+            throw AvifError.OutOfMemory
+        } finally {
+            if (directBitmap !== bitmap) {
+                directBitmap.recycle()
+            }
+        }
+    }
+
+    /**
+     * Decode AVIF data to an ARGB_8888 Bitmap
+     */
+    @Synchronized
+    fun decode(avifData: ByteArray): Bitmap {
+        val currentHandle = checkOpen()
+        try {
+            val decoded = nativeSessionDecode(currentHandle, avifData)
+                ?: throw AvifError.DecodingFailed("Native session decoding failed")
+            return decoded.toBitmap()
+        } catch (e: OutOfMemoryError) {
+            Log.e(TAG, "OutOfMemoryError during session decode", e)
+            throw AvifError.OutOfMemory
+        }
+    }
+
+    /**
+     * Decode AVIF data straight into an existing mutable Bitmap
+     *
+     * No intermediate pixel arrays are allocated; reusing one bitmap across frames keeps
+     * peak memory at a single image. The bitmap is reconfigured when the size changes.
+     */
+    @Synchronized
+    fun decodeInto(avifData: ByteArray, target: Bitmap): Bitmap {
+        val currentHandle = checkOpen()
+        if (!target.isMutable) {
+            throw AvifError.InvalidInput
+        }
+        if (!nativeSessionDecodeIntoBitmap(currentHandle, avifData, target)) {
+            throw AvifError.DecodingFailed("Native session decoding into bitmap failed")
+        }
+        return target
+    }
+
+    /**
+     * Decode AVIF data straight into a direct ByteBuffer
+     *
+     * @return ImageInfo describing the decoded image
+     */
+    @Synchronized
+    fun decodeInto(
+        avifData: ByteArray,
+        buffer: ByteBuffer,
+        rowBytes: Int,
+        channelOrder: ChannelOrder = ChannelOrder.RGBA
+    ): ImageInfo {
+        val currentHandle = checkOpen()
+        if (!buffer.isDirect) {
+            throw AvifError.InvalidInput
+        }
+        val info = IntArray(3)
+        val success = nativeSessionDecodeIntoBuffer(
+            currentHandle,
+            avifData,
+            buffer,
+            rowBytes,
+            channelOrder.toNativeValue(),
+            info
+        )
+        return decodeIntoBufferResult(success, info, buffer, rowBytes, channelOrder)
+    }
+
+    @Synchronized
+    override fun close() {
+        if (handle != 0L) {
+            nativeCloseSession(handle)
+            handle = 0
+        }
+    }
+
+    private fun checkOpen(): Long {
+        if (handle == 0L) throw AvifError.Unknown("AVIF session is closed")
+        return handle
+    }
+
+    private companion object {
+        const val TAG = "AvifSession"
+    }
+}
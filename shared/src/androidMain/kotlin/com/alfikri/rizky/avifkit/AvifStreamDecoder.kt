@@ -0,0 +1,170 @@
+package com.alfikri.rizky.avifkit
+
+import android.graphics.Bitmap
+import android.util.Log
+import java.io.Closeable
+
+/**
+ * Incremental decoder for AVIF data that arrives in chunks (e.g. a slow download)
+ *
+ * Feed bytes with [append] as they arrive and call [finish] after the last chunk.
+ * The header is parsed as soon as enough bytes are present ([width] and [height]
+ * become non-zero), and grid images (large photos are usually stored as grids)
+ * are decoded cell row by cell row, so [decodedRows] grows while data is still
+ * arriving and [bitmap] can paint the top of the image early. Non-grid images
+ * become available all at once when their data is complete.
+ *
+ * The bitmap is in display orientation (irot/imir applied, as in
+ * [AvifConverter.decodeAvif]). Rows are decoded in stored order, so for rotated
+ * or transposed images the painted area grows from another edge, or column by column.
+ *
+ * Calls are serialized; always [close] the decoder when done.
+ *
+ * @param expectedSize Total size in bytes if known (e.g. Content-Length), or 0
+ * @throws AvifError.DecodingFailed if the native library or libavif is not available
+ */
+class AvifStreamDecoder(expectedSize: Long = 0) : Closeable {
+
+    private external fun nativeCreate(expectedSize: Long): Long
+
+    private external fun nativeAppend(
+        handle: Long,
+        bytes: ByteArray?,
+        offset: Int,
+        length: Int,
+        endOfStream: Boolean,
+        outInfo: IntArray
+    ): Int
+
+    /** Returns the stored rows from the top that are final (may be below toRow), or -1 on failure */
+    private external fun nativeDrawRows(handle: Long, bitmap: Bitmap, fromRow: Int, toRow: Int): Int
+
+    private external fun nativeClose(handle: Long)
+
+    private var handle: Long = 0
+    private val info = IntArray(5)
+    private var target: Bitmap? = null
+    private var paintedRows = 0
+
+    /** Displayed image width, or 0 until the header has arrived */
+    var width: Int = 0
+        private set
+
+    /** Displayed image height, or 0 until the header has arrived */
+    var height: Int = 0
+        private set
+
+    /** Rows the image is stored in; [height] unless the orientation swaps the axes */
+    var totalRows: Int = 0
+        private set
+
+    /** Whether the image has an alpha channel (valid once [width] is non-zero) */
+    var hasAlpha: Boolean = false
+        private set
+
+    /** Stored rows from the top that are fully decoded (up to [totalRows]) */
+    var decodedRows: Int = 0
+        private set
+
+    /** Whether the whole image has been decoded */
+    var isComplete: Boolean = false
+        private set
+
+    init {
+        // Touching AvifConverter loads the native library
+        if (!AvifConverter.isNativeLibraryLoaded()) {
+            throw AvifError.DecodingFailed("Native library not loaded")
+        }
+        handle = nativeCreate(expectedSize)
+        if (handle == 0L) {
+            throw AvifError.DecodingFailed("Failed to create AVIF stream decoder (libavif not available)")
+        }
+    }
+
+    /**
+     * Append the next chunk and decode as far as the data received so far allows
+     *
+     * @return Number of decoded rows after this chunk
+     * @throws AvifError.DecodingFailed if the data is not a valid AVIF image
+     */
+    @Synchronized
+    fun append(bytes: ByteArray, offset: Int = 0, length: Int = bytes.size - offset): Int {
+        if (offset < 0 || length < 0 || offset + length > bytes.size) throw AvifError.InvalidInput
+        return update(nativeAppend(checkOpen(), bytes, offset, length, false, info))
+    }
+
+    /**
+     * Signal that all data has been appended and finish decoding
+     *
+     * @throws AvifError.DecodingFailed if the data is truncated or invalid
+     */
+    @Synchronized
+    fun finish() {
+        update(nativeAppend(checkOpen(), null, 0, 0, true, info))
+        if (!isComplete) {
+            throw AvifError.DecodingFailed("AVIF data ended before the image was complete")
+        }
+    }
+
+    /**
+     * The image decoded so far, or null before any row is available
+     *
+     * Rows decoded since the previous call are converted into one bitmap owned by
+     * this decoder; the part not decoded yet is transparent. The same bitmap is
+     * returned on every call, so copy it if it must outlive the decoder.
+     */
+    @Synchronized
+    fun bitmap(): Bitmap? {
+        val currentHandle = checkOpen()
+        if (decodedRows == 0) return null
+        val bitmap = target ?: try {
+            Bitmap.createBitmap(width, height, Bitmap.Config.ARGB_8888).also { target = it }
+        } catch (e: OutOfMemoryError) {
+            Log.e(TAG, "OutOfMemoryError allocating stream bitmap", e)
+            throw AvifError.OutOfMemory
+        }
+
+        if (decodedRows > paintedRows) {
+            // The last rows drawn before the rest arrives are redrawn next time (chroma context)
+            val finalRows = nativeDrawRows(currentHandle, bitmap, paintedRows, decodedRows)
+            if (finalRows < 0) {
+                throw AvifError.DecodingFailed("Failed to convert rows $paintedRows..$decodedRows")
+            }
+            paintedRows = finalRows
+        }
+        return bitmap
+    }
+
+    @Synchronized
+    override fun close() {
+        if (handle != 0L) {
+            nativeClose(handle)
+            handle = 0
+        }
+        target = null
+    }
+
+    private fun update(state: Int): Int {
+        if (state == STATE_FAILED) {
+            throw AvifError.DecodingFailed("Failed to decode AVIF stream")
+        }
+        width = info[0]
+        height = info[1]
+        decodedRows = info[2]
+        hasAlpha = info[3] != 0
+        totalRows = info[4]
+        isComplete = state == STATE_COMPLETE
+        return decodedRows
+    }
+
+    private fun checkOpen(): Long {
+        if (handle == 0L) throw AvifError.Unknown("AVIF stream decoder is closed")
+        return handle
+    }
+
+    private companion object {
+        const val TAG = "AvifStreamDecoder"
+        const val STATE_COMPLETE = 1
+        const val STATE_FAILED = -1
+    }
+}
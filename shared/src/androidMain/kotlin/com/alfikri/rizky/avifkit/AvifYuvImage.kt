@@ -0,0 +1,155 @@
+package com.alfikri.rizky.avifkit
+
+import android.os.ParcelFileDescriptor
+import java.io.Closeable
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * A decoded AVIF image kept in its coded YUV form, for GPU and video consumers
+ *
+ * Decoding stops before YUV -> RGB conversion, the most expensive CPU stage of a
+ * regular decode. The planes are direct ByteBuffers over the decoder's own memory
+ * (no copy), ready for texture upload or a MediaCodec input. Samples are 8-bit,
+ * or little-endian uint16 when [depth] is above 8; strides are in bytes.
+ *
+ * The buffers are only valid until [close]: the memory is freed then, and reading
+ * a buffer afterwards is undefined behaviour. Always [close] the image when done.
+ * Pixels are in stored orientation; rotate by [orientation] when displaying.
+ *
+ * @throws AvifError.DecodingFailed if the data cannot be decoded or libavif is not available
+ */
+class AvifYuvImage private constructor() : Closeable {
+
+    private external fun nativeOpen(avifData: ByteArray): Long
+
+    private external fun nativeOpenFd(fd: Int): Long
+
+    private external fun nativeGetInfo(handle: Long, outInfo: IntArray): Boolean
+
+    private external fun nativePlane(handle: Long, channel: Int): ByteBuffer?
+
+    private external fun nativeClose(handle: Long)
+
+    private var handle: Long = 0
+
+    /** Image width in pixels */
+    var width: Int = 0
+        private set
+
+    /** Image height in pixels */
+    var height: Int = 0
+        private set
+
+    /** Bits per sample (8, 10 or 12) */
+    var depth: Int = 8
+        private set
+
+    /** Chroma subsampling of the U and V planes, or null for monochrome images (no chroma planes) */
+    var subsample: ChromaSubsample? = null
+        private set
+
+    /** Whether samples span the full range rather than the limited (studio) range */
+    var fullRange: Boolean = false
+        private set
+
+    /** CICP colour primaries code (1 = BT.709, 9 = BT.2020, 2 = unspecified) */
+    var colorPrimaries: Int = 0
+        private set
+
+    /** CICP transfer characteristics code (13 = sRGB, 16 = PQ, 18 = HLG) */
+    var transferCharacteristics: Int = 0
+        private set
+
+    /** CICP matrix coefficients code (1 = BT.709, 6 = BT.601, 9 = BT.2020, 0 = identity/GBR) */
+    var matrixCoefficients: Int = 0
+        private set
+
+    /** Whether the color planes are premultiplied by [a] */
+    var alphaPremultiplied: Boolean = false
+        private set
+
+    /** Exif orientation (from irot/imir, else the Exif payload) needed to display the image upright */
+    var orientation: Int = 1
+        private set
+
+    /** Luma plane */
+    lateinit var y: YuvPlane
+        private set
+
+    /** Cb plane, or null for monochrome images */
+    var u: YuvPlane? = null
+        private set
+
+    /** Cr plane, or null for monochrome images */
+    var v: YuvPlane? = null
+        private set
+
+    /** Alpha plane (full size, same depth as the color planes), or null if the image is opaque */
+    var a: YuvPlane? = null
+        private set
+
+    /**
+     * Decode an AVIF held in memory (copied once into native memory)
+     */
+    constructor(avifData: ByteArray) : this() {
+        open { nativeOpen(avifData) }
+    }
+
+    /**
+     * Decode an AVIF from a file descriptor
+     * The descriptor is duplicated, so the caller may close theirs afterwards.
+     */
+    constructor(descriptor: ParcelFileDescriptor) : this() {
+        open { nativeOpenFd(descriptor.fd) }
+    }
+
+    private inline fun open(openNative: () -> Long) {
+        // Touching AvifConverter loads the native library
+        if (!AvifConverter.isNativeLibraryLoaded()) {
+            throw AvifError.DecodingFailed("Native library not loaded")
+        }
+        handle = openNative()
+        if (handle == 0L) {
+            throw AvifError.DecodingFailed("Failed to decode AVIF to YUV")
+        }
+        val info = IntArray(14)
+        nativeGetInfo(handle, info)
+        width = info[0]
+        height = info[1]
+        depth = info[2]
+        subsample = chromaSubsampleFromNative(info[3])
+        fullRange = info[4] != 0
+        colorPrimaries = info[5]
+        transferCharacteristics = info[6]
+        matrixCoefficients = info[7]
+        alphaPremultiplied = info[9] != 0
+        orientation = info[10]
+
+        val sampleBytes = if (depth > 8) 2 else 1
+        fun plane(channel: Int, rowStride: Int): YuvPlane? =
+            nativePlane(handle, channel)?.let { YuvPlane(it.order(ByteOrder.LITTLE_ENDIAN), rowStride, sampleBytes) }
+        y = plane(0, info[11]) ?: run {
+            close()
+            throw AvifError.DecodingFailed("Decoded image has no luma plane")
+        }
+        u = plane(1, info[12])
+        v = plane(2, info[12])
+        a = if (info[8] != 0) plane(3, info[13]) else null
+    }
+
+    /**
+     * Whether the planes are still valid
+     */
+    @get:Synchronized
+    val isOpen: Boolean
+        get() = handle != 0L
+
+    @Synchronized
+    override fun close() {
+        if (handle != 0L) {
+            nativeClose(handle)
+            handle = 0
+        }
+    }
+}
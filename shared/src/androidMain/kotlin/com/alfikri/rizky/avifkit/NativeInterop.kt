@@ -0,0 +1,219 @@
+package com.alfikri.rizky.avifkit
+
+import android.graphics.Bitmap
+import android.graphics.ColorSpace
+import android.os.Build
+import androidx.annotation.RequiresApi
+
+/**
+ * Conversions between Kotlin types and the layouts the native library expects,
+ * shared by AvifConverter and AvifSession
+ */
+
+/**
+ * Native subsample value (0=444, 1=422, 2=420)
+ */
+internal fun ChromaSubsample.toNativeValue(): Int = when (this) {
+    ChromaSubsample.YUV444 -> 0
+    ChromaSubsample.YUV422 -> 1
+    ChromaSubsample.YUV420 -> 2
+}
+
+/**
+ * ChromaSubsample for a native subsample value (null for monochrome or unknown)
+ */
+internal fun chromaSubsampleFromNative(value: Int): ChromaSubsample? = when (value) {
+    0 -> ChromaSubsample.YUV444
+    1 -> ChromaSubsample.YUV422
+    2 -> ChromaSubsample.YUV420
+    else -> null
+}
+
+/**
+ * Native channel order value (0=RGBA, 1=BGRA, 2=ARGB, 3=ABGR, 4=RGB, 5=BGR)
+ */
+internal fun ChannelOrder.toNativeValue(): Int = when (this) {
+    ChannelOrder.RGBA -> 0
+    ChannelOrder.BGRA -> 1
+    ChannelOrder.ARGB -> 2
+    ChannelOrder.ABGR -> 3
+    ChannelOrder.RGB -> 4
+    ChannelOrder.BGR -> 5
+}
+
+/**
+ * Native resize filter value (0=AUTO, 1=AREA, 2=LANCZOS3)
+ */
+internal fun ResizeFilter.toNativeValue(): Int = when (this) {
+    ResizeFilter.AUTO -> 0
+    ResizeFilter.AREA -> 1
+    ResizeFilter.LANCZOS3 -> 2
+}
+
+/**
+ * Native YUV layout value (0=I420, 1=NV12, 2=NV21)
+ */
+internal fun YuvLayout.toNativeValue(): Int = when (this) {
+    YuvLayout.I420 -> 0
+    YuvLayout.NV12 -> 1
+    YuvLayout.NV21 -> 2
+}
+
+/**
+ * Native YUV matrix value (0=BT.601, 1=BT.709, 2=BT.2020)
+ */
+internal fun YuvMatrix.toNativeValue(): Int = when (this) {
+    YuvMatrix.BT601 -> 0
+    YuvMatrix.BT709 -> 1
+    YuvMatrix.BT2020 -> 2
+}
+
+/**
+ * Bitmap config for a high-bit-depth format, or null when this release lacks it
+ * (RGBA_1010102 needs API 33, RGBA_F16 API 26)
+ */
+internal fun HighBitDepthFormat.toBitmapConfig(): Bitmap.Config? = when (this) {
+    HighBitDepthFormat.RGBA_1010102 ->
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.TIRAMISU) Bitmap.Config.RGBA_1010102 else null
+    HighBitDepthFormat.RGBA_F16 ->
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.O) Bitmap.Config.RGBA_F16 else null
+}
+
+/**
+ * CICP colour primaries and transfer characteristics written for a ColorSpace
+ * Spaces AVIF has no code for are tagged as sRGB.
+ */
+@RequiresApi(Build.VERSION_CODES.O)
+internal fun ColorSpace.toCicp(): Pair<Int, Int> {
+    if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.TIRAMISU && this == ColorSpace.get(ColorSpace.Named.BT2020_PQ)) {
+        return CICP_BT2020 to CICP_TRANSFER_PQ
+    }
+    if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.UPSIDE_DOWN_CAKE && this == ColorSpace.get(ColorSpace.Named.BT2020_HLG)) {
+        return CICP_BT2020 to CICP_TRANSFER_HLG
+    }
+    return when (this) {
+        ColorSpace.get(ColorSpace.Named.BT2020) -> CICP_BT2020 to CICP_TRANSFER_BT2020
+        ColorSpace.get(ColorSpace.Named.DISPLAY_P3) -> CICP_P3 to CICP_TRANSFER_SRGB
+        ColorSpace.get(ColorSpace.Named.BT709) -> CICP_BT709 to CICP_TRANSFER_BT709
+        ColorSpace.get(ColorSpace.Named.LINEAR_SRGB),
+        ColorSpace.get(ColorSpace.Named.LINEAR_EXTENDED_SRGB) -> CICP_BT709 to CICP_TRANSFER_LINEAR
+        else -> CICP_BT709 to CICP_TRANSFER_SRGB
+    }
+}
+
+/**
+ * ColorSpace for CICP values read from a file (sRGB when unspecified or unknown)
+ * PQ and HLG fall back to plain BT.2020 before the releases that define them.
+ */
+@RequiresApi(Build.VERSION_CODES.O)
+internal fun colorSpaceFromCicp(primaries: Int, transfer: Int): ColorSpace = ColorSpace.get(
+    when {
+        primaries == CICP_BT2020 && transfer == CICP_TRANSFER_PQ &&
+            Build.VERSION.SDK_INT >= Build.VERSION_CODES.TIRAMISU -> ColorSpace.Named.BT2020_PQ
+        primaries == CICP_BT2020 && transfer == CICP_TRANSFER_HLG &&
+            Build.VERSION.SDK_INT >= Build.VERSION_CODES.UPSIDE_DOWN_CAKE -> ColorSpace.Named.BT2020_HLG
+        primaries == CICP_BT2020 -> ColorSpace.Named.BT2020
+        primaries == CICP_P3 -> ColorSpace.Named.DISPLAY_P3
+        transfer == CICP_TRANSFER_LINEAR -> ColorSpace.Named.LINEAR_SRGB
+        else -> ColorSpace.Named.SRGB
+    }
+)
+
+private const val CICP_BT709 = 1
+private const val CICP_BT2020 = 9
+private const val CICP_P3 = 12
+private const val CICP_TRANSFER_BT709 = 1
+private const val CICP_TRANSFER_LINEAR = 8
+private const val CICP_TRANSFER_SRGB = 13
+private const val CICP_TRANSFER_BT2020 = 14
+private const val CICP_TRANSFER_PQ = 16
+private const val CICP_TRANSFER_HLG = 18
+
+/**
+ * Bytes per pixel for a raw buffer in this channel order
+ */
+internal val ChannelOrder.bytesPerPixel: Int
+    get() = when (this) {
+        ChannelOrder.RGB, ChannelOrder.BGR -> 3
+        else -> 4
+    }
+
+/**
+ * Build the result of a decode-into-buffer call from the native [width, height, hasAlpha] info,
+ * throwing a descriptive error when the buffer could not hold the image
+ */
+internal fun decodeIntoBufferResult(
+    success: Boolean,
+    info: IntArray,
+    buffer: java.nio.ByteBuffer,
+    rowBytes: Int,
+    channelOrder: ChannelOrder
+): ImageInfo {
+    val (width, height, hasAlpha) = info.toList()
+    if (!success) {
+        val required = rowBytes.toLong() * (height - 1) + width.toLong() * channelOrder.bytesPerPixel
+        if (width > 0 && height > 0 && buffer.capacity() < required) {
+            throw AvifError.DecodingFailed(
+                "Target buffer too small for ${width}x$height: need $required bytes, have ${buffer.capacity()}"
+            )
+        }
+        throw AvifError.DecodingFailed("Native decoding into buffer failed")
+    }
+    return ImageInfo(
+        width = width,
+        height = height,
+        format = ImageFormat.AVIF,
+        hasAlpha = hasAlpha != 0
+    )
+}
+
+/**
+ * The bitmap itself if native code can lock it as RGBA_8888, otherwise an ARGB_8888 copy
+ * (e.g. RGB_565 or HARDWARE bitmaps). Callers recycle the copy.
+ */
+internal fun toArgb8888(bitmap: Bitmap): Bitmap? =
+    if (bitmap.config == Bitmap.Config.ARGB_8888) {
+        bitmap
+    } else {
+        bitmap.copy(Bitmap.Config.ARGB_8888, false)
+    }
+
+/**
+ * Convert a Bitmap to tightly packed RGBA bytes (the layout nativeEncode expects)
+ */
+internal fun bitmapToByteArray(bitmap: Bitmap): ByteArray {
+    val pixels = IntArray(bitmap.width * bitmap.height)
+    bitmap.getPixels(pixels, 0, bitmap.width, 0, 0, bitmap.width, bitmap.height)
+    val rgba = ByteArray(pixels.size * 4)
+
+    if (AvifConverter.isNativeLibraryLoaded()) {
+        // SIMD swizzle in native code
+        nativeArgbToRgba(pixels, rgba)
+        return rgba
+    }
+
+    // Convert to byte array (RGBA format)
+    return rgba.apply {
+        pixels.forEachIndexed { i, pixel ->
+            this[i * 4] = (pixel shr 16 and 0xFF).toByte()     // R
+            this[i * 4 + 1] = (pixel shr 8 and 0xFF).toByte()  // G
+            this[i * 4 + 2] = (pixel and 0xFF).toByte()        // B
+            this[i * 4 + 3] = (pixel shr 24 and 0xFF).toByte() // A
+        }
+    }
+}
+
+/**
+ * ARGB ints -> RGBA bytes (rgba must hold 4 bytes per pixel)
+ */
+private external fun nativeArgbToRgba(argb: IntArray, rgba: ByteArray)
+
+/**
+ * Build an ARGB_8888 Bitmap from native decode output
+ */
+internal fun DecodedImage.toBitmap(): Bitmap = Bitmap.createBitmap(
+    pixels,
+    width,
+    height,
+    Bitmap.Config.ARGB_8888
+)
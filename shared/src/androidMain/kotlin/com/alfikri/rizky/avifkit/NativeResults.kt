@@ -0,0 +1,88 @@
+package com.alfikri.rizky.avifkit
+
+/**
+ * Results the native library constructs through JNI
+ *
+ * Class names and constructor signatures are looked up from native code; keep them
+ * in sync with the FindClass/GetMethodID calls there.
+ */
+
+/**
+ * Internal result of a native size-targeted encode
+ *
+ * @param data Best AVIF bitstream found by the search
+ * @param quality Quality used for [data]
+ * @param speed Speed used for [data]
+ * @param subsample Subsample value used for [data] (0=444, 1=422, 2=420)
+ * @param attempts Number of encodes the search performed
+ * @param targetMet Whether [data] fits the requested size
+ */
+internal data class TargetSizeEncodeResult(
+    val data: ByteArray,
+    val quality: Int,
+    val speed: Int,
+    val subsample: Int,
+    val attempts: Int,
+    val targetMet: Boolean
+) {
+    override fun equals(other: Any?): Boolean {
+        if (this === other) return true
+        if (other == null || this::class != other::class) return false
+        other as TargetSizeEncodeResult
+        if (!data.contentEquals(other.data)) return false
+        if (quality != other.quality) return false
+        if (speed != other.speed) return false
+        if (subsample != other.subsample) return false
+        if (attempts != other.attempts) return false
+        if (targetMet != other.targetMet) return false
+        return true
+    }
+
+    override fun hashCode(): Int {
+        var result = data.contentHashCode()
+        result = 31 * result + quality
+        result = 31 * result + speed
+        result = 31 * result + subsample
+        result = 31 * result + attempts
+        result = 31 * result + targetMet.hashCode()
+        return result
+    }
+}
+
+/**
+ * Internal result of a native quality-targeted encode
+ *
+ * @param data Smallest AVIF bitstream that reached the target (or the best-scoring one)
+ * @param quality Quality used for [data]
+ * @param score Weighted YUV SSIM of [data] against the encoder input
+ * @param attempts Number of encodes the search performed
+ * @param targetMet Whether [score] reaches the requested target
+ */
+internal data class TargetQualityEncodeResult(
+    val data: ByteArray,
+    val quality: Int,
+    val score: Float,
+    val attempts: Int,
+    val targetMet: Boolean
+) {
+    override fun equals(other: Any?): Boolean {
+        if (this === other) return true
+        if (other == null || this::class != other::class) return false
+        other as TargetQualityEncodeResult
+        if (!data.contentEquals(other.data)) return false
+        if (quality != other.quality) return false
+        if (score != other.score) return false
+        if (attempts != other.attempts) return false
+        if (targetMet != other.targetMet) return false
+        return true
+    }
+
+    override fun hashCode(): Int {
+        var result = data.contentHashCode()
+        result = 31 * result + quality
+        result = 31 * result + score.hashCode()
+        result = 31 * result + attempts
+        result = 31 * result + targetMet.hashCode()
+        return result
+    }
+}
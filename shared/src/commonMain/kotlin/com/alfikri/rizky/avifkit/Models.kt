@@ -54,6 +54,10 @@ sealed class ImageInput {
  * @param compressionStrategy Strategy for adaptive compression when maxSize is set.
  *                           SMART (default) finds highest quality within target size.
  *                           STRICT finds smallest possible size.
+ * @param targetQuality Minimum visual similarity to the source, as SSIM between 0 and 1
+ *                      (e.g. 0.95). If set, quality is searched for the smallest
+ *                      file that still reaches it, overriding [quality]. Ignored when
+ *                      maxSize is set. Android only; other platforms ignore it.
  */
 data class EncodingOptions(
     val quality: Int = 75,
@@ -64,7 +68,8 @@ data class EncodingOptions(
     val preserveMetadata: Boolean = false,
     val maxDimension: Int? = null,
     val maxSize: Long? = null,
-    val compressionStrategy: CompressionStrategy = CompressionStrategy.SMART
+    val compressionStrategy: CompressionStrategy = CompressionStrategy.SMART,
+    val targetQuality: Float? = null
 ) {
     init {
         require(quality in 0..100) { "Quality must be between 0 and 100" }
@@ -72,6 +77,7 @@ data class EncodingOptions(
         require(alphaQuality in 0..100) { "Alpha quality must be between 0 and 100" }
         maxSize?.let { require(it > 0) { "Max size must be positive" } }
         maxDimension?.let { require(it > 0) { "Max dimension must be positive" } }
+        targetQuality?.let { require(it > 0f && it < 1f) { "Target quality must be between 0 and 1" } }
     }
 
     companion object {
@@ -157,12 +163,22 @@ enum class CompressionStrategy {
     STRICT
 }
 
+/**
+ * Image properties read without decoding pixels
+ *
+ * bitDepth, chromaSubsample and frameCount are only filled when the container reports
+ * them (AVIF probed natively); null means unknown. chromaSubsample is also null for
+ * monochrome AVIF. frameCount is 1 for still images.
+ */
 data class ImageInfo(
     val width: Int,
     val height: Int,
     val format: ImageFormat = ImageFormat.UNKNOWN,
     val hasAlpha: Boolean = false,
-    val fileSize: Long? = null
+    val fileSize: Long? = null,
+    val bitDepth: Int? = null,
+    val chromaSubsample: ChromaSubsample? = null,
+    val frameCount: Int? = null
 )
 
 /**